@@ -0,0 +1,349 @@
+# End to end timings of the rendering pipeline on a synthetic scene.
+#
+#   MIX_ENV=test mix run bench/pipeline.exs [options]
+#
+# The test env is needed for the fonts in the test assets library.
+#
+#   --prims N         primitives in the whole scene (default 1000)
+#   --depth D         groups each run of primitives is nested in (default 4)
+#   --transforms F    fraction of primitives and groups that rotate or scale (0.5)
+#   --text F          fraction of primitives that are text (0.2)
+#   --components C    components the primitives are split across (default 4)
+#   --iterations K    timed runs of each stage (default 50)
+#   --out PATH        also write the results to PATH
+#
+# The stages are
+#
+#   compile        Graph.Compiler.compile/1 of every graph in the scene
+#   serialize      Script.serialize/1 of every compiled script
+#   bounds         Graph.Bounds.compute/1 of every graph
+#   bounds_cached  the same, on graphs whose group bounds are already cached
+#   put_graph      ViewPort.put_graph/3 of every graph
+#   driver         from the first put_graph until a stub driver has read the
+#                  main script in its update_scene/2
+#   hit_test       one ViewPort.find_point/2 at a random point
+#
+# Two scenes built from different seeds are put in turn, so every put_graph
+# writes a changed script. The output is tab separated with the parameters and
+# revision in the header, so runs from different releases can be diffed or
+# loaded side by side. Times are in microseconds.
+#
+# words and reductions are for one run of the stage in a fresh process with
+# garbage collection held off. Refc binaries aren't counted. The driver and
+# hit_test stages do their work in other processes, so they aren't measured.
+
+alias Scenic.Graph
+alias Scenic.Script
+alias Scenic.ViewPort
+
+defmodule Scenic.Bench.Pipeline do
+  @moduledoc false
+
+  import Scenic.Primitives
+
+  alias Scenic.Graph
+  alias Scenic.Primitive
+  alias Scenic.ViewPort
+
+  @width 700
+  @height 600
+  @chunk 25
+  @colors [:red, :green, :blue, :yellow, :cyan, :magenta, :white]
+
+  def size(), do: {@width, @height}
+
+  # --------------------------------------------------------
+  # a scene is the main graph plus a graph for each component, as
+  # [{name, graph}] with the main graph last
+  def scene(p, seed) do
+    :rand.seed(:exsss, {seed, 2, 3})
+    per_graph = max(div(p.prims, p.components + 1), 1)
+
+    components =
+      for i <- 1..p.components//1 do
+        {"bench_component_#{i}", build(per_graph, p)}
+      end
+
+    main =
+      Enum.reduce(components, build(per_graph, p), fn {name, _}, g ->
+        Primitive.Component.add_to_graph(
+          g,
+          {__MODULE__.Component, nil, name},
+          translate: {:rand.uniform(@width div 2), :rand.uniform(@height div 2)}
+        )
+      end)
+
+    components ++ [{ViewPort.main_id(), main}]
+  end
+
+  # runs of primitives, each wrapped in depth nested groups
+  defp build(count, p) do
+    1..count
+    |> Enum.chunk_every(@chunk)
+    |> Enum.reduce(Graph.build(font: :roboto, font_size: 16), &nest(&2, &1, p.depth, p))
+  end
+
+  defp nest(g, ids, 0, p), do: Enum.reduce(ids, g, &prim(&2, &1, p))
+
+  defp nest(g, ids, depth, p) do
+    group(g, &nest(&1, ids, depth - 1, p), transform(p, {10, 10}))
+  end
+
+  defp prim(g, i, p) do
+    opts = [fill: Enum.random(@colors)] ++ transform(p, {@width, @height})
+
+    case :rand.uniform() < p.text do
+      true ->
+        text(g, "Item #{i}", opts)
+
+      false ->
+        opts = [input: :cursor_button] ++ opts
+
+        case rem(i, 3) do
+          0 -> rect(g, {40, 30}, opts)
+          1 -> circle(g, 16, opts)
+          2 -> rrect(g, {40, 30, 6}, opts)
+        end
+    end
+  end
+
+  # always a translate within the range, and sometimes a rotate or a scale on top
+  defp transform(p, {w, h}) do
+    translate = [translate: {:rand.uniform(w), :rand.uniform(h)}]
+
+    case :rand.uniform() < p.transforms do
+      true -> [Enum.random(rotate: :rand.uniform(), scale: 0.5 + :rand.uniform()) | translate]
+      false -> translate
+    end
+  end
+
+  # --------------------------------------------------------
+  # microseconds for each of k runs, after a warm up
+  def time(k, fun) do
+    fun.(0)
+
+    for i <- 1..k do
+      start = :erlang.monotonic_time()
+      fun.(i)
+      System.convert_time_unit(:erlang.monotonic_time() - start, :native, :nanosecond) / 1000
+    end
+  end
+
+  # heap words and reductions used by run i of fun. It runs in a fresh process
+  # whose heap is big enough not to collect. If it did collect anyway, try again
+  # with a bigger one.
+  def alloc(fun, i), do: alloc(fun, i, 1_000_000, 4)
+
+  defp alloc(_fun, _i, _heap, 0), do: nil
+
+  defp alloc(fun, i, heap, tries) do
+    opts = [:monitor, min_heap_size: heap]
+    {pid, ref} = :erlang.spawn_opt(fn -> exit({:alloc, measure(fun, i)}) end, opts)
+
+    receive do
+      {:DOWN, ^ref, :process, ^pid, {:alloc, nil}} -> alloc(fun, i, heap * 8, tries - 1)
+      {:DOWN, ^ref, :process, ^pid, {:alloc, used}} -> used
+    end
+  end
+
+  defp measure(fun, i) do
+    {gcs, words, reds} = counters()
+    fun.(i)
+    {gcs_after, words_after, reds_after} = counters()
+
+    case gcs_after == gcs do
+      true -> {words_after - words, reds_after - reds}
+      false -> nil
+    end
+  end
+
+  defp counters() do
+    [garbage_collection_info: gc, reductions: reds] =
+      Process.info(self(), [:garbage_collection_info, :reductions])
+
+    {gc[:minor_gcs], gc[:heap_size] + gc[:mbuf_size], reds}
+  end
+
+  # --------------------------------------------------------
+  def row(stage, times, used) do
+    sorted = Enum.sort(times)
+    n = length(sorted)
+    p95 = Enum.at(sorted, max(ceil(n * 0.95) - 1, 0))
+
+    {words, reds} =
+      case used do
+        {words, reds} -> {words, reds}
+        nil -> {"-", "-"}
+      end
+
+    [
+      stage,
+      n,
+      us(hd(sorted)),
+      us(Enum.at(sorted, div(n, 2))),
+      us(p95),
+      us(Enum.sum(sorted) / n),
+      words,
+      reds
+    ]
+    |> Enum.join("\t")
+  end
+
+  defp us(t), do: :erlang.float_to_binary(t / 1, decimals: 2)
+
+  # --------------------------------------------------------
+  defmodule Component do
+    @moduledoc false
+    # stands in for a real component. The scene puts its graph directly.
+    def validate(param), do: {:ok, param}
+  end
+
+  defmodule Scene do
+    @moduledoc false
+    use Scenic.Scene
+    def init(scene, _param, _opts), do: {:ok, scene}
+  end
+
+  # a driver that reads every script it is told about, then reports in
+  defmodule Driver do
+    @moduledoc false
+    use Scenic.Driver
+
+    def validate_opts(opts), do: {:ok, opts}
+
+    def init(driver, opts), do: {:ok, assign(driver, :listener, opts[:listener])}
+
+    def update_scene(ids, %{viewport: vp, assigns: %{listener: listener}} = driver) do
+      Enum.each(ids, &ViewPort.get_script(vp, &1))
+      send(listener, {:bench_updated, ids})
+      {:ok, driver}
+    end
+  end
+end
+
+alias Scenic.Bench.Pipeline
+
+{args, _, _} =
+  OptionParser.parse(System.argv(),
+    strict: [
+      prims: :integer,
+      depth: :integer,
+      transforms: :float,
+      text: :float,
+      components: :integer,
+      iterations: :integer,
+      out: :string
+    ]
+  )
+
+p = %{
+  prims: args[:prims] || 1000,
+  depth: args[:depth] || 4,
+  transforms: args[:transforms] || 0.5,
+  text: args[:text] || 0.2,
+  components: args[:components] || 4,
+  iterations: args[:iterations] || 50
+}
+
+k = p.iterations
+scenes = {Pipeline.scene(p, 1), Pipeline.scene(p, 2)}
+scene = fn i -> elem(scenes, rem(i, 2)) end
+graphs = fn i -> Enum.map(scene.(i), &elem(&1, 1)) end
+
+scripts =
+  Enum.map(graphs.(0), fn g ->
+    {:ok, script} = Graph.Compiler.compile(g)
+    script
+  end)
+
+cached = Enum.map(graphs.(0), &Graph.cache_bounds/1)
+
+# a viewport with the stub driver
+case DynamicSupervisor.start_link(name: :scenic_viewports, strategy: :one_for_one) do
+  {:ok, _} -> :ok
+  {:error, {:already_started, _}} -> :ok
+end
+
+{:ok, vp} =
+  ViewPort.start(
+    size: Pipeline.size(),
+    default_scene: Pipeline.Scene,
+    drivers: [[module: Pipeline.Driver, listener: self()]]
+  )
+
+put_all = fn i ->
+  Enum.each(scene.(i), fn {name, graph} -> ViewPort.put_graph(vp, name, graph) end)
+end
+
+main_id = ViewPort.main_id()
+
+await_main = fn await ->
+  receive do
+    {:bench_updated, ids} -> if main_id in ids, do: :ok, else: await.(await)
+  after
+    5_000 -> raise "The stub driver was not updated"
+  end
+end
+
+flush = fn flush ->
+  receive do
+    {:bench_updated, _} -> flush.(flush)
+  after
+    0 -> :ok
+  end
+end
+
+stages = [
+  compile: fn i -> Enum.each(graphs.(i), &Graph.Compiler.compile/1) end,
+  serialize: fn _ -> Enum.each(scripts, &Script.serialize/1) end,
+  bounds: fn i -> Enum.each(graphs.(i), &Graph.Bounds.compute/1) end,
+  bounds_cached: fn _ -> Enum.each(cached, &Graph.Bounds.compute/1) end,
+  put_graph: put_all
+]
+
+rows =
+  Enum.map(stages, fn {stage, fun} ->
+    # the run after the last timed one, so put_graph sees a changed scene
+    Pipeline.row(stage, Pipeline.time(k, fun), Pipeline.alloc(fun, k + 1))
+  end)
+
+# offset so the first put differs from the scene left by the put_graph stage
+driver =
+  Pipeline.time(k, fn i ->
+    flush.(flush)
+    put_all.(i + k)
+    await_main.(await_main)
+  end)
+
+# let the input lists land, then hit test at random points
+{:ok, _} = ViewPort.info(vp)
+{w, h} = Pipeline.size()
+points = List.to_tuple(for _ <- 0..k, do: {:rand.uniform(w), :rand.uniform(h)})
+hit_test = Pipeline.time(k, &ViewPort.find_point(vp, elem(points, &1)))
+
+rows = rows ++ [Pipeline.row(:driver, driver, nil), Pipeline.row(:hit_test, hit_test, nil)]
+
+rev =
+  case System.cmd("git", ["rev-parse", "--short", "HEAD"], stderr_to_stdout: true) do
+    {rev, 0} -> String.trim(rev)
+    _ -> "unknown"
+  end
+
+params = Enum.map_join(p, " ", fn {key, value} -> "#{key}=#{value}" end)
+
+out =
+  [
+    "# scenic pipeline benchmarks",
+    "# rev: #{rev}",
+    "# scenic: #{Application.spec(:scenic, :vsn)} elixir: #{System.version()} " <>
+      "otp: #{System.otp_release()}",
+    "# params: #{params}",
+    "# stage\truns\tmin_us\tmedian_us\tp95_us\tmean_us\twords\treductions"
+    | rows
+  ]
+  |> Enum.join("\n")
+
+IO.puts(out)
+if args[:out], do: File.write!(args[:out], out <> "\n")
+
+ViewPort.stop(vp)
@@ -0,0 +1,52 @@
+# Throughput of the CPU rasterizer on a synthetic scene.
+#
+#   mix run bench/raster.exs [width] [height] [frames]
+#
+# Prints frames per second for a single band and for one band per scheduler.
+
+import Scenic.Primitives
+
+alias Scenic.Graph
+alias Scenic.Raster
+
+{width, height, frames} =
+  case Enum.map(System.argv(), &String.to_integer/1) do
+    [w, h, f] -> {w, h, f}
+    [w, h] -> {w, h, 60}
+    _ -> {800, 480, 60}
+  end
+
+:rand.seed(:exsss, {1, 2, 3})
+
+graph =
+  Enum.reduce(1..200, Graph.build(), fn i, g ->
+    x = :rand.uniform(width)
+    y = :rand.uniform(height)
+    color = Enum.random([:red, :green, :blue, :yellow, :cyan, :magenta, :white])
+
+    case rem(i, 5) do
+      0 -> rect(g, {60, 40}, fill: color, translate: {x, y})
+      1 -> rrect(g, {60, 40, 8}, fill: color, stroke: {2, :white}, translate: {x, y})
+      2 -> circle(g, 24, fill: {:linear, {0, 0, 48, 0, color, :black}}, translate: {x, y})
+      3 -> line(g, {{0, 0}, {80, 30}}, stroke: {3, color}, cap: :round, translate: {x, y})
+      4 -> sector(g, {30, 2.0}, fill: color, rotate: i / 10, translate: {x, y})
+    end
+  end)
+
+{:ok, script} = Graph.Compiler.compile(graph)
+
+run = fn tiles ->
+  # warm up, then time the frames
+  Raster.render(script, width, height, tiles: tiles)
+
+  {us, _} =
+    :timer.tc(fn ->
+      Enum.each(1..frames, fn _ -> Raster.render(script, width, height, tiles: tiles) end)
+    end)
+
+  fps = frames * 1_000_000 / us
+  IO.puts("#{width}x#{height} tiles: #{tiles} -> #{Float.round(fps, 1)} fps")
+end
+
+run.(1)
+run.(System.schedulers_online())
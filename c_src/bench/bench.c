@@ -0,0 +1,323 @@
+// Standalone micro benchmarks of the nif kernels. This links the kernels
+// directly, without erlang, so they can be measured and compared between
+// commits. Build and run it with
+//
+//   make bench
+//   make bench KERNEL=matrix      (only the kernels with "matrix" in the name)
+//
+// Each kernel is run over a range of sizes. A run repeats the kernel until it
+// has covered at least MIN_ELEMENTS elements, and the fastest of TRIALS runs is
+// reported, as time per element. On x86 the time is read from the time stamp
+// counter and is in (reference) cycles. Elsewhere it is in nanoseconds.
+//
+// The output is one tab separated line per kernel and size, after a few
+// comment lines starting with #, so results are easy to diff or load.
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "matrix_math.h"
+#include "line_math.h"
+#include "pixels.h"
+#include "tween_math.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define TICK_UNIT "cycles"
+static inline uint64_t ticks( void ) { return __rdtsc(); }
+#else
+#define TICK_UNIT "ns"
+static inline uint64_t ticks( void ) {
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+#endif
+
+#ifndef BENCH_REV
+#define BENCH_REV "unknown"
+#endif
+
+#define MIN_ELEMENTS      (1 << 22)
+#define TRIALS            7
+
+#define MAX_MATRICES      4096
+#define MAX_VECTORS       (1 << 18)
+#define MAX_LINES         4096
+#define IMAGE_SIDE        1024
+#define MAX_PIXELS        (IMAGE_SIDE * IMAGE_SIDE)
+#define MAX_PUTS          65536
+#define MAX_TWEENS        4096
+
+typedef void (*kernel_fn)( size_t n );
+typedef bool (*put_fn)( uint8_t* p, size_t size, size_t width, size_t stride,
+                        size_t x, size_t y, const uint8_t* color );
+typedef void (*clear_fn)( uint8_t* p, size_t size, size_t width, size_t stride,
+                          const uint8_t* color );
+typedef void (*histogram_fn)( const uint8_t* p, size_t stride, size_t x, size_t y,
+                              size_t w, size_t h, uint64_t* hist );
+typedef void (*stats_fn)( const uint8_t* p, size_t stride, size_t x, size_t y,
+                          size_t w, size_t h, uint8_t* min, uint8_t* max, uint64_t* sum );
+
+static float      mx_a[MAX_MATRICES][16];
+static float      mx_b[MAX_MATRICES][16];
+static float      mx_c[MAX_MATRICES][16];
+static float      vectors[MAX_VECTORS][2];
+static double     lines[MAX_LINES][8];
+static double     line_out[MAX_LINES][4];
+static uint8_t    image[MAX_PIXELS * 4];
+static uint8_t    frame[MAX_PIXELS * 4];
+static uint8_t    crop_out[MAX_PIXELS * 4];
+static uint64_t   hist[4 * 256];
+static size_t     positions[MAX_PUTS];
+static double     tweens[MAX_TWEENS][TWEEN_RECORD];
+static double     tween_out[MAX_TWEENS];
+
+// read after every run so the work can't be thrown away
+static volatile float sink;
+
+
+//=============================================================================
+// deterministic inputs, so runs on different commits see the same data
+
+static uint32_t rng_state = 0x12345678;
+
+//---------------------------------------------------------
+static uint32_t rng( void ) {
+  // xorshift32
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 17;
+  rng_state ^= rng_state << 5;
+  return rng_state;
+}
+
+//---------------------------------------------------------
+static float rng_float( void ) {
+  return (float)(rng() % 20000) / 100.0f - 100.0f;
+}
+
+//---------------------------------------------------------
+static void setup( void ) {
+  for ( size_t i = 0; i < MAX_MATRICES; i++ ) {
+    for ( int j = 0; j < 16; j++ ) {
+      mx_a[i][j] = rng_float();
+      mx_b[i][j] = rng_float();
+    }
+  }
+  for ( size_t i = 0; i < MAX_VECTORS; i++ ) {
+    vectors[i][0] = rng_float();
+    vectors[i][1] = rng_float();
+  }
+  for ( size_t i = 0; i < MAX_LINES; i++ ) {
+    for ( int j = 0; j < 8; j++ ) {lines[i][j] = rng_float();}
+  }
+  for ( size_t i = 0; i < MAX_PUTS; i++ ) {
+    positions[i] = rng() % MAX_PIXELS;
+  }
+  for ( size_t i = 0; i < MAX_PIXELS * 4; i++ ) {frame[i] = rng();}
+  for ( size_t i = 0; i < MAX_TWEENS; i++ ) {
+    tweens[i][0] = rng() % TWEEN_EASINGS;
+    tweens[i][1] = (rng() % 1000) / 1000.0;
+    tweens[i][2] = rng_float();
+    tweens[i][3] = rng_float();
+  }
+}
+
+
+//=============================================================================
+// the kernels, each run over n elements
+
+//---------------------------------------------------------
+static void k_matrix_multiply( size_t n ) {
+  for ( size_t i = 0; i < n; i++ ) {matrix_multiply( mx_a[i], mx_b[i], mx_c[i] );}
+  sink = mx_c[n - 1][5];
+}
+
+static void k_matrix_adjugate( size_t n ) {
+  for ( size_t i = 0; i < n; i++ ) {matrix_adjugate( mx_a[i], mx_c[i] );}
+  sink = mx_c[n - 1][5];
+}
+
+static void k_matrix_determinant( size_t n ) {
+  float d = 0;
+  for ( size_t i = 0; i < n; i++ ) {d += matrix_determinant( mx_a[i] );}
+  sink = d;
+}
+
+static void k_matrix_project_vector2( size_t n ) {
+  float sum = 0;
+  for ( size_t i = 0; i < n; i++ ) {
+    float x = vectors[i][0];
+    float y = vectors[i][1];
+    matrix_project_vector2( mx_a[0], &x, &y );
+    sum += x + y;
+  }
+  sink = sum;
+}
+
+//---------------------------------------------------------
+static void k_line_parallel( size_t n ) {
+  for ( size_t i = 0; i < n; i++ ) {
+    double* l = lines[i];
+    line_parallel( l[0], l[1], l[2], l[3], 4.0, line_out[i] );
+  }
+  sink = (float)line_out[n - 1][0];
+}
+
+static void k_line_intersection( size_t n ) {
+  double sum = 0;
+  for ( size_t i = 0; i < n; i++ ) {
+    double* l = lines[i];
+    double x, y;
+    line_intersection( l[0], l[1], l[2], l[3], l[4], l[5], l[6], l[7], &x, &y );
+    sum += x + y;
+  }
+  sink = (float)sum;
+}
+
+//---------------------------------------------------------
+// n pixels as rows of up to IMAGE_SIDE, tightly packed
+static const uint8_t color[4] = {1, 2, 3, 4};
+
+static void clear( clear_fn fn, size_t ch, size_t n ) {
+  size_t width = n < IMAGE_SIDE ? n : IMAGE_SIDE;
+  fn( image, n * ch, width, width * ch, color );
+  sink = image[n - 1];
+}
+
+static void k_clear_g( size_t n )     {clear( pixels_clear_g, 1, n );}
+static void k_clear_ga( size_t n )    {clear( pixels_clear_ga, 2, n );}
+static void k_clear_rgb( size_t n )   {clear( pixels_clear_rgb, 3, n );}
+static void k_clear_rgba( size_t n )  {clear( pixels_clear_rgba, 4, n );}
+
+//---------------------------------------------------------
+// n puts at random positions in an IMAGE_SIDE square image
+static void put( put_fn fn, size_t ch, size_t n ) {
+  for ( size_t i = 0; i < n; i++ ) {
+    fn( image, MAX_PIXELS * ch, IMAGE_SIDE, IMAGE_SIDE * ch,
+        positions[i] % IMAGE_SIDE, positions[i] / IMAGE_SIDE, color );
+  }
+  sink = image[positions[0]];
+}
+
+static void k_put_g( size_t n )       {put( pixels_put_g, 1, n );}
+static void k_put_ga( size_t n )      {put( pixels_put_ga, 2, n );}
+static void k_put_rgb( size_t n )     {put( pixels_put_rgb, 3, n );}
+static void k_put_rgba( size_t n )    {put( pixels_put_rgba, 4, n );}
+
+//---------------------------------------------------------
+// regions of n pixels, as rows of up to IMAGE_SIDE, out of an IMAGE_SIDE square
+// frame of noise
+static size_t region_w( size_t n ) {return n < IMAGE_SIDE ? n : IMAGE_SIDE;}
+
+static void histogram( histogram_fn fn, size_t ch, size_t n ) {
+  fn( frame, IMAGE_SIDE * ch, 0, 0, region_w(n), n / region_w(n), hist );
+  sink = hist[255];
+}
+
+static void k_histogram_g( size_t n )     {histogram( pixels_histogram_g, 1, n );}
+static void k_histogram_rgba( size_t n )  {histogram( pixels_histogram_rgba, 4, n );}
+
+static void stats( stats_fn fn, size_t ch, size_t n ) {
+  uint8_t   min[4], max[4];
+  uint64_t  sum[4];
+  fn( frame, IMAGE_SIDE * ch, 0, 0, region_w(n), n / region_w(n), min, max, sum );
+  sink = sum[0];
+}
+
+static void k_stats_g( size_t n )         {stats( pixels_stats_g, 1, n );}
+static void k_stats_rgba( size_t n )      {stats( pixels_stats_rgba, 4, n );}
+
+static void k_crop_rgba( size_t n ) {
+  pixels_crop( frame, IMAGE_SIDE * 4, 4, 1, 1, region_w(n) - 1, n / region_w(n), crop_out );
+  sink = crop_out[0];
+}
+
+//---------------------------------------------------------
+// a frame of animated values, with the easings mixed
+static void k_tween_batch( size_t n ) {
+  tween_batch( tweens, n, tween_out );
+  sink = (float)tween_out[n - 1];
+}
+
+//=============================================================================
+// the runner
+
+typedef struct {
+  const char*   name;
+  kernel_fn     fn;
+  size_t        sizes[4];     // zero terminated
+} bench_t;
+
+static const bench_t benches[] = {
+  {"matrix_multiply",         k_matrix_multiply,        {1, 64, MAX_MATRICES, 0}},
+  {"matrix_adjugate",         k_matrix_adjugate,        {1, 64, MAX_MATRICES, 0}},
+  {"matrix_determinant",      k_matrix_determinant,     {1, 64, MAX_MATRICES, 0}},
+  {"matrix_project_vector2",  k_matrix_project_vector2, {64, 4096, MAX_VECTORS, 0}},
+  {"line_parallel",           k_line_parallel,          {1, 64, MAX_LINES, 0}},
+  {"line_intersection",       k_line_intersection,      {1, 64, MAX_LINES, 0}},
+  {"pixels_clear_g",          k_clear_g,                {256, 65536, MAX_PIXELS, 0}},
+  {"pixels_clear_ga",         k_clear_ga,               {256, 65536, MAX_PIXELS, 0}},
+  {"pixels_clear_rgb",        k_clear_rgb,              {256, 65536, MAX_PIXELS, 0}},
+  {"pixels_clear_rgba",       k_clear_rgba,             {256, 65536, MAX_PIXELS, 0}},
+  {"pixels_put_g",            k_put_g,                  {256, MAX_PUTS, 0}},
+  {"pixels_put_ga",           k_put_ga,                 {256, MAX_PUTS, 0}},
+  {"pixels_put_rgb",          k_put_rgb,                {256, MAX_PUTS, 0}},
+  {"pixels_put_rgba",         k_put_rgba,               {256, MAX_PUTS, 0}},
+  {"pixels_histogram_g",      k_histogram_g,            {256, 65536, MAX_PIXELS, 0}},
+  {"pixels_histogram_rgba",   k_histogram_rgba,         {256, 65536, MAX_PIXELS, 0}},
+  {"pixels_stats_g",          k_stats_g,                {256, 65536, MAX_PIXELS, 0}},
+  {"pixels_stats_rgba",       k_stats_rgba,             {256, 65536, MAX_PIXELS, 0}},
+  {"pixels_crop_rgba",        k_crop_rgba,              {256, 65536, MAX_PIXELS, 0}},
+  {"tween_batch",             k_tween_batch,            {1, 64, 2048, MAX_TWEENS}},
+};
+
+//---------------------------------------------------------
+static double run( kernel_fn fn, size_t n ) {
+  size_t    reps = MIN_ELEMENTS / n;
+  uint64_t  best = UINT64_MAX;
+
+  if ( reps == 0 ) {reps = 1;}
+
+  // warm the caches and the branch predictors
+  fn( n );
+
+  for ( int t = 0; t < TRIALS; t++ ) {
+    uint64_t start = ticks();
+    for ( size_t r = 0; r < reps; r++ ) {fn( n );}
+    uint64_t elapsed = ticks() - start;
+    if ( elapsed < best ) {best = elapsed;}
+  }
+
+  return (double)best / (double)(reps * n);
+}
+
+//---------------------------------------------------------
+int main( int argc, char** argv ) {
+  const char* filter = argc > 1 ? argv[1] : NULL;
+
+  setup();
+
+  printf( "# scenic nif kernel benchmarks\n" );
+  printf( "# rev: %s\n", BENCH_REV );
+  printf( "# unit: %s per element, fastest of %d runs\n", TICK_UNIT, TRIALS );
+  printf( "# kernel\telements\t%s_per_element\n", TICK_UNIT );
+
+  for ( size_t b = 0; b < sizeof(benches) / sizeof(benches[0]); b++ ) {
+    const bench_t* bench = &benches[b];
+    if ( filter && !strstr(bench->name, filter) ) {continue;}
+
+    for ( int s = 0; s < 4 && bench->sizes[s]; s++ ) {
+      double per = run( bench->fn, bench->sizes[s] );
+      printf( "%s\t%zu\t%.3f\n", bench->name, bench->sizes[s], per );
+      fflush( stdout );
+    }
+  }
+
+  return 0;
+}
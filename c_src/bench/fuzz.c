@@ -0,0 +1,71 @@
+// libFuzzer harness for the pixel kernels. The input picks a pixel format, a
+// buffer size, a row stride and width, a position and the channel values. A
+// put must succeed exactly when the pixel is inside the width of a whole row in
+// the buffer, and neither a put nor a clear may touch memory outside it. Build
+// and run it with
+//
+//   make fuzz
+//
+// which needs clang, and builds with the address sanitizer.
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pixels.h"
+#include "line_math.h"
+
+//---------------------------------------------------------
+int LLVMFuzzerTestOneInput( const uint8_t* data, size_t size ) {
+  uint8_t*  p;
+  size_t    buf_size, stride, width, x, y, bpp;
+  bool      ok = false;
+  uint8_t   c[4];
+
+  if ( size < 15 ) {return 0;}
+
+  bpp = (data[0] % 4) + 1;
+  buf_size = (size_t)data[1] | ((size_t)data[2] << 8);
+  stride = data[3];
+  width = data[4];
+  x = (size_t)data[5] | ((size_t)data[6] << 8);
+  y = (size_t)data[7] | ((size_t)data[8] << 8);
+  memcpy( c, data + 9, 4 );
+
+  // an exact size allocation, so the sanitizer sees any overrun
+  p = malloc( buf_size ? buf_size : 1 );
+  if ( !p ) {return 0;}
+
+  switch ( bpp ) {
+    case 1:
+      ok = pixels_put_g( p, buf_size, width, stride, x, y, c );
+      pixels_clear_g( p, buf_size, width, stride, c );
+      break;
+    case 2:
+      ok = pixels_put_ga( p, buf_size, width, stride, x, y, c );
+      pixels_clear_ga( p, buf_size, width, stride, c );
+      break;
+    case 3:
+      ok = pixels_put_rgb( p, buf_size, width, stride, x, y, c );
+      pixels_clear_rgb( p, buf_size, width, stride, c );
+      break;
+    case 4:
+      ok = pixels_put_rgba( p, buf_size, width, stride, x, y, c );
+      pixels_clear_rgba( p, buf_size, width, stride, c );
+      break;
+  }
+  assert( ok == (stride && x < width && (x + 1) * bpp <= stride &&
+                 (y + 1) * stride <= buf_size) );
+  free( p );
+
+  // the line functions take any doubles. They only need to not crash
+  if ( size >= 15 + sizeof(double) * 8 ) {
+    double l[8], out[4], ix, iy;
+    memcpy( l, data + 15, sizeof(l) );
+    line_parallel( l[0], l[1], l[2], l[3], l[4], out );
+    line_intersection( l[0], l[1], l[2], l[3], l[4], l[5], l[6], l[7], &ix, &iy );
+  }
+
+  return 0;
+}
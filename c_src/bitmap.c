@@ -5,205 +5,197 @@
 
 #include <string.h>
 #include <erl_nif.h>
+#include "pixels.h"
 
 //=============================================================================
 // utilities
 
-//=============================================================================
-// Erlang NIF stuff from here down.
+typedef bool (*put_fn)( uint8_t* p, size_t size, size_t width, size_t stride,
+                        size_t x, size_t y, const uint8_t* color );
+typedef void (*clear_fn)( uint8_t* p, size_t size, size_t width, size_t stride,
+                          const uint8_t* color );
+typedef void (*histogram_fn)( const uint8_t* p, size_t stride, size_t x, size_t y,
+                              size_t w, size_t h, uint64_t* hist );
+typedef void (*stats_fn)( const uint8_t* p, size_t stride, size_t x, size_t y,
+                          size_t w, size_t h, uint8_t* min, uint8_t* max, uint64_t* sum );
+
+// indexed by the number of channels
+static const put_fn puts[5] = {
+  NULL, pixels_put_g, pixels_put_ga, pixels_put_rgb, pixels_put_rgba
+};
+static const clear_fn clears[5] = {
+  NULL, pixels_clear_g, pixels_clear_ga, pixels_clear_rgb, pixels_clear_rgba
+};
+static const histogram_fn histograms[5] = {
+  NULL, pixels_histogram_g, pixels_histogram_ga, pixels_histogram_rgb, pixels_histogram_rgba
+};
+static const stats_fn stats[5] = {
+  NULL, pixels_stats_g, pixels_stats_ga, pixels_stats_rgb, pixels_stats_rgba
+};
 
-//-----------------------------------------------------------------------------
-static ERL_NIF_TERM
-nif_put_g(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+// a rectangle of a bitmap
+typedef struct {
   ErlNifBinary  pixels;
-  unsigned int  pos;
-  unsigned int  g;
-
-  // get the parameters
-  if ( !enif_inspect_binary(env, argv[0], &pixels) )    {return enif_make_badarg(env);}
-  if ( !enif_get_uint(env, argv[1], &pos) )       {return enif_make_badarg(env);}
-  if ( pos >= pixels.size ) {return enif_make_badarg(env);}
-  if ( !enif_get_uint(env, argv[2], &g) )      {return enif_make_badarg(env);}
-
-  // put the value
-  pixels.data[pos] = g;
-
-  return enif_make_atom(env, "ok");;
+  unsigned int  stride;
+  unsigned int  channels;
+  unsigned int  x;
+  unsigned int  y;
+  unsigned int  w;
+  unsigned int  h;
+} region_t;
+
+//---------------------------------------------------------
+// read the channel values that end the argument list
+static bool get_color( ErlNifEnv* env, const ERL_NIF_TERM* argv, int channels, uint8_t* color ) {
+  unsigned int v;
+  for ( int i = 0; i < channels; i++ ) {
+    if ( !enif_get_uint(env, argv[i], &v) || v > 255 ) {return false;}
+    color[i] = v;
+  }
+  return true;
 }
 
-//-----------------------------------------------------------------------------
-static ERL_NIF_TERM
-nif_put_ga(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
-  ErlNifBinary  pixels;
-  unsigned int  pos;
-  unsigned int  g;
-  unsigned int  a;
-
-  // get the parameters
-  if ( !enif_inspect_binary(env, argv[0], &pixels) )    {return enif_make_badarg(env);}
-  if ( !enif_get_uint(env, argv[1], &pos) )       {return enif_make_badarg(env);}
-  if ( pos >= (pixels.size - 1) ) {return enif_make_badarg(env);}
-  if ( !enif_get_uint(env, argv[2], &g) )      {return enif_make_badarg(env);}
-  if ( !enif_get_uint(env, argv[3], &a) )      {return enif_make_badarg(env);}
-
-  // put the value
-  pos *= 2;
-  pixels.data[pos] = g;
-  pixels.data[pos + 1] = a;
-
-  return enif_make_atom(env, "ok");;
+//---------------------------------------------------------
+// read the args: pixels, stride, channels, x, y, w, h. The region must be
+// inside whole rows of the buffer.
+static bool get_region( ErlNifEnv* env, const ERL_NIF_TERM* argv, region_t* r ) {
+  if ( !enif_inspect_binary(env, argv[0], &r->pixels) )  {return false;}
+  if ( !enif_get_uint(env, argv[1], &r->stride) )        {return false;}
+  if ( !enif_get_uint(env, argv[2], &r->channels) )      {return false;}
+  if ( !enif_get_uint(env, argv[3], &r->x) )             {return false;}
+  if ( !enif_get_uint(env, argv[4], &r->y) )             {return false;}
+  if ( !enif_get_uint(env, argv[5], &r->w) )             {return false;}
+  if ( !enif_get_uint(env, argv[6], &r->h) )             {return false;}
+
+  if ( r->channels < 1 || r->channels > 4 || !r->stride ) {return false;}
+  if ( (size_t)r->x + r->w > r->stride / r->channels )    {return false;}
+  if ( (size_t)r->y + r->h > r->pixels.size / r->stride ) {return false;}
+  return true;
 }
 
-//-----------------------------------------------------------------------------
-static ERL_NIF_TERM
-nif_put_rgb(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
-  ErlNifBinary  pixels;
-  unsigned int  pos;
-  unsigned int  r;
-  unsigned int  g;
-  unsigned int  b;
-
-  // get the parameters
-  if ( !enif_inspect_binary(env, argv[0], &pixels) )    {return enif_make_badarg(env);}
-  if ( !enif_get_uint(env, argv[1], &pos) )       {return enif_make_badarg(env);}
-  if ( pos >= (pixels.size - 2) ) {return enif_make_badarg(env);}
-  if ( !enif_get_uint(env, argv[2], &r) )      {return enif_make_badarg(env);}
-  if ( !enif_get_uint(env, argv[3], &g) )      {return enif_make_badarg(env);}
-  if ( !enif_get_uint(env, argv[4], &b) )      {return enif_make_badarg(env);}
-
-  // put the value
-  pos *= 3;
-  pixels.data[pos] = r;
-  pixels.data[pos + 1] = g;
-  pixels.data[pos + 2] = b;
-
-  return enif_make_atom(env, "ok");;
-}
+//=============================================================================
+// Erlang NIF stuff from here down.
 
 //-----------------------------------------------------------------------------
+// args: pixels, width, stride, x, y, then one value per channel.
+// The number of channels is taken from the arity
 static ERL_NIF_TERM
-nif_put_rgba(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+nif_put(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
   ErlNifBinary  pixels;
-  unsigned int  pos;
-  unsigned int  r;
-  unsigned int  g;
-  unsigned int  b;
-  unsigned int  a;
+  unsigned int  width;
+  unsigned int  stride;
+  unsigned int  x;
+  unsigned int  y;
+  uint8_t       color[4];
+  int           channels = argc - 5;
 
   // get the parameters
   if ( !enif_inspect_binary(env, argv[0], &pixels) )    {return enif_make_badarg(env);}
-  if ( !enif_get_uint(env, argv[1], &pos) )       {return enif_make_badarg(env);}
-  if ( pos >= (pixels.size - 3) ) {return enif_make_badarg(env);}
-  if ( !enif_get_uint(env, argv[2], &r) )      {return enif_make_badarg(env);}
-  if ( !enif_get_uint(env, argv[3], &g) )      {return enif_make_badarg(env);}
-  if ( !enif_get_uint(env, argv[4], &b) )      {return enif_make_badarg(env);}
-  if ( !enif_get_uint(env, argv[5], &a) )      {return enif_make_badarg(env);}
+  if ( !enif_get_uint(env, argv[1], &width) )           {return enif_make_badarg(env);}
+  if ( !enif_get_uint(env, argv[2], &stride) )          {return enif_make_badarg(env);}
+  if ( !enif_get_uint(env, argv[3], &x) )               {return enif_make_badarg(env);}
+  if ( !enif_get_uint(env, argv[4], &y) )               {return enif_make_badarg(env);}
+  if ( !get_color(env, argv + 5, channels, color) )     {return enif_make_badarg(env);}
 
   // put the value
-  pos *= 4;
-  pixels.data[pos] = r;
-  pixels.data[pos + 1] = g;
-  pixels.data[pos + 2] = b;
-  pixels.data[pos + 3] = a;
+  if ( !puts[channels](pixels.data, pixels.size, width, stride, x, y, color) ) {
+    return enif_make_badarg(env);
+  }
 
-  return enif_make_atom(env, "ok");;
+  return enif_make_atom(env, "ok");
 }
 
-
-
-
 //-----------------------------------------------------------------------------
+// args: pixels, width, stride, then one value per channel.
+// The number of channels is taken from the arity
 static ERL_NIF_TERM
-nif_clear_g(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+nif_clear(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
   ErlNifBinary  pixels;
-  unsigned int  g;
+  unsigned int  width;
+  unsigned int  stride;
+  uint8_t       color[4];
+  int           channels = argc - 3;
 
   // get the parameters
   if ( !enif_inspect_binary(env, argv[0], &pixels) )    {return enif_make_badarg(env);}
-  if ( !enif_get_uint(env, argv[1], &g) )      {return enif_make_badarg(env);}
+  if ( !enif_get_uint(env, argv[1], &width) )           {return enif_make_badarg(env);}
+  if ( !enif_get_uint(env, argv[2], &stride) )          {return enif_make_badarg(env);}
+  if ( !get_color(env, argv + 3, channels, color) )     {return enif_make_badarg(env);}
 
   // clear the pixels
-  memset(pixels.data, g, pixels.size);
+  clears[channels]( pixels.data, pixels.size, width, stride, color );
 
   return enif_make_binary( env, &pixels );
 }
 
+
 //-----------------------------------------------------------------------------
+// args: pixels, stride, channels, x, y, w, h.
+// returns a new binary with the region's pixels, with the rows packed
 static ERL_NIF_TERM
-nif_clear_ga(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
-  ErlNifBinary  pixels;
-  unsigned int  size;
-  unsigned int  g;
-  unsigned int  a;
+nif_crop(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+  region_t      r;
+  ERL_NIF_TERM  term;
+  uint8_t*      out;
 
-  // get the parameters
-  if ( !enif_inspect_binary(env, argv[0], &pixels) )    {return enif_make_badarg(env);}
-  if ( !enif_get_uint(env, argv[1], &g) )      {return enif_make_badarg(env);}
-  if ( !enif_get_uint(env, argv[2], &a) )      {return enif_make_badarg(env);}  
+  if ( !get_region(env, argv, &r) )                     {return enif_make_badarg(env);}
 
-  // clear the pixels
-  size = pixels.size;
-  for( unsigned int i = 0; i < size; i += 2) {
-    pixels.data[i] = g;
-    pixels.data[i+1] = a;
-  }
+  out = enif_make_new_binary( env, (size_t)r.w * r.h * r.channels, &term );
+  if ( !out )                                           {return enif_make_badarg(env);}
+  pixels_crop( r.pixels.data, r.stride, r.channels, r.x, r.y, r.w, r.h, out );
 
-  return enif_make_binary( env, &pixels );
+  return term;
 }
 
 //-----------------------------------------------------------------------------
+// args: pixels, stride, channels, x, y, w, h.
+// returns a tuple per channel, each with the 256 counts of its values
 static ERL_NIF_TERM
-nif_clear_rgb(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
-  ErlNifBinary  pixels;
-  unsigned int  size;
-  unsigned int  r;
-  unsigned int  g;
-  unsigned int  b;
+nif_histogram(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+  region_t      r;
+  uint64_t      hist[4 * 256];
+  ERL_NIF_TERM  counts[256];
+  ERL_NIF_TERM  channels[4];
 
-  // get the parameters
-  if ( !enif_inspect_binary(env, argv[0], &pixels) )    {return enif_make_badarg(env);}
-  if ( !enif_get_uint(env, argv[1], &r) )      {return enif_make_badarg(env);}
-  if ( !enif_get_uint(env, argv[2], &g) )      {return enif_make_badarg(env);}
-  if ( !enif_get_uint(env, argv[3], &b) )      {return enif_make_badarg(env);}
+  if ( !get_region(env, argv, &r) )                     {return enif_make_badarg(env);}
 
-  // clear the pixels
-  size = pixels.size;
-  for( unsigned int i = 0; i < size; i += 3) {
-    pixels.data[i] = r;
-    pixels.data[i+1] = g;
-    pixels.data[i+2] = b;
+  histograms[r.channels]( r.pixels.data, r.stride, r.x, r.y, r.w, r.h, hist );
+
+  for ( unsigned int c = 0; c < r.channels; c++ ) {
+    for ( int i = 0; i < 256; i++ ) {counts[i] = enif_make_uint64( env, hist[c * 256 + i] );}
+    channels[c] = enif_make_tuple_from_array( env, counts, 256 );
   }
 
-  return enif_make_binary( env, &pixels );
+  return enif_make_tuple_from_array( env, channels, r.channels );
 }
 
 //-----------------------------------------------------------------------------
+// args: pixels, stride, channels, x, y, w, h. The region can't be empty.
+// returns a {min, max, mean} tuple per channel
 static ERL_NIF_TERM
-nif_clear_rgba(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
-  ErlNifBinary  pixels;
-  unsigned int  size;
-  unsigned int  r;
-  unsigned int  g;
-  unsigned int  b;
-  unsigned int  a;
-
-  // get the parameters
-  if ( !enif_inspect_binary(env, argv[0], &pixels) )    {return enif_make_badarg(env);}
-  if ( !enif_get_uint(env, argv[1], &r) )      {return enif_make_badarg(env);}
-  if ( !enif_get_uint(env, argv[2], &g) )      {return enif_make_badarg(env);}
-  if ( !enif_get_uint(env, argv[3], &b) )      {return enif_make_badarg(env);}
-  if ( !enif_get_uint(env, argv[4], &a) )      {return enif_make_badarg(env);}
-
-  // clear the pixels
-  size = pixels.size;
-  for( unsigned int i = 0; i < size; i += 4) {
-    pixels.data[i] = r;
-    pixels.data[i+1] = g;
-    pixels.data[i+2] = b;
-    pixels.data[i+3] = a;
+nif_min_max_mean(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+  region_t      r;
+  uint8_t       min[4];
+  uint8_t       max[4];
+  uint64_t      sum[4];
+  double        n;
+  ERL_NIF_TERM  channels[4];
+
+  if ( !get_region(env, argv, &r) )                     {return enif_make_badarg(env);}
+  if ( !r.w || !r.h )                                   {return enif_make_badarg(env);}
+
+  stats[r.channels]( r.pixels.data, r.stride, r.x, r.y, r.w, r.h, min, max, sum );
+
+  n = (double)r.w * r.h;
+  for ( unsigned int c = 0; c < r.channels; c++ ) {
+    channels[c] = enif_make_tuple3( env,
+      enif_make_uint(env, min[c]),
+      enif_make_uint(env, max[c]),
+      enif_make_double(env, sum[c] / n)
+    );
   }
 
-  return enif_make_binary( env, &pixels );
+  return enif_make_tuple_from_array( env, channels, r.channels );
 }
 
 
@@ -212,14 +204,17 @@ nif_clear_rgba(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
 
 static ErlNifFunc nif_funcs[] = {
   // {erl_function_name, erl_function_arity, c_function}
-  {"nif_put",             3, nif_put_g,         0},
-  {"nif_put",             4, nif_put_ga,        0},
-  {"nif_put",             5, nif_put_rgb,       0},
-  {"nif_put",             6, nif_put_rgba,      0},
-  {"nif_clear",           2, nif_clear_g,       0},
-  {"nif_clear",           3, nif_clear_ga,      0},
-  {"nif_clear",           4, nif_clear_rgb,     0},
-  {"nif_clear",           5, nif_clear_rgba,    0},
+  {"nif_put",             6, nif_put,           0},
+  {"nif_put",             7, nif_put,           0},
+  {"nif_put",             8, nif_put,           0},
+  {"nif_put",             9, nif_put,           0},
+  {"nif_clear",           4, nif_clear,         0},
+  {"nif_clear",           5, nif_clear,         0},
+  {"nif_clear",           6, nif_clear,         0},
+  {"nif_clear",           7, nif_clear,         0},
+  {"nif_crop",            7, nif_crop,          ERL_NIF_DIRTY_JOB_CPU_BOUND},
+  {"nif_histogram",       7, nif_histogram,     ERL_NIF_DIRTY_JOB_CPU_BOUND},
+  {"nif_min_max_mean",    7, nif_min_max_mean,  ERL_NIF_DIRTY_JOB_CPU_BOUND},
 };
 
-ERL_NIF_INIT(Elixir.Scenic.Assets.Stream.Bitmap, nif_funcs, NULL, NULL, NULL, NULL)
\ No newline at end of file
+ERL_NIF_INIT(Elixir.Scenic.Assets.Stream.Bitmap, nif_funcs, NULL, NULL, NULL, NULL)
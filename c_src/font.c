@@ -0,0 +1,257 @@
+// Text measurement against a glyph advance table. The table is built on the
+// elixir side from a font's metrics and is a single binary:
+//
+//   256 int32 advances for code points 0..255, -1 where there is no glyph
+//   then pairs of uint32 code point, int32 advance, sorted by code point,
+//   for everything above 255
+//
+// All values are native endian and in font units. Widths are returned in font
+// units too, so they don't depend on the font size. Any string that isn't
+// valid utf8 or uses a code point the table doesn't have is reported as
+// :undefined so the caller can fall back to measuring it some other way.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <erl_nif.h>
+
+#define DENSE_COUNT       256
+#define MISSING           -1
+
+typedef struct {
+  const unsigned char*  dense;
+  const unsigned char*  pairs;      // cp, advance, cp, advance...
+  size_t                pair_count;
+} table_t;
+
+
+//=============================================================================
+// utilities
+
+//---------------------------------------------------------
+static bool get_table( ErlNifEnv* env, ERL_NIF_TERM term, ErlNifBinary* bin, table_t* t ) {
+  if ( !enif_inspect_binary(env, term, bin) )                   {return false;}
+  if ( bin->size < DENSE_COUNT * 4 || (bin->size - DENSE_COUNT * 4) % 8 ) {return false;}
+  t->dense = bin->data;
+  t->pairs = bin->data + DENSE_COUNT * 4;
+  t->pair_count = (bin->size - DENSE_COUNT * 4) / 8;
+  return true;
+}
+
+//---------------------------------------------------------
+// the binary isn't necessarily aligned, so read through memcpy
+static int32_t get_i32( const unsigned char* p ) {
+  int32_t v;
+  memcpy( &v, p, 4 );
+  return v;
+}
+
+//---------------------------------------------------------
+static int32_t advance( const table_t* t, uint32_t cp ) {
+  size_t lo = 0, hi = t->pair_count;
+
+  if ( cp < DENSE_COUNT ) {return get_i32( t->dense + cp * 4 );}
+
+  while ( lo < hi ) {
+    size_t mid = (lo + hi) / 2;
+    uint32_t mid_cp = (uint32_t)get_i32( t->pairs + mid * 8 );
+    if ( mid_cp == cp ) {return get_i32( t->pairs + mid * 8 + 4 );}
+    if ( mid_cp < cp ) {lo = mid + 1;}
+    else {hi = mid;}
+  }
+  return MISSING;
+}
+
+//---------------------------------------------------------
+// decode one utf8 code point. returns the number of bytes used, or 0 if invalid
+static int utf8_next( const unsigned char* s, size_t size, uint32_t* cp ) {
+  unsigned char c = s[0];
+  int n, i;
+
+  if ( c < 0x80 )               {*cp = c; return 1;}
+  else if ( (c & 0xE0) == 0xC0 ) {*cp = c & 0x1F; n = 2;}
+  else if ( (c & 0xF0) == 0xE0 ) {*cp = c & 0x0F; n = 3;}
+  else if ( (c & 0xF8) == 0xF0 ) {*cp = c & 0x07; n = 4;}
+  else {return 0;}
+
+  if ( (size_t)n > size ) {return 0;}
+  for ( i = 1; i < n; i++ ) {
+    if ( (s[i] & 0xC0) != 0x80 ) {return 0;}
+    *cp = (*cp << 6) | (s[i] & 0x3F);
+  }
+  return n;
+}
+
+//---------------------------------------------------------
+// the width of a whole string, or -1 if it can't be measured
+static int64_t string_width( const table_t* t, const unsigned char* s, size_t size ) {
+  int64_t width = 0;
+  size_t at = 0;
+
+  while ( at < size ) {
+    uint32_t cp;
+    int n = utf8_next( s + at, size - at, &cp );
+    if ( !n ) {return -1;}
+    int32_t adv = advance( t, cp );
+    if ( adv == MISSING ) {return -1;}
+    width += adv;
+    at += n;
+  }
+  return width;
+}
+
+
+//=============================================================================
+// Erlang NIF stuff from here down.
+
+//---------------------------------------------------------
+// args: table, [string]
+// returns a list of widths in font units. :undefined for any that can't be measured
+static ERL_NIF_TERM
+nif_widths(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+  ErlNifBinary  table_bin, str;
+  table_t       t;
+  unsigned int  count, i;
+  ERL_NIF_TERM  list, head, tail;
+  ERL_NIF_TERM* out;
+
+  if ( !get_table(env, argv[0], &table_bin, &t) )         {return enif_make_badarg(env);}
+  if ( !enif_get_list_length(env, argv[1], &count) )      {return enif_make_badarg(env);}
+
+  out = enif_alloc( (count ? count : 1) * sizeof(ERL_NIF_TERM) );
+  if ( !out ) {return enif_make_badarg(env);}
+
+  list = argv[1];
+  for ( i = 0; i < count; i++ ) {
+    enif_get_list_cell( env, list, &head, &tail );
+    list = tail;
+    if ( !enif_inspect_binary(env, head, &str) ) {
+      enif_free( out );
+      return enif_make_badarg(env);
+    }
+    int64_t w = string_width( &t, str.data, str.size );
+    out[i] = w < 0 ? enif_make_atom(env, "undefined") : enif_make_int64(env, w);
+  }
+
+  list = enif_make_list_from_array( env, out, count );
+  enif_free( out );
+  return list;
+}
+
+//---------------------------------------------------------
+// args: table, [string], max_width in font units
+// returns a list with, for each string, a list of its lines as sub binaries.
+// :undefined for any string that can't be measured.
+//
+// Lines break at "\n", and otherwise at the last space that fits. The space at a
+// break is dropped. A word that is wider than a whole line is broken between
+// characters. Every line holds at least one character.
+static ERL_NIF_TERM wrap_one( ErlNifEnv* env, const table_t* t, ERL_NIF_TERM term,
+                              const ErlNifBinary* str, int64_t max_width ) {
+  ERL_NIF_TERM  lines = enif_make_list( env, 0 );
+  ERL_NIF_TERM  rev;
+  size_t        at = 0, start = 0, space = 0;
+  bool          have_space = false;
+  int64_t       width = 0, after_space = 0;
+
+  while ( at < str->size ) {
+    uint32_t cp;
+    int n = utf8_next( str->data + at, str->size - at, &cp );
+    if ( !n ) {return enif_make_atom(env, "undefined");}
+
+    if ( cp == '\n' ) {
+      lines = enif_make_list_cell( env, enif_make_sub_binary(env, term, start, at - start), lines );
+      at += n;
+      start = at;
+      width = 0;
+      have_space = false;
+      continue;
+    }
+
+    int32_t adv = advance( t, cp );
+    if ( adv == MISSING ) {return enif_make_atom(env, "undefined");}
+
+    if ( cp == ' ' && width + adv > max_width && at > start ) {
+      // a space that doesn't fit is where the line breaks
+      lines = enif_make_list_cell( env, enif_make_sub_binary(env, term, start, at - start), lines );
+      at += n;
+      start = at;
+      width = 0;
+      have_space = false;
+      continue;
+    }
+
+    while ( width + adv > max_width && at > start ) {
+      if ( have_space && space > start ) {
+        // break at the last space. what came after it moves to the next line
+        lines = enif_make_list_cell( env, enif_make_sub_binary(env, term, start, space - start), lines );
+        start = space + 1;
+        width = after_space;
+      } else {
+        // no space to break at. break right here
+        lines = enif_make_list_cell( env, enif_make_sub_binary(env, term, start, at - start), lines );
+        start = at;
+        width = 0;
+      }
+      have_space = false;
+    }
+
+    if ( cp == ' ' ) {
+      have_space = true;
+      space = at;
+      after_space = 0;
+    } else if ( have_space ) {
+      after_space += adv;
+    }
+
+    width += adv;
+    at += n;
+  }
+  lines = enif_make_list_cell( env, enif_make_sub_binary(env, term, start, str->size - start), lines );
+
+  enif_make_reverse_list( env, lines, &rev );
+  return rev;
+}
+
+static ERL_NIF_TERM
+nif_wraps(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+  ErlNifBinary  table_bin, str;
+  table_t       t;
+  unsigned int  count, i;
+  ErlNifSInt64  max_width;
+  ERL_NIF_TERM  list, head, tail;
+  ERL_NIF_TERM* out;
+
+  if ( !get_table(env, argv[0], &table_bin, &t) )         {return enif_make_badarg(env);}
+  if ( !enif_get_list_length(env, argv[1], &count) )      {return enif_make_badarg(env);}
+  if ( !enif_get_int64(env, argv[2], &max_width) )        {return enif_make_badarg(env);}
+
+  out = enif_alloc( (count ? count : 1) * sizeof(ERL_NIF_TERM) );
+  if ( !out ) {return enif_make_badarg(env);}
+
+  list = argv[1];
+  for ( i = 0; i < count; i++ ) {
+    enif_get_list_cell( env, list, &head, &tail );
+    list = tail;
+    if ( !enif_inspect_binary(env, head, &str) ) {
+      enif_free( out );
+      return enif_make_badarg(env);
+    }
+    out[i] = wrap_one( env, &t, head, &str, max_width );
+  }
+
+  list = enif_make_list_from_array( env, out, count );
+  enif_free( out );
+  return list;
+}
+
+//=============================================================================
+// erl housekeeping. This is the list of functions available to the erl side
+
+static ErlNifFunc nif_funcs[] = {
+  // {erl_function_name, erl_function_arity, c_function, flags}
+  {"nif_widths", 2, nif_widths, ERL_NIF_DIRTY_JOB_CPU_BOUND},
+  {"nif_wraps", 3, nif_wraps, ERL_NIF_DIRTY_JOB_CPU_BOUND}
+};
+
+ERL_NIF_INIT(Elixir.Scenic.Assets.Static.Font, nif_funcs, NULL, NULL, NULL, NULL)
@@ -0,0 +1,1650 @@
+// Decoders for the compressed images accepted by Scenic.Assets.Stream.Image,
+// and a fast png encoder for bitmaps. No external libraries.
+//
+// PNG  Non-interlaced. All bit depths and color types, palettes and tRNS.
+//      Comes with a small inflate.
+// JPEG Baseline huffman, 8 bit, grayscale or YCbCr with any 1x/2x sampling,
+//      restart markers. Can scale by 1/2, 1/4 or 1/8 while decoding.
+//
+// Both decoders write straight into an rgb or rgba buffer, only for the
+// requested region of interest, and stop reading the compressed stream once
+// the last row of that region is done.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <erl_nif.h>
+
+#define ERR_NONE          0
+#define ERR_INVALID       1
+#define ERR_UNSUPPORTED   2
+#define ERR_MEMORY        3
+
+// the most pixels an image can have. 1GB as rgba
+#define MAX_PIXELS        (1 << 28)
+
+#define TYPE_UNKNOWN      0
+#define TYPE_PNG          1
+#define TYPE_JPEG         2
+
+// what to decode and where to put it
+typedef struct {
+  int             x, y, w, h;   // region of interest, in output pixels
+  int             channels;     // 3 or 4
+  int             scale;        // 1, 2, 4 or 8. jpeg only
+  unsigned char*  out;          // w * h * channels
+} target_t;
+
+
+//=============================================================================
+// utilities
+
+//---------------------------------------------------------
+static uint32_t get_u32_be( const unsigned char* p ) {
+  return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+//---------------------------------------------------------
+static uint32_t get_u16_be( const unsigned char* p ) {
+  return ((uint32_t)p[0] << 8) | (uint32_t)p[1];
+}
+
+//---------------------------------------------------------
+static unsigned char clamp_u8( int v ) {
+  if ( v < 0 ) {return 0;}
+  if ( v > 255 ) {return 255;}
+  return (unsigned char)v;
+}
+
+//---------------------------------------------------------
+static void put_pixel( target_t* t, int x, int y, int r, int g, int b, int a ) {
+  unsigned char* p = t->out + ((size_t)y * t->w + x) * t->channels;
+  p[0] = (unsigned char)r;
+  p[1] = (unsigned char)g;
+  p[2] = (unsigned char)b;
+  if ( t->channels == 4 ) {p[3] = (unsigned char)a;}
+}
+
+
+//=============================================================================
+// inflate. zlib stream in, raw bytes out.
+
+#define MAX_BITS    15
+#define FAST_BITS   9
+
+typedef struct {
+  const unsigned char*  p;
+  const unsigned char*  end;
+  uint32_t              bits;
+  int                   count;
+} zbits_t;
+
+typedef struct {
+  short     count[MAX_BITS + 1];
+  short     symbol[288];
+  uint16_t  fast[1 << FAST_BITS];   // (length << 9) | symbol. 0 if not fast
+} zhuff_t;
+
+static const short len_base[29] = {
+  3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+  35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const short len_extra[29] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+  3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const int dist_base[30] = {
+  1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+  257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const short dist_extra[30] = {
+  0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+  7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+static const unsigned char code_order[19] = {
+  16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+};
+
+//---------------------------------------------------------
+static void zfill( zbits_t* b ) {
+  while ( b->count <= 24 && b->p < b->end ) {
+    b->bits |= (uint32_t)(*b->p++) << b->count;
+    b->count += 8;
+  }
+}
+
+//---------------------------------------------------------
+static bool zget( zbits_t* b, int n, uint32_t* v ) {
+  if ( n == 0 ) {*v = 0; return true;}
+  zfill( b );
+  if ( b->count < n ) {return false;}
+  *v = b->bits & ((1u << n) - 1);
+  b->bits >>= n;
+  b->count -= n;
+  return true;
+}
+
+//---------------------------------------------------------
+static unsigned int reverse_bits( unsigned int code, int len ) {
+  unsigned int r = 0;
+  while ( len-- ) {
+    r = (r << 1) | (code & 1);
+    code >>= 1;
+  }
+  return r;
+}
+
+//---------------------------------------------------------
+// build a canonical huffman decoder from code lengths
+static bool zhuff_build( zhuff_t* h, const unsigned char* lengths, int n ) {
+  short offs[MAX_BITS + 2];
+  int   len, sym, left, i, index;
+  unsigned int code;
+
+  memset( h->count, 0, sizeof(h->count) );
+  memset( h->fast, 0, sizeof(h->fast) );
+  for ( sym = 0; sym < n; sym++ ) {h->count[lengths[sym]]++;}
+
+  // over-subscribed codes are invalid. incomplete ones are allowed
+  left = 1;
+  for ( len = 1; len <= MAX_BITS; len++ ) {
+    left <<= 1;
+    left -= h->count[len];
+    if ( left < 0 ) {return false;}
+  }
+
+  offs[1] = 0;
+  for ( len = 1; len < MAX_BITS; len++ ) {offs[len + 1] = offs[len] + h->count[len];}
+  for ( sym = 0; sym < n; sym++ ) {
+    if ( lengths[sym] ) {h->symbol[offs[lengths[sym]]++] = (short)sym;}
+  }
+
+  // lookup table for the short codes. deflate sends codes lsb first
+  code = 0;
+  index = 0;
+  for ( len = 1; len <= FAST_BITS; len++ ) {
+    for ( i = 0; i < h->count[len]; i++ ) {
+      unsigned int j = reverse_bits( code + i, len );
+      for ( ; j < (1u << FAST_BITS); j += (1u << len) ) {
+        h->fast[j] = (uint16_t)((len << 9) | h->symbol[index]);
+      }
+      index++;
+    }
+    code = (code + h->count[len]) << 1;
+  }
+
+  return true;
+}
+
+//---------------------------------------------------------
+static int zhuff_decode( zbits_t* b, const zhuff_t* h ) {
+  int       len, code, first, index, count;
+  uint16_t  e;
+
+  zfill( b );
+  e = h->fast[b->bits & ((1u << FAST_BITS) - 1)];
+  if ( e && (e >> 9) <= b->count ) {
+    b->bits >>= (e >> 9);
+    b->count -= (e >> 9);
+    return e & 0x1FF;
+  }
+
+  // the long way. one bit at a time
+  code = first = index = 0;
+  for ( len = 1; len <= MAX_BITS; len++ ) {
+    if ( b->count < len ) {return -1;}
+    code |= (b->bits >> (len - 1)) & 1;
+    count = h->count[len];
+    if ( code - count < first ) {
+      b->bits >>= len;
+      b->count -= len;
+      return h->symbol[index + (code - first)];
+    }
+    index += count;
+    first += count;
+    first <<= 1;
+    code <<= 1;
+  }
+  return -1;
+}
+
+//---------------------------------------------------------
+static int inflate_codes( zbits_t* b, const zhuff_t* lit, const zhuff_t* dist,
+                          unsigned char* out, size_t cap, size_t* pos ) {
+  int       sym;
+  uint32_t  extra;
+  size_t    len, d;
+
+  while ( *pos < cap ) {
+    sym = zhuff_decode( b, lit );
+    if ( sym < 0 ) {return ERR_INVALID;}
+
+    if ( sym < 256 ) {
+      out[(*pos)++] = (unsigned char)sym;
+      continue;
+    }
+    if ( sym == 256 ) {return ERR_NONE;}
+
+    sym -= 257;
+    if ( sym >= 29 || !zget(b, len_extra[sym], &extra) ) {return ERR_INVALID;}
+    len = len_base[sym] + extra;
+
+    sym = zhuff_decode( b, dist );
+    if ( sym < 0 || sym >= 30 || !zget(b, dist_extra[sym], &extra) ) {return ERR_INVALID;}
+    d = dist_base[sym] + extra;
+    if ( d > *pos ) {return ERR_INVALID;}
+
+    // may overlap itself. copy forward a byte at a time
+    if ( len > cap - *pos ) {len = cap - *pos;}
+    while ( len-- ) {
+      out[*pos] = out[*pos - d];
+      (*pos)++;
+    }
+  }
+
+  return ERR_NONE;
+}
+
+//---------------------------------------------------------
+static int inflate_dynamic( zbits_t* b, zhuff_t* lit, zhuff_t* dist,
+                            unsigned char* out, size_t cap, size_t* pos ) {
+  unsigned char lengths[320];
+  uint32_t      hlit, hdist, hclen, v, rep;
+  int           i, sym, n;
+  unsigned char fill;
+
+  if ( !zget(b, 5, &hlit) || !zget(b, 5, &hdist) || !zget(b, 4, &hclen) ) {return ERR_INVALID;}
+  hlit += 257;
+  hdist += 1;
+  hclen += 4;
+  if ( hlit > 286 || hdist > 30 ) {return ERR_INVALID;}
+
+  memset( lengths, 0, sizeof(lengths) );
+  for ( i = 0; i < (int)hclen; i++ ) {
+    if ( !zget(b, 3, &v) ) {return ERR_INVALID;}
+    lengths[code_order[i]] = (unsigned char)v;
+  }
+  if ( !zhuff_build(lit, lengths, 19) ) {return ERR_INVALID;}
+
+  // literal/length and distance code lengths, run length encoded
+  n = hlit + hdist;
+  for ( i = 0; i < n; ) {
+    sym = zhuff_decode( b, lit );
+    if ( sym < 0 ) {return ERR_INVALID;}
+
+    if ( sym < 16 ) {
+      lengths[i++] = (unsigned char)sym;
+      continue;
+    }
+
+    if ( sym == 16 ) {
+      if ( i == 0 || !zget(b, 2, &rep) ) {return ERR_INVALID;}
+      fill = lengths[i - 1];
+      rep += 3;
+    } else if ( sym == 17 ) {
+      if ( !zget(b, 3, &rep) ) {return ERR_INVALID;}
+      fill = 0;
+      rep += 3;
+    } else {
+      if ( !zget(b, 7, &rep) ) {return ERR_INVALID;}
+      fill = 0;
+      rep += 11;
+    }
+
+    if ( i + (int)rep > n ) {return ERR_INVALID;}
+    while ( rep-- ) {lengths[i++] = fill;}
+  }
+
+  if ( !zhuff_build(lit, lengths, hlit) ) {return ERR_INVALID;}
+  if ( !zhuff_build(dist, lengths + hlit, hdist) ) {return ERR_INVALID;}
+  return inflate_codes( b, lit, dist, out, cap, pos );
+}
+
+//---------------------------------------------------------
+static int inflate_fixed( zbits_t* b, zhuff_t* lit, zhuff_t* dist,
+                          unsigned char* out, size_t cap, size_t* pos ) {
+  unsigned char lengths[288];
+  int           i;
+
+  for ( i = 0; i < 144; i++ ) {lengths[i] = 8;}
+  for ( ; i < 256; i++ ) {lengths[i] = 9;}
+  for ( ; i < 280; i++ ) {lengths[i] = 7;}
+  for ( ; i < 288; i++ ) {lengths[i] = 8;}
+  zhuff_build( lit, lengths, 288 );
+
+  for ( i = 0; i < 30; i++ ) {lengths[i] = 5;}
+  zhuff_build( dist, lengths, 30 );
+
+  return inflate_codes( b, lit, dist, out, cap, pos );
+}
+
+//---------------------------------------------------------
+static int inflate_stored( zbits_t* b, unsigned char* out, size_t cap, size_t* pos ) {
+  uint32_t len, nlen, v;
+
+  // skip to the byte boundary
+  b->bits >>= (b->count & 7);
+  b->count -= (b->count & 7);
+
+  if ( !zget(b, 16, &len) || !zget(b, 16, &nlen) ) {return ERR_INVALID;}
+  if ( len != (~nlen & 0xFFFF) ) {return ERR_INVALID;}
+
+  while ( len-- && *pos < cap ) {
+    if ( !zget(b, 8, &v) ) {return ERR_INVALID;}
+    out[(*pos)++] = (unsigned char)v;
+  }
+  return ERR_NONE;
+}
+
+//---------------------------------------------------------
+// inflate a zlib stream until it ends or cap bytes are out
+static int inflate_zlib( const unsigned char* data, size_t size, unsigned char* out,
+                         size_t cap, size_t* pos ) {
+  zbits_t   b;
+  zhuff_t*  lit;
+  zhuff_t*  dist;
+  uint32_t  last, type;
+  int       err = ERR_NONE;
+
+  if ( size < 2 ) {return ERR_INVALID;}
+  if ( (data[0] & 0x0F) != 8 || (data[1] & 0x20) ) {return ERR_INVALID;}
+  if ( ((data[0] << 8) | data[1]) % 31 ) {return ERR_INVALID;}
+
+  b.p = data + 2;
+  b.end = data + size;
+  b.bits = 0;
+  b.count = 0;
+
+  lit = enif_alloc( sizeof(zhuff_t) );
+  dist = enif_alloc( sizeof(zhuff_t) );
+  if ( !lit || !dist ) {
+    enif_free( lit );
+    enif_free( dist );
+    return ERR_MEMORY;
+  }
+
+  *pos = 0;
+  do {
+    if ( !zget(&b, 1, &last) || !zget(&b, 2, &type) ) {err = ERR_INVALID; break;}
+    switch ( type ) {
+      case 0:   err = inflate_stored( &b, out, cap, pos );                break;
+      case 1:   err = inflate_fixed( &b, lit, dist, out, cap, pos );      break;
+      case 2:   err = inflate_dynamic( &b, lit, dist, out, cap, pos );    break;
+      default:  err = ERR_INVALID;                                        break;
+    }
+  } while ( err == ERR_NONE && !last && *pos < cap );
+
+  enif_free( lit );
+  enif_free( dist );
+  return err;
+}
+
+
+//=============================================================================
+// PNG
+
+typedef struct {
+  uint32_t              width;
+  uint32_t              height;
+  int                   depth;
+  int                   color;
+  int                   samples;      // per pixel
+  unsigned char         palette[256 * 4];
+  int                   palette_count;
+  bool                  has_key;      // tRNS color key for gray and rgb
+  uint32_t              key[3];
+  size_t                idat_size;
+} png_t;
+
+static const unsigned char png_sig[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+
+#define DEPTHS_LOW        ((1 << 1) | (1 << 2) | (1 << 4))
+#define DEPTHS_HIGH       ((1 << 8) | (1 << 16))
+
+//---------------------------------------------------------
+// walk the chunks. fills in the header. copies the image data to idat if given
+static int png_read( const unsigned char* data, size_t size, png_t* png, unsigned char* idat ) {
+  const unsigned char*  p = data + 8;
+  const unsigned char*  end = data + size;
+  size_t                at = 0;
+  uint32_t              len, i;
+  int                   depths;
+  bool                  have_header = false;
+
+  if ( size < 8 || memcmp(data, png_sig, 8) ) {return ERR_INVALID;}
+  memset( png, 0, sizeof(png_t) );
+
+  while ( end - p >= 12 ) {
+    len = get_u32_be( p );
+    if ( (size_t)(end - p) - 12 < len ) {return ERR_INVALID;}
+
+    if ( !memcmp(p + 4, "IHDR", 4) ) {
+      const unsigned char* h = p + 8;
+      if ( len < 13 ) {return ERR_INVALID;}
+      png->width = get_u32_be( h );
+      png->height = get_u32_be( h + 4 );
+      png->depth = h[8];
+      png->color = h[9];
+      if ( h[10] != 0 || h[11] != 0 ) {return ERR_INVALID;}
+      if ( h[12] != 0 ) {return ERR_UNSUPPORTED;}
+      // the bit depths allowed for each color type, as a mask of 1 << depth.
+      // a palette index is never more than 8 bits
+      switch ( png->color ) {
+        case 0:   png->samples = 1;   depths = DEPTHS_LOW | DEPTHS_HIGH;   break;
+        case 2:   png->samples = 3;   depths = DEPTHS_HIGH;                break;
+        case 3:   png->samples = 1;   depths = DEPTHS_LOW | (1 << 8);      break;
+        case 4:   png->samples = 2;   depths = DEPTHS_HIGH;                break;
+        case 6:   png->samples = 4;   depths = DEPTHS_HIGH;                break;
+        default:  return ERR_INVALID;
+      }
+      if ( png->depth > 16 || !(depths & (1 << png->depth)) ) {return ERR_INVALID;}
+      if ( png->width == 0 || png->height == 0 ) {return ERR_INVALID;}
+      if ( (uint64_t)png->width * png->height > MAX_PIXELS ) {return ERR_UNSUPPORTED;}
+      have_header = true;
+    } else if ( !memcmp(p + 4, "PLTE", 4) ) {
+      png->palette_count = len / 3 > 256 ? 256 : len / 3;
+      for ( i = 0; i < (uint32_t)png->palette_count; i++ ) {
+        png->palette[i * 4] = p[8 + i * 3];
+        png->palette[i * 4 + 1] = p[8 + i * 3 + 1];
+        png->palette[i * 4 + 2] = p[8 + i * 3 + 2];
+        png->palette[i * 4 + 3] = 255;
+      }
+    } else if ( !memcmp(p + 4, "tRNS", 4) ) {
+      if ( png->color == 3 ) {
+        for ( i = 0; i < len && i < 256; i++ ) {png->palette[i * 4 + 3] = p[8 + i];}
+      } else if ( png->color == 0 && len >= 2 ) {
+        png->has_key = true;
+        png->key[0] = get_u16_be( p + 8 );
+      } else if ( png->color == 2 && len >= 6 ) {
+        png->has_key = true;
+        for ( i = 0; i < 3; i++ ) {png->key[i] = get_u16_be( p + 8 + i * 2 );}
+      }
+    } else if ( !memcmp(p + 4, "IDAT", 4) ) {
+      if ( idat ) {memcpy( idat + at, p + 8, len );}
+      at += len;
+    } else if ( !memcmp(p + 4, "IEND", 4) ) {
+      break;
+    }
+
+    p += 12 + len;
+  }
+
+  if ( !have_header || at == 0 ) {return ERR_INVALID;}
+  png->idat_size = at;
+  return ERR_NONE;
+}
+
+//---------------------------------------------------------
+static unsigned char paeth( int a, int b, int c ) {
+  int p = a + b - c;
+  int pa = p > a ? p - a : a - p;
+  int pb = p > b ? p - b : b - p;
+  int pc = p > c ? p - c : c - p;
+  if ( pa <= pb && pa <= pc ) {return (unsigned char)a;}
+  if ( pb <= pc ) {return (unsigned char)b;}
+  return (unsigned char)c;
+}
+
+//---------------------------------------------------------
+// undo the filter on one row in place. prev is the previous unfiltered row
+static bool png_unfilter( unsigned char* row, const unsigned char* prev, size_t stride, int bpp ) {
+  int     filter = row[0];
+  size_t  i;
+
+  row++;
+  prev = prev ? prev + 1 : NULL;
+
+  for ( i = 0; i < stride; i++ ) {
+    int a = i >= (size_t)bpp ? row[i - bpp] : 0;
+    int b = prev ? prev[i] : 0;
+    int c = (prev && i >= (size_t)bpp) ? prev[i - bpp] : 0;
+
+    switch ( filter ) {
+      case 0:   break;
+      case 1:   row[i] += a;                        break;
+      case 2:   row[i] += b;                        break;
+      case 3:   row[i] += (a + b) >> 1;             break;
+      case 4:   row[i] += paeth( a, b, c );         break;
+      default:  return false;
+    }
+  }
+  return true;
+}
+
+//---------------------------------------------------------
+// raw sample n of a row at any bit depth
+static uint32_t png_sample( const unsigned char* row, size_t n, int depth ) {
+  size_t bit;
+  switch ( depth ) {
+    case 8:   return row[n];
+    case 16:  return get_u16_be( row + n * 2 );
+    default:
+      bit = n * depth;
+      return (row[bit >> 3] >> (8 - depth - (bit & 7))) & ((1 << depth) - 1);
+  }
+}
+
+//---------------------------------------------------------
+// scale a raw sample to 8 bits
+static int png_to8( uint32_t v, int depth ) {
+  switch ( depth ) {
+    case 1:   return v * 255;
+    case 2:   return v * 85;
+    case 4:   return v * 17;
+    case 8:   return v;
+    default:  return v >> 8;
+  }
+}
+
+//---------------------------------------------------------
+static void png_put_row( const png_t* png, const unsigned char* row, target_t* t, int ty ) {
+  int       x, r, g, b, a;
+  uint32_t  s0, s1, s2;
+  size_t    n;
+
+  for ( x = 0; x < t->w; x++ ) {
+    n = (size_t)(t->x + x) * png->samples;
+    s0 = png_sample( row, n, png->depth );
+    a = 255;
+
+    switch ( png->color ) {
+      case 0:
+        r = g = b = png_to8( s0, png->depth );
+        if ( png->has_key && s0 == png->key[0] ) {a = 0;}
+        break;
+      case 2:
+        s1 = png_sample( row, n + 1, png->depth );
+        s2 = png_sample( row, n + 2, png->depth );
+        r = png_to8( s0, png->depth );
+        g = png_to8( s1, png->depth );
+        b = png_to8( s2, png->depth );
+        if ( png->has_key && s0 == png->key[0] && s1 == png->key[1] && s2 == png->key[2] ) {
+          a = 0;
+        }
+        break;
+      case 3:
+        // an index past the end of the palette is black
+        if ( s0 >= (uint32_t)png->palette_count ) {
+          r = g = b = 0;
+          break;
+        }
+        r = png->palette[s0 * 4];
+        g = png->palette[s0 * 4 + 1];
+        b = png->palette[s0 * 4 + 2];
+        a = png->palette[s0 * 4 + 3];
+        break;
+      case 4:
+        r = g = b = png_to8( s0, png->depth );
+        a = png_to8( png_sample(row, n + 1, png->depth), png->depth );
+        break;
+      default:
+        r = png_to8( s0, png->depth );
+        g = png_to8( png_sample(row, n + 1, png->depth), png->depth );
+        b = png_to8( png_sample(row, n + 2, png->depth), png->depth );
+        a = png_to8( png_sample(row, n + 3, png->depth), png->depth );
+        break;
+    }
+
+    put_pixel( t, x, ty, r, g, b, a );
+  }
+}
+
+//---------------------------------------------------------
+static int png_info( const unsigned char* data, size_t size, int* w, int* h ) {
+  png_t png;
+  int   err = png_read( data, size, &png, NULL );
+  if ( err ) {return err;}
+  if ( png.width > 0x7FFFFFFF || png.height > 0x7FFFFFFF ) {return ERR_UNSUPPORTED;}
+  *w = png.width;
+  *h = png.height;
+  return ERR_NONE;
+}
+
+//---------------------------------------------------------
+static int png_decode( const unsigned char* data, size_t size, target_t* t ) {
+  png_t           png;
+  unsigned char*  idat = NULL;
+  unsigned char*  raw = NULL;
+  size_t          stride, need, got;
+  int             err, bpp, y;
+
+  if ( t->scale != 1 ) {return ERR_UNSUPPORTED;}
+  if ( (err = png_read(data, size, &png, NULL)) ) {return err;}
+
+  idat = enif_alloc( png.idat_size );
+  if ( !idat ) {return ERR_MEMORY;}
+  png_read( data, size, &png, idat );
+
+  // only inflate as far as the last row of the region
+  stride = ((size_t)png.width * png.samples * png.depth + 7) / 8;
+  bpp = (png.samples * png.depth + 7) / 8;
+  need = (size_t)(t->y + t->h) * (stride + 1);
+
+  raw = enif_alloc( need );
+  if ( !raw ) {
+    enif_free( idat );
+    return ERR_MEMORY;
+  }
+
+  err = inflate_zlib( idat, png.idat_size, raw, need, &got );
+  if ( !err && got < need ) {err = ERR_INVALID;}
+
+  for ( y = 0; !err && y < t->y + t->h; y++ ) {
+    unsigned char* row = raw + (size_t)y * (stride + 1);
+    if ( !png_unfilter(row, y ? row - (stride + 1) : NULL, stride, bpp) ) {err = ERR_INVALID;}
+    else if ( y >= t->y ) {png_put_row( &png, row + 1, t, y - t->y );}
+  }
+
+  enif_free( raw );
+  enif_free( idat );
+  return err;
+}
+
+
+//=============================================================================
+// JPEG
+
+typedef struct {
+  int       mincode[17];
+  int       maxcode[18];
+  int       valptr[17];
+  uint8_t   vals[256];
+  uint16_t  fast[1 << FAST_BITS];   // (length << 8) | value. 0 if not fast
+  bool      defined;
+} jhuff_t;
+
+typedef struct {
+  int       id;
+  int       h, v;         // sampling factors
+  int       tq;           // quantization table
+  int       td, ta;       // dc and ac huffman tables
+  int       pred;         // dc predictor
+  uint8_t*  plane;        // decoded samples, scaled
+  int       pw, ph;       // plane size
+} jcomp_t;
+
+typedef struct {
+  const uint8_t*  p;
+  const uint8_t*  end;
+  uint32_t        acc;    // msb aligned
+  int             n;
+  bool            marker;
+} jbits_t;
+
+typedef struct {
+  uint16_t  quant[4][64];
+  jhuff_t   dc[4];
+  jhuff_t   ac[4];
+  jcomp_t   comp[3];
+  int       ncomp;
+  int       width, height;
+  int       hmax, vmax;
+  int       restart;
+  const uint8_t* scan;    // first byte of entropy coded data
+  int       scan_comp[3];
+  int       scan_ncomp;
+} jpeg_t;
+
+static const uint8_t zigzag[64] = {
+   0,  1,  8, 16,  9,  2,  3, 10, 17, 24, 32, 25, 18, 11,  4,  5,
+  12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13,  6,  7, 14, 21, 28,
+  35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+  58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63
+};
+
+//---------------------------------------------------------
+// false if the code lengths are over-subscribed, which would run the codes
+// of a length past the end of the fast table
+static bool jhuff_build( jhuff_t* h, const uint8_t* counts ) {
+  int code = 0, k = 0, l, i;
+
+  memset( h->fast, 0, sizeof(h->fast) );
+  for ( l = 1; l <= 16; l++ ) {
+    h->valptr[l] = k;
+    h->mincode[l] = code;
+    code += counts[l - 1];
+    k += counts[l - 1];
+    if ( code > (1 << l) ) {return false;}
+    h->maxcode[l] = counts[l - 1] ? code - 1 : -1;
+    code <<= 1;
+  }
+  h->maxcode[17] = 0x7FFFFFFF;
+
+  // lookup table for the short codes. jpeg sends codes msb first
+  for ( l = 1; l <= FAST_BITS; l++ ) {
+    for ( i = h->mincode[l]; i <= h->maxcode[l]; i++ ) {
+      int j, base = i << (FAST_BITS - l);
+      for ( j = 0; j < (1 << (FAST_BITS - l)); j++ ) {
+        h->fast[base + j] = (uint16_t)((l << 8) | h->vals[h->valptr[l] + i - h->mincode[l]]);
+      }
+    }
+  }
+  h->defined = true;
+  return true;
+}
+
+//---------------------------------------------------------
+// fill the bit buffer. past a marker, or the end, it fills with zeros
+static void jfill( jbits_t* b ) {
+  while ( b->n <= 24 ) {
+    uint32_t c = 0;
+    if ( !b->marker && b->p < b->end ) {
+      c = *b->p;
+      if ( c == 0xFF ) {
+        uint8_t next = b->p + 1 < b->end ? b->p[1] : 0xD9;
+        if ( next == 0 ) {
+          b->p += 2;
+        } else {
+          // leave the marker in place for the restart handling
+          b->marker = true;
+          c = 0;
+        }
+      } else {
+        b->p++;
+      }
+    }
+    b->acc |= c << (24 - b->n);
+    b->n += 8;
+  }
+}
+
+//---------------------------------------------------------
+static int jreceive( jbits_t* b, int s ) {
+  int v;
+  if ( s == 0 ) {return 0;}
+  jfill( b );
+  v = (int)(b->acc >> (32 - s));
+  b->acc <<= s;
+  b->n -= s;
+  return v;
+}
+
+//---------------------------------------------------------
+static int jextend( int v, int s ) {
+  return (s && v < (1 << (s - 1))) ? v - (1 << s) + 1 : v;
+}
+
+//---------------------------------------------------------
+static int jdecode( jbits_t* b, const jhuff_t* h ) {
+  uint16_t  e;
+  int       l, code;
+
+  jfill( b );
+  e = h->fast[b->acc >> (32 - FAST_BITS)];
+  if ( e ) {
+    b->acc <<= (e >> 8);
+    b->n -= (e >> 8);
+    return e & 0xFF;
+  }
+
+  for ( l = FAST_BITS + 1; l <= 16; l++ ) {
+    code = (int)(b->acc >> (32 - l));
+    if ( code <= h->maxcode[l] ) {
+      b->acc <<= l;
+      b->n -= l;
+      return h->vals[h->valptr[l] + code - h->mincode[l]];
+    }
+  }
+  return -1;
+}
+
+//---------------------------------------------------------
+// decode one block of coefficients into natural order, dequantized
+static bool jblock( jbits_t* b, jpeg_t* j, jcomp_t* c, int* coef ) {
+  const uint16_t* q = j->quant[c->tq];
+  int             t, k, rs, r, s;
+
+  memset( coef, 0, 64 * sizeof(int) );
+
+  t = jdecode( b, &j->dc[c->td] );
+  if ( t < 0 || t > 11 ) {return false;}
+  c->pred += jextend( jreceive(b, t), t );
+  coef[0] = c->pred * q[0];
+
+  for ( k = 1; k < 64; ) {
+    rs = jdecode( b, &j->ac[c->ta] );
+    if ( rs < 0 ) {return false;}
+    r = rs >> 4;
+    s = rs & 15;
+    if ( s == 0 ) {
+      if ( r != 15 ) {break;}
+      k += 16;
+      continue;
+    }
+    k += r;
+    if ( k > 63 ) {return false;}
+    coef[zigzag[k]] = jextend( jreceive(b, s), s ) * q[k];
+    k++;
+  }
+  return true;
+}
+
+//---------------------------------------------------------
+// cosines[x][u] = c(u) * cos((2x + 1) * u * pi / 16) / 2, where c(0) is 1 / sqrt(2)
+// and c(u) is 1 otherwise
+static const float cosines[8][8] = {
+  { 0.35355339f,  0.49039264f,  0.46193977f,  0.41573481f,
+    0.35355339f,  0.27778512f,  0.19134172f,  0.09754516f},
+  { 0.35355339f,  0.41573481f,  0.19134172f, -0.09754516f,
+   -0.35355339f, -0.49039264f, -0.46193977f, -0.27778512f},
+  { 0.35355339f,  0.27778512f, -0.19134172f, -0.49039264f,
+   -0.35355339f,  0.09754516f,  0.46193977f,  0.41573481f},
+  { 0.35355339f,  0.09754516f, -0.46193977f, -0.27778512f,
+    0.35355339f,  0.41573481f, -0.19134172f, -0.49039264f},
+  { 0.35355339f, -0.09754516f, -0.46193977f,  0.27778512f,
+    0.35355339f, -0.41573481f, -0.19134172f,  0.49039264f},
+  { 0.35355339f, -0.27778512f, -0.19134172f,  0.49039264f,
+   -0.35355339f, -0.09754516f,  0.46193977f, -0.41573481f},
+  { 0.35355339f, -0.41573481f,  0.19134172f,  0.09754516f,
+   -0.35355339f,  0.49039264f, -0.46193977f,  0.27778512f},
+  { 0.35355339f, -0.49039264f,  0.46193977f, -0.41573481f,
+    0.35355339f, -0.27778512f,  0.19134172f, -0.09754516f}
+};
+
+//---------------------------------------------------------
+// inverse dct, then box filter down by scale. writes (8 / scale) square
+static void jidct( const int* coef, uint8_t* dst, int stride, int scale ) {
+  float         tmp[64], px[64];
+  int           x, y, u, bs, i, k;
+
+  if ( scale == 8 ) {
+    // only the dc term matters at 1/8
+    dst[0] = clamp_u8( (int)lroundf(coef[0] / 8.0f) + 128 );
+    return;
+  }
+
+  // rows then columns
+  for ( y = 0; y < 8; y++ ) {
+    for ( x = 0; x < 8; x++ ) {
+      float s = 0.0f;
+      for ( u = 0; u < 8; u++ ) {s += cosines[x][u] * coef[y * 8 + u];}
+      tmp[y * 8 + x] = s;
+    }
+  }
+  for ( x = 0; x < 8; x++ ) {
+    for ( y = 0; y < 8; y++ ) {
+      float s = 0.0f;
+      for ( u = 0; u < 8; u++ ) {s += cosines[y][u] * tmp[u * 8 + x];}
+      px[y * 8 + x] = s + 128.0f;
+    }
+  }
+
+  bs = 8 / scale;
+  for ( y = 0; y < bs; y++ ) {
+    for ( x = 0; x < bs; x++ ) {
+      float s = 0.0f;
+      for ( i = 0; i < scale; i++ ) {
+        for ( k = 0; k < scale; k++ ) {s += px[(y * scale + i) * 8 + x * scale + k];}
+      }
+      dst[y * stride + x] = clamp_u8( (int)lroundf(s / (scale * scale)) );
+    }
+  }
+}
+
+//---------------------------------------------------------
+// read the markers up to the start of the first scan
+static int jpeg_read( const uint8_t* data, size_t size, jpeg_t* j ) {
+  const uint8_t*  p = data + 2;
+  const uint8_t*  end = data + size;
+  bool            have_frame = false;
+  uint32_t        len;
+  int             i, k;
+
+  if ( size < 4 || data[0] != 0xFF || data[1] != 0xD8 ) {return ERR_INVALID;}
+  memset( j, 0, sizeof(jpeg_t) );
+
+  while ( end - p >= 4 ) {
+    uint8_t marker;
+
+    if ( p[0] != 0xFF ) {return ERR_INVALID;}
+    marker = p[1];
+    if ( marker == 0xFF ) {p++; continue;}     // fill byte
+    if ( marker == 0xD8 || (marker >= 0xD0 && marker <= 0xD7) ) {p += 2; continue;}
+    if ( marker == 0xD9 ) {break;}
+
+    len = get_u16_be( p + 2 );
+    if ( len < 2 || (size_t)(end - p) - 2 < len ) {return ERR_INVALID;}
+    {
+      const uint8_t* s = p + 4;
+      const uint8_t* e = p + 2 + len;
+
+      switch ( marker ) {
+        case 0xDB:    // quantization tables
+          while ( s < e ) {
+            int prec = s[0] >> 4, id = s[0] & 3;
+            s++;
+            if ( e - s < (prec ? 128 : 64) ) {return ERR_INVALID;}
+            for ( i = 0; i < 64; i++ ) {
+              j->quant[id][i] = prec ? get_u16_be( s + i * 2 ) : s[i];
+            }
+            s += prec ? 128 : 64;
+          }
+          break;
+
+        case 0xC4:    // huffman tables
+          while ( s < e ) {
+            int       cls = s[0] >> 4, id = s[0] & 3, total = 0;
+            jhuff_t*  h = cls ? &j->ac[id] : &j->dc[id];
+            if ( e - s < 17 ) {return ERR_INVALID;}
+            for ( i = 0; i < 16; i++ ) {total += s[1 + i];}
+            if ( total > 256 || e - s < 17 + total ) {return ERR_INVALID;}
+            memcpy( h->vals, s + 17, total );
+            if ( !jhuff_build(h, s + 1) ) {return ERR_INVALID;}
+            s += 17 + total;
+          }
+          break;
+
+        case 0xC0:    // baseline
+        case 0xC1:    // extended sequential, huffman
+          if ( len < 8 || s[0] != 8 ) {return ERR_UNSUPPORTED;}
+          j->height = get_u16_be( s + 1 );
+          j->width = get_u16_be( s + 3 );
+          j->ncomp = s[5];
+          if ( j->ncomp != 1 && j->ncomp != 3 ) {return ERR_UNSUPPORTED;}
+          if ( j->width == 0 || j->height == 0 ) {return ERR_UNSUPPORTED;}
+          if ( (uint64_t)j->width * j->height > MAX_PIXELS ) {return ERR_UNSUPPORTED;}
+          if ( len < 8 + 3 * (uint32_t)j->ncomp ) {return ERR_INVALID;}
+          j->hmax = j->vmax = 1;
+          for ( i = 0; i < j->ncomp; i++ ) {
+            jcomp_t* c = &j->comp[i];
+            c->id = s[6 + i * 3];
+            c->h = s[7 + i * 3] >> 4;
+            c->v = s[7 + i * 3] & 15;
+            c->tq = s[8 + i * 3] & 3;
+            if ( c->h < 1 || c->h > 2 || c->v < 1 || c->v > 2 ) {return ERR_UNSUPPORTED;}
+            if ( c->h > j->hmax ) {j->hmax = c->h;}
+            if ( c->v > j->vmax ) {j->vmax = c->v;}
+          }
+          // a single component scan is never interleaved
+          if ( j->ncomp == 1 ) {j->comp[0].h = j->comp[0].v = j->hmax = j->vmax = 1;}
+          have_frame = true;
+          break;
+
+        case 0xC2: case 0xC3: case 0xC5: case 0xC6: case 0xC7:
+        case 0xC9: case 0xCA: case 0xCB: case 0xCD: case 0xCE: case 0xCF:
+          // progressive, lossless, hierarchical and arithmetic coding
+          return ERR_UNSUPPORTED;
+
+        case 0xDD:    // restart interval
+          if ( len < 4 ) {return ERR_INVALID;}
+          j->restart = get_u16_be( s );
+          break;
+
+        case 0xDA:    // start of scan
+          if ( !have_frame || len < 6 ) {return ERR_INVALID;}
+          j->scan_ncomp = s[0];
+          if ( j->scan_ncomp != j->ncomp ) {return ERR_UNSUPPORTED;}
+          if ( len < 6 + 2 * (uint32_t)j->scan_ncomp ) {return ERR_INVALID;}
+          for ( i = 0; i < j->scan_ncomp; i++ ) {
+            int id = s[1 + i * 2];
+            for ( k = 0; k < j->ncomp && j->comp[k].id != id; k++ ) {}
+            if ( k == j->ncomp ) {return ERR_INVALID;}
+            j->comp[k].td = s[2 + i * 2] >> 4 & 3;
+            j->comp[k].ta = s[2 + i * 2] & 3;
+            if ( !j->dc[j->comp[k].td].defined || !j->ac[j->comp[k].ta].defined ) {
+              return ERR_INVALID;
+            }
+            j->scan_comp[i] = k;
+          }
+          j->scan = e;
+          return ERR_NONE;
+
+        default:      // app, comment and friends
+          break;
+      }
+    }
+    p += 2 + len;
+  }
+
+  return ERR_INVALID;
+}
+
+//---------------------------------------------------------
+// skip past the next restart marker and reset the decoder state
+static void jrestart( jbits_t* b, jpeg_t* j ) {
+  int i;
+  const uint8_t* p = b->p;
+
+  while ( p + 1 < b->end && !(p[0] == 0xFF && p[1] >= 0xD0 && p[1] <= 0xD7) ) {p++;}
+  b->p = p + 1 < b->end ? p + 2 : b->end;
+  b->acc = 0;
+  b->n = 0;
+  b->marker = false;
+  for ( i = 0; i < j->ncomp; i++ ) {j->comp[i].pred = 0;}
+}
+
+//---------------------------------------------------------
+static int jpeg_info( const uint8_t* data, size_t size, int scale, int* w, int* h ) {
+  jpeg_t* j = enif_alloc( sizeof(jpeg_t) );
+  int     err;
+
+  if ( !j ) {return ERR_MEMORY;}
+  err = jpeg_read( data, size, j );
+  if ( !err ) {
+    *w = (j->width + scale - 1) / scale;
+    *h = (j->height + scale - 1) / scale;
+  }
+  enif_free( j );
+  return err;
+}
+
+//---------------------------------------------------------
+// nearest neighbor upsampling of subsampled components
+static int jsample( const jcomp_t* c, const jpeg_t* j, int x, int y ) {
+  return c->plane[(y * c->v / j->vmax) * c->pw + x * c->h / j->hmax];
+}
+
+//---------------------------------------------------------
+static void jpeg_put( const jpeg_t* j, target_t* t ) {
+  int x, y, ox, oy;
+
+  for ( y = 0; y < t->h; y++ ) {
+    oy = t->y + y;
+    for ( x = 0; x < t->w; x++ ) {
+      int Y, cb, cr;
+      ox = t->x + x;
+
+      Y = jsample( &j->comp[0], j, ox, oy );
+      if ( j->ncomp == 1 ) {
+        put_pixel( t, x, y, Y, Y, Y, 255 );
+        continue;
+      }
+
+      cb = jsample( &j->comp[1], j, ox, oy ) - 128;
+      cr = jsample( &j->comp[2], j, ox, oy ) - 128;
+
+      // fixed point ycbcr to rgb. 16 fractional bits
+      put_pixel( t, x, y,
+        clamp_u8( Y + ((91881 * cr + 32768) >> 16) ),
+        clamp_u8( Y - ((22554 * cb + 46802 * cr - 32768) >> 16) ),
+        clamp_u8( Y + ((116130 * cb + 32768) >> 16) ),
+        255
+      );
+    }
+  }
+}
+
+//---------------------------------------------------------
+static int jpeg_decode( const uint8_t* data, size_t size, target_t* t ) {
+  jpeg_t*   j;
+  jbits_t   b;
+  int       coef[64];
+  int       err, i, mx, my, mcux, mcuy, last_row, col0, col1, bs, count = 0;
+
+  j = enif_alloc( sizeof(jpeg_t) );
+  if ( !j ) {return ERR_MEMORY;}
+  if ( (err = jpeg_read(data, size, j)) ) {
+    enif_free( j );
+    return err;
+  }
+
+  bs = 8 / t->scale;
+  mcux = (j->width + 8 * j->hmax - 1) / (8 * j->hmax);
+  mcuy = (j->height + 8 * j->vmax - 1) / (8 * j->vmax);
+
+  // the mcu rows and columns covering the region of interest
+  last_row = ((t->y + t->h) * t->scale - 1) / (8 * j->vmax);
+  col0 = (t->x * t->scale) / (8 * j->hmax);
+  col1 = ((t->x + t->w) * t->scale - 1) / (8 * j->hmax);
+  if ( last_row >= mcuy ) {last_row = mcuy - 1;}
+
+  for ( i = 0; i < j->ncomp; i++ ) {
+    jcomp_t* c = &j->comp[i];
+    c->pw = mcux * c->h * bs;
+    c->ph = (last_row + 1) * c->v * bs;
+    c->plane = enif_alloc( (size_t)c->pw * c->ph );
+    if ( !c->plane ) {err = ERR_MEMORY;}
+    else {memset( c->plane, 0, (size_t)c->pw * c->ph );}
+  }
+
+  b.p = j->scan;
+  b.end = data + size;
+  b.acc = 0;
+  b.n = 0;
+  b.marker = false;
+
+  for ( my = 0; !err && my <= last_row; my++ ) {
+    for ( mx = 0; !err && mx < mcux; mx++ ) {
+      bool wanted = mx >= col0 && mx <= col1;
+
+      if ( j->restart && count && count % j->restart == 0 ) {jrestart( &b, j );}
+      count++;
+
+      for ( i = 0; !err && i < j->scan_ncomp; i++ ) {
+        jcomp_t*  c = &j->comp[j->scan_comp[i]];
+        int       bx, by;
+        for ( by = 0; !err && by < c->v; by++ ) {
+          for ( bx = 0; !err && bx < c->h; bx++ ) {
+            int px = (mx * c->h + bx) * bs;
+            int py = (my * c->v + by) * bs;
+            if ( !jblock(&b, j, c, coef) ) {err = ERR_INVALID;}
+            else if ( wanted ) {jidct( coef, c->plane + (size_t)py * c->pw + px, c->pw, t->scale );}
+          }
+        }
+      }
+    }
+  }
+
+  if ( !err ) {jpeg_put( j, t );}
+
+  for ( i = 0; i < j->ncomp; i++ ) {enif_free( j->comp[i].plane );}
+  enif_free( j );
+  return err;
+}
+
+
+//=============================================================================
+// PNG encoder. 8 bit gray, gray alpha, rgb or rgba. Each row gets the filter
+// with the smallest sum of absolute differences, then the whole thing goes
+// through a single pass deflate with one hash probe and fixed huffman codes.
+// That trades some size for speed, which is the right call for frames that
+// are sent once and thrown away.
+
+#define ZHASH_BITS        15
+#define ZHASH_SIZE        (1 << ZHASH_BITS)
+#define ZWINDOW           32768
+#define ZMIN_MATCH        4
+#define ZMAX_MATCH        258
+
+typedef struct {
+  unsigned char*  out;
+  size_t          pos;
+  uint32_t        bits;
+  int             count;
+} zout_t;
+
+static const uint16_t zlen_base[29] = {
+  3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+  35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t zlen_extra[29] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+  3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16_t zdist_base[30] = {
+  1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+  257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t zdist_extra[30] = {
+  0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+  7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+//---------------------------------------------------------
+static void zput( zout_t* z, uint32_t value, int count ) {
+  z->bits |= value << z->count;
+  z->count += count;
+  while ( z->count >= 8 ) {
+    z->out[z->pos++] = (unsigned char)z->bits;
+    z->bits >>= 8;
+    z->count -= 8;
+  }
+}
+
+//---------------------------------------------------------
+// huffman codes go out most significant bit first
+static void zput_code( zout_t* z, uint32_t code, int count ) {
+  uint32_t rev = 0;
+  for ( int i = 0; i < count; i++ ) {
+    rev = (rev << 1) | ((code >> i) & 1);
+  }
+  zput( z, rev, count );
+}
+
+//---------------------------------------------------------
+// fixed literal / length codes
+static void zput_symbol( zout_t* z, int sym ) {
+  if ( sym < 144 )        {zput_code( z, 0x30 + sym, 8 );}
+  else if ( sym < 256 )   {zput_code( z, 0x190 + sym - 144, 9 );}
+  else if ( sym < 280 )   {zput_code( z, sym - 256, 7 );}
+  else                    {zput_code( z, 0xC0 + sym - 280, 8 );}
+}
+
+//---------------------------------------------------------
+static void zput_match( zout_t* z, int len, int dist ) {
+  int i = 28;
+  while ( zlen_base[i] > len ) {i--;}
+  zput_symbol( z, 257 + i );
+  zput( z, len - zlen_base[i], zlen_extra[i] );
+
+  i = 29;
+  while ( zdist_base[i] > dist ) {i--;}
+  zput_code( z, i, 5 );
+  zput( z, dist - zdist_base[i], zdist_extra[i] );
+}
+
+//---------------------------------------------------------
+static uint32_t adler32( const unsigned char* data, size_t size ) {
+  uint32_t a = 1, b = 0;
+  while ( size ) {
+    size_t n = size < 5552 ? size : 5552;
+    size -= n;
+    while ( n-- ) {
+      a += *data++;
+      b += a;
+    }
+    a %= 65521;
+    b %= 65521;
+  }
+  return (b << 16) | a;
+}
+
+//---------------------------------------------------------
+// compress into a zlib stream. out must hold at least zlib_bound(size)
+static size_t zlib_bound( size_t size ) {
+  return size + size / 8 + 64;
+}
+
+static size_t deflate_zlib( const unsigned char* in, size_t size, unsigned char* out,
+                            int32_t* head ) {
+  zout_t z = {out, 0, 0, 0};
+  size_t i = 0;
+  uint32_t adler = adler32( in, size );
+
+  // zlib header, fastest compression
+  out[z.pos++] = 0x78;
+  out[z.pos++] = 0x01;
+
+  for ( int n = 0; n < ZHASH_SIZE; n++ ) {head[n] = -1;}
+
+  // one final block of fixed codes
+  zput( &z, 1, 1 );
+  zput( &z, 1, 2 );
+
+  while ( i + ZMIN_MATCH <= size ) {
+    uint32_t v;
+    memcpy( &v, in + i, 4 );
+    uint32_t h = (v * 2654435761u) >> (32 - ZHASH_BITS);
+    int32_t cand = head[h];
+    head[h] = (int32_t)i;
+
+    if ( cand >= 0 && i - cand <= ZWINDOW && !memcmp(in + cand, in + i, ZMIN_MATCH) ) {
+      size_t max = size - i < ZMAX_MATCH ? size - i : ZMAX_MATCH;
+      size_t len = ZMIN_MATCH;
+      while ( len < max && in[cand + len] == in[i + len] ) {len++;}
+      zput_match( &z, (int)len, (int)(i - cand) );
+      i += len;
+    } else {
+      zput_symbol( &z, in[i++] );
+    }
+  }
+  while ( i < size ) {zput_symbol( &z, in[i++] );}
+
+  // end of block, then flush to a byte boundary
+  zput_symbol( &z, 256 );
+  if ( z.count ) {zput( &z, 0, 8 - z.count );}
+
+  out[z.pos++] = adler >> 24;
+  out[z.pos++] = adler >> 16;
+  out[z.pos++] = adler >> 8;
+  out[z.pos++] = adler;
+  return z.pos;
+}
+
+//---------------------------------------------------------
+// the png crc, polynomial 0xEDB88320
+static const uint32_t crc_table[256] = {
+  0x00000000u, 0x77073096u, 0xEE0E612Cu, 0x990951BAu, 0x076DC419u, 0x706AF48Fu,
+  0xE963A535u, 0x9E6495A3u, 0x0EDB8832u, 0x79DCB8A4u, 0xE0D5E91Eu, 0x97D2D988u,
+  0x09B64C2Bu, 0x7EB17CBDu, 0xE7B82D07u, 0x90BF1D91u, 0x1DB71064u, 0x6AB020F2u,
+  0xF3B97148u, 0x84BE41DEu, 0x1ADAD47Du, 0x6DDDE4EBu, 0xF4D4B551u, 0x83D385C7u,
+  0x136C9856u, 0x646BA8C0u, 0xFD62F97Au, 0x8A65C9ECu, 0x14015C4Fu, 0x63066CD9u,
+  0xFA0F3D63u, 0x8D080DF5u, 0x3B6E20C8u, 0x4C69105Eu, 0xD56041E4u, 0xA2677172u,
+  0x3C03E4D1u, 0x4B04D447u, 0xD20D85FDu, 0xA50AB56Bu, 0x35B5A8FAu, 0x42B2986Cu,
+  0xDBBBC9D6u, 0xACBCF940u, 0x32D86CE3u, 0x45DF5C75u, 0xDCD60DCFu, 0xABD13D59u,
+  0x26D930ACu, 0x51DE003Au, 0xC8D75180u, 0xBFD06116u, 0x21B4F4B5u, 0x56B3C423u,
+  0xCFBA9599u, 0xB8BDA50Fu, 0x2802B89Eu, 0x5F058808u, 0xC60CD9B2u, 0xB10BE924u,
+  0x2F6F7C87u, 0x58684C11u, 0xC1611DABu, 0xB6662D3Du, 0x76DC4190u, 0x01DB7106u,
+  0x98D220BCu, 0xEFD5102Au, 0x71B18589u, 0x06B6B51Fu, 0x9FBFE4A5u, 0xE8B8D433u,
+  0x7807C9A2u, 0x0F00F934u, 0x9609A88Eu, 0xE10E9818u, 0x7F6A0DBBu, 0x086D3D2Du,
+  0x91646C97u, 0xE6635C01u, 0x6B6B51F4u, 0x1C6C6162u, 0x856530D8u, 0xF262004Eu,
+  0x6C0695EDu, 0x1B01A57Bu, 0x8208F4C1u, 0xF50FC457u, 0x65B0D9C6u, 0x12B7E950u,
+  0x8BBEB8EAu, 0xFCB9887Cu, 0x62DD1DDFu, 0x15DA2D49u, 0x8CD37CF3u, 0xFBD44C65u,
+  0x4DB26158u, 0x3AB551CEu, 0xA3BC0074u, 0xD4BB30E2u, 0x4ADFA541u, 0x3DD895D7u,
+  0xA4D1C46Du, 0xD3D6F4FBu, 0x4369E96Au, 0x346ED9FCu, 0xAD678846u, 0xDA60B8D0u,
+  0x44042D73u, 0x33031DE5u, 0xAA0A4C5Fu, 0xDD0D7CC9u, 0x5005713Cu, 0x270241AAu,
+  0xBE0B1010u, 0xC90C2086u, 0x5768B525u, 0x206F85B3u, 0xB966D409u, 0xCE61E49Fu,
+  0x5EDEF90Eu, 0x29D9C998u, 0xB0D09822u, 0xC7D7A8B4u, 0x59B33D17u, 0x2EB40D81u,
+  0xB7BD5C3Bu, 0xC0BA6CADu, 0xEDB88320u, 0x9ABFB3B6u, 0x03B6E20Cu, 0x74B1D29Au,
+  0xEAD54739u, 0x9DD277AFu, 0x04DB2615u, 0x73DC1683u, 0xE3630B12u, 0x94643B84u,
+  0x0D6D6A3Eu, 0x7A6A5AA8u, 0xE40ECF0Bu, 0x9309FF9Du, 0x0A00AE27u, 0x7D079EB1u,
+  0xF00F9344u, 0x8708A3D2u, 0x1E01F268u, 0x6906C2FEu, 0xF762575Du, 0x806567CBu,
+  0x196C3671u, 0x6E6B06E7u, 0xFED41B76u, 0x89D32BE0u, 0x10DA7A5Au, 0x67DD4ACCu,
+  0xF9B9DF6Fu, 0x8EBEEFF9u, 0x17B7BE43u, 0x60B08ED5u, 0xD6D6A3E8u, 0xA1D1937Eu,
+  0x38D8C2C4u, 0x4FDFF252u, 0xD1BB67F1u, 0xA6BC5767u, 0x3FB506DDu, 0x48B2364Bu,
+  0xD80D2BDAu, 0xAF0A1B4Cu, 0x36034AF6u, 0x41047A60u, 0xDF60EFC3u, 0xA867DF55u,
+  0x316E8EEFu, 0x4669BE79u, 0xCB61B38Cu, 0xBC66831Au, 0x256FD2A0u, 0x5268E236u,
+  0xCC0C7795u, 0xBB0B4703u, 0x220216B9u, 0x5505262Fu, 0xC5BA3BBEu, 0xB2BD0B28u,
+  0x2BB45A92u, 0x5CB36A04u, 0xC2D7FFA7u, 0xB5D0CF31u, 0x2CD99E8Bu, 0x5BDEAE1Du,
+  0x9B64C2B0u, 0xEC63F226u, 0x756AA39Cu, 0x026D930Au, 0x9C0906A9u, 0xEB0E363Fu,
+  0x72076785u, 0x05005713u, 0x95BF4A82u, 0xE2B87A14u, 0x7BB12BAEu, 0x0CB61B38u,
+  0x92D28E9Bu, 0xE5D5BE0Du, 0x7CDCEFB7u, 0x0BDBDF21u, 0x86D3D2D4u, 0xF1D4E242u,
+  0x68DDB3F8u, 0x1FDA836Eu, 0x81BE16CDu, 0xF6B9265Bu, 0x6FB077E1u, 0x18B74777u,
+  0x88085AE6u, 0xFF0F6A70u, 0x66063BCAu, 0x11010B5Cu, 0x8F659EFFu, 0xF862AE69u,
+  0x616BFFD3u, 0x166CCF45u, 0xA00AE278u, 0xD70DD2EEu, 0x4E048354u, 0x3903B3C2u,
+  0xA7672661u, 0xD06016F7u, 0x4969474Du, 0x3E6E77DBu, 0xAED16A4Au, 0xD9D65ADCu,
+  0x40DF0B66u, 0x37D83BF0u, 0xA9BCAE53u, 0xDEBB9EC5u, 0x47B2CF7Fu, 0x30B5FFE9u,
+  0xBDBDF21Cu, 0xCABAC28Au, 0x53B39330u, 0x24B4A3A6u, 0xBAD03605u, 0xCDD70693u,
+  0x54DE5729u, 0x23D967BFu, 0xB3667A2Eu, 0xC4614AB8u, 0x5D681B02u, 0x2A6F2B94u,
+  0xB40BBE37u, 0xC30C8EA1u, 0x5A05DF1Bu, 0x2D02EF8Du
+};
+
+//---------------------------------------------------------
+static uint32_t crc32( uint32_t crc, const unsigned char* data, size_t size ) {
+  crc = ~crc;
+  while ( size-- ) {crc = crc_table[(crc ^ *data++) & 0xFF] ^ (crc >> 8);}
+  return ~crc;
+}
+
+//---------------------------------------------------------
+static void put_u32_be( unsigned char* p, uint32_t v ) {
+  p[0] = v >> 24;
+  p[1] = v >> 16;
+  p[2] = v >> 8;
+  p[3] = v;
+}
+
+//---------------------------------------------------------
+// write a chunk whose data is already in place at p + 8. returns the chunk size
+static size_t png_chunk( unsigned char* p, const char* type, size_t size ) {
+  put_u32_be( p, (uint32_t)size );
+  memcpy( p + 4, type, 4 );
+  put_u32_be( p + 8 + size, crc32(0, p + 4, size + 4) );
+  return size + 12;
+}
+
+//---------------------------------------------------------
+static unsigned int filter_cost( const unsigned char* row, int n ) {
+  unsigned int sum = 0;
+  for ( int i = 0; i < n; i++ ) {sum += row[i] < 128 ? row[i] : 256 - row[i];}
+  return sum;
+}
+
+//---------------------------------------------------------
+// filter one row of n bytes. prev is NULL on the first row
+static void png_filter( const unsigned char* row, const unsigned char* prev, int n, int bpp,
+                        unsigned char* dst, unsigned char* scratch ) {
+  unsigned int best_cost = 0;
+  int best = -1;
+
+  for ( int f = 0; f < 5; f++ ) {
+    for ( int i = 0; i < n; i++ ) {
+      int a = i >= bpp ? row[i - bpp] : 0;
+      int b = prev ? prev[i] : 0;
+      int c = prev && i >= bpp ? prev[i - bpp] : 0;
+      switch ( f ) {
+        case 0:   scratch[i] = row[i];                          break;
+        case 1:   scratch[i] = row[i] - a;                      break;
+        case 2:   scratch[i] = row[i] - b;                      break;
+        case 3:   scratch[i] = row[i] - ((a + b) >> 1);         break;
+        case 4:   scratch[i] = row[i] - paeth( a, b, c );       break;
+      }
+    }
+    unsigned int cost = filter_cost( scratch, n );
+    if ( best < 0 || cost < best_cost ) {
+      best = f;
+      best_cost = cost;
+      dst[0] = f;
+      memcpy( dst + 1, scratch, n );
+    }
+  }
+}
+
+//---------------------------------------------------------
+// encode a w x h region at x, y out of a bitmap with the given number of
+// channels, whose rows are pitch bytes apart. returns the png size, or 0 if out
+// of memory. *out is allocated with enif_alloc and must be freed by the caller.
+static size_t png_encode( const unsigned char* pixels, size_t pitch, int channels,
+                          int x, int y, int w, int h, unsigned char** out ) {
+  static const unsigned char color_types[5] = {0, 0, 4, 2, 6};
+  size_t stride = (size_t)w * channels;
+  size_t raw_size = (size_t)h * (stride + 1);
+  size_t cap = 8 + 25 + 12 + zlib_bound(raw_size) + 12;
+  unsigned char* raw = enif_alloc( raw_size + stride );
+  int32_t* head = enif_alloc( ZHASH_SIZE * sizeof(int32_t) );
+  unsigned char* png = enif_alloc( cap );
+  size_t pos = 0;
+
+  if ( !raw || !head || !png ) {
+    if ( raw ) {enif_free( raw );}
+    if ( head ) {enif_free( head );}
+    if ( png ) {enif_free( png );}
+    return 0;
+  }
+
+  for ( int row = 0; row < h; row++ ) {
+    const unsigned char* src = pixels + (size_t)(y + row) * pitch + (size_t)x * channels;
+    const unsigned char* prev = row ? src - pitch : NULL;
+    png_filter( src, prev, (int)stride, channels, raw + row * (stride + 1), raw + raw_size );
+  }
+
+  memcpy( png, png_sig, 8 );
+  pos = 8;
+
+  put_u32_be( png + pos + 8, w );
+  put_u32_be( png + pos + 12, h );
+  png[pos + 16] = 8;
+  png[pos + 17] = color_types[channels];
+  png[pos + 18] = 0;
+  png[pos + 19] = 0;
+  png[pos + 20] = 0;
+  pos += png_chunk( png + pos, "IHDR", 13 );
+
+  size_t zsize = deflate_zlib( raw, raw_size, png + pos + 8, head );
+  pos += png_chunk( png + pos, "IDAT", zsize );
+  pos += png_chunk( png + pos, "IEND", 0 );
+
+  enif_free( raw );
+  enif_free( head );
+  *out = png;
+  return pos;
+}
+
+//---------------------------------------------------------
+// the smallest rect containing every pixel that differs between a and b.
+// rows are pitch bytes apart. Any padding after the pixels in a row is ignored.
+// returns false if they are the same
+static bool diff_rect( const unsigned char* a, const unsigned char* b, size_t pitch,
+                       int width, int height, int channels,
+                       int* rx, int* ry, int* rw, int* rh ) {
+  size_t stride = (size_t)width * channels;
+  int top = 0, bottom = height - 1, left = width, right = -1;
+
+  while ( top < height && !memcmp(a + top * pitch, b + top * pitch, stride) ) {top++;}
+  if ( top == height ) {return false;}
+  while ( !memcmp(a + bottom * pitch, b + bottom * pitch, stride) ) {bottom--;}
+
+  for ( int row = top; row <= bottom; row++ ) {
+    const unsigned char* pa = a + row * pitch;
+    const unsigned char* pb = b + row * pitch;
+    int l = 0, r = width - 1;
+    while ( l < left && !memcmp(pa + l * channels, pb + l * channels, channels) ) {l++;}
+    if ( l < left ) {left = l;}
+    while ( r > right && !memcmp(pa + r * channels, pb + r * channels, channels) ) {r--;}
+    if ( r > right ) {right = r;}
+  }
+
+  *rx = left;
+  *ry = top;
+  *rw = right - left + 1;
+  *rh = bottom - top + 1;
+  return true;
+}
+
+
+//=============================================================================
+// Erlang NIF stuff from here down.
+
+//---------------------------------------------------------
+// bitmaps can have padding at the end of each row. The bytes per row are
+// whatever evenly divides the binary between the rows, and must hold the pixels
+static bool get_pitch( const ErlNifBinary* bin, unsigned int width, unsigned int height,
+                       unsigned int channels, size_t* pitch ) {
+  if ( !height ) {*pitch = (size_t)width * channels; return bin->size == 0;}
+  if ( bin->size % height ) {return false;}
+  *pitch = bin->size / height;
+  return *pitch >= (size_t)width * channels;
+}
+
+//---------------------------------------------------------
+static int image_type( const unsigned char* data, size_t size ) {
+  if ( size >= 8 && !memcmp(data, png_sig, 8) ) {return TYPE_PNG;}
+  if ( size >= 3 && data[0] == 0xFF && data[1] == 0xD8 && data[2] == 0xFF ) {return TYPE_JPEG;}
+  return TYPE_UNKNOWN;
+}
+
+//---------------------------------------------------------
+static ERL_NIF_TERM make_error( ErlNifEnv* env, int err ) {
+  const char* reason;
+  switch ( err ) {
+    case ERR_UNSUPPORTED:   reason = "unsupported";   break;
+    case ERR_MEMORY:        reason = "memory";        break;
+    default:                reason = "invalid";       break;
+  }
+  return enif_make_tuple2( env, enif_make_atom(env, "error"), enif_make_atom(env, reason) );
+}
+
+//---------------------------------------------------------
+// args: bin, channels, scale, x, y, w, h
+// a w or h of zero means the rest of the image
+// returns {:ok, {width, height, pixels}} or {:error, reason}
+static ERL_NIF_TERM
+nif_decode(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+  ErlNifBinary  bin;
+  unsigned int  channels, scale, x, y, w, h;
+  int           type, width, height, err;
+  target_t      t;
+  ERL_NIF_TERM  pixels;
+
+  if ( !enif_inspect_binary(env, argv[0], &bin) )   {return enif_make_badarg(env);}
+  if ( !enif_get_uint(env, argv[1], &channels) )    {return enif_make_badarg(env);}
+  if ( !enif_get_uint(env, argv[2], &scale) )       {return enif_make_badarg(env);}
+  if ( !enif_get_uint(env, argv[3], &x) )           {return enif_make_badarg(env);}
+  if ( !enif_get_uint(env, argv[4], &y) )           {return enif_make_badarg(env);}
+  if ( !enif_get_uint(env, argv[5], &w) )           {return enif_make_badarg(env);}
+  if ( !enif_get_uint(env, argv[6], &h) )           {return enif_make_badarg(env);}
+  if ( channels != 3 && channels != 4 )             {return enif_make_badarg(env);}
+  if ( scale != 1 && scale != 2 && scale != 4 && scale != 8 ) {return enif_make_badarg(env);}
+
+  type = image_type( bin.data, bin.size );
+  switch ( type ) {
+    case TYPE_PNG:
+      if ( scale != 1 ) {return make_error( env, ERR_UNSUPPORTED );}
+      err = png_info( bin.data, bin.size, &width, &height );
+      break;
+    case TYPE_JPEG:
+      err = jpeg_info( bin.data, bin.size, scale, &width, &height );
+      break;
+    default:
+      return make_error( env, ERR_INVALID );
+  }
+  if ( err ) {return make_error( env, err );}
+
+  // the region must be inside the image. written so x + w can't overflow
+  if ( x >= (unsigned int)width || y >= (unsigned int)height ) {
+    return enif_make_tuple2( env, enif_make_atom(env, "error"), enif_make_atom(env, "roi") );
+  }
+  if ( w == 0 ) {w = (unsigned int)width - x;}
+  if ( h == 0 ) {h = (unsigned int)height - y;}
+  if ( w > (unsigned int)width - x || h > (unsigned int)height - y ) {
+    return enif_make_tuple2( env, enif_make_atom(env, "error"), enif_make_atom(env, "roi") );
+  }
+
+  t.x = x;
+  t.y = y;
+  t.w = w;
+  t.h = h;
+  t.channels = channels;
+  t.scale = scale;
+  t.out = enif_make_new_binary( env, (size_t)w * h * channels, &pixels );
+  if ( !t.out ) {return make_error( env, ERR_MEMORY );}
+
+  err = type == TYPE_PNG ? png_decode( bin.data, bin.size, &t ) : jpeg_decode( bin.data, bin.size, &t );
+  if ( err ) {return make_error( env, err );}
+
+  return enif_make_tuple2(
+    env,
+    enif_make_atom(env, "ok"),
+    enif_make_tuple3( env, enif_make_uint(env, w), enif_make_uint(env, h), pixels )
+  );
+}
+
+//---------------------------------------------------------
+// args: pixels, width, height, channels, x, y, w, h
+// returns {:ok, png} or {:error, :memory}
+static ERL_NIF_TERM
+nif_encode(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+  ErlNifBinary    bin;
+  unsigned int    width, height, channels, x, y, w, h;
+  unsigned char*  png;
+  unsigned char*  dst;
+  size_t          size, pitch;
+  ERL_NIF_TERM    term;
+
+  if ( !enif_inspect_binary(env, argv[0], &bin) )   {return enif_make_badarg(env);}
+  if ( !enif_get_uint(env, argv[1], &width) )       {return enif_make_badarg(env);}
+  if ( !enif_get_uint(env, argv[2], &height) )      {return enif_make_badarg(env);}
+  if ( !enif_get_uint(env, argv[3], &channels) )    {return enif_make_badarg(env);}
+  if ( !enif_get_uint(env, argv[4], &x) )           {return enif_make_badarg(env);}
+  if ( !enif_get_uint(env, argv[5], &y) )           {return enif_make_badarg(env);}
+  if ( !enif_get_uint(env, argv[6], &w) )           {return enif_make_badarg(env);}
+  if ( !enif_get_uint(env, argv[7], &h) )           {return enif_make_badarg(env);}
+  if ( channels < 1 || channels > 4 )               {return enif_make_badarg(env);}
+  if ( !get_pitch(&bin, width, height, channels, &pitch) ) {return enif_make_badarg(env);}
+  if ( w == 0 || h == 0 || x >= width || y >= height ) {return enif_make_badarg(env);}
+  if ( w > width - x || h > height - y )           {return enif_make_badarg(env);}
+
+  size = png_encode( bin.data, pitch, channels, x, y, w, h, &png );
+  if ( !size ) {return make_error( env, ERR_MEMORY );}
+
+  dst = enif_make_new_binary( env, size, &term );
+  if ( dst ) {memcpy( dst, png, size );}
+  enif_free( png );
+  if ( !dst ) {return make_error( env, ERR_MEMORY );}
+
+  return enif_make_tuple2( env, enif_make_atom(env, "ok"), term );
+}
+
+//---------------------------------------------------------
+// args: pixels, previous, width, height, channels
+// returns {x, y, w, h} of the changed pixels, or :same
+static ERL_NIF_TERM
+nif_diff(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+  ErlNifBinary  a, b;
+  unsigned int  width, height, channels;
+  int           x, y, w, h;
+  size_t        pitch;
+
+  if ( !enif_inspect_binary(env, argv[0], &a) )     {return enif_make_badarg(env);}
+  if ( !enif_inspect_binary(env, argv[1], &b) )     {return enif_make_badarg(env);}
+  if ( !enif_get_uint(env, argv[2], &width) )       {return enif_make_badarg(env);}
+  if ( !enif_get_uint(env, argv[3], &height) )      {return enif_make_badarg(env);}
+  if ( !enif_get_uint(env, argv[4], &channels) )    {return enif_make_badarg(env);}
+  if ( channels < 1 || channels > 4 )               {return enif_make_badarg(env);}
+  if ( !get_pitch(&a, width, height, channels, &pitch) ) {return enif_make_badarg(env);}
+  if ( b.size != a.size )                           {return enif_make_badarg(env);}
+
+  if ( !diff_rect(a.data, b.data, pitch, width, height, channels, &x, &y, &w, &h) ) {
+    return enif_make_atom( env, "same" );
+  }
+  return enif_make_tuple4(
+    env,
+    enif_make_int(env, x),
+    enif_make_int(env, y),
+    enif_make_int(env, w),
+    enif_make_int(env, h)
+  );
+}
+
+//=============================================================================
+// erl housekeeping. This is the list of functions available to the erl side
+
+static ErlNifFunc nif_funcs[] = {
+  // {erl_function_name, erl_function_arity, c_function, flags}
+  {"nif_decode", 7, nif_decode, ERL_NIF_DIRTY_JOB_CPU_BOUND},
+  {"nif_encode", 8, nif_encode, ERL_NIF_DIRTY_JOB_CPU_BOUND},
+  {"nif_diff", 5, nif_diff, ERL_NIF_DIRTY_JOB_CPU_BOUND}
+};
+
+ERL_NIF_INIT(Elixir.Scenic.Assets.Stream.Image, nif_funcs, NULL, NULL, NULL, NULL)
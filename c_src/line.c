@@ -7,6 +7,7 @@
 #include <stdbool.h>
 #include <math.h>
 #include <erl_nif.h>
+#include "line_math.h"
 
 
 
@@ -44,7 +45,7 @@ static ERL_NIF_TERM
 nif_parallel(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
   double x0, y0, x1, y1;
   double w;
-  double x, y, d, t;
+  double out[4];
 
   // get the parameters
   if ( !get_double_num(env, argv[0], &x0) )     {return enif_make_badarg(env);}
@@ -53,30 +54,15 @@ nif_parallel(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
   if ( !get_double_num(env, argv[3], &y1) )     {return enif_make_badarg(env);}
   if ( !get_double_num(env, argv[4], &w) )      {return enif_make_badarg(env);}
 
-  x = x0 - x1;
-  y = y0 - y1;
-
-  d = sqrt( (x * x) + (y * y) );
-
-  x = x / d;
-  y = y / d;
-
-  t = x;
-  x = -y;
-  y = t;
-
-  x0 = x0 + (w * x);
-  y0 = y0 + (w * y);
-  x1 = x1 + (w * x);
-  y1 = y1 + (w * y);
+  line_parallel( x0, y0, x1, y1, w, out );
 
   return enif_make_tuple2( env,
     enif_make_tuple2( env,
-      enif_make_double(env, x0),
-      enif_make_double(env, y0)
+      enif_make_double(env, out[0]),
+      enif_make_double(env, out[1])
     ), enif_make_tuple2( env,
-      enif_make_double(env, x1),
-      enif_make_double(env, y1)
+      enif_make_double(env, out[2]),
+      enif_make_double(env, out[3])
     )
   );
 }
@@ -96,7 +82,6 @@ static ERL_NIF_TERM
 nif_intersection(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
     double x0, y0, x1, y1, x2, y2, x3, y3;
     double x, y;
-    double d, d0, d1;
 
   // get the parameters
   if ( !get_double_num(env, argv[0], &x0) )     {return enif_make_badarg(env);}
@@ -108,11 +93,7 @@ nif_intersection(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
   if ( !get_double_num(env, argv[6], &x3) )     {return enif_make_badarg(env);}
   if ( !get_double_num(env, argv[7], &y3) )     {return enif_make_badarg(env);}
 
-  d = (x0-x1) * (y2-y3) - (y0-y1) * (x2-x3);
-  d0 = x0*y1 - y0*x1;
-  d1 = x2*y3 - y2*x3;
-  x = (d0*(x2-x3) - d1*(x0-x1)) / d;
-  y = (d0*(y2-y3) - d1*(y0-y1)) / d;
+  line_intersection( x0, y0, x1, y1, x2, y2, x3, y3, &x, &y );
 
   return enif_make_tuple2( env,
       enif_make_double(env, x),
@@ -0,0 +1,48 @@
+//
+//  Created by Boyd Multerer on 2017-10-26.
+//  Copyright © 2017 Kry10 Limited. All rights reserved.
+//
+
+// line math kernels. These don't know anything about erlang, so they can be
+// linked into the nif and into the standalone benchmarks.
+
+#include <math.h>
+#include "line_math.h"
+
+//---------------------------------------------------------
+// find a parallel line to the given one, at a specified distance away.
+// out is x0, y0, x1, y1
+void line_parallel( double x0, double y0, double x1, double y1, double w, double out[4] ) {
+  double x, y, d, t;
+
+  x = x0 - x1;
+  y = y0 - y1;
+
+  d = sqrt( (x * x) + (y * y) );
+
+  x = x / d;
+  y = y / d;
+
+  t = x;
+  x = -y;
+  y = t;
+
+  out[0] = x0 + (w * x);
+  out[1] = y0 + (w * y);
+  out[2] = x1 + (w * x);
+  out[3] = y1 + (w * y);
+}
+
+//---------------------------------------------------------
+// find a point that is the intersection of two lines
+void line_intersection( double x0, double y0, double x1, double y1,
+                        double x2, double y2, double x3, double y3,
+                        double* x, double* y ) {
+  double d, d0, d1;
+
+  d = (x0-x1) * (y2-y3) - (y0-y1) * (x2-x3);
+  d0 = x0*y1 - y0*x1;
+  d1 = x2*y3 - y2*x3;
+  *x = (d0*(x2-x3) - d1*(x0-x1)) / d;
+  *y = (d0*(y2-y3) - d1*(y0-y1)) / d;
+}
@@ -0,0 +1,16 @@
+//
+//  Created by Boyd Multerer on 2017-10-26.
+//  Copyright © 2017 Kry10 Limited. All rights reserved.
+//
+
+// line math kernels.
+
+#ifndef SCENIC_LINE_MATH_H
+#define SCENIC_LINE_MATH_H
+
+void line_parallel( double x0, double y0, double x1, double y1, double w, double out[4] );
+void line_intersection( double x0, double y0, double x1, double y1,
+                        double x2, double y2, double x3, double y3,
+                        double* x, double* y );
+
+#endif
@@ -6,9 +6,11 @@
 // native matrix math functions.
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
 #include <math.h>
 #include <erl_nif.h>
+#include "matrix_math.h"
 
 // #include "erl_utils.h"
 
@@ -46,164 +48,6 @@ bool get_float_num(ErlNifEnv *env, ERL_NIF_TERM term, float* f ) {
   return false;
 }
 
-//=============================================================================
-// matrix math
-
-//---------------------------------------------------------
-bool matrix_close(float a[], float b[], double tolerance) {
-  double t = fabs(tolerance);
-  for(int i = 0; i < 16; i++ ) {
-    if (fabs(a[i] - b[i]) > t) {
-      return false;
-    }
-  };
-  return true;
-}
-
-//---------------------------------------------------------
-void matrix_add(float a[], float b[], float c[]) {
-  for(int i = 0; i < 16; i++ ) { c[i] = a[i] + b[i]; };
-}
-
-//---------------------------------------------------------
-void matrix_subtract(float a[], float b[], float c[]) {
-  for(int i = 0; i < 16; i++ ) { c[i] = a[i] - b[i]; };
-}
-
-//---------------------------------------------------------
-void matrix_multiply(float a[], float b[], float c[]) {
-  c[0]  = (a[0]  * b[0]) + (a[1]  * b[4]) + (a[2] * b[8])   + (a[3] * b[12]);
-  c[1]  = (a[0]  * b[1]) + (a[1]  * b[5]) + (a[2] * b[9])   + (a[3] * b[13]);
-  c[2]  = (a[0]  * b[2]) + (a[1]  * b[6]) + (a[2] * b[10])  + (a[3] * b[14]);
-  c[3]  = (a[0]  * b[3]) + (a[1]  * b[7]) + (a[2] * b[11])  + (a[3] * b[15]);
-
-  c[4]  = (a[4]  * b[0]) + (a[5]  * b[4]) + (a[6] * b[8])   + (a[7] * b[12]);
-  c[5]  = (a[4]  * b[1]) + (a[5]  * b[5]) + (a[6] * b[9])   + (a[7] * b[13]);
-  c[6]  = (a[4]  * b[2]) + (a[5]  * b[6]) + (a[6] * b[10])  + (a[7] * b[14]);
-  c[7]  = (a[4]  * b[3]) + (a[5]  * b[7]) + (a[6] * b[11])  + (a[7] * b[15]);
-
-  c[8]  = (a[8]  * b[0]) + (a[9]  * b[4]) + (a[10] * b[8])  + (a[11] * b[12]);
-  c[9]  = (a[8]  * b[1]) + (a[9]  * b[5]) + (a[10] * b[9])  + (a[11] * b[13]);
-  c[10] = (a[8]  * b[2]) + (a[9]  * b[6]) + (a[10] * b[10]) + (a[11] * b[14]);
-  c[11] = (a[8]  * b[3]) + (a[9]  * b[7]) + (a[10] * b[11]) + (a[11] * b[15]);
-
-  c[12] = (a[12] * b[0]) + (a[13] * b[4]) + (a[14] * b[8])  + (a[15] * b[12]);
-  c[13] = (a[12] * b[1]) + (a[13] * b[5]) + (a[14] * b[9])  + (a[15] * b[13]);
-  c[14] = (a[12] * b[2]) + (a[13] * b[6]) + (a[14] * b[10]) + (a[15] * b[14]);
-  c[15] = (a[12] * b[3]) + (a[13] * b[7]) + (a[14] * b[11]) + (a[15] * b[15]);
-}
-
-//---------------------------------------------------------
-void matrix_multiply_scalar(float a[], float s, float c[]) {
-  for(int i = 0; i < 16; i++ ) { c[i] = a[i] * s; };
-}
-
-//---------------------------------------------------------
-void matrix_divide_scalar(float a[], float s, float c[]) {
-  for(int i = 0; i < 16; i++ ) { c[i] = a[i] / s; };
-}
-
-//---------------------------------------------------------
-float matrix_determinant(float a[]) {
-  return (a[0]  * a[5]  * a[10] * a[15]) + (a[0]  * a[9]  * a[14] * a[7])  +
-  (a[0]  * a[13] * a[6]  * a[11]) + (a[4]  * a[1]  * a[14] * a[11]) +
-  (a[4]  * a[9]  * a[2]  * a[15]) + (a[4]  * a[13] * a[10] * a[3])  +
-  (a[8]  * a[1]  * a[6]  * a[15]) + (a[8]  * a[5]  * a[14] * a[3])  +
-  (a[8]  * a[13] * a[2]  * a[7])  + (a[12] * a[1]  * a[10] * a[7])  +
-  (a[12] * a[5]  * a[2]  * a[11]) + (a[12] * a[9]  * a[6]  * a[3])  -
-  (a[0]  * a[5]  * a[14] * a[11]) - (a[0]  * a[9]  * a[6]  * a[15]) -
-  (a[0]  * a[13] * a[10] * a[7])  - (a[4]  * a[1]  * a[10] * a[15]) -
-  (a[4]  * a[9]  * a[14] * a[3])  - (a[4]  * a[13] * a[2]  * a[11]) - 
-  (a[8]  * a[1]  * a[14] * a[7])  - (a[8]  * a[5]  * a[2]  * a[15]) -
-  (a[8]  * a[13] * a[6]  * a[3])  - (a[12] * a[1]  * a[6]  * a[11]) -
-  (a[12] * a[5]  * a[10] * a[3])  - (a[12] * a[9]  * a[2]  * a[7]);
-}
-
-//---------------------------------------------------------
-void matrix_transpose(float a[], float c[]) {
-  c[0] = a[0];
-  c[1] = a[4];
-  c[2] = a[8];
-  c[3] = a[12];
-
-  c[4] = a[1];
-  c[5] = a[5];
-  c[6] = a[9];
-  c[7] = a[13];
-
-  c[8] = a[2];
-  c[9] = a[6];
-  c[10] = a[10];
-  c[11] = a[14];
-
-  c[12] = a[3];
-  c[13] = a[7];
-  c[14] = a[11];
-  c[15] = a[15];
-}
-
-//---------------------------------------------------------
-void matrix_adjugate(float a[], float c[]) {
-//  float b[16];
-
-  c[0]  = (a[5]*a[10]*a[15]) + (a[9]*a[14]*a[7]) + (a[13]*a[6]*a[11]) - (a[5]*a[14]*a[11]) - (a[9]*a[6]*a[15]) - (a[13]*a[10]*a[7]);
-  c[4]  = (a[4]*a[14]*a[11]) + (a[8]*a[6]*a[15]) + (a[12]*a[10]*a[7]) - (a[4]*a[10]*a[15]) - (a[8]*a[14]*a[7]) - (a[12]*a[6]*a[11]);
-  c[8]  = (a[4]*a[9]*a[15])  + (a[8]*a[13]*a[7]) + (a[12]*a[5]*a[11]) - (a[4]*a[13]*a[11]) - (a[8]*a[5]*a[15]) - (a[12]*a[9]*a[7]);
-  c[12] = (a[4]*a[13]*a[10]) + (a[8]*a[5]*a[14]) + (a[12]*a[9]*a[6])  - (a[4]*a[9]*a[14])  - (a[8]*a[13]*a[6]) - (a[12]*a[5]*a[10]);
-
-  c[1]  = (a[1]*a[14]*a[11]) + (a[9]*a[2]*a[15]) + (a[13]*a[10]*a[3]) - (a[1]*a[10]*a[15]) - (a[9]*a[14]*a[3]) - (a[13]*a[2]*a[11]);
-  c[5]  = (a[0]*a[10]*a[15]) + (a[8]*a[14]*a[3]) + (a[12]*a[2]*a[11]) - (a[0]*a[14]*a[11]) - (a[8]*a[2]*a[15]) - (a[12]*a[10]*a[3]);
-  c[9]  = (a[0]*a[13]*a[11]) + (a[8]*a[1]*a[15]) + (a[12]*a[9]*a[3])  - (a[0]*a[9]*a[15])  - (a[8]*a[13]*a[3]) - (a[12]*a[1]*a[11]);
-  c[13] = (a[0]*a[9]*a[14])  + (a[8]*a[13]*a[2]) + (a[12]*a[1]*a[10]) - (a[0]*a[13]*a[10]) - (a[8]*a[1]*a[14]) - (a[12]*a[9]*a[2]);
-
-  c[2]  = (a[1]*a[6]*a[15])  + (a[5]*a[14]*a[3]) + (a[13]*a[2]*a[7])  - (a[1]*a[14]*a[7])  - (a[5]*a[2]*a[15]) - (a[13]*a[6]*a[3]);
-  c[6]  = (a[0]*a[14]*a[7])  + (a[4]*a[2]*a[15]) + (a[12]*a[6]*a[3])  - (a[0]*a[6]*a[15])  - (a[4]*a[14]*a[3]) - (a[12]*a[2]*a[7]);
-  c[10] = (a[0]*a[5]*a[15])  + (a[4]*a[13]*a[3]) + (a[12]*a[1]*a[7])  - (a[0]*a[13]*a[7])  - (a[4]*a[1]*a[15]) - (a[12]*a[5]*a[3]);
-  c[14] = (a[0]*a[13]*a[6])  + (a[4]*a[1]*a[14]) + (a[12]*a[5]*a[2])  - (a[0]*a[5]*a[14])  - (a[4]*a[13]*a[2]) - (a[12]*a[1]*a[6]);
-
-  c[3]  = (a[1]*a[10]*a[7])  + (a[5]*a[2]*a[11]) + (a[9]*a[6]*a[3])   - (a[1]*a[6]*a[11])  - (a[5]*a[10]*a[3]) - (a[9]*a[2]*a[7]);
-  c[7]  = (a[0]*a[6]*a[11])  + (a[4]*a[10]*a[3]) + (a[8]*a[2]*a[7])   - (a[0]*a[10]*a[7])  - (a[4]*a[2]*a[11]) - (a[8]*a[6]*a[3]);
-  c[11] = (a[0]*a[9]*a[7])   + (a[4]*a[1]*a[11]) + (a[8]*a[5]*a[3])   - (a[0]*a[5]*a[11])  - (a[4]*a[9]*a[3])  - (a[8]*a[1]*a[7]);
-  c[15] = (a[0]*a[5]*a[10])  + (a[4]*a[9]*a[2])  + (a[8]*a[1]*a[6])   - (a[0]*a[9]*a[6])   - (a[4]*a[1]*a[10]) - (a[8]*a[5]*a[2]);
-}
-
-//---------------------------------------------------------
-void matrix_project_vector2(float mx[], float* x, float* y) {
-  float mxv[16] = {
-    1.0f, 0.0f, 0.0f, *x,
-    0.0f, 1.0f, 0.0f, *y,
-    0.0f, 0.0f, 1.0f, 0.0f,
-    0.0f, 0.0f, 0.0f, 1.0f
-  };
-  float mx_out[16];
-
-  // do the multiply
-  matrix_multiply(mx, mxv, mx_out);
-
-  // extract the results
-  *x = mx_out[3];
-  *y = mx_out[7];
-}
-
-//---------------------------------------------------------
-void matrix_project_vector3(float mx[], float* x, float* y, float* z) {
-  float mxv[16] = {
-    1.0f, 0.0f, 0.0f, *x,
-    0.0f, 1.0f, 0.0f, *y,
-    0.0f, 0.0f, 1.0f, *z,
-    0.0f, 0.0f, 0.0f, 1.0f
-  };
-  float mx_out[16];
-
-  // do the multiply
-  matrix_multiply(mx, mxv, mx_out);
-
-  // extract the results
-  *x = mx_out[3];
-  *y = mx_out[7];
-  *z = mx_out[11];
-}
-
 //=============================================================================
 // Erlang NIF stuff from here down.
 
@@ -583,6 +427,61 @@ nif_project_vector2s(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
   return result;
 }
 
+//-----------------------------------------------------------------------------
+// project many packed lists of 2d vectors, each by its own matrix, and return
+// the bounds of all the results. Each region in the binary is a matrix, a
+// uint32 vector count, then that many float x,y pairs, all native endian.
+// returns {left, top, right, bottom} or nil if there are no vectors at all.
+static ERL_NIF_TERM
+nif_project_bounds(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+  ErlNifBinary      bin;
+  float             mx[16];
+  float             l = 0, t = 0, r = 0, b = 0;
+  float             x, y;
+  bool              empty = true;
+  uint32_t          count;
+  size_t            at = 0;
+
+  if ( !enif_inspect_binary(env, argv[0], &bin) )        {return enif_make_badarg(env);}
+
+  while ( at < bin.size ) {
+    // the data isn't necessarily aligned. copy the header out
+    if ( bin.size - at < MATRIX_SIZE + sizeof(uint32_t) ) {return enif_make_badarg(env);}
+    memcpy( mx, bin.data + at, MATRIX_SIZE );
+    memcpy( &count, bin.data + at + MATRIX_SIZE, sizeof(uint32_t) );
+    at += MATRIX_SIZE + sizeof(uint32_t);
+    if ( (bin.size - at) / (sizeof(float) * 2) < count ) {return enif_make_badarg(env);}
+
+    for ( uint32_t i = 0; i < count; i++ ) {
+      memcpy( &x, bin.data + at, sizeof(float) );
+      memcpy( &y, bin.data + at + sizeof(float), sizeof(float) );
+      at += sizeof(float) * 2;
+
+      matrix_project_vector2( mx, &x, &y );
+      if ( empty ) {
+        l = r = x;
+        t = b = y;
+        empty = false;
+      } else {
+        if ( x < l ) {l = x;}
+        if ( x > r ) {r = x;}
+        if ( y < t ) {t = y;}
+        if ( y > b ) {b = y;}
+      }
+    }
+  }
+
+  if ( empty ) {return enif_make_atom(env, "nil");}
+
+  return enif_make_tuple4(
+    env,
+    enif_make_double(env, l),
+    enif_make_double(env, t),
+    enif_make_double(env, r),
+    enif_make_double(env, b)
+  );
+}
+
 //=============================================================================
 // erl housekeeping. This is the list of functions available to the erl side
 
@@ -601,6 +500,7 @@ static ErlNifFunc nif_funcs[] = {
   {"nif_adjugate",          1, nif_adjugate,        0},
   {"nif_project_vector2",   3, nif_project_vector2, 0},
   {"nif_project_vector2s",  2, nif_project_vector2s, 0},
+  {"nif_project_bounds",    1, nif_project_bounds,  0},
   // {"nif_project_vector3",   4, nif_project_vector3, 0},
   // {"nif_project_vector3s",  2, nif_project_vector3s, 0},
 };
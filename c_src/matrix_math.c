@@ -0,0 +1,168 @@
+//
+//  Created by Boyd Multerer
+//  Copyright © 2017 Kry10 Limited. All rights reserved.
+//
+
+// matrix math kernels. These don't know anything about erlang, so they can be
+// linked into the nif and into the standalone benchmarks.
+
+#include <math.h>
+#include "matrix_math.h"
+
+//=============================================================================
+// matrix math
+
+//---------------------------------------------------------
+bool matrix_close(float a[], float b[], double tolerance) {
+  double t = fabs(tolerance);
+  for(int i = 0; i < 16; i++ ) {
+    if (fabs(a[i] - b[i]) > t) {
+      return false;
+    }
+  };
+  return true;
+}
+
+//---------------------------------------------------------
+void matrix_add(float a[], float b[], float c[]) {
+  for(int i = 0; i < 16; i++ ) { c[i] = a[i] + b[i]; };
+}
+
+//---------------------------------------------------------
+void matrix_subtract(float a[], float b[], float c[]) {
+  for(int i = 0; i < 16; i++ ) { c[i] = a[i] - b[i]; };
+}
+
+//---------------------------------------------------------
+void matrix_multiply(float a[], float b[], float c[]) {
+  c[0]  = (a[0]  * b[0]) + (a[1]  * b[4]) + (a[2] * b[8])   + (a[3] * b[12]);
+  c[1]  = (a[0]  * b[1]) + (a[1]  * b[5]) + (a[2] * b[9])   + (a[3] * b[13]);
+  c[2]  = (a[0]  * b[2]) + (a[1]  * b[6]) + (a[2] * b[10])  + (a[3] * b[14]);
+  c[3]  = (a[0]  * b[3]) + (a[1]  * b[7]) + (a[2] * b[11])  + (a[3] * b[15]);
+
+  c[4]  = (a[4]  * b[0]) + (a[5]  * b[4]) + (a[6] * b[8])   + (a[7] * b[12]);
+  c[5]  = (a[4]  * b[1]) + (a[5]  * b[5]) + (a[6] * b[9])   + (a[7] * b[13]);
+  c[6]  = (a[4]  * b[2]) + (a[5]  * b[6]) + (a[6] * b[10])  + (a[7] * b[14]);
+  c[7]  = (a[4]  * b[3]) + (a[5]  * b[7]) + (a[6] * b[11])  + (a[7] * b[15]);
+
+  c[8]  = (a[8]  * b[0]) + (a[9]  * b[4]) + (a[10] * b[8])  + (a[11] * b[12]);
+  c[9]  = (a[8]  * b[1]) + (a[9]  * b[5]) + (a[10] * b[9])  + (a[11] * b[13]);
+  c[10] = (a[8]  * b[2]) + (a[9]  * b[6]) + (a[10] * b[10]) + (a[11] * b[14]);
+  c[11] = (a[8]  * b[3]) + (a[9]  * b[7]) + (a[10] * b[11]) + (a[11] * b[15]);
+
+  c[12] = (a[12] * b[0]) + (a[13] * b[4]) + (a[14] * b[8])  + (a[15] * b[12]);
+  c[13] = (a[12] * b[1]) + (a[13] * b[5]) + (a[14] * b[9])  + (a[15] * b[13]);
+  c[14] = (a[12] * b[2]) + (a[13] * b[6]) + (a[14] * b[10]) + (a[15] * b[14]);
+  c[15] = (a[12] * b[3]) + (a[13] * b[7]) + (a[14] * b[11]) + (a[15] * b[15]);
+}
+
+//---------------------------------------------------------
+void matrix_multiply_scalar(float a[], float s, float c[]) {
+  for(int i = 0; i < 16; i++ ) { c[i] = a[i] * s; };
+}
+
+//---------------------------------------------------------
+void matrix_divide_scalar(float a[], float s, float c[]) {
+  for(int i = 0; i < 16; i++ ) { c[i] = a[i] / s; };
+}
+
+//---------------------------------------------------------
+float matrix_determinant(float a[]) {
+  return (a[0]  * a[5]  * a[10] * a[15]) + (a[0]  * a[9]  * a[14] * a[7])  +
+  (a[0]  * a[13] * a[6]  * a[11]) + (a[4]  * a[1]  * a[14] * a[11]) +
+  (a[4]  * a[9]  * a[2]  * a[15]) + (a[4]  * a[13] * a[10] * a[3])  +
+  (a[8]  * a[1]  * a[6]  * a[15]) + (a[8]  * a[5]  * a[14] * a[3])  +
+  (a[8]  * a[13] * a[2]  * a[7])  + (a[12] * a[1]  * a[10] * a[7])  +
+  (a[12] * a[5]  * a[2]  * a[11]) + (a[12] * a[9]  * a[6]  * a[3])  -
+  (a[0]  * a[5]  * a[14] * a[11]) - (a[0]  * a[9]  * a[6]  * a[15]) -
+  (a[0]  * a[13] * a[10] * a[7])  - (a[4]  * a[1]  * a[10] * a[15]) -
+  (a[4]  * a[9]  * a[14] * a[3])  - (a[4]  * a[13] * a[2]  * a[11]) - 
+  (a[8]  * a[1]  * a[14] * a[7])  - (a[8]  * a[5]  * a[2]  * a[15]) -
+  (a[8]  * a[13] * a[6]  * a[3])  - (a[12] * a[1]  * a[6]  * a[11]) -
+  (a[12] * a[5]  * a[10] * a[3])  - (a[12] * a[9]  * a[2]  * a[7]);
+}
+
+//---------------------------------------------------------
+void matrix_transpose(float a[], float c[]) {
+  c[0] = a[0];
+  c[1] = a[4];
+  c[2] = a[8];
+  c[3] = a[12];
+
+  c[4] = a[1];
+  c[5] = a[5];
+  c[6] = a[9];
+  c[7] = a[13];
+
+  c[8] = a[2];
+  c[9] = a[6];
+  c[10] = a[10];
+  c[11] = a[14];
+
+  c[12] = a[3];
+  c[13] = a[7];
+  c[14] = a[11];
+  c[15] = a[15];
+}
+
+//---------------------------------------------------------
+void matrix_adjugate(float a[], float c[]) {
+//  float b[16];
+
+  c[0]  = (a[5]*a[10]*a[15]) + (a[9]*a[14]*a[7]) + (a[13]*a[6]*a[11]) - (a[5]*a[14]*a[11]) - (a[9]*a[6]*a[15]) - (a[13]*a[10]*a[7]);
+  c[4]  = (a[4]*a[14]*a[11]) + (a[8]*a[6]*a[15]) + (a[12]*a[10]*a[7]) - (a[4]*a[10]*a[15]) - (a[8]*a[14]*a[7]) - (a[12]*a[6]*a[11]);
+  c[8]  = (a[4]*a[9]*a[15])  + (a[8]*a[13]*a[7]) + (a[12]*a[5]*a[11]) - (a[4]*a[13]*a[11]) - (a[8]*a[5]*a[15]) - (a[12]*a[9]*a[7]);
+  c[12] = (a[4]*a[13]*a[10]) + (a[8]*a[5]*a[14]) + (a[12]*a[9]*a[6])  - (a[4]*a[9]*a[14])  - (a[8]*a[13]*a[6]) - (a[12]*a[5]*a[10]);
+
+  c[1]  = (a[1]*a[14]*a[11]) + (a[9]*a[2]*a[15]) + (a[13]*a[10]*a[3]) - (a[1]*a[10]*a[15]) - (a[9]*a[14]*a[3]) - (a[13]*a[2]*a[11]);
+  c[5]  = (a[0]*a[10]*a[15]) + (a[8]*a[14]*a[3]) + (a[12]*a[2]*a[11]) - (a[0]*a[14]*a[11]) - (a[8]*a[2]*a[15]) - (a[12]*a[10]*a[3]);
+  c[9]  = (a[0]*a[13]*a[11]) + (a[8]*a[1]*a[15]) + (a[12]*a[9]*a[3])  - (a[0]*a[9]*a[15])  - (a[8]*a[13]*a[3]) - (a[12]*a[1]*a[11]);
+  c[13] = (a[0]*a[9]*a[14])  + (a[8]*a[13]*a[2]) + (a[12]*a[1]*a[10]) - (a[0]*a[13]*a[10]) - (a[8]*a[1]*a[14]) - (a[12]*a[9]*a[2]);
+
+  c[2]  = (a[1]*a[6]*a[15])  + (a[5]*a[14]*a[3]) + (a[13]*a[2]*a[7])  - (a[1]*a[14]*a[7])  - (a[5]*a[2]*a[15]) - (a[13]*a[6]*a[3]);
+  c[6]  = (a[0]*a[14]*a[7])  + (a[4]*a[2]*a[15]) + (a[12]*a[6]*a[3])  - (a[0]*a[6]*a[15])  - (a[4]*a[14]*a[3]) - (a[12]*a[2]*a[7]);
+  c[10] = (a[0]*a[5]*a[15])  + (a[4]*a[13]*a[3]) + (a[12]*a[1]*a[7])  - (a[0]*a[13]*a[7])  - (a[4]*a[1]*a[15]) - (a[12]*a[5]*a[3]);
+  c[14] = (a[0]*a[13]*a[6])  + (a[4]*a[1]*a[14]) + (a[12]*a[5]*a[2])  - (a[0]*a[5]*a[14])  - (a[4]*a[13]*a[2]) - (a[12]*a[1]*a[6]);
+
+  c[3]  = (a[1]*a[10]*a[7])  + (a[5]*a[2]*a[11]) + (a[9]*a[6]*a[3])   - (a[1]*a[6]*a[11])  - (a[5]*a[10]*a[3]) - (a[9]*a[2]*a[7]);
+  c[7]  = (a[0]*a[6]*a[11])  + (a[4]*a[10]*a[3]) + (a[8]*a[2]*a[7])   - (a[0]*a[10]*a[7])  - (a[4]*a[2]*a[11]) - (a[8]*a[6]*a[3]);
+  c[11] = (a[0]*a[9]*a[7])   + (a[4]*a[1]*a[11]) + (a[8]*a[5]*a[3])   - (a[0]*a[5]*a[11])  - (a[4]*a[9]*a[3])  - (a[8]*a[1]*a[7]);
+  c[15] = (a[0]*a[5]*a[10])  + (a[4]*a[9]*a[2])  + (a[8]*a[1]*a[6])   - (a[0]*a[9]*a[6])   - (a[4]*a[1]*a[10]) - (a[8]*a[5]*a[2]);
+}
+
+//---------------------------------------------------------
+void matrix_project_vector2(float mx[], float* x, float* y) {
+  float mxv[16] = {
+    1.0f, 0.0f, 0.0f, *x,
+    0.0f, 1.0f, 0.0f, *y,
+    0.0f, 0.0f, 1.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 1.0f
+  };
+  float mx_out[16];
+
+  // do the multiply
+  matrix_multiply(mx, mxv, mx_out);
+
+  // extract the results
+  *x = mx_out[3];
+  *y = mx_out[7];
+}
+
+//---------------------------------------------------------
+void matrix_project_vector3(float mx[], float* x, float* y, float* z) {
+  float mxv[16] = {
+    1.0f, 0.0f, 0.0f, *x,
+    0.0f, 1.0f, 0.0f, *y,
+    0.0f, 0.0f, 1.0f, *z,
+    0.0f, 0.0f, 0.0f, 1.0f
+  };
+  float mx_out[16];
+
+  // do the multiply
+  matrix_multiply(mx, mxv, mx_out);
+
+  // extract the results
+  *x = mx_out[3];
+  *y = mx_out[7];
+  *z = mx_out[11];
+}
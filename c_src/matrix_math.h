@@ -0,0 +1,25 @@
+//
+//  Created by Boyd Multerer
+//  Copyright © 2017 Kry10 Limited. All rights reserved.
+//
+
+// matrix math kernels. Matrices are 16 floats, row major.
+
+#ifndef SCENIC_MATRIX_MATH_H
+#define SCENIC_MATRIX_MATH_H
+
+#include <stdbool.h>
+
+bool matrix_close(float a[], float b[], double tolerance);
+void matrix_add(float a[], float b[], float c[]);
+void matrix_subtract(float a[], float b[], float c[]);
+void matrix_multiply(float a[], float b[], float c[]);
+void matrix_multiply_scalar(float a[], float s, float c[]);
+void matrix_divide_scalar(float a[], float s, float c[]);
+float matrix_determinant(float a[]);
+void matrix_transpose(float a[], float c[]);
+void matrix_adjugate(float a[], float c[]);
+void matrix_project_vector2(float mx[], float* x, float* y);
+void matrix_project_vector3(float mx[], float* x, float* y, float* z);
+
+#endif
@@ -0,0 +1,143 @@
+// Memory mapped, read-only views of static asset files. The mapping is owned
+// by a resource and handed to erlang as a resource binary, so sub-binaries of
+// it can be passed around without copying and the file is unmapped when the
+// last reference goes away.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <erl_nif.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#define MAX_PATH_LEN      4096
+
+typedef struct {
+  void*   data;
+  size_t  size;
+} mapping_t;
+
+static ErlNifResourceType* mapping_type = NULL;
+
+
+//=============================================================================
+// utilities
+
+//---------------------------------------------------------
+static ERL_NIF_TERM make_error( ErlNifEnv* env, const char* reason ) {
+  return enif_make_tuple2(
+    env,
+    enif_make_atom(env, "error"),
+    enif_make_atom(env, reason)
+  );
+}
+
+//---------------------------------------------------------
+// the same posix atoms that File.read returns
+static const char* posix_reason( int err ) {
+  switch ( err ) {
+    case ENOENT:    return "enoent";
+    case EACCES:    return "eacces";
+    case EISDIR:    return "eisdir";
+    case ENOTDIR:   return "enotdir";
+    case ENOMEM:    return "enomem";
+    case EMFILE:    return "emfile";
+    default:        return "eio";
+  }
+}
+
+//---------------------------------------------------------
+static void mapping_dtor( ErlNifEnv* env, void* obj ) {
+#ifndef _WIN32
+  mapping_t* m = (mapping_t*)obj;
+  if ( m->data ) {munmap( m->data, m->size );}
+#endif
+}
+
+
+//=============================================================================
+// Erlang NIF stuff from here down.
+
+//---------------------------------------------------------
+// args: path
+// returns {:ok, bin} or {:error, posix}
+static ERL_NIF_TERM
+nif_map(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+#ifdef _WIN32
+  return make_error( env, "enotsup" );
+#else
+  ErlNifBinary  path_bin;
+  char          path[MAX_PATH_LEN];
+  struct stat   st;
+  mapping_t*    m;
+  void*         data;
+  int           fd;
+  ERL_NIF_TERM  term;
+
+  if ( !enif_inspect_binary(env, argv[0], &path_bin) )  {return enif_make_badarg(env);}
+  if ( path_bin.size >= MAX_PATH_LEN )                   {return make_error( env, "enametoolong" );}
+  memcpy( path, path_bin.data, path_bin.size );
+  path[path_bin.size] = 0;
+
+  fd = open( path, O_RDONLY );
+  if ( fd < 0 ) {return make_error( env, posix_reason(errno) );}
+
+  if ( fstat(fd, &st) ) {
+    int err = errno;
+    close( fd );
+    return make_error( env, posix_reason(err) );
+  }
+  if ( S_ISDIR(st.st_mode) ) {
+    close( fd );
+    return make_error( env, "eisdir" );
+  }
+
+  // a zero length mapping isn't allowed. an empty binary is the same thing
+  if ( st.st_size == 0 ) {
+    close( fd );
+    enif_make_new_binary( env, 0, &term );
+    return enif_make_tuple2( env, enif_make_atom(env, "ok"), term );
+  }
+
+  data = mmap( NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+  close( fd );
+  if ( data == MAP_FAILED ) {return make_error( env, posix_reason(errno) );}
+
+  m = enif_alloc_resource( mapping_type, sizeof(mapping_t) );
+  if ( !m ) {
+    munmap( data, (size_t)st.st_size );
+    return make_error( env, "enomem" );
+  }
+  m->data = data;
+  m->size = (size_t)st.st_size;
+
+  term = enif_make_resource_binary( env, m, m->data, m->size );
+  enif_release_resource( m );
+
+  return enif_make_tuple2( env, enif_make_atom(env, "ok"), term );
+#endif
+}
+
+//---------------------------------------------------------
+static int load( ErlNifEnv* env, void** priv_data, ERL_NIF_TERM load_info ) {
+  mapping_type = enif_open_resource_type(
+    env, NULL, "scenic_asset_mapping", mapping_dtor, ERL_NIF_RT_CREATE, NULL
+  );
+  return mapping_type ? 0 : 1;
+}
+
+//=============================================================================
+// erl housekeeping. This is the list of functions available to the erl side
+
+static ErlNifFunc nif_funcs[] = {
+  // {erl_function_name, erl_function_arity, c_function, flags}
+  {"nif_map", 1, nif_map, ERL_NIF_DIRTY_JOB_IO_BOUND}
+};
+
+ERL_NIF_INIT(Elixir.Scenic.Assets.Static.Mmap, nif_funcs, load, NULL, NULL, NULL)
@@ -0,0 +1,96 @@
+//
+//  Created by Boyd Multerer on 2021-04-19
+//  Copyright © 2021 Kry10 Limited. All rights reserved.
+//
+
+// pixel kernels. These don't know anything about erlang, so they can be
+// linked into the nif and into the standalone benchmarks.
+
+#include <string.h>
+#include "pixels.h"
+
+//=============================================================================
+// One put and one clear per channel count. CH is a constant in each, so the
+// per channel loops unroll.
+//
+// put writes the pixel at x, y. It must be inside the width of the row, not in
+// the padding, and the whole row must be inside the buffer.
+//
+// clear fills the first row one pixel at a time, then by doubling copies
+// within the row, then copies that row down into the rest. Only whole rows
+// are written, and only the width of each.
+//
+// histogram counts each value of each channel in the region into hist, which
+// is 256 counts per channel. stats finds the min, max and sum of each channel.
+
+#define PIXELS_DEFINE(name, CH)                                                   \
+  bool pixels_put_##name( uint8_t* p, size_t size, size_t width, size_t stride,   \
+                          size_t x, size_t y, const uint8_t* color ) {            \
+    if ( !stride || y >= size / stride ) {return false;}                          \
+    if ( x >= width || x >= stride / CH ) {return false;}                         \
+    p += y * stride + x * CH;                                                     \
+    for ( int c = 0; c < CH; c++ ) {p[c] = color[c];}                             \
+    return true;                                                                  \
+  }                                                                               \
+                                                                                  \
+  void pixels_clear_##name( uint8_t* p, size_t size, size_t width, size_t stride, \
+                            const uint8_t* color ) {                              \
+    size_t rows, row_bytes, filled, n;                                            \
+    if ( !stride ) {return;}                                                      \
+    rows = size / stride;                                                         \
+    row_bytes = width < stride / CH ? width * CH : stride / CH * CH;              \
+    if ( !rows || !row_bytes ) {return;}                                          \
+    for ( int c = 0; c < CH; c++ ) {p[c] = color[c];}                             \
+    for ( filled = CH; filled < row_bytes; filled += n ) {                        \
+      n = filled < row_bytes - filled ? filled : row_bytes - filled;              \
+      memcpy( p + filled, p, n );                                                 \
+    }                                                                             \
+    for ( size_t r = 1; r < rows; r++ ) {memcpy( p + r * stride, p, row_bytes );} \
+  }                                                                               \
+                                                                                  \
+  void pixels_histogram_##name( const uint8_t* p, size_t stride, size_t x,        \
+                                size_t y, size_t w, size_t h, uint64_t* hist ) {  \
+    memset( hist, 0, CH * 256 * sizeof(uint64_t) );                               \
+    for ( size_t r = 0; r < h; r++ ) {                                            \
+      const uint8_t* row = p + (y + r) * stride + x * CH;                         \
+      for ( size_t i = 0; i < w * CH; i += CH ) {                                 \
+        for ( int c = 0; c < CH; c++ ) {hist[c * 256 + row[i + c]]++;}            \
+      }                                                                           \
+    }                                                                             \
+  }                                                                               \
+                                                                                  \
+  void pixels_stats_##name( const uint8_t* p, size_t stride, size_t x, size_t y,  \
+                            size_t w, size_t h, uint8_t* min, uint8_t* max,       \
+                            uint64_t* sum ) {                                     \
+    uint8_t   lo[CH], hi[CH];                                                     \
+    uint64_t  total[CH];                                                          \
+    for ( int c = 0; c < CH; c++ ) {lo[c] = 255; hi[c] = 0; total[c] = 0;}        \
+    for ( size_t r = 0; r < h; r++ ) {                                            \
+      const uint8_t* row = p + (y + r) * stride + x * CH;                         \
+      for ( size_t i = 0; i < w * CH; i += CH ) {                                 \
+        for ( int c = 0; c < CH; c++ ) {                                          \
+          uint8_t v = row[i + c];                                                 \
+          if ( v < lo[c] ) {lo[c] = v;}                                           \
+          if ( v > hi[c] ) {hi[c] = v;}                                           \
+          total[c] += v;                                                          \
+        }                                                                         \
+      }                                                                           \
+    }                                                                             \
+    memcpy( min, lo, CH );                                                        \
+    memcpy( max, hi, CH );                                                        \
+    memcpy( sum, total, sizeof(total) );                                          \
+  }
+
+PIXELS_DEFINE(g, 1)
+PIXELS_DEFINE(ga, 2)
+PIXELS_DEFINE(rgb, 3)
+PIXELS_DEFINE(rgba, 4)
+
+//---------------------------------------------------------
+// copy the region into out, with its rows packed
+void pixels_crop( const uint8_t* p, size_t stride, size_t channels,
+                  size_t x, size_t y, size_t w, size_t h, uint8_t* out ) {
+  size_t row_bytes = w * channels;
+  p += y * stride + x * channels;
+  for ( size_t r = 0; r < h; r++ ) {memcpy( out + r * row_bytes, p + r * stride, row_bytes );}
+}
@@ -0,0 +1,46 @@
+//
+//  Created by Boyd Multerer on 2021-04-19
+//  Copyright © 2021 Kry10 Limited. All rights reserved.
+//
+
+// pixel kernels for 8 bit per channel bitmaps in the g, ga, rgb and rgba
+// formats. There is one set of kernels per channel count, all generated from
+// the same macro in pixels.c.
+//
+// Rows are stride bytes apart. The stride is at least width * channels, and
+// can be more so that every row starts on an aligned boundary. Padding at the
+// end of a row is never written.
+//
+// The put functions return false if the pixel isn't in the buffer. The region
+// functions read a w by h rectangle at x, y, which the caller has checked is
+// inside whole rows of the buffer.
+
+#ifndef SCENIC_PIXELS_H
+#define SCENIC_PIXELS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define PIXELS_DECLARE(name)                                                      \
+  bool pixels_put_##name( uint8_t* p, size_t size, size_t width, size_t stride,   \
+                          size_t x, size_t y, const uint8_t* color );             \
+  void pixels_clear_##name( uint8_t* p, size_t size, size_t width, size_t stride, \
+                            const uint8_t* color );                               \
+  void pixels_histogram_##name( const uint8_t* p, size_t stride, size_t x,        \
+                                size_t y, size_t w, size_t h, uint64_t* hist );   \
+  void pixels_stats_##name( const uint8_t* p, size_t stride, size_t x, size_t y,  \
+                            size_t w, size_t h, uint8_t* min, uint8_t* max,       \
+                            uint64_t* sum );
+
+PIXELS_DECLARE(g)
+PIXELS_DECLARE(ga)
+PIXELS_DECLARE(rgb)
+PIXELS_DECLARE(rgba)
+
+#undef PIXELS_DECLARE
+
+void pixels_crop( const uint8_t* p, size_t stride, size_t channels,
+                  size_t x, size_t y, size_t w, size_t h, uint8_t* out );
+
+#endif
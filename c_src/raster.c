@@ -0,0 +1,464 @@
+// CPU rasterizer for Scenic.Raster. The Elixir side flattens a script into a
+// display list of filled polygons in device space. This file fills those
+// polygons into a band of rows with nonzero winding and anti-aliased edges,
+// then converts the band into one of the bitmap.c pixel layouts.
+//
+// Display list command layout. All values are native endian.
+//   uint32  paint type (0 solid, 1 linear, 2 radial)
+//   float   paint[20]
+//             0..5   inverse transform a, b, c, d, e, f
+//             6..9   linear sx, sy, ex, ey or radial cx, cy, r0, r1
+//             10..13 start color r, g, b, a in 0..1
+//             14..17 end color r, g, b, a in 0..1
+//   float   clip x0, y0, x1, y1
+//   uint32  contour count
+//   per contour
+//     uint32  point count
+//     float   x, y per point
+//
+// Coverage is exact horizontally and sampled at SUB_SAMPLES positions
+// vertically in each pixel row.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <erl_nif.h>
+
+#define SUB_SAMPLES     4
+#define PAINT_FLOATS    20
+
+#define PAINT_SOLID     0
+#define PAINT_LINEAR    1
+#define PAINT_RADIAL    2
+
+typedef struct {
+  float x0, y0, x1, y1;   // y0 < y1
+  int   dir;
+} edge_t;
+
+typedef struct {
+  float x;
+  int   dir;
+} crossing_t;
+
+typedef struct {
+  uint32_t  type;
+  float     p[PAINT_FLOATS];
+} paint_t;
+
+typedef struct {
+  const unsigned char*  p;
+  const unsigned char*  end;
+} reader_t;
+
+typedef struct {
+  int             width;
+  int             y0;       // first row of the band
+  int             y1;       // one past the last row of the band
+  unsigned char*  pixels;   // rgba, (y1 - y0) rows
+  float*          cover;    // one row of coverage
+
+  edge_t*         edges;
+  size_t          edge_count;
+  size_t          edge_cap;
+
+  crossing_t*     xs;
+  size_t          xs_cap;
+} band_t;
+
+
+//=============================================================================
+// utilities
+
+//---------------------------------------------------------
+static bool read_u32( reader_t* r, uint32_t* v ) {
+  if ( r->end - r->p < 4 ) {return false;}
+  memcpy( v, r->p, 4 );
+  r->p += 4;
+  return true;
+}
+
+//---------------------------------------------------------
+static bool read_f32( reader_t* r, float* v ) {
+  if ( r->end - r->p < 4 ) {return false;}
+  memcpy( v, r->p, 4 );
+  r->p += 4;
+  return true;
+}
+
+//---------------------------------------------------------
+static bool push_edge( band_t* b, float x0, float y0, float x1, float y1 ) {
+  edge_t* e;
+
+  // horizontal edges never cross a sample row
+  if ( y0 == y1 ) {return true;}
+
+  if ( b->edge_count == b->edge_cap ) {
+    size_t  cap = b->edge_cap ? b->edge_cap * 2 : 256;
+    edge_t* edges = enif_realloc( b->edges, cap * sizeof(edge_t) );
+    if ( !edges ) {return false;}
+    b->edges = edges;
+    b->edge_cap = cap;
+  }
+
+  e = &b->edges[b->edge_count++];
+  if ( y0 < y1 ) {
+    e->x0 = x0; e->y0 = y0; e->x1 = x1; e->y1 = y1; e->dir = 1;
+  } else {
+    e->x0 = x1; e->y0 = y1; e->x1 = x0; e->y1 = y0; e->dir = -1;
+  }
+  return true;
+}
+
+//---------------------------------------------------------
+static int compare_edges( const void* a, const void* b ) {
+  float ya = ((const edge_t*)a)->y0;
+  float yb = ((const edge_t*)b)->y0;
+  return (ya > yb) - (ya < yb);
+}
+
+//---------------------------------------------------------
+static void sort_crossings( crossing_t* xs, size_t n ) {
+  size_t      i, j;
+  crossing_t  c;
+  // crossing lists are short. insertion sort is fine
+  for ( i = 1; i < n; i++ ) {
+    c = xs[i];
+    j = i;
+    while ( j > 0 && xs[j - 1].x > c.x ) {
+      xs[j] = xs[j - 1];
+      j--;
+    }
+    xs[j] = c;
+  }
+}
+
+//---------------------------------------------------------
+// add the coverage of the span [xa, xb) on one sample row
+static void add_span( float* cover, float xa, float xb, float lo, float hi ) {
+  int   ia, ib, i;
+  const float weight = 1.0f / SUB_SAMPLES;
+
+  if ( xa < lo ) {xa = lo;}
+  if ( xb > hi ) {xb = hi;}
+  if ( xb <= xa ) {return;}
+
+  ia = (int)xa;
+  ib = (int)xb;
+
+  if ( ia == ib ) {
+    cover[ia] += (xb - xa) * weight;
+    return;
+  }
+
+  cover[ia] += ((float)(ia + 1) - xa) * weight;
+  for ( i = ia + 1; i < ib; i++ ) {cover[i] += weight;}
+  if ( xb > (float)ib ) {cover[ib] += (xb - (float)ib) * weight;}
+}
+
+//---------------------------------------------------------
+static float clamp01( float v ) {
+  if ( v < 0.0f ) {return 0.0f;}
+  if ( v > 1.0f ) {return 1.0f;}
+  return v;
+}
+
+//---------------------------------------------------------
+// evaluate the paint at a device pixel center. rgba out in 0..1
+static void paint_at( const paint_t* paint, float x, float y, float* rgba ) {
+  const float*  p = paint->p;
+  float         lx, ly, dx, dy, t, len2;
+  int           i;
+
+  if ( paint->type == PAINT_SOLID ) {
+    for ( i = 0; i < 4; i++ ) {rgba[i] = p[10 + i];}
+    return;
+  }
+
+  // back into the paint's local space
+  lx = p[0] * x + p[2] * y + p[4];
+  ly = p[1] * x + p[3] * y + p[5];
+
+  if ( paint->type == PAINT_LINEAR ) {
+    dx = p[8] - p[6];
+    dy = p[9] - p[7];
+    len2 = dx * dx + dy * dy;
+    t = len2 > 0.0f ? ((lx - p[6]) * dx + (ly - p[7]) * dy) / len2 : 0.0f;
+  } else {
+    dx = lx - p[6];
+    dy = ly - p[7];
+    t = p[9] != p[8] ? (sqrtf(dx * dx + dy * dy) - p[8]) / (p[9] - p[8]) : 0.0f;
+  }
+
+  t = clamp01( t );
+  for ( i = 0; i < 4; i++ ) {rgba[i] = p[10 + i] + (p[14 + i] - p[10 + i]) * t;}
+}
+
+//---------------------------------------------------------
+// source-over blend of a non-premultiplied color into an rgba pixel
+static void blend( unsigned char* px, const float* rgba, float cover ) {
+  float sa = rgba[3] * cover;
+  float da, oa;
+  int   i;
+
+  if ( sa <= 0.0f ) {return;}
+
+  da = px[3] / 255.0f;
+  oa = sa + da * (1.0f - sa);
+
+  for ( i = 0; i < 3; i++ ) {
+    float c = (rgba[i] * sa + (px[i] / 255.0f) * da * (1.0f - sa)) / oa;
+    px[i] = (unsigned char)(clamp01(c) * 255.0f + 0.5f);
+  }
+  px[3] = (unsigned char)(clamp01(oa) * 255.0f + 0.5f);
+}
+
+
+//=============================================================================
+// rasterizing
+
+//---------------------------------------------------------
+// fill the edges collected in the band with the paint, inside the clip
+static bool fill_edges( band_t* b, const paint_t* paint, const float* clip,
+                        float bx0, float by0, float bx1, float by1 ) {
+  float   lo, hi, fy0, fy1;
+  int     row, row0, row1, col0, col1, s, x;
+  size_t  i, n;
+  float   rgba[4];
+
+  // vertical extent. intersect the bounds, the clip and the band
+  fy0 = by0 > clip[1] ? by0 : clip[1];
+  fy1 = by1 < clip[3] ? by1 : clip[3];
+  row0 = (int)floorf( fy0 );
+  row1 = (int)ceilf( fy1 );
+  if ( row0 < b->y0 ) {row0 = b->y0;}
+  if ( row1 > b->y1 ) {row1 = b->y1;}
+  if ( row1 <= row0 ) {return true;}
+
+  // horizontal extent
+  lo = bx0 > clip[0] ? bx0 : clip[0];
+  hi = bx1 < clip[2] ? bx1 : clip[2];
+  if ( lo < 0.0f ) {lo = 0.0f;}
+  if ( hi > (float)b->width ) {hi = (float)b->width;}
+  if ( hi <= lo ) {return true;}
+  col0 = (int)floorf( lo );
+  col1 = (int)ceilf( hi );
+
+  if ( b->xs_cap < b->edge_count ) {
+    crossing_t* xs = enif_realloc( b->xs, b->edge_count * sizeof(crossing_t) );
+    if ( !xs ) {return false;}
+    b->xs = xs;
+    b->xs_cap = b->edge_count;
+  }
+
+  qsort( b->edges, b->edge_count, sizeof(edge_t), compare_edges );
+
+  for ( row = row0; row < row1; row++ ) {
+    memset( b->cover + col0, 0, (col1 - col0) * sizeof(float) );
+
+    for ( s = 0; s < SUB_SAMPLES; s++ ) {
+      float sy = (float)row + ((float)s + 0.5f) / SUB_SAMPLES;
+      int   winding = 0;
+      float xa = 0.0f;
+
+      // gather the crossings. edges are sorted by their top
+      n = 0;
+      for ( i = 0; i < b->edge_count && b->edges[i].y0 <= sy; i++ ) {
+        edge_t* e = &b->edges[i];
+        if ( e->y1 <= sy ) {continue;}
+        b->xs[n].x = e->x0 + (sy - e->y0) * (e->x1 - e->x0) / (e->y1 - e->y0);
+        b->xs[n].dir = e->dir;
+        n++;
+      }
+      sort_crossings( b->xs, n );
+
+      // walk the spans with a nonzero winding
+      for ( i = 0; i < n; i++ ) {
+        int was = winding;
+        winding += b->xs[i].dir;
+        if ( was == 0 && winding != 0 ) {
+          xa = b->xs[i].x;
+        } else if ( was != 0 && winding == 0 ) {
+          add_span( b->cover, xa, b->xs[i].x, lo, hi );
+        }
+      }
+    }
+
+    // blend the row
+    for ( x = col0; x < col1; x++ ) {
+      float c = b->cover[x];
+      if ( c <= 0.0f ) {continue;}
+      paint_at( paint, (float)x + 0.5f, (float)row + 0.5f, rgba );
+      blend( b->pixels + ((size_t)(row - b->y0) * b->width + x) * 4, rgba, c > 1.0f ? 1.0f : c );
+    }
+  }
+
+  return true;
+}
+
+//---------------------------------------------------------
+// returns false if the display list is malformed or memory ran out
+static bool render_band( band_t* b, reader_t* r ) {
+  paint_t   paint;
+  float     clip[4];
+  uint32_t  contours, points, c, i;
+  float     bx0, by0, bx1, by1;
+
+  while ( r->p < r->end ) {
+    if ( !read_u32(r, &paint.type) ) {return false;}
+    for ( i = 0; i < PAINT_FLOATS; i++ ) {
+      if ( !read_f32(r, &paint.p[i]) ) {return false;}
+    }
+    for ( i = 0; i < 4; i++ ) {
+      if ( !read_f32(r, &clip[i]) ) {return false;}
+    }
+    if ( !read_u32(r, &contours) ) {return false;}
+
+    b->edge_count = 0;
+    bx0 = by0 = INFINITY;
+    bx1 = by1 = -INFINITY;
+
+    for ( c = 0; c < contours; c++ ) {
+      float fx = 0.0f, fy = 0.0f, px = 0.0f, py = 0.0f, x, y;
+
+      if ( !read_u32(r, &points) ) {return false;}
+      if ( (size_t)(r->end - r->p) < (size_t)points * 8 ) {return false;}
+
+      for ( i = 0; i < points; i++ ) {
+        read_f32( r, &x );
+        read_f32( r, &y );
+        if ( !isfinite(x) || !isfinite(y) ) {return false;}
+
+        if ( x < bx0 ) {bx0 = x;}
+        if ( x > bx1 ) {bx1 = x;}
+        if ( y < by0 ) {by0 = y;}
+        if ( y > by1 ) {by1 = y;}
+
+        if ( i == 0 ) {
+          fx = x; fy = y;
+        } else if ( !push_edge(b, px, py, x, y) ) {
+          return false;
+        }
+        px = x; py = y;
+      }
+
+      // close the contour
+      if ( points > 1 && !push_edge(b, px, py, fx, fy) ) {return false;}
+    }
+
+    if ( b->edge_count == 0 ) {continue;}
+    if ( by1 <= (float)b->y0 || by0 >= (float)b->y1 ) {continue;}
+    if ( !fill_edges(b, &paint, clip, bx0, by0, bx1, by1) ) {return false;}
+  }
+
+  return true;
+}
+
+//---------------------------------------------------------
+// convert the rgba band into the requested pixel layout. matches bitmap.c
+static void write_band( const band_t* b, unsigned char* out, int bpp ) {
+  size_t                count = (size_t)(b->y1 - b->y0) * b->width;
+  const unsigned char*  px = b->pixels;
+  size_t                i;
+
+  for ( i = 0; i < count; i++, px += 4 ) {
+    unsigned char g = (unsigned char)((px[0] * 77 + px[1] * 150 + px[2] * 29) >> 8);
+    switch ( bpp ) {
+      case 1:
+        *out++ = g;
+        break;
+      case 2:
+        *out++ = g;
+        *out++ = px[3];
+        break;
+      case 3:
+        *out++ = px[0];
+        *out++ = px[1];
+        *out++ = px[2];
+        break;
+      default:
+        *out++ = px[0];
+        *out++ = px[1];
+        *out++ = px[2];
+        *out++ = px[3];
+        break;
+    }
+  }
+}
+
+
+//=============================================================================
+// Erlang NIF stuff from here down.
+
+//---------------------------------------------------------
+// render rows [y0, y1) of the display list
+// args: display_list, width, height, bytes_per_pixel, y0, y1, clear_rgba
+// returns the band as a binary in the requested layout
+static ERL_NIF_TERM
+nif_render(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+  ErlNifBinary    dl;
+  ErlNifBinary    clear;
+  unsigned int    width, height, bpp, y0, y1;
+  band_t          band;
+  reader_t        reader;
+  ERL_NIF_TERM    term;
+  unsigned char*  out;
+  size_t          count, i;
+  bool            ok;
+
+  if ( !enif_inspect_binary(env, argv[0], &dl) )    {return enif_make_badarg(env);}
+  if ( !enif_get_uint(env, argv[1], &width) )       {return enif_make_badarg(env);}
+  if ( !enif_get_uint(env, argv[2], &height) )      {return enif_make_badarg(env);}
+  if ( !enif_get_uint(env, argv[3], &bpp) )         {return enif_make_badarg(env);}
+  if ( !enif_get_uint(env, argv[4], &y0) )          {return enif_make_badarg(env);}
+  if ( !enif_get_uint(env, argv[5], &y1) )          {return enif_make_badarg(env);}
+  if ( !enif_inspect_binary(env, argv[6], &clear) ) {return enif_make_badarg(env);}
+  if ( bpp < 1 || bpp > 4 || clear.size != 4 )      {return enif_make_badarg(env);}
+  if ( width == 0 || y1 > height || y0 > y1 )       {return enif_make_badarg(env);}
+
+  memset( &band, 0, sizeof(band_t) );
+  band.width = width;
+  band.y0 = y0;
+  band.y1 = y1;
+
+  count = (size_t)(y1 - y0) * width;
+  band.pixels = enif_alloc( count * 4 + 4 );
+  band.cover = enif_alloc( (width + 1) * sizeof(float) );
+  if ( !band.pixels || !band.cover ) {
+    enif_free( band.pixels );
+    enif_free( band.cover );
+    return enif_make_badarg(env);
+  }
+
+  // start from the clear color
+  for ( i = 0; i < count; i++ ) {memcpy( band.pixels + i * 4, clear.data, 4 );}
+
+  reader.p = dl.data;
+  reader.end = dl.data + dl.size;
+  ok = render_band( &band, &reader );
+
+  if ( ok ) {
+    out = enif_make_new_binary( env, count * bpp, &term );
+    write_band( &band, out, bpp );
+  }
+
+  enif_free( band.pixels );
+  enif_free( band.cover );
+  enif_free( band.edges );
+  enif_free( band.xs );
+
+  if ( !ok ) {return enif_make_badarg(env);}
+  return term;
+}
+
+//=============================================================================
+// erl housekeeping. This is the list of functions available to the erl side
+
+static ErlNifFunc nif_funcs[] = {
+  // {erl_function_name, erl_function_arity, c_function, flags}
+  {"nif_render", 7, nif_render, ERL_NIF_DIRTY_JOB_CPU_BOUND}
+};
+
+ERL_NIF_INIT(Elixir.Scenic.Raster, nif_funcs, NULL, NULL, NULL, NULL)
@@ -0,0 +1,74 @@
+// Validation of packed sprite draw commands. Each command is nine
+// big-endian float32 values. sx, sy, sw, sh, dx, dy, dw, dh, alpha.
+// This is the same layout the commands have in a serialized script.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <erl_nif.h>
+
+#define FLOATS_PER_CMD    9
+#define BYTES_PER_CMD     (FLOATS_PER_CMD * 4)
+
+
+//=============================================================================
+// utilities
+
+//---------------------------------------------------------
+// read a big-endian float32 out of the buffer
+static float get_float_be( const unsigned char* p ) {
+  uint32_t  u;
+  float     f;
+  u = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+  memcpy( &f, &u, sizeof(float) );
+  return f;
+}
+
+//---------------------------------------------------------
+static ERL_NIF_TERM make_error( ErlNifEnv* env, const char* reason ) {
+  return enif_make_tuple2(
+    env,
+    enif_make_atom(env, "error"),
+    enif_make_atom(env, reason)
+  );
+}
+
+
+//=============================================================================
+// Erlang NIF stuff from here down.
+
+//---------------------------------------------------------
+// returns {:ok, count} if the binary holds whole commands of finite
+// floats, otherwise {:error, :length} or {:error, :nan}
+static ERL_NIF_TERM
+nif_validate(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+  ErlNifBinary  bin;
+  size_t        count;
+  size_t        i;
+
+  if ( !enif_inspect_binary(env, argv[0], &bin) ) {return enif_make_badarg(env);}
+
+  if ( bin.size % BYTES_PER_CMD ) {return make_error(env, "length");}
+  count = bin.size / BYTES_PER_CMD;
+
+  for ( i = 0; i < count * FLOATS_PER_CMD; i++ ) {
+    if ( !isfinite(get_float_be(bin.data + i * 4)) ) {return make_error(env, "nan");}
+  }
+
+  return enif_make_tuple2(
+    env,
+    enif_make_atom(env, "ok"),
+    enif_make_uint64(env, count)
+  );
+}
+
+//=============================================================================
+// erl housekeeping. This is the list of functions available to the erl side
+
+static ErlNifFunc nif_funcs[] = {
+  // {erl_function_name, erl_function_arity, c_function, flags}
+  {"nif_validate", 1, nif_validate, 0}
+};
+
+ERL_NIF_INIT(Elixir.Scenic.Primitive.Sprites, nif_funcs, NULL, NULL, NULL, NULL)
@@ -0,0 +1,41 @@
+// Batched easing and interpolation for Scenic.Graph.Animation. A whole frame
+// of animated values goes through in one call.
+
+#include <erl_nif.h>
+#include "tween_math.h"
+
+
+//=============================================================================
+// Erlang NIF stuff from here down.
+
+//-----------------------------------------------------------------------------
+// records is a binary of native doubles, {easing, t, from, to} per value.
+// returns a binary with one native double per record.
+static ERL_NIF_TERM
+nif_tween(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+  ErlNifBinary  records;
+  ErlNifBinary  out;
+  size_t        n;
+
+  // get the parameters
+  if ( !enif_inspect_binary(env, argv[0], &records) )  {return enif_make_badarg(env);}
+  if ( records.size % (TWEEN_RECORD * sizeof(double)) ) {return enif_make_badarg(env);}
+  n = records.size / (TWEEN_RECORD * sizeof(double));
+
+  if ( !enif_alloc_binary(n * sizeof(double), &out) )  {return enif_make_badarg(env);}
+  tween_batch( records.data, n, (double*)out.data );
+
+  return enif_make_binary( env, &out );
+}
+
+
+//=============================================================================
+// erl housekeeping. This is the list of functions available to the erl side
+
+static ErlNifFunc nif_funcs[] = {
+  // {erl_function_name, erl_function_arity, c_function, flags}
+  {"nif_tween",             1, nif_tween,         0}
+};
+
+
+ERL_NIF_INIT(Elixir.Scenic.Graph.Animation, nif_funcs, NULL, NULL, NULL, NULL)
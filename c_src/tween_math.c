@@ -0,0 +1,45 @@
+// tween kernels. These don't know anything about erlang, so they can be
+// linked into the nif and into the standalone benchmarks.
+
+#include <string.h>
+#include "tween_math.h"
+
+//---------------------------------------------------------
+// the eased progress at t, which is clamped to 0..1. An unknown easing is linear.
+double tween_ease( int easing, double t ) {
+  double u;
+
+  if ( !(t > 0.0) ) {return 0.0;}
+  if ( t >= 1.0 ) {return 1.0;}
+
+  switch( easing ) {
+    case TWEEN_EASE_IN:
+      return t * t * t;
+    case TWEEN_EASE_OUT:
+      u = 1.0 - t;
+      return 1.0 - u * u * u;
+    case TWEEN_EASE_IN_OUT:
+      if ( t < 0.5 ) {return 4.0 * t * t * t;}
+      u = 2.0 - 2.0 * t;
+      return 1.0 - u * u * u / 2.0;
+    case TWEEN_EASE_OUT_BACK:
+      // overshoots by about 10% before settling
+      u = t - 1.0;
+      return 1.0 + 2.70158 * u * u * u + 1.70158 * u * u;
+    default:
+      return t;
+  }
+}
+
+//---------------------------------------------------------
+// interpolate n records of {easing, t, from, to} into out. The records are
+// copied out one at a time, so they don't need to be aligned.
+void tween_batch( const void* records, size_t n, double* out ) {
+  const unsigned char*  p = records;
+  double                r[TWEEN_RECORD];
+
+  for ( size_t i = 0; i < n; i++ ) {
+    memcpy( r, p + i * sizeof(r), sizeof(r) );
+    out[i] = r[2] + (r[3] - r[2]) * tween_ease( (int)r[0], r[1] );
+  }
+}
@@ -0,0 +1,22 @@
+// tween kernels. The easings are numbered in the same order as the
+// @easings list in Scenic.Graph.Animation.
+
+#ifndef SCENIC_TWEEN_MATH_H
+#define SCENIC_TWEEN_MATH_H
+
+#include <stddef.h>
+
+#define TWEEN_LINEAR          0
+#define TWEEN_EASE_IN         1
+#define TWEEN_EASE_OUT        2
+#define TWEEN_EASE_IN_OUT     3
+#define TWEEN_EASE_OUT_BACK   4
+#define TWEEN_EASINGS         5
+
+// each record is {easing, t, from, to}
+#define TWEEN_RECORD          4
+
+double tween_ease( int easing, double t );
+void tween_batch( const void* records, size_t n, double* out );
+
+#endif
@@ -80,6 +80,7 @@ defmodule Scenic do
     [
       Scenic.PubSub,
       Scenic.Assets.Stream,
+      Scenic.Assets.Static.Font.Cache,
       {DynamicSupervisor, name: @viewports, strategy: :one_for_one}
     ]
     |> Supervisor.init(strategy: :one_for_one)
@@ -111,6 +111,35 @@ defmodule Scenic.Assets.Static do
     module: MyApplication.Assets
   ```
 
+  ### Atlases
+
+  A UI with many small images, such as icons, makes the driver switch textures for
+  each one it draws. The optional `:atlases` config packs selected images together
+  into a single image when your assets module is compiled.
+
+  ```elixir
+  defmodule MyApplication.Assets do
+    use Scenic.Assets.Static,
+      otp_app: :my_application,
+      atlases: [
+        icons: ["images/icons/*.png", {:some_dep, "images/flags/*.png"}]
+      ]
+  end
+  ```
+
+  Each atlas is a name and a list of wildcard patterns, relative to your asset
+  sources. The atlas itself is added to the library as `{:atlas, "icons"}`, and the
+  position of each image in it is recorded and can be fetched with `region/2`.
+  An atlas is at most 4096 pixels on a side, which is as large a texture as the
+  drivers can count on. If the images don't fit, compiling the assets raises and
+  they need to be split into more than one atlas.
+
+  The images are still in the library on their own and are referred to by the same
+  ids as before. When the graph is compiled, `Scenic.Primitive.Sprites` that use an
+  atlased image are drawn from the atlas instead, as are rects filled with an
+  atlased image that aren't stroked and are no bigger than the image. Sprite source
+  rectangles that reach outside of the image will pick up its neighbors in the atlas.
+
   ### Troubleshooting
 
   If you have added an asset to your assets directory and you think it should be in
@@ -132,14 +161,22 @@ defmodule Scenic.Assets.Static do
       Valid files move on to the next step
     2) The valid assets files are hashed to create a cryptographic signature that is used
       later when the files are loaded to confirm that they are unchanged.
-    3) The asset files are copied into the `/priv/static` directory, which is where they
-      are actually loaded from at run time. The name of the file in this directory is
+    3) The asset files are copied into the `/priv/__scenic/assets` directory, which is where
+      they are actually loaded from at run time. The name of the file in this directory is
       a `Base.url_encode64/2` version of the hash of the file's contents.
     4) A map is created, which is the actual asset library used at runtime. This map
       has the original file name as keys and holds the hashes, and parsed metadata
       as the contents. This map is stored as a literal object in your assets module
       and is the reason it needs to be compiled when you add a new asset.
 
+  The build is incremental. The size, mtime, hash and metadata of every file, and the
+  size and mtime of its copy, are kept in a manifest next to the copies. On the next
+  build, files whose size and mtime are unchanged, and whose copy is untouched, aren't
+  read again. The files that did change are read, parsed and hashed in parallel. Copies
+  that already hold the right contents are left alone, and copies of files that are no
+  longer in the library are removed. The manifest is thrown away when Scenic is
+  upgraded.
+
   If you are curious and want to see the library yourself, you can query the
   `MyApplication.Assets.library/0` function, which is added at compile time. Alternately,
   the function `Scenic.Assets.Static.library/0` should return the same library.
@@ -216,6 +253,8 @@ defmodule Scenic.Assets.Static do
   @hash_type :sha3_256
 
   @dst_dir "/priv/__scenic/assets"
+  @manifest_version 2
+  @version Mix.Project.config()[:version]
   @default_src_dir "assets"
 
   @default_aliases [
@@ -223,14 +262,26 @@ defmodule Scenic.Assets.Static do
     roboto_mono: {:scenic, "fonts/roboto_mono.ttf"}
   ]
 
+  @load_opts_schema [
+    cache: [type: :boolean, default: true],
+    mmap: [type: :boolean, default: false]
+  ]
+
+  @chunk_size 65536
+
   @parsers [
     Scenic.Assets.Static.Image,
     Scenic.Assets.Static.Font
   ]
 
+  @type region ::
+          {atlas :: String.t(),
+           {x :: non_neg_integer, y :: non_neg_integer, w :: pos_integer, h :: pos_integer}}
+
   @type t :: %Scenic.Assets.Static{
           aliases: map,
           metas: map,
+          regions: %{String.t() => region()},
           hash_type: :sha3_256,
           module: module,
           otp_app: atom,
@@ -239,6 +290,7 @@ defmodule Scenic.Assets.Static do
 
   defstruct aliases: %{},
             metas: %{},
+            regions: %{},
             hash_type: @hash_type,
             module: nil,
             otp_app: nil,
@@ -384,6 +436,30 @@ defmodule Scenic.Assets.Static do
     end
   end
 
+  # --------------------------------------------------------
+  @doc """
+  Fetch where an image was packed into an atlas.
+
+  Return is in the form of `{:ok, {atlas_hash, {x, y, width, height}}}`
+
+  If the image is not in an atlas, `:error` is returned.
+
+  Example:
+  ```elixir
+  {:ok, {atlas, {x, y, w, h}}} = Scenic.Assets.Static.region( "images/icons/play.png" )
+  ```
+  """
+  @spec region(id :: any) :: {:ok, region()} | :error
+  def region(id), do: library() |> region(id)
+
+  @spec region(library :: t(), id :: any) :: {:ok, region()} | :error
+  def region(%Static{regions: regions} = lib, id) do
+    case to_hash(lib, id) do
+      {:ok, hash} -> Map.fetch(regions, hash)
+      _ -> :error
+    end
+  end
+
   # --------------------------------------------------------
   @doc """
   Load the binary contents of an asset given it's id or hash.
@@ -396,6 +472,21 @@ defmodule Scenic.Assets.Static do
   the library. If this test fails, `{:error, :hash_failed}` is returned.
 
   If the output file cannot be read, it returns a posix error.
+
+  ### Caching
+
+  An asset is only read and hashed the first time it is loaded. After that, the
+  verified binary is kept in a `:persistent_term` and every later load, from any
+  process, gets a reference to the same binary instead of a copy. The cache lasts
+  until the VM stops.
+
+  ### Options
+
+  * `:cache` Use and fill the cache. Defaults to `true`. Set it to `false` for large,
+    rarely used assets that shouldn't stay in memory.
+  * `:mmap` Memory map the file instead of reading it onto the heap. The OS pages the
+    contents in as they are touched and can drop them again under memory pressure.
+    Defaults to `false`. Falls back to a normal read where mapping isn't supported.
   """
   @spec load(id :: any) ::
           {:ok, data :: binary}
@@ -405,24 +496,37 @@ defmodule Scenic.Assets.Static do
 
   def load(id), do: library() |> load(id)
 
-  @spec load(library :: t(), id :: any) ::
+  @spec load(library :: t(), id :: any, opts :: Keyword.t()) ::
           {:ok, data :: binary}
           | {:error, :not_found}
           | {:error, :hash_failed}
           | {:error, File.posix()}
 
-  def load(%Static{otp_app: otp_app, hash_type: hash_type} = lib, id) do
+  def load(%Static{otp_app: otp_app, hash_type: hash_type} = lib, id, opts \\ []) do
+    opts =
+      case NimbleOptions.validate(opts, @load_opts_schema) do
+        {:ok, opts} -> opts
+        {:error, error} -> raise Exception.message(error)
+      end
+
     dir =
       otp_app
       |> :code.lib_dir()
       |> Path.join(dst_dir())
 
+    read = if opts[:mmap], do: &Static.Mmap.read/1, else: &File.read/1
+
     with {:ok, str_hash} <- to_hash(lib, id),
+         {:cached, nil} <- {:cached, cached(opts, otp_app, str_hash)},
          {:ok, bin_hash} <- Base.url_decode64(str_hash, padding: false),
-         {:ok, bin} <- File.read(Path.join(dir, str_hash)),
+         {:ok, bin} <- read.(Path.join(dir, str_hash)),
          ^bin_hash <- :crypto.hash(hash_type, bin) do
+      if opts[:cache], do: put_cached(otp_app, str_hash, bin)
       {:ok, bin}
     else
+      {:cached, bin} ->
+        {:ok, bin}
+
       :error ->
         err = {:error, :not_found}
         Logger.error("asset: #{inspect(id)} from #{dir}, error: #{inspect(err)}")
@@ -439,6 +543,68 @@ defmodule Scenic.Assets.Static do
     end
   end
 
+  defp cached(opts, otp_app, str_hash) do
+    case opts[:cache] do
+      true -> :persistent_term.get({__MODULE__, otp_app, str_hash}, nil)
+      false -> nil
+    end
+  end
+
+  # replacing a persistent term is expensive, so don't if another process beat us to it
+  defp put_cached(otp_app, str_hash, bin) do
+    key = {__MODULE__, otp_app, str_hash}
+
+    case :persistent_term.get(key, nil) do
+      nil -> :persistent_term.put(key, bin)
+      _ -> :ok
+    end
+  end
+
+  # --------------------------------------------------------
+  @doc """
+  Stream the contents of an asset in chunks.
+
+  The asset is loaded and verified exactly like `load/3`, memory mapped by default,
+  and then handed out as a stream of sub-binaries. No chunk is a copy, which lets a
+  driver send a large font or image along without holding a second copy of it.
+
+  Returns `{:ok, stream}` or the same errors as `load/3`.
+
+  ### Options
+
+  * `:chunk_size` The size of each chunk in bytes. Defaults to `65536`.
+  * `:cache` and `:mmap` are the same as in `load/3`, except that `:mmap` defaults
+    to `true`.
+
+  Example:
+  ```elixir
+  {:ok, chunks} = Scenic.Assets.Static.stream( :roboto )
+  Enum.each( chunks, &send_to_remote(&1) )
+  ```
+  """
+  @spec stream(id :: any) :: {:ok, Enumerable.t()} | {:error, atom}
+  def stream(id), do: library() |> stream(id)
+
+  @spec stream(library :: t(), id :: any, opts :: Keyword.t()) ::
+          {:ok, Enumerable.t()} | {:error, atom}
+  def stream(%Static{} = lib, id, opts \\ []) do
+    {chunk_size, opts} = Keyword.pop(opts, :chunk_size, @chunk_size)
+
+    unless is_integer(chunk_size) and chunk_size > 0 do
+      raise "expected :chunk_size to be a positive integer, got: #{inspect(chunk_size)}"
+    end
+
+    with {:ok, bin} <- load(lib, id, Keyword.put_new(opts, :mmap, true)) do
+      size = byte_size(bin)
+
+      {:ok,
+       Stream.unfold(0, fn
+         at when at >= size -> nil
+         at -> {binary_part(bin, at, min(chunk_size, size - at)), at + chunk_size}
+       end)}
+    end
+  end
+
   # ========================================================
 
   # --------------------------------------------------------
@@ -459,20 +625,42 @@ defmodule Scenic.Assets.Static do
           reraise e, __STACKTRACE__
       end
 
-    # make sure the destination directory exists (delete and recreate to keep it clean)
-    File.rm_rf(dst)
+    # make sure the destination directory exists. Copies that are still in the
+    # library are left in place, and the rest are removed once it is built.
     File.mkdir_p!(dst)
+    started = System.os_time(:second)
 
     # start building the library
     library = %Static{module: library_module, otp_app: opts[:otp_app]}
+    cache = read_manifest(dst, library)
 
-    # build the file data and metas from the sources
-    library =
+    sources =
       opts
       |> Keyword.get(:sources, [])
       |> Keyword.put_new(opts[:otp_app], @default_src_dir)
       |> Keyword.put_new(:scenic, "deps/scenic/assets")
-      |> Enum.reduce(library, &build_from_source(&2, &1, dst))
+
+    # build the file data and metas from the sources
+    files = Enum.flat_map(sources, &source_files(library, &1))
+    scanned = scan(files, cache, library, dst)
+    write_manifest(dst, library, files, scanned, started)
+
+    library =
+      files
+      |> Enum.zip(scanned)
+      |> Enum.reduce(library, fn
+        {{app, dir, path}, {_stat, {str_hash, meta}}}, lib ->
+          add_asset(lib, app, Path.relative_to(path, dir), str_hash, meta)
+
+        _, lib ->
+          lib
+      end)
+
+    # pack any atlases out of the images that are now in the library
+    library =
+      opts
+      |> Keyword.get(:atlases, [])
+      |> Enum.reduce(library, &Static.Atlas.build(&2, &1, atlas_sources(sources), dst))
 
     # add the default aliases
     library = Enum.reduce(@default_aliases, library, &add_alias(&2, &1))
@@ -485,6 +673,8 @@ defmodule Scenic.Assets.Static do
       end
       |> Enum.reduce(library, &add_alias(&2, &1))
 
+    prune(dst, library)
+
     # finally add the meta_hash
     meta_hash =
       library.metas
@@ -495,27 +685,21 @@ defmodule Scenic.Assets.Static do
   end
 
   # --------------------------------------------------------
-  defp build_from_source(library, source, dst)
+  # the files in a source, as {app, dir, path}
+  defp source_files(library, source)
 
-  defp build_from_source(%Static{otp_app: app} = lib, src, dst) when is_bitstring(src) do
-    build_from_source(lib, {app, src}, dst)
+  defp source_files(%Static{otp_app: app} = lib, src) when is_bitstring(src) do
+    source_files(lib, {app, src})
   end
 
-  defp build_from_source(%Static{} = lib, {app, dir}, dst)
-       when is_atom(app) and is_bitstring(dir) do
-    # build the library
+  defp source_files(%Static{}, {app, dir}) when is_atom(app) and is_bitstring(dir) do
     dir
     |> Path.join("**")
     |> Path.wildcard()
-    |> Enum.reduce(lib, fn path, lib ->
-      case File.dir?(path) do
-        true -> lib
-        false -> ingest_file(lib, app, dir, path, dst)
-      end
-    end)
+    |> Enum.map(&{app, dir, &1})
   end
 
-  defp build_from_source(%Static{module: mod}, src, _dst) do
+  defp source_files(%Static{module: mod}, src) do
     raise """
     Invalid :sources list when building assets library #{inspect(mod)}
     Received: #{inspect(src)}
@@ -526,30 +710,156 @@ defmodule Scenic.Assets.Static do
   end
 
   # --------------------------------------------------------
-  defp ingest_file(%Static{otp_app: otp_app, hash_type: hash_type} = lib, src_app, dir, path, dst) do
+  # Find the hash and meta of every file, in the same order. Files whose size and
+  # mtime match the last build, and whose copy hasn't been touched since, are taken
+  # from the manifest. The rest are read, parsed, hashed and copied in parallel.
+  #
+  # Each file comes back as {{size, mtime}, {str_hash, meta}}, or {stat, :error}
+  # if it isn't an asset, or nil if it isn't a regular file.
+  defp scan(files, cache, %Static{hash_type: hash_type}, dst) do
+    files
+    |> Enum.map(fn {_app, _dir, path} -> {path, Map.get(cache, path)} end)
+    |> Task.async_stream(
+      fn {path, cached} -> scan_file(path, cached, hash_type, dst) end,
+      max_concurrency: System.schedulers_online(),
+      timeout: :infinity
+    )
+    |> Enum.map(fn {:ok, scanned} -> scanned end)
+  end
+
+  defp scan_file(path, cached, hash_type, dst) do
+    case File.stat(path, time: :posix) do
+      {:ok, %File.Stat{type: :regular, size: size, mtime: mtime}} ->
+        stat = {size, mtime}
+
+        case cached do
+          {^stat, :error, _} ->
+            {stat, :error}
+
+          {^stat, {str_hash, _} = entry, copy_stat} ->
+            case copy_stat(dst, str_hash) == copy_stat do
+              true -> {stat, entry}
+              false -> ingest_file(path, stat, hash_type, dst)
+            end
+
+          _ ->
+            ingest_file(path, stat, hash_type, dst)
+        end
+
+      _ ->
+        nil
+    end
+  end
+
+  # --------------------------------------------------------
+  defp ingest_file(path, stat, hash_type, dst) do
     with {:ok, bin} <- File.read(path),
          {:ok, meta} <- parse_bin(bin) do
-      id = Path.relative_to(path, dir)
       bin_hash = :crypto.hash(hash_type, bin)
       str_hash = Base.url_encode64(bin_hash, padding: false)
+      copy(dst, str_hash, bin)
+      {stat, {str_hash, meta}}
+    else
+      _ -> {stat, :error}
+    end
+  end
 
-      Path.join(dst, str_hash) |> File.write!(bin)
+  defp copy_stat(dst, str_hash) do
+    case File.stat(Path.join(dst, str_hash), time: :posix) do
+      {:ok, %File.Stat{type: :regular, size: size, mtime: mtime}} -> {size, mtime}
+      _ -> nil
+    end
+  end
 
-      # fill in the library entries
-      lib =
-        lib
-        |> assign(:metas, str_hash, meta)
-        |> assign(:aliases, {src_app, id}, str_hash)
+  @doc false
+  # A copy that is already there is only kept if it holds the same bytes. Two
+  # files with the same contents can be copied at once, so write to a temporary
+  # file and rename it into place.
+  def copy(dst, str_hash, bin) do
+    path = Path.join(dst, str_hash)
+
+    unless File.read(path) == {:ok, bin} do
+      tmp = Path.join(dst, "#{str_hash}.#{System.unique_integer([:positive])}.tmp")
+      File.write!(tmp, bin)
+      File.rename!(tmp, path)
+    end
 
-      case otp_app == src_app do
-        true -> assign(lib, :aliases, id, str_hash)
-        false -> lib
-      end
+    :ok
+  end
+
+  # fill in the library entries
+  defp add_asset(%Static{otp_app: otp_app} = lib, src_app, id, str_hash, meta) do
+    lib =
+      lib
+      |> assign(:metas, str_hash, meta)
+      |> assign(:aliases, {src_app, id}, str_hash)
+
+    case otp_app == src_app do
+      true -> assign(lib, :aliases, id, str_hash)
+      false -> lib
+    end
+  end
+
+  # remove the copies of files that are no longer in the library
+  defp prune(dst, %Static{metas: metas}) do
+    dst
+    |> File.ls!()
+    |> Enum.reject(&Map.has_key?(metas, &1))
+    |> Enum.each(&File.rm!(Path.join(dst, &1)))
+  end
+
+  # --------------------------------------------------------
+  # The manifest maps each source file to its stat, scanned entry and the stat
+  # of its copy from the last build. It lives next to the copies, not among them.
+  # It is only used by the same version of Scenic that wrote it.
+  defp manifest_path(dst), do: Path.join(Path.dirname(dst), "assets.manifest")
+
+  defp read_manifest(dst, %Static{hash_type: hash_type}) do
+    with {:ok, bin} <- File.read(manifest_path(dst)),
+         {@manifest_version, @version, ^hash_type, entries} <- binary_to_term(bin) do
+      entries
     else
-      _ -> lib
+      _ -> %{}
     end
   end
 
+  defp binary_to_term(bin) do
+    :erlang.binary_to_term(bin)
+  rescue
+    _ -> :error
+  end
+
+  # mtimes are in whole seconds, so a file or copy written in the second the
+  # build started could change again without its mtime moving. Those are left out.
+  defp write_manifest(dst, %Static{hash_type: hash_type}, files, scanned, started) do
+    entries =
+      for {{_, _, path}, {{_size, mtime} = stat, result}} <- Enum.zip(files, scanned),
+          mtime < started,
+          copy_stat = manifest_copy_stat(dst, result),
+          settled?(copy_stat, started),
+          into: %{},
+          do: {path, {stat, result, copy_stat}}
+
+    File.write!(
+      manifest_path(dst),
+      :erlang.term_to_binary({@manifest_version, @version, hash_type, entries})
+    )
+  end
+
+  defp manifest_copy_stat(dst, {str_hash, _}), do: copy_stat(dst, str_hash)
+  defp manifest_copy_stat(_, :error), do: :none
+
+  defp settled?({_size, mtime}, started), do: mtime < started
+  defp settled?(:none, _), do: true
+  defp settled?(nil, _), do: false
+
+  defp atlas_sources(sources) do
+    Enum.flat_map(sources, fn
+      {app, dir} when is_atom(app) and is_bitstring(dir) -> [{app, dir}]
+      _ -> []
+    end)
+  end
+
   # --------------------------------------------------------
   def assign(%Static{metas: metas} = lib, :metas, key, value) do
     %{lib | metas: Map.put(metas, key, value)}
@@ -559,6 +869,10 @@ defmodule Scenic.Assets.Static do
     %{lib | aliases: Map.put(aliases, key, value)}
   end
 
+  def assign(%Static{regions: regions} = lib, :regions, key, value) do
+    %{lib | regions: Map.put(regions, key, value)}
+  end
+
   # --------------------------------------------------------
   defp parse_bin(bin) do
     @parsers
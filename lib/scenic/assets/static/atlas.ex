@@ -0,0 +1,171 @@
+defmodule Scenic.Assets.Static.Atlas do
+  @moduledoc false
+
+  # Packs the images selected by an :atlases entry into a single png at compile time.
+  # The images are placed in shelves, tallest first, with a transparent pixel of
+  # padding between them so that filtering doesn't bleed one into the next.
+
+  require Logger
+
+  alias Scenic.Assets.Static
+  alias Scenic.Assets.Stream.Bitmap
+  alias Scenic.Assets.Stream.Image
+
+  @padding 1
+  @max_size 4096
+
+  # --------------------------------------------------------
+  @doc false
+  def build(%Static{} = lib, {name, patterns}, sources, dst) when is_atom(name) do
+    hashes =
+      patterns
+      |> List.wrap()
+      |> Enum.flat_map(&match(lib, &1, sources))
+      |> Enum.uniq()
+
+    case hashes do
+      [] ->
+        Logger.warning("Atlas #{inspect(name)} doesn't match any images: #{inspect(patterns)}")
+        lib
+
+      hashes ->
+        hashes
+        |> Enum.map(&decode(&1, dst, name))
+        |> pack(name)
+        |> write(lib, name, dst)
+    end
+  end
+
+  def build(%Static{module: mod}, atlas, _sources, _dst) do
+    raise """
+    Invalid :atlases list when building assets library #{inspect(mod)}
+    Received: #{inspect(atlas)}
+
+    Expected a list of atlases in the format of
+    [atlas_name: [relative_path_pattern, {otp_app, relative_path_pattern}]]
+    """
+  end
+
+  # --------------------------------------------------------
+  # find the hashes of the images matching a wildcard pattern
+  defp match(%Static{otp_app: app} = lib, pattern, sources) when is_bitstring(pattern) do
+    match(lib, {app, pattern}, sources)
+  end
+
+  defp match(%Static{aliases: aliases, metas: metas}, {app, pattern}, sources) do
+    for {^app, dir} <- sources,
+        path <- Path.wildcard(Path.join(dir, pattern)),
+        {:ok, hash} <- [Map.fetch(aliases, {app, Path.relative_to(path, dir)})],
+        match?({:ok, {Static.Image, _}}, Map.fetch(metas, hash)) do
+      hash
+    end
+  end
+
+  # --------------------------------------------------------
+  defp decode(hash, dst, name) do
+    with {:ok, bin} <- File.read(Path.join(dst, hash)),
+         {:ok, {_, {w, h, :rgba}, pixels}} <- Image.decode(bin, format: :rgba) do
+      {hash, w, h, pixels}
+    else
+      err ->
+        raise "Unable to add #{hash} to atlas #{inspect(name)}, err: #{inspect(err)}"
+    end
+  end
+
+  # --------------------------------------------------------
+  # shelf packing. returns {width, height, [{hash, x, y, w, h, pixels}]}
+  # Starts at about a square and widens the shelves until the atlas is no taller
+  # than @max_size, which is as big a texture as the drivers can count on.
+  defp pack(images, name) do
+    {widest, area} =
+      Enum.reduce(images, {0, 0}, fn {_, w, h, _}, {widest, area} ->
+        {max(widest, w), area + (w + @padding) * (h + @padding)}
+      end)
+
+    if widest > @max_size do
+      raise "Atlas #{inspect(name)} holds an image wider than #{@max_size} pixels"
+    end
+
+    width =
+      area
+      |> :math.sqrt()
+      |> ceil()
+      |> next_pow2()
+      |> max(widest)
+      |> min(@max_size)
+
+    images
+    |> Enum.sort_by(fn {hash, w, h, _} -> {-h, -w, hash} end)
+    |> pack(width, name)
+  end
+
+  defp pack(images, width, name) do
+    case shelve(images, width) do
+      {_, height, _} = packed when height <= @max_size ->
+        packed
+
+      _ when width < @max_size ->
+        pack(images, min(width * 2, @max_size), name)
+
+      _ ->
+        raise "Atlas #{inspect(name)} doesn't fit in #{@max_size}x#{@max_size} pixels. " <>
+                "Split it into more than one atlas"
+    end
+  end
+
+  defp shelve(images, width) do
+    {placed, {_, y, shelf_h}} =
+      images
+      |> Enum.map_reduce({0, 0, 0}, fn {hash, w, h, pixels}, {x, y, shelf_h} ->
+        {x, y, shelf_h} =
+          case x + w > width do
+            true -> {0, y + shelf_h + @padding, 0}
+            false -> {x, y, shelf_h}
+          end
+
+        {{hash, x, y, w, h, pixels}, {x + w + @padding, y, max(shelf_h, h)}}
+      end)
+
+    width = Enum.reduce(placed, 0, fn {_, x, _, w, _, _}, acc -> max(acc, x + w) end)
+    {width, y + shelf_h, placed}
+  end
+
+  defp next_pow2(n), do: next_pow2(n, 1)
+  defp next_pow2(n, p) when p >= n, do: p
+  defp next_pow2(n, p), do: next_pow2(n, p * 2)
+
+  # --------------------------------------------------------
+  # compose the atlas, encode it and add it and the regions to the library
+  defp write({width, height, placed}, %Static{hash_type: hash_type} = lib, name, dst) do
+    pixels =
+      for row <- 0..(height - 1) do
+        placed
+        |> Enum.filter(fn {_, _, y, _, h, _} -> row >= y and row < y + h end)
+        |> Enum.sort_by(fn {_, x, _, _, _, _} -> x end)
+        |> Enum.map_reduce(0, fn {_, x, y, w, _, px}, at ->
+          {[blank(x - at), binary_part(px, (row - y) * w * 4, w * 4)], x + w}
+        end)
+        |> then(fn {segments, at} -> [segments, blank(width - at)] end)
+      end
+      |> IO.iodata_to_binary()
+
+    {:ok, {Image, {^width, ^height, _}, png}} =
+      Image.from_bitmap({Bitmap, {width, height, :rgba}, pixels})
+
+    {:ok, meta} = Static.Image.parse_meta(png)
+    str_hash = :crypto.hash(hash_type, png) |> Base.url_encode64(padding: false)
+    Static.copy(dst, str_hash, png)
+
+    lib =
+      lib
+      |> Static.assign(:metas, str_hash, meta)
+      |> Static.assign(:aliases, {:atlas, to_string(name)}, str_hash)
+
+    Enum.reduce(placed, lib, fn {hash, x, y, w, h, _}, lib ->
+      Static.assign(lib, :regions, hash, {str_hash, {x, y, w, h}})
+    end)
+  end
+
+  defp blank(0), do: []
+  defp blank(n), do: :binary.copy(<<0, 0, 0, 0>>, n)
+end
@@ -4,12 +4,237 @@
 #
 
 defmodule Scenic.Assets.Static.Font do
-  @moduledoc false
+  @moduledoc """
+  Measure and wrap text set in a static font.
 
+  These work like `FontMetrics.width/4` and `FontMetrics.wrap/5`, but take the id of
+  a font in the static assets library instead of its metrics, and measure in native
+  code against a table of glyph advances that is built once per font.
+
+  The batched versions, `widths/3` and `wraps/4`, measure a whole list of strings in
+  a single native call, which is what you want when sizing a table or a list of
+  labels.
+
+  ```elixir
+  alias Scenic.Assets.Static.Font
+
+  Font.width("Hello", 20, :roboto)
+  Font.widths(["Name", "Size", "Modified"], 16, :roboto)
+  Font.wrap(long_message, 300, 16, :roboto)
+  ```
+
+  ### Caching
+
+  Results are memoized in an ETS table keyed by the font, the hash of the string
+  and, for wrapping, the width in font units. Widths are kept in font units, so a
+  string measured once is known at every size. The table is owned by the `:scenic`
+  supervisor and is simply cleared when it gets large. Without it (if scenic isn't
+  started), nothing is cached.
+
+  ### Wrapping
+
+  Lines break at `"\\n"`, and otherwise at the last space that fits. The space at a
+  break is dropped. A word that is wider than the whole line is broken between
+  characters.
+
+  Strings that use characters the font doesn't have are measured and wrapped by
+  `FontMetrics` instead.
+  """
+
+  alias Scenic.Assets.Static
+
+  @app Mix.Project.config()[:app]
+
+  # load the NIF
+  @compile {:autoload, false}
+  @on_load :load_nifs
+
+  @doc false
+  def load_nifs do
+    :ok =
+      @app
+      |> :code.priv_dir()
+      |> :filename.join(~c"font")
+      |> :erlang.load_nif(0)
+  end
+
+  @cache __MODULE__.Cache
+  @max_cached 20_000
+  @dense 256
+
+  # --------------------------------------------------------
+  @doc false
   def parse_meta(bin) do
     case TruetypeMetrics.parse(bin, "") do
       {:ok, meta} -> {:ok, {__MODULE__, meta}}
       _ -> :error
     end
   end
+
+  # --------------------------------------------------------
+  @doc """
+  The width of a string in pixels, when drawn at the given font size.
+  """
+  @spec width(string :: String.t(), size :: number, font :: Static.id()) :: number
+  def width(string, size, font) when is_bitstring(string) do
+    [width] = widths([string], size, font)
+    width
+  end
+
+  @doc """
+  The widths of a list of strings in pixels, when drawn at the given font size.
+  """
+  @spec widths(strings :: [String.t()], size :: number, font :: Static.id()) :: [number]
+  def widths(strings, size, font) when is_list(strings) and is_number(size) do
+    {hash, fm, table} = fetch!(font)
+    scale = size / fm.units_per_em
+
+    hash
+    |> cached(:width, strings, &nif_widths(table, &1))
+    |> Enum.zip_with(strings, fn
+      :undefined, string -> FontMetrics.width(string, size, fm)
+      units, _ -> units * scale
+    end)
+  end
+
+  # --------------------------------------------------------
+  @doc """
+  Wrap a string so that no line is wider than `max_width` pixels at the given font
+  size.
+
+  Returns the string with `"\\n"` at each line break.
+  """
+  @spec wrap(
+          string :: String.t(),
+          max_width :: number,
+          size :: number,
+          font :: Static.id()
+        ) :: String.t()
+  def wrap(string, max_width, size, font) when is_bitstring(string) do
+    [lines] = wraps([string], max_width, size, font)
+    Enum.join(lines, "\n")
+  end
+
+  @doc """
+  Wrap a list of strings so that no line is wider than `max_width` pixels at the
+  given font size.
+
+  Returns a list of lines for each string.
+  """
+  @spec wraps(
+          strings :: [String.t()],
+          max_width :: number,
+          size :: number,
+          font :: Static.id()
+        ) :: [[String.t()]]
+  def wraps(strings, max_width, size, font)
+      when is_list(strings) and is_number(max_width) and is_number(size) do
+    {hash, fm, table} = fetch!(font)
+    max_units = floor(max_width * fm.units_per_em / size)
+
+    hash
+    |> cached({:wrap, max_units}, strings, &nif_wraps(table, &1, max_units))
+    |> Enum.zip_with(strings, fn
+      :undefined, string -> FontMetrics.wrap(string, max_width, size, fm) |> String.split("\n")
+      lines, _ -> lines
+    end)
+  end
+
+  # --------------------------------------------------------
+  # the font's metrics and advance table. The table is built the first time a
+  # font is measured and kept for the life of the VM.
+  defp fetch!(font) do
+    with {:ok, hash} <- Static.to_hash(font),
+         {:ok, {__MODULE__, fm}} <- Static.meta(hash) do
+      case :persistent_term.get({__MODULE__, hash}, nil) do
+        nil ->
+          table = build_table(fm)
+          :persistent_term.put({__MODULE__, hash}, table)
+          {hash, fm, table}
+
+        table ->
+          {hash, fm, table}
+      end
+    else
+      err -> raise "Invalid font -> #{inspect(font)}, err: #{inspect(err)}"
+    end
+  end
+
+  defp build_table(%FontMetrics{metrics: metrics}) do
+    advances =
+      for {cp, adv} when is_integer(cp) and cp >= 0 and is_integer(adv) <- metrics,
+          into: %{},
+          do: {cp, adv}
+
+    dense =
+      for cp <- 0..(@dense - 1), into: <<>> do
+        <<Map.get(advances, cp, -1)::signed-32-native>>
+      end
+
+    sparse =
+      for {cp, adv} <- Enum.sort(advances), cp >= @dense, into: <<>> do
+        <<cp::unsigned-32-native, adv::signed-32-native>>
+      end
+
+    dense <> sparse
+  end
+
+  # --------------------------------------------------------
+  # look each string up in the cache, measure all the misses in one call, then
+  # cache those. The string is stored with the result to rule out hash collisions.
+  defp cached(hash, kind, strings, measure) do
+    case :ets.whereis(@cache) do
+      :undefined ->
+        measure.(strings)
+
+      tab ->
+        keyed =
+          Enum.map(strings, fn string ->
+            key = {hash, kind, :erlang.phash2(string)}
+
+            case :ets.lookup(tab, key) do
+              [{_, ^string, result}] -> {:hit, result}
+              _ -> {:miss, key, string}
+            end
+          end)
+
+        misses = for {:miss, key, string} <- keyed, do: {key, string}
+
+        measured =
+          case misses do
+            [] -> []
+            misses -> misses |> Enum.map(&elem(&1, 1)) |> measure.()
+          end
+
+        put_cached(tab, misses, measured)
+        merge(keyed, measured)
+    end
+  end
+
+  defp put_cached(_tab, [], _), do: :ok
+
+  defp put_cached(tab, misses, measured) do
+    if :ets.info(tab, :size) > @max_cached, do: :ets.delete_all_objects(tab)
+
+    # copy the strings and wrapped lines so the cache doesn't hold on to the
+    # larger binaries they may be part of
+    entries =
+      Enum.zip_with(misses, measured, fn {key, string}, result ->
+        {key, :binary.copy(string), copy_lines(result)}
+      end)
+
+    :ets.insert(tab, entries)
+  end
+
+  defp copy_lines(lines) when is_list(lines), do: Enum.map(lines, &:binary.copy/1)
+  defp copy_lines(result), do: result
+
+  defp merge([], []), do: []
+  defp merge([{:hit, result} | keyed], measured), do: [result | merge(keyed, measured)]
+  defp merge([{:miss, _, _} | keyed], [result | measured]), do: [result | merge(keyed, measured)]
+
+  # --------------------------------------------------------
+  # nif stubs
+  defp nif_widths(_, _), do: :erlang.nif_error("Did not find nif_widths")
+  defp nif_wraps(_, _, _), do: :erlang.nif_error("Did not find nif_wraps")
 end
@@ -0,0 +1,26 @@
+defmodule Scenic.Assets.Static.Font.Cache do
+  @moduledoc false
+
+  # Owns the public ETS table that Scenic.Assets.Static.Font memoizes text
+  # measurements in. All reads and writes happen in the calling processes.
+
+  use GenServer
+
+  @doc false
+  def start_link(_) do
+    GenServer.start_link(__MODULE__, nil, name: __MODULE__)
+  end
+
+  @doc false
+  def init(nil) do
+    __MODULE__ =
+      :ets.new(__MODULE__, [
+        :named_table,
+        :public,
+        {:read_concurrency, true},
+        {:write_concurrency, true}
+      ])
+
+    {:ok, nil}
+  end
+end
@@ -0,0 +1,35 @@
+defmodule Scenic.Assets.Static.Mmap do
+  @moduledoc false
+
+  # Read-only memory mapped files, as binaries. The pages are loaded by the OS as
+  # they are touched and are not counted against any process heap. Falls back to
+  # File.read/1 where mapping isn't supported.
+
+  @app Mix.Project.config()[:app]
+
+  # load the NIF
+  @compile {:autoload, false}
+  @on_load :load_nifs
+
+  @doc false
+  def load_nifs do
+    :ok =
+      @app
+      |> :code.priv_dir()
+      |> :filename.join(~c"mmap")
+      |> :erlang.load_nif(0)
+  end
+
+  @doc false
+  @spec read(path :: Path.t()) :: {:ok, binary} | {:error, File.posix()}
+  def read(path) do
+    case nif_map(IO.chardata_to_string(path)) do
+      {:error, :enotsup} -> File.read(path)
+      result -> result
+    end
+  end
+
+  # --------------------------------------------------------
+  # nif stubs
+  defp nif_map(_), do: :erlang.nif_error("Did not find nif_map")
+end
@@ -29,6 +29,7 @@ defmodule Scenic.Assets.Stream do
 
   alias Scenic.Assets.Stream.Image
   alias Scenic.Assets.Stream.Bitmap
+  alias Scenic.Telemetry
 
   @type asset :: Image.t() | Bitmap.t()
   @type id :: String.t()
@@ -103,7 +104,16 @@ defmodule Scenic.Assets.Stream do
   """
   @spec put(id :: String.t(), asset :: asset()) ::
           :ok | {:error, atom} | {:error, atom, any}
-  def put(id, {type, _meta, _bin} = asset) do
+  def put(id, {type, _meta, bin} = asset) do
+    Telemetry.span(
+      [:assets, :stream, :put],
+      %{id: id, type: type},
+      fn -> do_put(id, asset) end,
+      fn _ -> {%{bytes: if(is_binary(bin), do: byte_size(bin), else: 0)}, %{}} end
+    )
+  end
+
+  defp do_put(id, {type, _meta, _bin} = asset) do
     case type.valid?(asset) do
       true ->
         case :ets.lookup(__MODULE__, id) do
@@ -33,7 +33,7 @@ defmodule Scenic.Assets.Stream.Bitmap do
 
   bitmap = Bitmap.build( :rgb, 20, 10, clear: :blue )
     |> Bitmap.put( 2, 3, :red )
-    |> Bitmap.put( 9, 10, :yellow )
+    |> Bitmap.put( 9, 9, :yellow )
     |> Bitmap.commit()
 
   Scenic.Assets.Stream.put( "stream_id", bitmap )
@@ -96,6 +96,10 @@ defmodule Scenic.Assets.Stream.Bitmap do
   @type t :: {__MODULE__, meta :: meta(), data :: binary}
   @type m :: {:mutable_bitmap, meta :: meta(), data :: binary}
 
+  @type rect ::
+          {x :: non_neg_integer, y :: non_neg_integer, width :: non_neg_integer,
+           height :: non_neg_integer}
+
   # --------------------------------------------------------
   @doc """
   Build a new bitmap with a given depth, width and height.
@@ -116,6 +120,28 @@ defmodule Scenic.Assets.Stream.Bitmap do
 
   * `:clear` Set the new bitmap so that every pixel is the specified color.
   * `:commit` Set to true to start the bitmap committed. Set to false for mutable. The default if not specified is mutable.
+  * `:align` Pad each row to a multiple of this many bytes. See "Row Stride" below.
+
+  ### Row Stride
+
+  By default the rows are tightly packed, one right after the other. Code that
+  uploads to a GPU, or hands the memory to DMA, often needs every row to start on
+  an aligned boundary. With the `:align` option, each row is padded up to a
+  multiple of that many bytes, so the bitmap can be handed over as is, without
+  repacking.
+
+  ```elixir
+  # 33 rgb pixels is 99 bytes, so every row is padded to 128 bytes
+  bitmap = Bitmap.build(:rgb, 33, 10, align: 64)
+  Bitmap.stride(bitmap)
+  #=> 128
+  ```
+
+  The padding is never written by `put/4` or `clear/2`. The stride of any bitmap
+  is its size divided by its height, which is what `stride/1` returns.
+
+  The drivers assume tightly packed rows, so `Scenic.Assets.Stream` only accepts
+  bitmaps without padding. Use `pack/1` to drop the padding before streaming one.
   """
 
   @spec build(
@@ -128,15 +154,13 @@ defmodule Scenic.Assets.Stream.Bitmap do
   def build(format, width, height, opts \\ [])
 
   def build(format, width, height, opts) do
-    bits =
-      case format do
-        :g -> 8 * width * height
-        :ga -> 8 * width * height * 2
-        :rgb -> 8 * width * height * 3
-        :rgba -> 8 * width * height * 4
+    stride =
+      case opts[:align] do
+        nil -> width * bpp(format)
+        align when is_integer(align) and align > 0 -> align_up(width * bpp(format), align)
       end
 
-    m = {@mutable, {width, height, format}, <<0::size(bits)>>}
+    m = {@mutable, {width, height, format}, <<0::size(8 * stride * height)>>}
 
     m =
       case opts[:clear] do
@@ -151,6 +175,36 @@ defmodule Scenic.Assets.Stream.Bitmap do
     end
   end
 
+  defp align_up(n, align), do: div(n + align - 1, align) * align
+
+  defp stride(0, _p), do: 0
+  defp stride(h, p), do: div(byte_size(p), h)
+
+  defp bpp(:g), do: 1
+  defp bpp(:ga), do: 2
+  defp bpp(:rgb), do: 3
+  defp bpp(:rgba), do: 4
+
+  # --------------------------------------------------------
+  @doc """
+  The number of bytes from the start of one row of the bitmap to the start of the
+  next.
+
+  Works with either committed or mutable bitmaps.
+  """
+  @spec stride(t_or_m :: t() | m()) :: non_neg_integer
+  def stride({_, {_, h, _}, p}), do: stride(h, p)
+
+  # --------------------------------------------------------
+  @doc """
+  Copy a bitmap into a new one with tightly packed rows.
+
+  The new bitmap is in the same state as the original, committed or mutable. This
+  is how a bitmap built with the `:align` option is made streamable.
+  """
+  @spec pack(t_or_m :: t() | m()) :: t() | m()
+  def pack({_, {w, h, _}, _} = bitmap), do: crop(bitmap, 0, 0, w, h)
+
   # --------------------------------------------------------
   @doc """
   Change a bitmap from committed to mutable.
@@ -184,33 +238,33 @@ defmodule Scenic.Assets.Stream.Bitmap do
   def get({@bitmap, meta, bin}, x, y), do: do_get(meta, bin, x, y)
 
   defp do_get({w, h, :g}, p, x, y)
-       when is_integer(x) and x >= 0 and x <= w and
-              is_integer(y) and y >= 0 and y <= h do
-    skip = y * w + x
+       when is_integer(x) and x >= 0 and x < w and
+              is_integer(y) and y >= 0 and y < h do
+    skip = y * stride(h, p) + x
     <<_::binary-size(skip), g::8, _::binary>> = p
     Color.to_g(g)
   end
 
   defp do_get({w, h, :ga}, p, x, y)
-       when is_integer(x) and x >= 0 and x <= w and
-              is_integer(y) and y >= 0 and y <= h do
-    skip = y * w * 2 + x * 2
+       when is_integer(x) and x >= 0 and x < w and
+              is_integer(y) and y >= 0 and y < h do
+    skip = y * stride(h, p) + x * 2
     <<_::binary-size(skip), g::8, a::8, _::binary>> = p
     Color.to_ga({g, a})
   end
 
   defp do_get({w, h, :rgb}, p, x, y)
-       when is_integer(x) and x >= 0 and x <= w and
-              is_integer(y) and y >= 0 and y <= h do
-    skip = y * w * 3 + x * 3
+       when is_integer(x) and x >= 0 and x < w and
+              is_integer(y) and y >= 0 and y < h do
+    skip = y * stride(h, p) + x * 3
     <<_::binary-size(skip), r::8, g::8, b::8, _::binary>> = p
     Color.to_rgb({r, g, b})
   end
 
   defp do_get({w, h, :rgba}, p, x, y)
-       when is_integer(x) and x >= 0 and x <= w and
-              is_integer(y) and y >= 0 and y <= h do
-    skip = y * w * 4 + x * 4
+       when is_integer(x) and x >= 0 and x < w and
+              is_integer(y) and y >= 0 and y < h do
+    skip = y * stride(h, p) + x * 4
     <<_::binary-size(skip), r::8, g::8, b::8, a::8, _::binary>> = p
     Color.to_rgba({r, g, b, a})
   end
@@ -234,34 +288,34 @@ defmodule Scenic.Assets.Stream.Bitmap do
   def put(mutable, x, y, color)
 
   def put({@mutable, {w, h, :g}, p}, x, y, color)
-      when is_integer(x) and x >= 0 and x <= w and
-             is_integer(y) and y >= 0 and y <= h do
+      when is_integer(x) and x >= 0 and x < w and
+             is_integer(y) and y >= 0 and y < h do
     {:color_g, g} = Color.to_g(color)
-    nif_put(p, y * w + x, g)
+    nif_put(p, w, stride(h, p), x, y, g)
     {@mutable, {w, h, :g}, p}
   end
 
   def put({@mutable, {w, h, :ga}, p}, x, y, color)
-      when is_integer(x) and x >= 0 and x <= w and
-             is_integer(y) and y >= 0 and y <= h do
+      when is_integer(x) and x >= 0 and x < w and
+             is_integer(y) and y >= 0 and y < h do
     {:color_ga, {g, a}} = Color.to_ga(color)
-    nif_put(p, y * w + x, g, a)
+    nif_put(p, w, stride(h, p), x, y, g, a)
     {@mutable, {w, h, :ga}, p}
   end
 
   def put({@mutable, {w, h, :rgb}, p}, x, y, color)
-      when is_integer(x) and x >= 0 and x <= w and
-             is_integer(y) and y >= 0 and y <= h do
+      when is_integer(x) and x >= 0 and x < w and
+             is_integer(y) and y >= 0 and y < h do
     {:color_rgb, {r, g, b}} = Color.to_rgb(color)
-    nif_put(p, y * w + x, r, g, b)
+    nif_put(p, w, stride(h, p), x, y, r, g, b)
     {@mutable, {w, h, :rgb}, p}
   end
 
   def put({@mutable, {w, h, :rgba}, p}, x, y, color)
-      when is_integer(x) and x >= 0 and x <= w and
-             is_integer(y) and y >= 0 and y <= h do
+      when is_integer(x) and x >= 0 and x < w and
+             is_integer(y) and y >= 0 and y < h do
     {:color_rgba, {r, g, b, a}} = Color.to_rgba(color)
-    nif_put(p, y * w + x, r, g, b, a)
+    nif_put(p, w, stride(h, p), x, y, r, g, b, a)
     {@mutable, {w, h, :rgba}, p}
   end
 
@@ -274,47 +328,25 @@ defmodule Scenic.Assets.Stream.Bitmap do
   The color you provide can be any valid value from the `Scenic.Color` module.
 
   Unlike the `put` function, which specifies the pixel by `x` and `y` position,
-  `put_offset` takes an offset directly into the data.
+  `put_offset` takes the index of the pixel, counting from the start.
 
-  The offset would be the same as y * width + x.
+  The offset would be the same as y * width + x. It doesn't count any row padding.
   """
 
   @spec put_offset(mutable :: m(), offset :: pos_integer, color :: Color.t()) ::
           mutable :: m()
   def put_offset(mutable, offset, color)
 
-  def put_offset({@mutable, {w, h, :g}, p}, offset, color) when is_integer(offset) do
-    if offset > w * h, do: raise("Offset is out of bounds")
-    {:color_g, g} = Color.to_g(color)
-    nif_put(p, offset, g)
-    {@mutable, {w, h, :g}, p}
-  end
-
-  def put_offset({@mutable, {w, h, :ga}, p}, offset, color) when is_integer(offset) do
-    if offset > w * h, do: raise("Offset is out of bounds")
-    {:color_ga, {g, a}} = Color.to_ga(color)
-    nif_put(p, offset, g, a)
-    {@mutable, {w, h, :ga}, p}
-  end
-
-  def put_offset({@mutable, {w, h, :rgb}, p}, offset, color) when is_integer(offset) do
-    if offset > w * h, do: raise("Offset is out of bounds")
-    {:color_rgb, {r, g, b}} = Color.to_rgb(color)
-    nif_put(p, offset, r, g, b)
-    {@mutable, {w, h, :rgb}, p}
-  end
-
-  def put_offset({@mutable, {w, h, :rgba}, p}, offset, color) when is_integer(offset) do
-    if offset > w * h, do: raise("Offset is out of bounds")
-    {:color_rgba, {r, g, b, a}} = Color.to_rgba(color)
-    nif_put(p, offset, r, g, b, a)
-    {@mutable, {w, h, :rgba}, p}
+  def put_offset({@mutable, {w, h, _}, _} = mutable, offset, color)
+      when is_integer(offset) and offset >= 0 do
+    if offset >= w * h, do: raise("Offset is out of bounds")
+    put(mutable, rem(offset, w), div(offset, w), color)
   end
 
-  defp nif_put(_, _, _), do: :erlang.nif_error("Did not find nif_put_g")
-  defp nif_put(_, _, _, _), do: :erlang.nif_error("Did not find nif_put_ga")
-  defp nif_put(_, _, _, _, _), do: :erlang.nif_error("Did not find nif_put_rgb")
-  defp nif_put(_, _, _, _, _, _), do: :erlang.nif_error("Did not find nif_put_rgba")
+  defp nif_put(_, _, _, _, _, _), do: :erlang.nif_error("Did not find nif_put")
+  defp nif_put(_, _, _, _, _, _, _), do: :erlang.nif_error("Did not find nif_put")
+  defp nif_put(_, _, _, _, _, _, _, _), do: :erlang.nif_error("Did not find nif_put")
+  defp nif_put(_, _, _, _, _, _, _, _, _), do: :erlang.nif_error("Did not find nif_put")
 
   # --------------------------------------------------------
   @doc """
@@ -337,25 +369,25 @@ defmodule Scenic.Assets.Stream.Bitmap do
 
   def clear({@mutable, {w, h, :g}, p}, color) do
     {:color_g, g} = Color.to_g(color)
-    nif_clear(p, g)
+    nif_clear(p, w, stride(h, p), g)
     {@mutable, {w, h, :g}, p}
   end
 
   def clear({@mutable, {w, h, :ga}, p}, color) do
     {:color_ga, {g, a}} = Color.to_ga(color)
-    nif_clear(p, g, a)
+    nif_clear(p, w, stride(h, p), g, a)
     {@mutable, {w, h, :ga}, p}
   end
 
   def clear({@mutable, {w, h, :rgb}, p}, color) do
     {:color_rgb, {r, g, b}} = Color.to_rgb(color)
-    nif_clear(p, r, g, b)
+    nif_clear(p, w, stride(h, p), r, g, b)
     {@mutable, {w, h, :rgb}, p}
   end
 
   def clear({@mutable, {w, h, :rgba}, p}, color) do
     {:color_rgba, {r, g, b, a}} = Color.to_rgba(color)
-    nif_clear(p, r, g, b, a)
+    nif_clear(p, w, stride(h, p), r, g, b, a)
     {@mutable, {w, h, :rgba}, p}
   end
 
@@ -363,14 +395,105 @@ defmodule Scenic.Assets.Stream.Bitmap do
     raise "Texture.clear(...) is not supported for file encoded data"
   end
 
-  defp nif_clear(_, _), do: :erlang.nif_error("Did not find nif_clear_g")
-  defp nif_clear(_, _, _), do: :erlang.nif_error("Did not find nif_clear_ga")
-  defp nif_clear(_, _, _, _), do: :erlang.nif_error("Did not find nif_clear_rgb")
-  defp nif_clear(_, _, _, _, _), do: :erlang.nif_error("Did not find nif_clear_rgba")
+  defp nif_clear(_, _, _, _), do: :erlang.nif_error("Did not find nif_clear")
+  defp nif_clear(_, _, _, _, _), do: :erlang.nif_error("Did not find nif_clear")
+  defp nif_clear(_, _, _, _, _, _), do: :erlang.nif_error("Did not find nif_clear")
+  defp nif_clear(_, _, _, _, _, _, _), do: :erlang.nif_error("Did not find nif_clear")
+
+  # --------------------------------------------------------
+  @doc """
+  Copy a rectangle out of a bitmap into a new bitmap of the same depth.
+
+  The new bitmap is in the same state as the original, committed or mutable. It
+  shares no memory with the original and its rows are tightly packed, so it is
+  safe to change either one.
+
+  The rectangle must be inside the bitmap.
+
+  ```elixir
+  tile = Bitmap.crop(frame, 64, 32, 16, 16)
+  ```
+  """
+  @spec crop(
+          t_or_m :: t() | m(),
+          x :: non_neg_integer,
+          y :: non_neg_integer,
+          width :: non_neg_integer,
+          height :: non_neg_integer
+        ) :: t() | m()
+  def crop(bitmap, x, y, width, height)
+
+  def crop({kind, {w, h, depth}, p}, x, y, cw, ch)
+      when kind in [@bitmap, @mutable] and is_integer(x) and x >= 0 and is_integer(y) and
+             y >= 0 and is_integer(cw) and cw >= 0 and is_integer(ch) and ch >= 0 and
+             x + cw <= w and y + ch <= h do
+    {kind, {cw, ch, depth}, nif_crop(p, stride(h, p), bpp(depth), x, y, cw, ch)}
+  end
+
+  # --------------------------------------------------------
+  @doc """
+  Count the values of each channel over a rectangle of a bitmap.
+
+  Returns a tuple with one element per channel of the bitmap's depth, in order.
+  Each of those is a tuple of 256 counts, one for each value of the channel.
+
+  The rectangle is `{x, y, width, height}` and must be inside the bitmap. By default
+  the whole bitmap is counted.
+
+  ```elixir
+  {r, g, b} = Bitmap.histogram(frame)
+  darkest_reds = elem(r, 0)
+  ```
+  """
+  @spec histogram(t_or_m :: t() | m(), rect :: rect() | :all) :: tuple
+  def histogram({_, {_, h, depth} = meta, p}, rect \\ :all) do
+    {x, y, rw, rh} = region(meta, rect)
+    nif_histogram(p, stride(h, p), bpp(depth), x, y, rw, rh)
+  end
+
+  # --------------------------------------------------------
+  @doc """
+  Find the smallest, largest and average value of each channel over a rectangle
+  of a bitmap.
+
+  Returns a tuple with one `{min, max, mean}` per channel of the bitmap's depth,
+  in order. The mean is a float.
+
+  The rectangle is `{x, y, width, height}`. It must be inside the bitmap and can't
+  be empty. By default the whole bitmap is measured.
+
+  ```elixir
+  {{min, max, _mean}} = Bitmap.min_max_mean(grey_frame, {100, 100, 64, 64})
+  ```
+  """
+  @spec min_max_mean(t_or_m :: t() | m(), rect :: rect() | :all) :: tuple
+  def min_max_mean({_, {_, h, depth} = meta, p}, rect \\ :all) do
+    case region(meta, rect) do
+      {_, _, 0, _} -> raise ArgumentError, "min_max_mean needs a rect with some pixels in it"
+      {_, _, _, 0} -> raise ArgumentError, "min_max_mean needs a rect with some pixels in it"
+      {x, y, rw, rh} -> nif_min_max_mean(p, stride(h, p), bpp(depth), x, y, rw, rh)
+    end
+  end
+
+  defp region({w, h, _}, :all), do: {0, 0, w, h}
+
+  defp region({w, h, _}, {x, y, rw, rh} = rect)
+       when is_integer(x) and x >= 0 and is_integer(y) and y >= 0 and
+              is_integer(rw) and rw >= 0 and is_integer(rh) and rh >= 0 and
+              x + rw <= w and y + rh <= h,
+       do: rect
+
+  defp nif_crop(_, _, _, _, _, _, _), do: :erlang.nif_error("Did not find nif_crop")
+  defp nif_histogram(_, _, _, _, _, _, _), do: :erlang.nif_error("Did not find nif_histogram")
+
+  defp nif_min_max_mean(_, _, _, _, _, _, _),
+    do: :erlang.nif_error("Did not find nif_min_max_mean")
 
   # --------------------------------------------------------
   @doc false
   # @impl Scenic.Assets.Stream
+  # The drivers only get the meta, so they can't know about padded rows. Only
+  # tightly packed bitmaps are streamable.
   @spec valid?(bitmap :: t()) :: boolean
   def valid?(bitmap)
   def valid?({@bitmap, {w, h, :g}, p}), do: byte_size(p) == w * h
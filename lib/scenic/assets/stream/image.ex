@@ -30,8 +30,58 @@ defmodule Scenic.Assets.Stream.Image do
     { :noreply, state }
   end
   ```
+
+  ### Decoding
+
+  Images are normally decoded by the driver, on the GPU side. When you need the
+  pixels on the Elixir side instead, for example to crop, sample, or composite a
+  camera frame, `decode/2` turns a png or jpeg into a mutable
+  `Scenic.Assets.Stream.Bitmap` without going through an external library.
+
+  ```elixir
+  {:ok, bitmap} = Stream.Image.decode(bin, format: :rgb, roi: {0, 0, 320, 240})
+  ```
+
+  Decoding happens on a dirty scheduler. When a region of interest is given, only the
+  rows (and for jpegs, the blocks) needed to produce that region are decoded.
+
+  ### Encoding
+
+  Going the other way, `from_bitmap/1` compresses a committed bitmap into a lossless
+  png image. A 1080p `:rgba` bitmap is 8 MB of raw pixels, which is fine locally, but
+  too much for a driver that mirrors the scene over a network.
+
+  For a stream of frames, `delta/2` encodes only the rectangle of pixels that
+  changed since the previous frame, along with where to draw it.
+
+  ```elixir
+  case Stream.Image.delta(bitmap, last_bitmap) do
+    {:ok, {x, y}, img} -> send_patch(x, y, img)
+    :unchanged -> :ok
+  end
+  ```
+
+  The encoder favors speed over size. Each row is filtered, then compressed in a
+  single deflate pass, on a dirty scheduler.
   """
 
+  alias Scenic.Assets.Stream.Bitmap
+
+  @app Mix.Project.config()[:app]
+
+  # load the NIF
+  @compile {:autoload, false}
+  @on_load :load_nifs
+
+  @doc false
+  def load_nifs do
+    :ok =
+      @app
+      |> :code.priv_dir()
+      |> :filename.join(~c"image")
+      |> :erlang.load_nif(0)
+  end
+
   @type meta :: {width :: pos_integer, height :: pos_integer, mime :: String.t()}
 
   @type t :: {__MODULE__, meta :: meta(), data :: binary}
@@ -52,6 +102,130 @@ defmodule Scenic.Assets.Stream.Image do
     end
   end
 
+  @channels %{g: 1, ga: 2, rgb: 3, rgba: 4}
+
+  @decode_schema [
+    format: [type: {:in, [:rgb, :rgba]}, default: :rgba],
+    scale: [type: {:in, [1, 2, 4, 8]}, default: 1],
+    roi: [type: {:custom, __MODULE__, :validate_roi, []}],
+    commit: [type: :boolean, default: false]
+  ]
+
+  # --------------------------------------------------------
+  @doc """
+  Decode a png or jpeg image into a bitmap.
+
+  Accepts either a streamable image created by `from_binary/1` or the compressed
+  binary itself.
+
+  On success, this returns `{:ok, bitmap}`, where the bitmap is mutable unless the
+  `commit: true` option is set.
+
+  ### Options
+
+  * `:format` The depth of the bitmap. Either `:rgb` or `:rgba`. Defaults to `:rgba`.
+    Images without an alpha channel are decoded as opaque.
+  * `:scale` Decode a jpeg at `1/scale` of its size. One of `1`, `2`, `4` or `8`.
+    This is much faster than decoding the full image and scaling it down. Defaults
+    to `1`. Pngs can only be decoded at a scale of `1`.
+  * `:roi` A region of interest `{x, y, width, height}`, in the coordinates of the
+    scaled image. Only that region is decoded and returned. A width or height of `0`
+    extends the region to the edge of the image.
+  * `:commit` Return a committed bitmap. Defaults to `false`.
+
+  ### Errors
+
+  * `{:error, :invalid}` The data is not a valid png or jpeg.
+  * `{:error, :unsupported}` The image uses a feature the decoder doesn't handle.
+    Interlaced pngs and progressive or arithmetic coded jpegs are not supported.
+  * `{:error, :roi}` The region of interest isn't inside the image.
+  * `{:error, :memory}` The decoder couldn't allocate the memory it needs.
+  """
+  @spec decode(image :: t() | binary, opts :: Keyword.t()) ::
+          {:ok, Bitmap.t() | Bitmap.m()}
+          | {:error, :invalid | :unsupported | :roi | :memory}
+  def decode(image, opts \\ [])
+  def decode({__MODULE__, _, bin}, opts), do: decode(bin, opts)
+
+  def decode(bin, opts) when is_binary(bin) do
+    opts =
+      case NimbleOptions.validate(opts, @decode_schema) do
+        {:ok, opts} -> opts
+        {:error, error} -> raise Exception.message(error)
+      end
+
+    format = opts[:format]
+    {x, y, w, h} = opts[:roi] || {0, 0, 0, 0}
+
+    case nif_decode(bin, @channels[format], opts[:scale], x, y, w, h) do
+      {:ok, {width, height, pixels}} ->
+        bitmap = {:mutable_bitmap, {width, height, format}, pixels}
+        if opts[:commit], do: {:ok, Bitmap.commit(bitmap)}, else: {:ok, bitmap}
+
+      err ->
+        err
+    end
+  end
+
+  # the nif takes 32 bit unsigned values
+  defguardp is_u32(n) when is_integer(n) and n >= 0 and n <= 0xFFFFFFFF
+
+  @doc false
+  def validate_roi({x, y, w, h} = roi)
+      when is_u32(x) and is_u32(y) and is_u32(w) and is_u32(h) do
+    {:ok, roi}
+  end
+
+  def validate_roi(roi) do
+    {:error, "expected :roi to be {x, y, width, height}, got: #{inspect(roi)}"}
+  end
+
+  # --------------------------------------------------------
+  @doc """
+  Compress a committed bitmap into a streamable png image.
+
+  All bitmap depths are supported and the encoding is lossless.
+
+  On success, this returns `{:ok, img}`
+  """
+  @spec from_bitmap(bitmap :: Bitmap.t()) :: {:ok, t()} | {:error, :memory}
+  def from_bitmap({Bitmap, {w, h, format}, pixels}) do
+    encode(pixels, w, h, format, {0, 0, w, h})
+  end
+
+  # --------------------------------------------------------
+  @doc """
+  Compress the part of a committed bitmap that changed since a previous frame.
+
+  Both bitmaps must have the same size and depth. The smallest rectangle holding every
+  changed pixel is encoded as a png image.
+
+  Returns `{:ok, {x, y}, img}`, where `{x, y}` is the position of the image in the
+  bitmap, or `:unchanged` if the bitmaps are identical.
+  """
+  @spec delta(bitmap :: Bitmap.t(), previous :: Bitmap.t()) ::
+          {:ok, {x :: non_neg_integer, y :: non_neg_integer}, t()}
+          | :unchanged
+          | {:error, :memory}
+  def delta({Bitmap, {w, h, format} = meta, pixels}, {Bitmap, meta, previous}) do
+    case nif_diff(pixels, previous, w, h, @channels[format]) do
+      :same ->
+        :unchanged
+
+      {x, y, _, _} = rect ->
+        with {:ok, img} <- encode(pixels, w, h, format, rect) do
+          {:ok, {x, y}, img}
+        end
+    end
+  end
+
+  defp encode(pixels, w, h, format, {x, y, rw, rh}) do
+    case nif_encode(pixels, w, h, @channels[format], x, y, rw, rh) do
+      {:ok, png} -> {:ok, {__MODULE__, {rw, rh, "image/png"}, png}}
+      err -> err
+    end
+  end
+
   # # --------------------------------------------------------
   @doc false
   # @impl Scenic.Assets.Stream
@@ -63,4 +237,10 @@ defmodule Scenic.Assets.Stream.Image do
   end
 
   def valid?(_), do: false
+
+  # --------------------------------------------------------
+  # nif stubs
+  defp nif_decode(_, _, _, _, _, _, _), do: :erlang.nif_error("Did not find nif_decode")
+  defp nif_encode(_, _, _, _, _, _, _, _), do: :erlang.nif_error("Did not find nif_encode")
+  defp nif_diff(_, _, _, _, _), do: :erlang.nif_error("Did not find nif_diff")
 end
@@ -188,7 +188,7 @@ defmodule Scenic.Component.Button do
 
     ascent = FontMetrics.ascent(font_size, fm)
     descent = FontMetrics.descent(font_size, fm)
-    fm_width = FontMetrics.width(text, font_size, fm)
+    fm_width = Static.Font.width(text, font_size, font)
 
     width =
       case opts[:width] || opts[:w] do
@@ -241,7 +241,7 @@ defmodule Scenic.Component.Button do
     font_size = opts[:button_font_size] || @default_font_size
 
     ascent = FontMetrics.ascent(font_size, fm)
-    fm_width = FontMetrics.width(text, font_size, fm)
+    fm_width = Static.Font.width(text, font_size, @default_font)
 
     width =
       case opts[:width] || opts[:w] do
@@ -155,6 +155,7 @@ defmodule Scenic.Driver do
   alias Scenic.Driver
   alias Scenic.ViewPort
   alias Scenic.Color
+  alias Scenic.Telemetry
 
   # import IEx
   require Logger
@@ -493,10 +494,17 @@ defmodule Scenic.Driver do
           |> List.flatten()
           |> Enum.uniq()
 
-        case module.update_scene(ids, %{driver | dirty_ids: ids}) do
-          {:ok, %Driver{} = driver} -> driver
-          other -> raise state_msg("update_scene", other)
-        end
+        Telemetry.span(
+          [:driver, :update_scene],
+          %{driver: module},
+          fn ->
+            case module.update_scene(ids, %{driver | dirty_ids: ids}) do
+              {:ok, %Driver{} = driver} -> driver
+              other -> raise state_msg("update_scene", other)
+            end
+          end,
+          fn _ -> {%{scripts: length(ids)}, %{}} end
+        )
 
       false ->
         driver
@@ -790,8 +798,13 @@ defmodule Scenic.Driver do
 
   defp do_put_scripts([], driver), do: {:noreply, driver}
 
-  defp do_put_scripts(ids, %Driver{dirty_ids: dirty_ids} = driver) do
-    {:noreply, request_update(%{driver | dirty_ids: [ids | dirty_ids]})}
+  defp do_put_scripts(ids, %Driver{module: module, dirty_ids: dirty_ids} = driver) do
+    Telemetry.span(
+      [:driver, :put_scripts],
+      %{driver: module},
+      fn -> {:noreply, request_update(%{driver | dirty_ids: [ids | dirty_ids]})} end,
+      fn _ -> {%{scripts: length(ids)}, %{}} end
+    )
   end
 
   defp do_input_limit_expired(
@@ -134,6 +134,9 @@ defmodule Scenic.Graph do
   function is relatively heavy when the graph references other scenes. The recommended
   pattern is to make multiple changes to the graph .
 
+  When changing many primitives at once, `Graph.modify_many/2` and `Graph.put_data/2`
+  apply all the changes in a single pass.
+
   ## Accessing Primitives
 
   When using a Graph, it is extremely common to access and modify primitives. The way
@@ -164,13 +167,15 @@ defmodule Scenic.Graph do
 
   @root_id :_root_
 
-  defstruct primitives: %{}, ids: %{}, next_uid: 1, add_to: 0, animations: []
+  defstruct primitives: %{}, ids: %{}, next_uid: 1, add_to: 0, animations: [], bounds_cache: %{}
 
   @type t :: %__MODULE__{
           primitives: map,
           ids: map,
           next_uid: pos_integer,
-          add_to: non_neg_integer
+          add_to: non_neg_integer,
+          animations: [Scenic.Graph.Animation.t()],
+          bounds_cache: map
         }
 
   @type bounds :: {left :: number, top :: number, right :: number, bottom :: number}
@@ -274,10 +279,14 @@ defmodule Scenic.Graph do
   group are deleted as well.
   """
   @spec delete(graph :: t(), id :: any) :: t()
-  def delete(%__MODULE__{primitives: primitives, ids: ids} = graph, id) do
+  def delete(%__MODULE__{ids: ids} = graph, id) do
     # resolve the id into a list of uids
     uids = Map.get(ids, id, [])
 
+    # the groups the deleted primitives were in need new bounds
+    %__MODULE__{primitives: primitives} =
+      graph = Enum.reduce(uids, graph, &invalidate_bounds(&2, &1))
+
     # delete each uid. Keep track of the primitives map, and build
     # list of descendands if we're deleting a group
     {primitives, descendants} =
@@ -304,6 +313,7 @@ defmodule Scenic.Graph do
     graph
     |> Map.put(:primitives, primitives)
     |> Map.put(:ids, ids)
+    |> Map.put(:bounds_cache, Map.drop(graph.bounds_cache, descendants))
   end
 
   # If the thing we're deleting is a group, find all descendants of the
@@ -385,11 +395,36 @@ defmodule Scenic.Graph do
         raise Error, message: @err_msg_put
 
       _ ->
-        Map.put(
-          graph,
-          :primitives,
-          Map.put(primitives, uid, primitive)
-        )
+        graph
+        |> Map.put(:primitives, Map.put(primitives, uid, primitive))
+        |> invalidate_bounds(uid)
+    end
+  end
+
+  @doc false
+  # put a batch of already validated primitives by uid, in one pass
+  @spec put_primitives(graph :: t(), primitives :: %{non_neg_integer => Primitive.t()}) :: t()
+  def put_primitives(%__MODULE__{} = graph, changed) when changed == %{}, do: graph
+
+  def put_primitives(%__MODULE__{primitives: primitives} = graph, changed) do
+    graph = %{graph | primitives: Map.merge(primitives, changed)}
+    Enum.reduce(changed, graph, fn {uid, _}, g -> invalidate_bounds(g, uid) end)
+  end
+
+  # --------------------------------------------------------
+  # drop the cached bounds of every group on the path from uid up to the root.
+  # Nothing else in the cache depends on what changed.
+  defp invalidate_bounds(%__MODULE__{bounds_cache: cache} = graph, _uid) when cache == %{},
+    do: graph
+
+  defp invalidate_bounds(%__MODULE__{primitives: primitives, bounds_cache: cache} = graph, uid) do
+    %{graph | bounds_cache: drop_bounds_path(cache, primitives, uid)}
+  end
+
+  defp drop_bounds_path(cache, primitives, uid) do
+    case primitives[uid] do
+      %Primitive{parent_uid: puid} -> drop_bounds_path(Map.delete(cache, uid), primitives, puid)
+      _ -> cache
     end
   end
 
@@ -556,6 +591,7 @@ defmodule Scenic.Graph do
           |> Group.insert_at(index, uid)
           |> (&Map.put(p_map, puid, &1)).()
           |> (&Map.put(graph, :primitives, &1)).()
+          |> invalidate_bounds(puid)
       end
 
     # if the incoming primitive has an id set on it, map it to the uid
@@ -665,6 +701,119 @@ defmodule Scenic.Graph do
     |> Enum.reduce(graph, &modify_by_uid(&2, &1, action))
   end
 
+  # --------------------------------------------------------
+  @doc """
+  Modify the primitives of many different ids in one pass.
+
+  Takes a map, or a list of `{id, action}` tuples, and passes the primitives with
+  each id to its action as `modify/3` would. The primitives an action changes are
+  put into the graph together, and only they are marked as changed. The cached
+  bounds of the rest of the graph are kept.
+
+  In a list, the actions for the same id are applied in order.
+
+  This is much faster than a pipeline of `modify/3` calls when updating a lot of
+  primitives, such as the cells of a large table.
+
+  Examples:
+
+      Graph.modify_many(graph, %{
+        :title => &text(&1, "Totals"),
+        {:cell, 0, 0} => &text(&1, "12"),
+        {:cell, 0, 1} => &update_opts(&1, fill: :red)
+      })
+  """
+  @spec modify_many(
+          graph :: t(),
+          actions ::
+            %{any => (Primitive.t() -> Primitive.t())}
+            | [{any, (Primitive.t() -> Primitive.t())}]
+        ) :: t()
+  def modify_many(%__MODULE__{ids: ids, primitives: primitives} = graph, actions) do
+    changed =
+      Enum.reduce(actions, %{}, fn {id, action}, changed when is_function(action, 1) ->
+        ids
+        |> Map.get(id, [])
+        |> Enum.reduce(changed, fn uid, changed ->
+          p = Map.get(changed, uid, primitives[uid])
+
+          case action.(p) do
+            ^p -> changed
+            %Primitive{} = p -> Map.put(changed, uid, p)
+            _ -> raise Error, message: "Action must return a valid primitive"
+          end
+        end)
+      end)
+
+    put_primitives(graph, changed)
+  end
+
+  @doc """
+  Set the data of the primitives of many different ids in one pass.
+
+  Takes a map, or a list of `{id, data}` tuples. Each primitive validates its new
+  data the same way it does when it is added. Primitives whose data is unchanged
+  are left alone. See `modify_many/2`.
+
+  Examples:
+
+      Graph.put_data(graph, %{:title => "Totals", {:cell, 0, 0} => "12", :bar => {200, 20}})
+  """
+  @spec put_data(graph :: t(), data :: %{any => any} | [{any, any}]) :: t()
+  def put_data(%__MODULE__{} = graph, data) do
+    modify_many(graph, Enum.map(data, fn {id, d} -> {id, &Primitive.put(&1, d)} end))
+  end
+
+  # ============================================================================
+  # animations
+
+  @doc """
+  Animate a transform, style or the data of one or more primitives.
+
+  The primitives with the given id are set to the end value `to` right away. When
+  the graph is pushed, the scene puts a frame of it to the ViewPort about every
+  16ms, easing from the current value to `to`, until the animation is done.
+
+  `key` is one of the `:translate`, `:scale`, `:rotate` or `:pin` transforms, a
+  style such as `:fill`, `:stroke` or `:font_size`, or `:data` for the primitive's
+  own data.
+
+  Options:
+  * `:duration` - in milliseconds. Default `300`.
+  * `:easing` - `:linear`, `:ease_in`, `:ease_out`, `:ease_in_out` or
+    `:ease_out_back`. Default `:ease_in_out`.
+  * `:delay` - milliseconds to wait before starting. Default `0`.
+  * `:from` - the start value, instead of the current one.
+
+  Examples:
+
+      graph
+      |> Graph.animate(:ball, :translate, {400, 300}, duration: 500)
+      |> Graph.animate(:ball, :fill, :red, easing: :ease_out)
+      |> Graph.animate(:bar, :data, {200, 20}, from: {0, 20})
+
+  See `Scenic.Graph.Animation` for the details.
+  """
+  @spec animate(
+          graph :: t(),
+          id :: any,
+          key :: atom,
+          to :: any,
+          opts :: Keyword.t()
+        ) :: t()
+  def animate(%__MODULE__{} = graph, id, key, to, opts \\ []) when is_atom(key) do
+    Scenic.Graph.Animation.add(graph, id, key, to, opts)
+  end
+
+  @doc """
+  Returns `true` if any of the graph's animations haven't finished yet.
+  """
+  @spec animating?(graph :: t()) :: boolean
+  def animating?(%__MODULE__{animations: animations}) do
+    now = Scenic.Graph.Animation.now()
+    Enum.any?(animations, &(&1.start + &1.duration > now))
+  end
+
   # ============================================================================
   # map a graph via traversal from the root node
   @doc """
@@ -849,4 +998,29 @@ defmodule Scenic.Graph do
   """
   @spec bounds(graph :: t()) :: Scenic.Graph.bounds() | nil
   defdelegate bounds(graph), to: Scenic.Graph.Bounds, as: :compute
+
+  # --------------------------------------------------------
+  @doc """
+  Compute the bounds of the graph and keep them in it.
+
+  The bounds of every group are cached, along with the transform and styles it
+  inherited. Changing a primitive with `modify/3`, `modify_many/2`, `add/2`,
+  `delete/2` and the like drops only the cached groups on the path from that
+  primitive up to the root, so the next `bounds/1` walks just the parts of the
+  graph that changed.
+
+  This is worth doing in layout code that repeatedly changes a large graph and
+  then measures it.
+
+  ```elixir
+  graph =
+    graph
+    |> Graph.modify(:label, &text(&1, "A longer label"))
+    |> Graph.cache_bounds()
+
+  {left, top, right, bottom} = Graph.bounds(graph)
+  ```
+  """
+  @spec cache_bounds(graph :: t()) :: t()
+  defdelegate cache_bounds(graph), to: Scenic.Graph.Bounds, as: :cache
 end
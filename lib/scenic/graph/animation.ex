@@ -0,0 +1,291 @@
+defmodule Scenic.Graph.Animation do
+  @moduledoc """
+  Tween the transforms, styles and data of primitives in a graph.
+
+  You don't normally use this module directly. Start an animation with
+  `Scenic.Graph.animate/5` and push the graph as usual. The scene then puts a
+  frame of the graph to the ViewPort about every 16ms until its animations are
+  done.
+
+  ```elixir
+  graph =
+    graph
+    |> Graph.animate(:ball, :translate, {400, 300}, duration: 500)
+    |> Graph.animate(:ball, :fill, :red, easing: :ease_out)
+
+  {:noreply, push_graph(scene, graph)}
+  ```
+
+  ### End state
+
+  `animate/5` sets the primitives to the end state of the animation right away.
+  The graph you hold on to always describes where things end up, and `bounds/1`,
+  `get/2` and the like see the end state. Only the frames that are put to the
+  ViewPort show the values in between.
+
+  Animating a value that is already animating replaces the old animation, which
+  then starts from the value it was last set to. Pass `:from` to start somewhere
+  else.
+
+  ### Frames
+
+  Each frame eases every running animation in the graph in a single native call,
+  applies the changed primitives to the graph in one pass, and puts the graph once.
+  The cost of a frame is one compile of the graph plus a little per animated value,
+  no matter how many values are animating.
+
+  The scene keeps the last graph it was given with running animations, so keep
+  the scene that `Scenic.Scene.push_graph/4` returns.
+
+  ### What can be animated
+
+  * The `:translate`, `:scale`, `:rotate` and `:pin` transforms.
+  * Any style whose value is made of numbers and colors, such as `:fill` and
+    `:stroke` with colors, or `:font_size`.
+  * The data of a primitive when it is made of numbers, such as the size of a
+    rect or the radius of a circle, by animating `:data`.
+
+  The start and end values must have the same shape. For example a `:scale` can't
+  animate from `2` to `{2, 3}`.
+
+  ### Easings
+
+  `:linear`, `:ease_in`, `:ease_out`, `:ease_in_out` (cubic) and `:ease_out_back`,
+  which overshoots the end a little before settling.
+  """
+
+  alias Scenic.Graph
+  alias Scenic.Primitive
+  alias Scenic.Primitive.Style
+
+  @app Mix.Project.config()[:app]
+
+  # load the NIF
+  @compile {:autoload, false}
+  @on_load :load_nifs
+
+  @doc false
+  def load_nifs do
+    :ok =
+      @app
+      |> :code.priv_dir()
+      |> :filename.join(~c"tween")
+      |> :erlang.load_nif(0)
+  end
+
+  # in the same order as the TWEEN_ constants in tween_math.h
+  @easings [:linear, :ease_in, :ease_out, :ease_in_out, :ease_out_back]
+
+  @shortcuts %{t: :translate, s: :scale, r: :rotate}
+
+  @opts_schema [
+    duration: [type: :pos_integer, default: 300],
+    easing: [type: {:in, @easings}, default: :ease_in_out],
+    delay: [type: :non_neg_integer, default: 0],
+    from: [type: :any]
+  ]
+
+  @type easing :: :linear | :ease_in | :ease_out | :ease_in_out | :ease_out_back
+
+  @type t :: %__MODULE__{
+          key: atom,
+          kind: :transform | :style | :data,
+          easing: non_neg_integer,
+          start: integer,
+          duration: pos_integer,
+          targets: [{uid :: non_neg_integer, from :: [number], to :: any}]
+        }
+  defstruct key: nil, kind: nil, easing: 0, start: 0, duration: 300, targets: []
+
+  # --------------------------------------------------------
+  @doc """
+  The clock the animations run on, in milliseconds.
+  """
+  @spec now() :: integer
+  def now(), do: :erlang.monotonic_time(:millisecond)
+
+  # --------------------------------------------------------
+  @doc false
+  # see Graph.animate/5
+  @spec add(
+          graph :: Graph.t(),
+          id :: any,
+          key :: atom,
+          to :: any,
+          opts :: Keyword.t()
+        ) :: Graph.t()
+  def add(%Graph{ids: ids, primitives: primitives} = graph, id, key, to, opts) do
+    opts =
+      case NimbleOptions.validate(opts, @opts_schema) do
+        {:ok, opts} -> opts
+        {:error, error} -> raise Exception.message(error)
+      end
+
+    key = Map.get(@shortcuts, key, key)
+    kind = kind!(key)
+    uids = Map.get(ids, id, [])
+
+    targets =
+      Enum.map(uids, fn uid ->
+        p = primitives[uid]
+        from = from!(p, kind, key, opts)
+        to = p |> put(kind, key, to) |> get(kind, key)
+
+        if shape(from) != shape(to) do
+          raise Graph.Error,
+            message: "Can't animate #{inspect(key)} from #{inspect(from)} to #{inspect(to)}"
+        end
+
+        {uid, components(from), to}
+      end)
+
+    now = now()
+
+    animation = %__MODULE__{
+      key: key,
+      kind: kind,
+      easing: Enum.find_index(@easings, &(&1 == opts[:easing])),
+      start: now + opts[:delay],
+      duration: opts[:duration],
+      targets: targets
+    }
+
+    graph = Graph.modify(graph, id, &put(&1, kind, key, to))
+    %{graph | animations: replace(graph.animations, animation, now)}
+  end
+
+  # drop the finished animations, and the targets the new one takes over
+  defp replace(animations, %{key: key, targets: targets} = animation, now) do
+    taken = Enum.map(targets, &elem(&1, 0))
+
+    animations
+    |> Enum.reject(&(&1.start + &1.duration <= now))
+    |> Enum.map(fn
+      %{key: ^key, targets: targets} = a ->
+        %{a | targets: Enum.reject(targets, &(elem(&1, 0) in taken))}
+
+      a ->
+        a
+    end)
+    |> Enum.reject(&(&1.targets == []))
+    |> Kernel.++([animation])
+  end
+
+  defp kind!(:data), do: :data
+
+  defp kind!(key) do
+    cond do
+      key in [:translate, :scale, :rotate, :pin] -> :transform
+      Map.has_key?(Style.opts_map(), key) -> :style
+      true -> raise Graph.Error, message: "Can't animate #{inspect(key)}"
+    end
+  end
+
+  defp from!(p, kind, key, opts) do
+    case Keyword.fetch(opts, :from) do
+      {:ok, from} -> p |> put(kind, key, from) |> get(kind, key)
+      :error -> get(p, kind, key) || default(key)
+    end
+    |> case do
+      nil -> raise Graph.Error, message: "Nothing to animate #{inspect(key)} from. Set :from"
+      from -> from
+    end
+  end
+
+  defp default(:translate), do: {0, 0}
+  defp default(:scale), do: 1
+  defp default(:rotate), do: 0
+  defp default(_), do: nil
+
+  # validated gets and puts, for setting up an animation
+  defp get(p, :data, _), do: p.data
+  defp get(p, :transform, key), do: Primitive.get_transform(p, key)
+  defp get(p, :style, key), do: Primitive.get_style(p, key)
+
+  defp put(p, :data, _, data), do: Primitive.put(p, data)
+  defp put(p, _, key, value), do: Primitive.merge_opts(p, [{key, value}])
+
+  # the numbers in a value, in order. Anything else has to match exactly.
+  defp shape(n) when is_number(n), do: :number
+  defp shape(t) when is_tuple(t), do: t |> Tuple.to_list() |> Enum.map(&shape/1)
+  defp shape(a) when is_atom(a), do: a
+  defp shape(v), do: raise(Graph.Error, message: "Can't animate #{inspect(v)}")
+
+  defp components(n) when is_number(n), do: [n]
+  defp components(t) when is_tuple(t), do: t |> Tuple.to_list() |> Enum.flat_map(&components/1)
+  defp components(_), do: []
+
+  # --------------------------------------------------------
+  @doc """
+  The graph as it is at time `now`, and whether any of its animations are still
+  running.
+  """
+  @spec frame(graph :: Graph.t(), now :: integer) :: {Graph.t(), running :: boolean}
+  def frame(graph, now \\ now())
+
+  def frame(%Graph{animations: []} = graph, _now), do: {graph, false}
+
+  def frame(%Graph{animations: animations} = graph, now) do
+    # an animation that hasn't started yet shows its start. One that has finished
+    # shows its end state, which is already in the graph.
+    running =
+      for %{start: start, duration: duration} = a <- animations,
+          start + duration > now,
+          do: {a, max(now - start, 0) / duration}
+
+    case running do
+      [] -> {graph, false}
+      running -> {Graph.put_primitives(graph, tween(running, graph.primitives)), true}
+    end
+  end
+
+  # ease every running value in one call, then put them into the primitives
+  defp tween(running, primitives) do
+    records =
+      for {%{easing: easing, targets: targets}, t} <- running,
+          {_uid, from, to} <- targets,
+          {f, to} <- Enum.zip(from, components(to)) do
+        <<easing::float-64-native, t::float-64-native, f::float-64-native,
+          to::float-64-native>>
+      end
+
+    values = for <<v::float-64-native <- nif_tween(IO.iodata_to_binary(records))>>, do: v
+
+    {changed, []} =
+      Enum.reduce(running, {%{}, values}, fn {%{kind: kind, key: key} = a, _}, acc ->
+        Enum.reduce(a.targets, acc, fn {uid, _, to}, {changed, values} ->
+          {value, values} = rebuild(to, values)
+          p = Map.get(changed, uid, primitives[uid])
+          {Map.put(changed, uid, set(p, kind, key, value)), values}
+        end)
+      end)
+
+    changed
+  end
+
+  # trusted puts, for the values in between validated ends
+  defp set(p, :data, _, data), do: %{p | data: data}
+  defp set(p, :transform, key, v), do: %{p | transforms: Map.put(p.transforms, key, v)}
+  defp set(p, :style, key, v), do: %{p | styles: Map.put(p.styles, key, v)}
+
+  # put the eased values back into the shape of the end value
+  defp rebuild(n, [v | values]) when is_number(n), do: {v, values}
+
+  defp rebuild({:color_rgba, {_, _, _, _}}, [r, g, b, a | values]) do
+    {{:color_rgba, {channel(r), channel(g), channel(b), channel(a)}}, values}
+  end
+
+  defp rebuild(t, values) when is_tuple(t) do
+    {list, values} = t |> Tuple.to_list() |> Enum.map_reduce(values, &rebuild/2)
+    {List.to_tuple(list), values}
+  end
+
+  defp rebuild(other, values), do: {other, values}
+
+  # an overshooting easing can take a color out of range
+  defp channel(c), do: c |> round() |> max(0) |> min(255)
+
+  # --------------------------------------------------------
+  # nif stubs
+  defp nif_tween(_), do: :erlang.nif_error("Did not find nif_tween")
+end
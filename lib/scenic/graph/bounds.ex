@@ -27,55 +27,145 @@ defmodule Scenic.Graph.Bounds do
   # import IEx
 
   @spec compute(graph :: Graph.t()) :: Graph.bounds() | nil
-  def compute(%Scenic.Graph{primitives: primitives}) do
-    primitive(
-      nil,
-      primitives[0],
+  def compute(%Scenic.Graph{} = graph) do
+    {bounds, _cache} = root(graph)
+    bounds
+  end
+
+  # --------------------------------------------------------
+  # Compute the bounds and keep the per group results in the graph. Groups
+  # that haven't changed since, and whose parent transform and styles are the
+  # same, are not walked again. Graph invalidates the cached groups along the
+  # path to anything it changes.
+  @spec cache(graph :: Graph.t()) :: Graph.t()
+  def cache(%Scenic.Graph{} = graph) do
+    {_bounds, cache} = root(graph)
+    %{graph | bounds_cache: cache}
+  end
+
+  defp root(%Scenic.Graph{primitives: primitives, bounds_cache: cache}) do
+    group(
+      0,
       primitives,
       Matrix.identity(),
-      Scenic.Primitive.Style.default()
+      Scenic.Primitive.Style.default(),
+      cache
     )
   end
 
-  defp primitive(bounds, primitive, primitives, mx, st)
+  # --------------------------------------------------------
+  # Bounds of a list of sibling primitives, in the local coordinate space
+  # they are drawn in. Used by the compiler to emit culling regions.
+  #
+  # Returns :error if anything in the subtree can't be bounded. That is
+  # scripts, components that don't implement bounds/2 and custom primitives.
+  # The result is padded by the widest stroke in the subtree.
+  @bounded [
+    Primitive.Arc,
+    Primitive.Circle,
+    Primitive.Ellipse,
+    Primitive.Line,
+    Primitive.Path,
+    Primitive.Quad,
+    Primitive.Rectangle,
+    Primitive.RoundedRectangle,
+    Primitive.Sector,
+    Primitive.Sprites,
+    Primitive.Text,
+    Primitive.Triangle
+  ]
+
+  @spec local(ids :: [non_neg_integer], primitives :: map, styles :: map) ::
+          {:ok, Graph.bounds()} | :error
+  def local(ids, primitives, %{} = st) do
+    with true <- Enum.all?(ids, &bounded?(primitives[&1], primitives)),
+         {{l, t, r, b}, _} <- children(ids, primitives, Matrix.identity(), st, %{}) do
+      w = Map.get(st, :stroke_width, 0)
+      w = Enum.reduce(ids, w, &max_stroke(primitives[&1], primitives, &2))
+
+      {:ok, {l - w, t - w, r + w, b + w}}
+    else
+      _ -> :error
+    end
+  end
+
+  defp bounded?(%Primitive{styles: %{hidden: true}}, _), do: true
+
+  defp bounded?(%Primitive{module: Primitive.Group, data: ids}, ps) do
+    Enum.all?(ids, &bounded?(ps[&1], ps))
+  end
+
+  defp bounded?(%Primitive{module: Primitive.Component, data: {mod, _, _}}, _) do
+    Kernel.function_exported?(mod, :bounds, 2)
+  end
+
+  defp bounded?(%Primitive{module: mod}, _), do: mod in @bounded
+
+  defp max_stroke(%Primitive{styles: %{hidden: true}}, _, w), do: w
+
+  defp max_stroke(%Primitive{module: mod, data: data} = p, ps, w) do
+    w =
+      case p do
+        %{styles: %{stroke: {sw, _}}} when sw > w -> sw
+        _ -> w
+      end
+
+    case mod do
+      Primitive.Group -> Enum.reduce(data, w, &max_stroke(ps[&1], ps, &2))
+      _ -> w
+    end
+  end
+
+  # --------------------------------------------------------
+  # The bounds of a group, given the transform and styles it inherits. A cached
+  # result is used if it was computed with the same inherited transform and
+  # styles. Otherwise the children are walked, with the points of all the leaf
+  # primitives projected together in one call.
+  defp group(uid, ps, mx, st, cache) do
+    case cache do
+      %{^uid => {^mx, ^st, bounds}} ->
+        {bounds, cache}
+
+      _ ->
+        case ps[uid] do
+          %Primitive{styles: %{hidden: true}} ->
+            {nil, cache}
+
+          %Primitive{data: ids} = p ->
+            {bounds, cache} = children(ids, ps, local_tx(p, mx), prep_styles(p, st), cache)
+            {bounds, Map.put(cache, uid, {mx, st, bounds})}
+        end
+    end
+  end
+
+  defp children(ids, ps, mx, st, cache) do
+    {regions, bounds, cache} =
+      Enum.reduce(ids, {[], nil, cache}, &child(&1, ps[&1], ps, mx, st, &2))
+
+    {set_bounds(Matrix.project_bounds(regions), bounds), cache}
+  end
 
   # skip hidden primitives
-  defp primitive(out, %Primitive{styles: %{hidden: true}}, _, _, _), do: out
-
-  defp primitive(
-         out,
-         %Primitive{module: Primitive.Group, data: ids} = p,
-         ps,
-         mx,
-         st
-       ) do
-    styles = prep_styles(p, st)
-    matrix = local_tx(p, mx)
+  defp child(_uid, %Primitive{styles: %{hidden: true}}, _, _, _, acc), do: acc
 
-    Enum.reduce(ids, out, &primitive(&2, ps[&1], ps, matrix, styles))
+  defp child(uid, %Primitive{module: Primitive.Group}, ps, mx, st, {regions, bounds, cache}) do
+    {group_bounds, cache} = group(uid, ps, mx, st, cache)
+    {regions, set_bounds(group_bounds, bounds), cache}
   end
 
-  defp primitive(
-         out,
-         %Primitive{module: mod, data: data} = p,
-         _ps,
-         mx,
-         st
-       ) do
+  defp child(_uid, %Primitive{module: mod, data: data} = p, _, mx, st, acc) do
+    {regions, bounds, cache} = acc
     styles = prep_styles(p, st)
     matrix = local_tx(p, mx)
 
-    points(mod, data, styles)
-    # we now have a list of lists of points. Some of the primitives
-    # have multiple discrete regions, which are the inner lists
-    # map these into bounds
-    |> Enum.map(fn pts ->
-      pts
-      |> Vector2.project(matrix)
-      |> Vector2.bounds()
-    end)
-    # we now have a list of bounds. Reduce that into the final bounds
-    |> Enum.reduce(out, &set_bounds(&1, &2))
+    # some of the primitives have multiple discrete regions. They are all
+    # projected by the same matrix
+    regions =
+      mod
+      |> points(data, styles)
+      |> Enum.reduce(regions, &[{matrix, &1} | &2])
+
+    {regions, bounds, cache}
   end
 
   defp prep_styles(%Primitive{} = p, %{} = st) do
@@ -171,12 +261,11 @@ defmodule Scenic.Graph.Bounds do
     ascent = FontMetrics.ascent(font_size, fm)
     descent = FontMetrics.descent(font_size, fm)
 
-    # width is of the longest line
+    # width is of the longest line. All the lines are measured in one call
     width =
-      Enum.reduce(lines, 0, fn line, acc ->
-        w = FontMetrics.width(line, font_size, fm)
-        if w > acc, do: w, else: acc
-      end)
+      lines
+      |> Static.Font.widths(font_size, st[:font])
+      |> Enum.max()
 
     natural_height = ascent - descent
     height = natural_height * line_height * (line_count - 1) + natural_height
@@ -225,6 +314,13 @@ defmodule Scenic.Graph.Bounds do
     end
   end
 
+  defp points(Primitive.Sprites, {_id, cmds}, _st) when is_binary(cmds) do
+    for <<_::binary-size(16), x::float-32-big, y::float-32-big, w::float-32-big,
+          h::float-32-big, _::binary-size(4) <- cmds>> do
+      [{x, y}, {x + w, y}, {x + w, y + h}, {x, y + h}, {x, y}]
+    end
+  end
+
   defp points(Primitive.Sprites, {_id, cmds}, _st) do
     Enum.reduce(cmds, [], fn {_, _, {x, y}, {w, h}, _alpha}, acc ->
       [[{x, y}, {x + w, y}, {x + w, y + h}, {x, y + h}, {x, y}] | acc]
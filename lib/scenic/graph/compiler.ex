@@ -10,14 +10,17 @@ defmodule Scenic.Graph.Compiler do
 
   alias Scenic.Script
   alias Scenic.Primitive
+  alias Scenic.Assets.Static
   alias Scenic.Graph
+  alias Scenic.Graph.Bounds
   alias Scenic.Color
   alias Scenic.Primitive.Style.Theme
   alias Scenic.Graph.Compiler
+  alias Scenic.Telemetry
 
   # import IEx
 
-  defstruct set: %{}, set_stack: [], reqs: nil, req_stack: []
+  defstruct set: %{}, set_stack: [], reqs: nil, req_stack: [], cull: false
 
   # ========================================================
   # internal helpers for working with the compiler state
@@ -52,19 +55,34 @@ defmodule Scenic.Graph.Compiler do
   # ========================================================
 
   # compile a graph into a list of scripts -> [{id,script}|...]
-  @spec compile(graph :: Graph.t()) :: {:ok, Script.t()}
-  def compile(graph)
+  #
+  # options
+  #   cull: true - wrap every group that can be bounded in a :cull op so
+  #                drivers can skip groups that are off screen
+  @spec compile(graph :: Graph.t(), opts :: Keyword.t()) :: {:ok, Script.t()}
+  def compile(graph, opts \\ [])
+
+  def compile(%Graph{primitives: primitives} = graph, opts) do
+    Telemetry.span([:graph, :compile], %{}, fn -> do_compile(graph, opts) end, fn {:ok, ops} ->
+      {Map.put(Telemetry.script_size(ops), :primitives, map_size(primitives)), %{}}
+    end)
+  end
+
+  defp do_compile(%Graph{primitives: primitives}, opts) do
+    cull = !!opts[:cull]
 
-  def compile(%Graph{primitives: primitives}) do
     {ops, _} =
       compile_primitive(
         Script.start(),
         primitives[0],
         primitives,
-        %Compiler{reqs: Scenic.Primitive.Style.default()}
+        %Compiler{reqs: Scenic.Primitive.Style.default(), cull: cull}
       )
 
-    {:ok, Script.finish(ops)}
+    case cull do
+      true -> {:ok, ops |> Script.finish() |> Script.resolve_culls()}
+      false -> {:ok, Script.finish(ops)}
+    end
   end
 
   defp compile_primitive(ops, primitive, primitives, state)
@@ -202,12 +220,7 @@ defmodule Scenic.Graph.Compiler do
   # The group is the root and also the only primitive doesn't set its own styles
   defp do_primitive(%Primitive{module: Primitive.Group, data: ids}, primitives, state) do
     {st_ops, state} = compile_styles([:scissor, :fill, :stroke], state)
-
-    {ops, state} =
-      Enum.reduce(ids, {[], state}, fn id, {ops, state} ->
-        compile_primitive(ops, primitives[id], primitives, state)
-      end)
-
+    {ops, state} = compile_group(ids, primitives, state)
     {ops, st_ops, state}
   end
 
@@ -244,13 +257,56 @@ defmodule Scenic.Graph.Compiler do
     {Script.draw_text([], text, spacing), st_ops, state}
   end
 
+  # A filled rect that is no bigger than an image packed into an atlas shows just
+  # that image, so draw it as a sprite from the atlas. This saves the driver from
+  # switching to the image's own texture.
+  defp do_primitive(
+         %Primitive{module: Primitive.Rectangle, data: {w, h}} = p,
+         primitives,
+         %{reqs: %{fill: {:image, id}} = reqs} = state
+       ) do
+    with :fill <- Script.draw_flag(reqs),
+         {:ok, {atlas, {x, y, iw, ih}}} <- Static.region(id),
+         true <- w >= 0 and w <= iw and h >= 0 and h <= ih do
+      styles = List.delete(Primitive.Rectangle.valid_styles(), :fill)
+      {st_ops, state} = compile_styles(styles, state)
+      {Script.draw_sprites([], atlas, [{{x, y}, {w, h}, {0, 0}, {w, h}}]), st_ops, state}
+    else
+      _ -> do_generic(p, primitives, state)
+    end
+  end
+
+  defp do_primitive(p, primitives, state), do: do_generic(p, primitives, state)
+
   # the generic primitive compiler
   # this is what allows new "meta" primitives
-  defp do_primitive(%Primitive{module: mod} = p, _, state) do
+  defp do_generic(%Primitive{module: mod} = p, _, state) do
     {st_ops, state} = compile_styles(mod.valid_styles(), state)
     {mod.compile(p, state.reqs), st_ops, state}
   end
 
+  # when culling, the children of a group that can be bounded are wrapped in
+  # markers and a push/pop so that skipping them doesn't lose any styles they set.
+  # The markers are turned into real :cull ops after the script is finished.
+  defp compile_group(ids, primitives, %Compiler{cull: true, reqs: reqs} = state) do
+    case Bounds.local(ids, primitives, reqs) do
+      {:ok, bounds} ->
+        {ops, state} = compile_children(ids, primitives, push_set(state))
+        {[:cull_end, :pop_state, ops, :push_state, {:cull_begin, bounds}], pop_set(state)}
+
+      :error ->
+        compile_children(ids, primitives, state)
+    end
+  end
+
+  defp compile_group(ids, primitives, state), do: compile_children(ids, primitives, state)
+
+  defp compile_children(ids, primitives, state) do
+    Enum.reduce(ids, {[], state}, fn id, {ops, state} ->
+      compile_primitive(ops, primitives[id], primitives, state)
+    end)
+  end
+
   defp do_compile_script_name(ops, name) do
     Script.render_script(ops, name)
   end
@@ -849,6 +849,40 @@ defmodule Scenic.Math.Matrix do
 
   defp nif_project_vector2s(_, _), do: nif_error("Did not find nif_project_vector2s")
 
+  # --------------------------------------------------------
+  @doc """
+  Project several lists of vectors, each by its own matrix, and find the bounds
+  of the results.
+
+  All the lists are projected in a single NIF call, which is much faster than
+  projecting them one at a time when there are many small lists.
+
+  Parameters:
+  * regions: A list of `{matrix, vectors}` tuples
+
+  Returns:
+  `{left, top, right, bottom}` or `nil` if there are no vectors
+  """
+  @spec project_bounds(regions :: list({Math.matrix(), list(Math.vector_2())})) ::
+          {number, number, number, number} | nil
+  def project_bounds(regions) do
+    regions
+    |> Enum.map(fn {matrix, vectors} ->
+      [
+        matrix,
+        <<length(vectors)::unsigned-integer-size(32)-native>>
+        | Enum.map(vectors, fn {x, y} ->
+            <<x::float-size(32)-native, y::float-size(32)-native>>
+          end)
+      ]
+    end)
+    |> IO.iodata_to_binary()
+    # in NIF
+    |> nif_project_bounds()
+  end
+
+  defp nif_project_bounds(_), do: nif_error("Did not find nif_project_bounds")
+
   # --------------------------------------------------------
   # def project_vector3s(a, vector_bin) do
   #   # in NIF
@@ -511,10 +511,11 @@ defmodule Scenic.Primitive do
   def put(primitive, data, opts \\ [])
 
   def put(%Primitive{module: mod} = p, data, opts) do
-    case mod.validate(data) do
-      {:ok, data} -> data
-      {:error, error} -> raise error
-    end
+    data =
+      case mod.validate(data) do
+        {:ok, data} -> data
+        {:error, error} -> raise error
+      end
 
     # give the primitive a chance to own the put
     p
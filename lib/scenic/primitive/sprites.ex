@@ -35,6 +35,18 @@ defmodule Scenic.Primitive.Sprites do
   An optional alpha channel can be set in last position to apply a transparency
   effect on the sprite.
 
+  ## Packed Commands
+
+  `draw_commands` can also be a binary of packed commands. Each command is nine
+  big-endian 32 bit floats. `src_x, src_y, src_w, src_h, dst_x, dst_y, dst_w,
+  dst_h, alpha`. This is the same layout the commands have in a serialized
+  script, so a packed list is validated with a single native length/NaN check
+  and is copied straight into the script without building any tuples.
+
+  Use packed commands for large sprite layers that change every frame, such as
+  particles or tile maps. `pack_commands/1` converts a list of commands and
+  `put_command/3` replaces a single command in a packed binary.
+
   In other words, This copies rectangular images from the source
   indicated by image_id and draws them in the coordinate space of
   the graph.
@@ -91,21 +103,40 @@ defmodule Scenic.Primitive.Sprites do
           {dw :: number, dh :: number},
           alpha :: number
         }
-  @type draw_cmds :: [draw_cmd()]
+  @type draw_cmds :: [draw_cmd()] | packed_cmds()
+  @type packed_cmds :: binary
 
   @type t :: {image :: Static.id(), draw_cmds}
   @type styles_t :: [:hidden | :scissor]
 
   @styles [:hidden, :scissor]
 
+  @cmd_size 36
+
+  @app Mix.Project.config()[:app]
+
+  # load the NIF to validate packed commands
+  @compile {:autoload, false}
+  @on_load :load_nifs
+
+  @doc false
+  def load_nifs do
+    :ok =
+      @app
+      |> :code.priv_dir()
+      |> :filename.join(~c"sprites")
+      |> :erlang.load_nif(0)
+  end
+
   @impl Primitive
   @spec validate(t()) :: {:ok, t()} | {:error, String.t()}
-  def validate({image, cmds}) when is_list(cmds) do
+  def validate({image, cmds}) when is_list(cmds) or is_binary(cmds) do
     with {:ok, image} <- validate_image(image),
          {:ok, cmds} <- validate_commands(cmds) do
       {:ok, {image, cmds}}
     else
       {:error, :command, cmd} -> err_bad_cmd(image, cmd)
+      {:error, :packed, reason} -> err_bad_packed(image, reason)
       {:error, :alias} -> err_bad_alias(image)
       {:error, :font} -> err_is_font(image)
       {:error, :not_found} -> err_missing_image(image)
@@ -163,6 +194,28 @@ defmodule Scenic.Primitive.Sprites do
     }
   end
 
+  defp err_bad_packed(image, reason) do
+    reason =
+      case reason do
+        :length -> "The size is not a multiple of #{@cmd_size} bytes"
+        :nan -> "It contains a NaN or infinite value"
+      end
+
+    {
+      :error,
+      """
+      #{IO.ANSI.red()}Invalid Sprites specification
+      Image: #{inspect(image)}
+      Invalid packed commands. #{reason}
+      #{IO.ANSI.yellow()}
+      Packed sprite commands are a binary of nine big-endian 32 bit floats per command.
+      <<src_x, src_y, src_w, src_h, dst_x, dst_y, dst_w, dst_h, alpha>>
+
+      Use Scenic.Primitive.Sprites.pack_commands/1 to build one from a list.#{IO.ANSI.default_color()}
+      """
+    }
+  end
+
   defp err_bad_alias(image) do
     {
       :error,
@@ -227,6 +280,13 @@ defmodule Scenic.Primitive.Sprites do
 
   @default_alpha 1
 
+  defp validate_commands(commands) when is_binary(commands) do
+    case nif_validate(commands) do
+      {:ok, _count} -> {:ok, commands}
+      {:error, reason} -> {:error, :packed, reason}
+    end
+  end
+
   defp validate_commands(commands) do
     validate =
       Enum.reduce_while(commands, {:ok, []}, fn
@@ -260,6 +320,61 @@ defmodule Scenic.Primitive.Sprites do
     end
   end
 
+  defp nif_validate(_) do
+    :erlang.nif_error("Did not find nif_validate")
+  end
+
+  # --------------------------------------------------------
+  @doc """
+  Pack a list of draw commands into a binary.
+
+  Commands without an alpha get an alpha of 1.
+  """
+  @spec pack_commands(cmds :: list) :: packed_cmds()
+  def pack_commands(cmds) when is_list(cmds) do
+    for cmd <- cmds, into: <<>>, do: pack_command(cmd)
+  end
+
+  @doc """
+  Replace the command at `index` in a packed commands binary.
+
+  The result is a new binary of the same size. No lists or tuples are built,
+  which makes this suitable for updating sprites every frame.
+  """
+  @spec put_command(cmds :: packed_cmds(), index :: non_neg_integer, cmd :: tuple) ::
+          packed_cmds()
+  def put_command(cmds, index, cmd)
+      when is_binary(cmds) and is_integer(index) and index >= 0 and
+             (index + 1) * @cmd_size <= byte_size(cmds) do
+    offset = index * @cmd_size
+    <<head::binary-size(offset), _::binary-size(@cmd_size), tail::binary>> = cmds
+    <<head::binary, pack_command(cmd)::binary, tail::binary>>
+  end
+
+  @doc """
+  Returns the number of commands in a packed commands binary.
+  """
+  @spec command_count(cmds :: packed_cmds()) :: non_neg_integer
+  def command_count(cmds) when is_binary(cmds), do: div(byte_size(cmds), @cmd_size)
+
+  defp pack_command({src, src_size, dst, dst_size}) do
+    pack_command({src, src_size, dst, dst_size, @default_alpha})
+  end
+
+  defp pack_command({{sx, sy}, {sw, sh}, {dx, dy}, {dw, dh}, alpha}) do
+    <<
+      sx::float-32-big,
+      sy::float-32-big,
+      sw::float-32-big,
+      sh::float-32-big,
+      dx::float-32-big,
+      dy::float-32-big,
+      dw::float-32-big,
+      dh::float-32-big,
+      alpha::float-32-big
+    >>
+  end
+
   # --------------------------------------------------------
   # filter and gather styles
 
@@ -84,6 +84,51 @@ defmodule Scenic.PubSub do
 
         Scenic.PubSub.unsubscribe( source_id )
 
+  ## High Frequency Sources
+
+  Publishing doesn't go through a central process. The publishing process writes the
+  new value into the `:ets` table itself and sends it straight to the subscribers, so
+  many sources can publish at high rates at the same time without queuing behind
+  each other.
+
+  A subscriber that can't keep up with a fast source, or that listens to many of
+  them, can subscribe in batch mode instead.
+
+        Scenic.PubSub.subscribe( source_id, batch: true )
+
+  Batched updates are coalesced per subscriber. Once per tick (about 16ms), each
+  batched subscriber is sent one message with the latest value of every source that
+  published since the last tick.
+
+  event | message sent to batched subscribers
+  --- | ---
+  data published | `{{Scenic.PubSub, :batch}, [{source_id, value, timestamp}]}`
+
+  Registration messages are sent to batched subscribers as they happen.
+
+  Use `stats/0` to see how fast each source is publishing and how far behind its
+  subscribers are.
+
+  ## Latest Value Only
+
+  A subscriber that only ever cares about the current value can ask to be told when
+  it changes, instead of being sent every value.
+
+        Scenic.PubSub.subscribe( source_id, changed: true )
+
+  It is sent a `{{Scenic.PubSub, :changed}, source_id}` message when the source
+  publishes. Nothing more is sent about that source until the subscriber reads the
+  value with `get/1`, `fetch/1` or `query/1`, which arms the next message. However
+  fast the source is, the subscriber's mailbox never holds more than one message per
+  source, and it reads the latest value when it is ready for it.
+
+  ```elixir
+  def handle_info({{Scenic.PubSub, :changed}, :temperature}, scene) do
+    temperature = Scenic.PubSub.get(:temperature)
+    {:noreply, render(scene, temperature)}
+  end
+  ```
+
   ## Other functions
 
   Any process can get data from a source on demand, whether or not it is a subscriber.
@@ -101,7 +146,19 @@ defmodule Scenic.PubSub do
   @table __MODULE__
   @name __MODULE__
 
+  @pending __MODULE__.Pending
+  @signaled __MODULE__.Signaled
+
+  # how often batched subscribers are sent their updates, and how often the
+  # publish rates are sampled
+  @batch_ms 16
+  @sample_ms 1000
+
   @data {__MODULE__, :data}
+  @batch {__MODULE__, :batch}
+  @changed {__MODULE__, :changed}
+
+  @err_msg_mode "A subscription can't be both batch and changed"
   @registered {__MODULE__, :registered}
   @unregistered {__MODULE__, :unregistered}
 
@@ -133,7 +190,7 @@ defmodule Scenic.PubSub do
 
   @spec get(source_id :: atom) :: any | nil
   def get(source_id) when is_atom(source_id) do
-    case :ets.lookup(@table, source_id) do
+    case lookup(source_id) do
       [{_key, data, _timestamp}] -> data
       _ -> nil
     end
@@ -191,7 +248,7 @@ defmodule Scenic.PubSub do
 
   @spec fetch(source_id :: atom) :: {:ok, any} | {:error, :not_found}
   def fetch(source_id) when is_atom(source_id) do
-    case :ets.lookup(@table, source_id) do
+    case lookup(source_id) do
       [{_key, data, _timestamp}] ->
         {:ok, data}
 
@@ -225,7 +282,7 @@ defmodule Scenic.PubSub do
 
   @spec query(source_id :: atom) :: {:ok, any} | {:error, :not_found}
   def query(source_id) when is_atom(source_id) do
-    case :ets.lookup(@table, source_id) do
+    case lookup(source_id) do
       [data] ->
         {:ok, data}
 
@@ -235,6 +292,17 @@ defmodule Scenic.PubSub do
     end
   end
 
+  # --------------------------------------------------------
+  # reading a value arms the next changed message to the reader, if it has a
+  # changed subscription. The signal is cleared before the read, so a publish
+  # that lands in between sends a new one instead of being missed. Only readers
+  # with an outstanding signal pay for the delete, so plain reads stay reads.
+  defp lookup(source_id) do
+    key = {self(), source_id}
+    if :ets.member(@signaled, key), do: :ets.delete(@signaled, key)
+    :ets.lookup(@table, source_id)
+  end
+
   # --------------------------------------------------------
   @doc """
   List the registered data sources.
@@ -287,7 +355,7 @@ defmodule Scenic.PubSub do
     # enforce that this is coming from the registered data source pid
     case :ets.lookup(@table, {:registration, source_id}) do
       [{_, _, ^pid}] ->
-        send(@name, {:put_data, source_id, data, timestamp})
+        put_data(source_id, data, timestamp)
         :ok
 
       # no data
@@ -297,6 +365,18 @@ defmodule Scenic.PubSub do
   end
 
   # --------------------------------------------------------
+  @subscribe_opts_schema [
+    batch: [
+      type: :boolean,
+      default: false,
+      doc: "Receive the latest data from the source once per tick, in a batch message"
+    ],
+    changed: [
+      type: :boolean,
+      default: false,
+      doc: "Only receive a signal when the data changes. Read it with `get/1`"
+    ]
+  ]
   @doc """
   Subscribe the calling process to receive events about a data source.
 
@@ -308,16 +388,39 @@ defmodule Scenic.PubSub do
   source registered | `{{Scenic.PubSub, :registered}, {source_id, opts}}` 
   source unregistered | `{{Scenic.PubSub, :unregistered}, source_id}` 
 
+  Batched subscribers receive `{{Scenic.PubSub, :batch}, [{source_id, value, timestamp}]}`
+  instead of the data messages. See "High Frequency Sources" above.
+
+  Changed subscribers receive `{{Scenic.PubSub, :changed}, source_id}` instead of the
+  data messages. See "Latest Value Only" above.
+
   ## Parameters
   * `source_id` an atom that is registered to a data source.
+  * `opts` subscription options.
+
+  Supported options:\n#{NimbleOptions.docs(@subscribe_opts_schema)}
 
   ## Return Value
 
   On success, returns `:ok`
   """
-  @spec subscribe(source_id :: atom) :: :ok
-  def subscribe(source_id) when is_atom(source_id) do
-    GenServer.call(@name, {:subscribe, source_id, self()})
+  @spec subscribe(source_id :: atom, opts :: Keyword.t()) :: :ok
+  def subscribe(source_id, opts \\ []) when is_atom(source_id) do
+    opts =
+      case NimbleOptions.validate(opts, @subscribe_opts_schema) do
+        {:ok, opts} -> opts
+        {:error, error} -> raise Error, message: error, source_id: source_id
+      end
+
+    mode =
+      case {opts[:batch], opts[:changed]} do
+        {true, true} -> raise Error, message: @err_msg_mode, source_id: source_id
+        {true, false} -> :batch
+        {false, true} -> :changed
+        _ -> :all
+      end
+
+    GenServer.call(@name, {:subscribe, source_id, self(), mode})
   end
 
   # --------------------------------------------------------
@@ -396,6 +499,35 @@ defmodule Scenic.PubSub do
     :ok
   end
 
+  # --------------------------------------------------------
+  @doc """
+  Report how the registered data sources are doing.
+
+  ## Return Value
+
+  A map of each registered `source_id` to
+
+        %{published: count, rate: per_second, subscribers: count, queue_depth: count}
+
+  * `published` is the number of times the source has published since it registered.
+  * `rate` is how many times per second it published over the last second.
+  * `subscribers` is the number of subscribed processes.
+  * `queue_depth` is the longest message queue of any of its subscribers. A number
+    that keeps growing means a subscriber isn't keeping up and should probably
+    subscribe in batch mode.
+  """
+  @spec stats() :: %{
+          atom => %{
+            published: non_neg_integer,
+            rate: number,
+            subscribers: non_neg_integer,
+            queue_depth: non_neg_integer
+          }
+        }
+  def stats() do
+    GenServer.call(@name, :stats)
+  end
+
   # ============================================================================
   # internal api
 
@@ -409,18 +541,58 @@ defmodule Scenic.PubSub do
   @doc false
   def init(:ok) do
     # set up the initial state
+    # publishers write into the tables directly. Each source only has one
+    # writer, so there is no contention between them
+    opts = [:named_table, :public, read_concurrency: true, write_concurrency: true]
+
     state = %{
-      data_table_id: :ets.new(@table, [:named_table]),
+      data_table_id: :ets.new(@table, opts),
+      pending_table_id: :ets.new(@pending, [:named_table, :public, write_concurrency: true]),
+      signaled_table_id: :ets.new(@signaled, opts),
       subs_id: %{},
-      subs_pid: %{}
+      subs_pid: %{},
+      batched: MapSet.new(),
+      changed: MapSet.new(),
+      flushing: false,
+      rates: %{},
+      sampled_at: :os.system_time(:milli_seconds)
     }
 
     # trap exits so we don't just crash when a subscriber goes away
     Process.flag(:trap_exit, true)
 
+    Process.send_after(self(), :sample, @sample_ms)
+
     {:ok, state}
   end
 
+  # --------------------------------------------------------
+  # runs in the publishing process. Writes the data and the count, then sends
+  # it to the subscribers. Batched subscribers get it at the next flush.
+  defp put_data(source_id, data, timestamp) do
+    entry = {source_id, data, timestamp}
+    :ets.insert(@table, entry)
+    :ets.update_counter(@table, {:published, source_id}, 1, {{:published, source_id}, 0})
+
+    case :ets.lookup(@table, {:subscribers, source_id}) do
+      [{_, immediate, batched, changed}] ->
+        msg = {@data, entry}
+        Enum.each(immediate, &send(&1, msg))
+        Enum.each(batched, &:ets.insert(@pending, {{&1, source_id}, data, timestamp}))
+        Enum.each(changed, &signal(&1, source_id))
+
+      [] ->
+        :ok
+    end
+  end
+
+  # send a changed message unless the last one hasn't been acted on yet
+  defp signal(pid, source_id) do
+    if :ets.insert_new(@signaled, {{pid, source_id}}) do
+      send(pid, {@changed, source_id})
+    end
+  end
+
   # ============================================================================
 
   # --------------------------------------------------------
@@ -431,11 +603,53 @@ defmodule Scenic.PubSub do
   # not best-practice, but is an escape valve.
   # timestamp should be from :os.system_time(:micro_seconds)
   def handle_info({:put_data, source_id, data, timestamp}, state) do
-    :ets.insert(@table, {source_id, data, timestamp})
-    send_subs(source_id, @data, {source_id, data, timestamp}, state)
+    put_data(source_id, data, timestamp)
     {:noreply, state}
   end
 
+  # --------------------------------------------------------
+  # send each batched subscriber the latest of everything published since the
+  # last tick. Only the exact entries that were read are deleted, so anything
+  # published in the meantime goes out with the next one.
+  @doc false
+  def handle_info(:flush, state) do
+    @pending
+    |> :ets.tab2list()
+    |> Enum.reduce(%{}, fn {{pid, source_id}, data, timestamp} = entry, batches ->
+      :ets.delete_object(@pending, entry)
+      update = {source_id, data, timestamp}
+      Map.update(batches, pid, [update], &[update | &1])
+    end)
+    |> Enum.each(fn {pid, batch} -> send(pid, {@batch, batch}) end)
+
+    {:noreply, schedule_flush(%{state | flushing: false})}
+  end
+
+  # --------------------------------------------------------
+  # sample the publish counts to get the recent rates
+  @doc false
+  def handle_info(:sample, %{rates: rates, sampled_at: sampled_at} = state) do
+    now = :os.system_time(:milli_seconds)
+    seconds = max(now - sampled_at, 1) / 1000
+
+    rates =
+      @table
+      |> :ets.match({{:published, :"$1"}, :"$2"})
+      |> Enum.into(%{}, fn [source_id, count] ->
+        # the count starts over if the source registers again
+        published =
+          case Map.get(rates, source_id) do
+            {last, _} when last <= count -> count - last
+            _ -> count
+          end
+
+        {source_id, {count, published / seconds}}
+      end)
+
+    Process.send_after(self(), :sample, @sample_ms)
+    {:noreply, %{state | rates: rates, sampled_at: now}}
+  end
+
   # --------------------------------------------------------
   @doc false
   def handle_info({:unsubscribe, source_id, pid}, state) do
@@ -469,18 +683,49 @@ defmodule Scenic.PubSub do
 
   # --------------------------------------------------------
   @doc false
-  def handle_call({:subscribe, source_id, pid}, _from, state) do
-    {reply, state} = do_subscribe(pid, source_id, state)
+  def handle_call({:subscribe, source_id, pid, mode}, _from, state) do
+    {reply, state} = do_subscribe(pid, source_id, mode, state)
 
     # send the already-set value if one is set
-    case query(source_id) do
-      {:ok, data} -> send(pid, {@data, data})
+    # batched subscribers get it with the next flush
+    case {:ets.lookup(@table, source_id), mode} do
+      {[{_, data, ts}], :batch} -> :ets.insert(@pending, {{pid, source_id}, data, ts})
+      {[_], :changed} -> signal(pid, source_id)
+      {[data], :all} -> send(pid, {@data, data})
       _ -> :ok
     end
 
     {:reply, reply, state}
   end
 
+  # --------------------------------------------------------
+  @doc false
+  def handle_call(:stats, _from, %{subs_id: subs_id, rates: rates} = state) do
+    stats =
+      list()
+      |> Enum.into(%{}, fn {source_id, _opts, _pid} ->
+        subs = Map.get(subs_id, source_id, [])
+
+        published =
+          case :ets.lookup(@table, {:published, source_id}) do
+            [{_, count}] -> count
+            [] -> 0
+          end
+
+        {_, rate} = Map.get(rates, source_id, {0, 0.0})
+
+        {source_id,
+         %{
+           published: published,
+           rate: rate,
+           subscribers: length(subs),
+           queue_depth: Enum.reduce(subs, 0, &max(queue_len(&1), &2))
+         }}
+      end)
+
+    {:reply, stats, state}
+  end
+
   # --------------------------------------------------------
   @doc false
   # handle data source registration
@@ -536,6 +781,7 @@ defmodule Scenic.PubSub do
         # delete the table entries
         :ets.delete(@table, reg_key)
         :ets.delete(@table, source_id)
+        :ets.delete(@table, {:published, source_id})
 
         unlink_pid(pid, state)
         :ok
@@ -550,8 +796,18 @@ defmodule Scenic.PubSub do
   # handle client subscriptions
 
   # --------------------------------------------------------
-  @spec do_subscribe(pid :: GenServer.server(), source_id :: atom, state :: map) :: any
-  defp do_subscribe(pid, source_id, %{subs_id: subs_id, subs_pid: subs_pid} = state) do
+  @spec do_subscribe(
+          pid :: GenServer.server(),
+          source_id :: atom,
+          mode :: :all | :batch | :changed,
+          state :: map
+        ) :: any
+  defp do_subscribe(
+         pid,
+         source_id,
+         mode,
+         %{subs_id: subs_id, subs_pid: subs_pid, batched: batched, changed: changed} = state
+       ) do
     # record the subscription
     subs_id =
       Map.put(
@@ -567,10 +823,30 @@ defmodule Scenic.PubSub do
         [source_id | Map.get(subs_pid, pid, [])] |> Enum.uniq()
       )
 
+    # subscribing again replaces the mode
+    key = {pid, source_id}
+    :ets.delete(@signaled, key)
+
+    {batched, changed} =
+      case mode do
+        :batch -> {MapSet.put(batched, key), MapSet.delete(changed, key)}
+        :changed -> {MapSet.delete(batched, key), MapSet.put(changed, key)}
+        :all -> {MapSet.delete(batched, key), MapSet.delete(changed, key)}
+      end
+
     # make sure the subscriber is linked
     Process.link(pid)
 
-    {:ok, %{state | subs_id: subs_id, subs_pid: subs_pid}}
+    state = %{
+      state
+      | subs_id: subs_id,
+        subs_pid: subs_pid,
+        batched: batched,
+        changed: changed
+    }
+    sync_subs(source_id, state)
+
+    {:ok, schedule_flush(state)}
   end
 
   # --------------------------------------------------------
@@ -596,7 +872,19 @@ defmodule Scenic.PubSub do
 
     subs_pid = Map.put(subs_pid, pid, subs_by_pid)
 
-    state = %{state | subs_id: subs_id, subs_pid: subs_pid}
+    batched = MapSet.delete(state.batched, {pid, source_id})
+    changed = MapSet.delete(state.changed, {pid, source_id})
+    :ets.delete(@pending, {pid, source_id})
+    :ets.delete(@signaled, {pid, source_id})
+
+    state = %{
+      state
+      | subs_id: subs_id,
+        subs_pid: subs_pid,
+        batched: batched,
+        changed: changed
+    }
+    sync_subs(source_id, state)
 
     # if pid no longer subscribed to anything, then some further cleanup
     state =
@@ -627,6 +915,45 @@ defmodule Scenic.PubSub do
     state
   end
 
+  # --------------------------------------------------------
+  # publishers read the subscribers of their source from the table, split into
+  # the ones that get every update, the ones that get batches and the ones that
+  # are only told it changed
+  defp sync_subs(source_id, %{subs_id: subs_id, batched: batched, changed: changed}) do
+    case Map.get(subs_id, source_id, []) do
+      [] ->
+        :ets.delete(@table, {:subscribers, source_id})
+
+      pids ->
+        {batch, pids} = Enum.split_with(pids, &MapSet.member?(batched, {&1, source_id}))
+        {signal, immediate} = Enum.split_with(pids, &MapSet.member?(changed, {&1, source_id}))
+        :ets.insert(@table, {{:subscribers, source_id}, immediate, batch, signal})
+    end
+  end
+
+  # --------------------------------------------------------
+  # the flush timer only runs while there are batched subscribers
+  defp schedule_flush(%{flushing: false, batched: batched} = state) do
+    case MapSet.size(batched) do
+      0 ->
+        state
+
+      _ ->
+        Process.send_after(self(), :flush, @batch_ms)
+        %{state | flushing: true}
+    end
+  end
+
+  defp schedule_flush(state), do: state
+
+  # --------------------------------------------------------
+  defp queue_len(pid) do
+    case Process.info(pid, :message_queue_len) do
+      {:message_queue_len, len} -> len
+      nil -> 0
+    end
+  end
+
   # --------------------------------------------------------
   defp send_subs(source_id, verb, msg, %{subs_id: subs}) do
     msg = {verb, msg}
@@ -0,0 +1,154 @@
+defmodule Scenic.Raster do
+  @moduledoc """
+  Render a script into a bitmap on the CPU, without a driver or a GPU.
+
+  This is useful for headless devices, for producing thumbnails and snapshots of a
+  scene, and for testing what a script actually draws.
+
+  ```elixir
+  alias Scenic.Assets.Stream.Bitmap
+
+  {:ok, script} = Scenic.Graph.Compiler.compile(graph)
+  bitmap = Scenic.Raster.render(script, 800, 600, clear: :dark_slate_gray)
+  Scenic.Assets.Stream.put("snapshot", bitmap)
+  ```
+
+  The result is a committed `Scenic.Assets.Stream.Bitmap` in any of the bitmap
+  depths, so it can be streamed into another scene, read back with
+  `Scenic.Assets.Stream.Bitmap.get/3`, or handed off to an encoder.
+
+  ### What gets drawn
+
+  Rectangles, rounded rectangles, circles, ellipses, arcs, sectors, triangles, quads,
+  lines, paths (including curves and arcs), and text are all rasterized. Fills and
+  strokes can be colors or linear or radial gradients. Transforms, scissors, the
+  state stack, stroke caps, joins and miter limits are honored. Text is drawn from
+  the TrueType fonts in your static assets.
+
+  Image and stream paints and sprites are skipped, as the rasterizer doesn't load
+  images. Scissors are intersected with any enclosing scissor and clip to the
+  bounding box of the transformed scissor rectangle.
+
+  Anti-aliasing is exact horizontally and uses four samples vertically per pixel.
+
+  ### Scripts by reference
+
+  `{:script, id}` ops are skipped unless a `:lookup` function is given. The lookup is
+  used to inline the referenced scripts first with `Scenic.Script.flatten/2`.
+
+  ```elixir
+  Scenic.Raster.render(script, 800, 600, lookup: &Scenic.ViewPort.get_script(vp, &1))
+  ```
+
+  ### Parallel rendering
+
+  The bitmap is split into horizontal bands that are rendered on separate dirty
+  schedulers. By default there is one band per online scheduler. Set `:tiles` to
+  change that. The output is identical regardless of the number of tiles.
+  """
+
+  alias Scenic.Assets.Stream.Bitmap
+  alias Scenic.Color
+  alias Scenic.Raster.Builder
+  alias Scenic.Script
+
+  @app Mix.Project.config()[:app]
+
+  # load the NIF
+  @compile {:autoload, false}
+  @on_load :load_nifs
+
+  @doc false
+  def load_nifs do
+    :ok =
+      @app
+      |> :code.priv_dir()
+      |> :filename.join(~c"raster")
+      |> :erlang.load_nif(0)
+  end
+
+  @bpp %{g: 1, ga: 2, rgb: 3, rgba: 4}
+
+  @opts_schema [
+    format: [type: {:in, [:g, :ga, :rgb, :rgba]}, default: :rgba],
+    clear: [type: :any, default: :black],
+    tiles: [type: :pos_integer],
+    lookup: [type: {:fun, 1}]
+  ]
+
+  # --------------------------------------------------------
+  @doc """
+  Render a script into a new committed bitmap of the given size.
+
+  ### Options
+
+  * `:format` The depth of the bitmap. One of `:g`, `:ga`, `:rgb` or `:rgba`.
+    Defaults to `:rgba`.
+  * `:clear` The color the bitmap starts as. Defaults to `:black`.
+  * `:tiles` The number of bands to render in parallel. Defaults to the number of
+    online schedulers.
+  * `:lookup` A function that takes a script id and returns `{:ok, script}`. Used
+    to inline `{:script, id}` references before rendering.
+  """
+  @spec render(
+          script :: Script.t(),
+          width :: pos_integer,
+          height :: pos_integer,
+          opts :: Keyword.t()
+        ) :: Bitmap.t()
+  def render(script, width, height, opts \\ [])
+
+  def render(script, width, height, opts)
+      when is_integer(width) and width > 0 and is_integer(height) and height > 0 do
+    opts =
+      case NimbleOptions.validate(opts, @opts_schema) do
+        {:ok, opts} -> opts
+        {:error, error} -> raise Exception.message(error)
+      end
+
+    format = opts[:format]
+    {:color_rgba, {r, g, b, a}} = Color.to_rgba(opts[:clear])
+    clear = <<r::8, g::8, b::8, a::8>>
+
+    dl =
+      script
+      |> flatten(opts[:lookup])
+      |> to_list()
+      |> Builder.build(width, height)
+
+    tiles = min(opts[:tiles] || System.schedulers_online(), height)
+    rows = div(height + tiles - 1, tiles)
+
+    bands =
+      for y0 <- 0..(height - 1)//rows do
+        {y0, min(y0 + rows, height)}
+      end
+
+    pixels =
+      bands
+      |> Task.async_stream(
+        fn {y0, y1} -> nif_render(dl, width, height, @bpp[format], y0, y1, clear) end,
+        max_concurrency: tiles,
+        ordered: true,
+        timeout: :infinity
+      )
+      |> Enum.map(fn {:ok, band} -> band end)
+      |> IO.iodata_to_binary()
+
+    {Bitmap, {width, height, format}, pixels}
+  end
+
+  defp flatten(script, nil), do: script
+
+  defp flatten(script, lookup) do
+    {script, _} = Script.flatten(script, lookup)
+    script
+  end
+
+  defp to_list(script) when is_list(script), do: script
+  defp to_list(script) when is_binary(script), do: Script.deserialize(script)
+
+  # --------------------------------------------------------
+  # nif stubs
+  defp nif_render(_, _, _, _, _, _, _), do: :erlang.nif_error("Did not find nif_render")
+end
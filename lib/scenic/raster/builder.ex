@@ -0,0 +1,720 @@
+defmodule Scenic.Raster.Builder do
+  @moduledoc false
+  # Walks the ops in a script and reduces them to the display list that
+  # raster.c fills. Every shape, stroke and string becomes one command made of
+  # device space polygons plus the paint and clip to fill them with.
+  #
+  # Transforms are 2x3 affine matrices {a, b, c, d, e, f} mapping
+  # x' = a*x + c*y + e and y' = b*x + d*y + f. Same layout as the transform op.
+  #
+  # Curves, arcs and strokes are flattened here. Strokes are expanded into
+  # convex pieces (segment quads, joins and caps) all wound the same way, so
+  # the nonzero fill in raster.c merges them without double blending.
+
+  alias Scenic.Raster.Glyphs
+
+  @identity {1.0, 0.0, 0.0, 1.0, 0.0, 0.0}
+  @tau :math.pi() * 2
+
+  @paint_solid 0
+  @paint_linear 1
+  @paint_radial 2
+
+  @min_arc_segments 4
+  @max_arc_segments 512
+  @max_curve_segments 64
+
+  @default_state %{
+    tx: @identity,
+    fill: {:solid, {1.0, 1.0, 1.0, 1.0}},
+    stroke: {:solid, {0.0, 0.0, 0.0, 1.0}},
+    stroke_width: 1,
+    cap: :butt,
+    join: :miter,
+    miter_limit: 10,
+    clip: nil,
+    font: nil,
+    font_size: 16,
+    text_align: :left,
+    text_base: :alphabetic
+  }
+
+  # --------------------------------------------------------
+  @spec build(ops :: list, width :: pos_integer, height :: pos_integer) :: binary
+  def build(ops, width, height) when is_list(ops) do
+    ctx = %{
+      st: %{@default_state | clip: {0.0, 0.0, width * 1.0, height * 1.0}},
+      stack: [],
+      path: [],
+      cur: nil,
+      pen: {0.0, 0.0},
+      out: [],
+      screen: {0.0, 0.0, width * 1.0, height * 1.0}
+    }
+
+    %{out: out} = run(ops, ctx)
+
+    out
+    |> Enum.reverse()
+    |> IO.iodata_to_binary()
+  end
+
+  # ============================================================================
+  # op dispatch
+
+  defp run([], ctx), do: ctx
+
+  defp run([{:cull, {l, t, r, b, count}} | ops], %{st: %{tx: tx, clip: clip}} = ctx) do
+    case intersect(clip, bbox(tx, [{l, t}, {r, t}, {r, b}, {l, b}])) do
+      nil -> ops |> Enum.drop(count) |> run(ctx)
+      _ -> run(ops, ctx)
+    end
+  end
+
+  defp run([op | ops], ctx), do: run(ops, op(op, ctx))
+
+  # --------------------------------------------------------
+  # state
+
+  defp op(:push_state, %{st: st, stack: stack} = ctx), do: %{ctx | stack: [st | stack]}
+  defp op(:pop_state, %{stack: []} = ctx), do: ctx
+  defp op(:pop_state, %{stack: [st | stack]} = ctx), do: %{ctx | st: st, stack: stack}
+  defp op(:pop_push_state, %{stack: []} = ctx), do: ctx
+  defp op(:pop_push_state, %{stack: [st | _]} = ctx), do: %{ctx | st: st}
+
+  defp op({:clear, color}, %{screen: {x0, y0, x1, y1}} = ctx) do
+    contour = [{x0, y0}, {x1, y0}, {x1, y1}, {x0, y1}]
+    emit(ctx, paint(color, @identity), ctx.screen, [contour])
+  end
+
+  # --------------------------------------------------------
+  # transforms
+
+  defp op({:translate, {x, y}}, ctx), do: multiply(ctx, {1.0, 0.0, 0.0, 1.0, x, y})
+  defp op({:scale, {x, y}}, ctx), do: multiply(ctx, {x, 0.0, 0.0, y, 0.0, 0.0})
+
+  defp op({:rotate, r}, ctx) do
+    cos = :math.cos(r)
+    sin = :math.sin(r)
+    multiply(ctx, {cos, sin, -sin, cos, 0.0, 0.0})
+  end
+
+  defp op({:transform, {_, _, _, _, _, _} = m}, ctx), do: multiply(ctx, m)
+
+  # --------------------------------------------------------
+  # styles
+
+  defp op({:fill_color, c}, ctx), do: put_st(ctx, :fill, paint(c, ctx.st.tx))
+  defp op({:fill_linear, g}, ctx), do: put_st(ctx, :fill, paint({:linear, g}, ctx.st.tx))
+  defp op({:fill_radial, g}, ctx), do: put_st(ctx, :fill, paint({:radial, g}, ctx.st.tx))
+  defp op({:fill_image, _}, ctx), do: put_st(ctx, :fill, nil)
+  defp op({:fill_stream, _}, ctx), do: put_st(ctx, :fill, nil)
+  defp op({:stroke_color, c}, ctx), do: put_st(ctx, :stroke, paint(c, ctx.st.tx))
+  defp op({:stroke_linear, g}, ctx), do: put_st(ctx, :stroke, paint({:linear, g}, ctx.st.tx))
+  defp op({:stroke_radial, g}, ctx), do: put_st(ctx, :stroke, paint({:radial, g}, ctx.st.tx))
+  defp op({:stroke_image, _}, ctx), do: put_st(ctx, :stroke, nil)
+  defp op({:stroke_stream, _}, ctx), do: put_st(ctx, :stroke, nil)
+  defp op({:stroke_width, w}, ctx), do: put_st(ctx, :stroke_width, w)
+  defp op({:cap, cap}, ctx), do: put_st(ctx, :cap, cap)
+  defp op({:join, join}, ctx), do: put_st(ctx, :join, join)
+  defp op({:miter_limit, limit}, ctx), do: put_st(ctx, :miter_limit, limit)
+  defp op({:font, font}, ctx), do: put_st(ctx, :font, font)
+  defp op({:font_size, size}, ctx), do: put_st(ctx, :font_size, size)
+  defp op({:text_align, align}, ctx), do: put_st(ctx, :text_align, align)
+  defp op({:text_base, base}, ctx), do: put_st(ctx, :text_base, base)
+
+  defp op({:scissor, {w, h}}, %{st: %{tx: tx, clip: clip}} = ctx) do
+    rect = bbox(tx, [{0, 0}, {w, 0}, {w, h}, {0, h}])
+    put_st(ctx, :clip, intersect(clip, rect) || {0.0, 0.0, 0.0, 0.0})
+  end
+
+  # --------------------------------------------------------
+  # draw commands. each one is a complete path of its own
+
+  defp op({:draw_line, {x0, y0, x1, y1, _}}, ctx) do
+    ctx
+    |> begin()
+    |> move_to(x0, y0)
+    |> line_to(x1, y1)
+    |> draw(:stroke)
+  end
+
+  defp op({:draw_triangle, {x0, y0, x1, y1, x2, y2, flag}}, ctx) do
+    ctx |> begin() |> polygon([{x0, y0}, {x1, y1}, {x2, y2}]) |> draw(flag)
+  end
+
+  defp op({:draw_quad, {x0, y0, x1, y1, x2, y2, x3, y3, flag}}, ctx) do
+    ctx |> begin() |> polygon([{x0, y0}, {x1, y1}, {x2, y2}, {x3, y3}]) |> draw(flag)
+  end
+
+  defp op({:draw_rect, {w, h, flag}}, ctx), do: ctx |> begin() |> rect(w, h) |> draw(flag)
+
+  defp op({:draw_rrect, {w, h, r, flag}}, ctx) do
+    ctx |> begin() |> rrect(w, h, r, r, r, r) |> draw(flag)
+  end
+
+  defp op({:draw_rrectv, {w, h, ul, ur, lr, ll, flag}}, ctx) do
+    ctx |> begin() |> rrect(w, h, ul, ur, lr, ll) |> draw(flag)
+  end
+
+  defp op({:draw_sector, {r, radians, flag}}, ctx) do
+    ctx |> begin() |> sector(r, radians) |> draw(flag)
+  end
+
+  defp op({:draw_arc, {r, radians, flag}}, ctx) do
+    ctx |> begin() |> arc(0, 0, r, 0, radians, sweep_dir(radians)) |> draw(flag)
+  end
+
+  defp op({:draw_circle, {r, flag}}, ctx) do
+    ctx |> begin() |> ellipse(r, r) |> draw(flag)
+  end
+
+  defp op({:draw_ellipse, {r0, r1, flag}}, ctx) do
+    ctx |> begin() |> ellipse(r0, r1) |> draw(flag)
+  end
+
+  defp op({:draw_text, text}, ctx), do: text(ctx, text)
+
+  # --------------------------------------------------------
+  # paths
+
+  defp op(:begin_path, ctx), do: begin(ctx)
+  defp op(:close_path, %{cur: nil} = ctx), do: ctx
+  defp op(:close_path, %{cur: {pts, _}} = ctx), do: %{ctx | cur: {pts, true}}
+  defp op(:fill_path, ctx), do: draw(ctx, :fill, false)
+  defp op(:stroke_path, ctx), do: draw(ctx, :stroke, false)
+  defp op({:move_to, {x, y}}, ctx), do: move_to(ctx, x, y)
+  defp op({:line_to, {x, y}}, ctx), do: line_to(ctx, x, y)
+
+  defp op({:bezier_to, {c1x, c1y, c2x, c2y, x, y}}, %{pen: {px, py}} = ctx) do
+    curve(ctx, [{px, py}, {c1x, c1y}, {c2x, c2y}, {x, y}])
+  end
+
+  defp op({:quadratic_to, {cx, cy, x, y}}, %{pen: {px, py}} = ctx) do
+    curve(ctx, [{px, py}, {cx, cy}, {x, y}])
+  end
+
+  defp op({:arc_to, {x1, y1, x2, y2, r}}, ctx), do: arc_to(ctx, x1, y1, x2, y2, r)
+  defp op({:arc, {cx, cy, r, a0, a1, dir}}, ctx), do: arc(ctx, cx, cy, r, a0, a1, dir)
+
+  defp op({:triangle, {x0, y0, x1, y1, x2, y2}}, ctx) do
+    polygon(ctx, [{x0, y0}, {x1, y1}, {x2, y2}])
+  end
+
+  defp op({:quad, {x0, y0, x1, y1, x2, y2, x3, y3}}, ctx) do
+    polygon(ctx, [{x0, y0}, {x1, y1}, {x2, y2}, {x3, y3}])
+  end
+
+  defp op({:rect, {w, h}}, ctx), do: rect(ctx, w, h)
+  defp op({:rrect, {w, h, r}}, ctx), do: rrect(ctx, w, h, r, r, r, r)
+  defp op({:sector, {r, radians}}, ctx), do: sector(ctx, r, radians)
+  defp op({:circle, r}, ctx), do: ellipse(ctx, r, r)
+  defp op({:ellipse, {r0, r1}}, ctx), do: ellipse(ctx, r0, r1)
+
+  # sprites and unresolved script references have nothing to rasterize
+  defp op(_, ctx), do: ctx
+
+  # ============================================================================
+  # state helpers
+
+  defp put_st(%{st: st} = ctx, key, value), do: %{ctx | st: Map.put(st, key, value)}
+
+  defp multiply(%{st: %{tx: m} = st} = ctx, t), do: %{ctx | st: %{st | tx: mul(m, t)}}
+
+  # m applied after t
+  defp mul({ma, mb, mc, md, me, mf}, {ta, tb, tc, td, te, tf}) do
+    {
+      ma * ta + mc * tb,
+      mb * ta + md * tb,
+      ma * tc + mc * td,
+      mb * tc + md * td,
+      ma * te + mc * tf + me,
+      mb * te + md * tf + mf
+    }
+  end
+
+  defp invert({a, b, c, d, e, f}) do
+    case a * d - b * c do
+      det when det == 0 ->
+        @identity
+
+      det ->
+        {d / det, -b / det, -c / det, a / det, (c * f - d * e) / det, (b * e - a * f) / det}
+    end
+  end
+
+  defp apply_tx({a, b, c, d, e, f}, {x, y}), do: {a * x + c * y + e, b * x + d * y + f}
+
+  # average scale of a transform. used to size strokes and pick flattening steps
+  defp tx_scale({a, b, c, d, _, _}), do: :math.sqrt(abs(a * d - b * c))
+
+  defp bbox(tx, pts) do
+    {xs, ys} = pts |> Enum.map(&apply_tx(tx, &1)) |> Enum.unzip()
+    {Enum.min(xs), Enum.min(ys), Enum.max(xs), Enum.max(ys)}
+  end
+
+  defp intersect({ax0, ay0, ax1, ay1}, {bx0, by0, bx1, by1}) do
+    x0 = max(ax0, bx0)
+    y0 = max(ay0, by0)
+    x1 = min(ax1, bx1)
+    y1 = min(ay1, by1)
+    if x0 < x1 and y0 < y1, do: {x0, y0, x1, y1}, else: nil
+  end
+
+  # --------------------------------------------------------
+  # paints are evaluated in device space, so gradients keep the inverse of
+  # the transform that was current when they were set
+  defp paint({:color_rgba, {r, g, b, a}}, _tx) do
+    {:solid, {r / 255, g / 255, b / 255, a / 255}}
+  end
+
+  defp paint({:linear, {sx, sy, ex, ey, c0, c1}}, tx) do
+    {:linear, invert(tx), {sx, sy, ex, ey}, unit_color(c0), unit_color(c1)}
+  end
+
+  defp paint({:radial, {cx, cy, r0, r1, c0, c1}}, tx) do
+    {:radial, invert(tx), {cx, cy, r0, r1}, unit_color(c0), unit_color(c1)}
+  end
+
+  defp paint(color, tx), do: paint(Scenic.Color.to_rgba(color), tx)
+
+  defp unit_color(c) do
+    {:color_rgba, {r, g, b, a}} = Scenic.Color.to_rgba(c)
+    {r / 255, g / 255, b / 255, a / 255}
+  end
+
+  # ============================================================================
+  # path building. points are stored in device space. The pen is kept in
+  # local space for the ops that are relative to the last point.
+
+  defp begin(ctx), do: %{ctx | path: [], cur: nil}
+
+  defp end_contour(%{cur: nil} = ctx), do: ctx
+
+  defp end_contour(%{cur: {pts, closed}, path: path} = ctx) do
+    %{ctx | path: [{Enum.reverse(pts), closed} | path], cur: nil}
+  end
+
+  defp move_to(ctx, x, y) do
+    ctx = end_contour(ctx)
+    %{ctx | cur: {[apply_tx(ctx.st.tx, {x, y})], false}, pen: {x, y}}
+  end
+
+  defp line_to(%{cur: nil} = ctx, x, y), do: move_to(ctx, x, y)
+
+  defp line_to(%{cur: {pts, closed}, st: %{tx: tx}} = ctx, x, y) do
+    %{ctx | cur: {[apply_tx(tx, {x, y}) | pts], closed}, pen: {x, y}}
+  end
+
+  defp lines_to(ctx, pts), do: Enum.reduce(pts, ctx, fn {x, y}, ctx -> line_to(ctx, x, y) end)
+
+  # a closed contour of its own
+  defp polygon(ctx, [{x, y} | pts]) do
+    ctx
+    |> move_to(x, y)
+    |> lines_to(pts)
+    |> close()
+    |> end_contour()
+  end
+
+  defp close(ctx), do: op(:close_path, ctx)
+
+  defp rect(ctx, w, h), do: polygon(ctx, [{0, 0}, {w, 0}, {w, h}, {0, h}])
+
+  defp rrect(ctx, w, h, ul, ur, lr, ll) do
+    # negative sizes extend up and left from the origin
+    {x, w} = if w < 0, do: {w, -w}, else: {0, w}
+    {y, h} = if h < 0, do: {h, -h}, else: {0, h}
+    max_r = min(w, h) / 2
+    [ul, ur, lr, ll] = Enum.map([ul, ur, lr, ll], &min(max(&1, 0), max_r))
+    hp = :math.pi() / 2
+
+    ctx
+    |> move_to(x + ul, y)
+    |> corner(x + w - ur, y + ur, ur, -hp, 0)
+    |> corner(x + w - lr, y + h - lr, lr, 0, hp)
+    |> corner(x + ll, y + h - ll, ll, hp, 2 * hp)
+    |> corner(x + ul, y + ul, ul, 2 * hp, 3 * hp)
+    |> close()
+    |> end_contour()
+  end
+
+  defp corner(ctx, x, y, r, _, _) when r == 0, do: line_to(ctx, x, y)
+  defp corner(ctx, x, y, r, a0, a1), do: arc(ctx, x, y, r, a0, a1, 2)
+
+  defp sector(ctx, r, radians) do
+    ctx
+    |> move_to(0, 0)
+    |> arc(0, 0, r, 0, radians, sweep_dir(radians))
+    |> close()
+    |> end_contour()
+  end
+
+  defp ellipse(%{st: %{tx: tx}} = ctx, r0, r1) do
+    n = arc_segments(@tau, max(abs(r0), abs(r1)) * tx_scale(tx))
+
+    pts =
+      for i <- 1..(n - 1) do
+        a = @tau * i / n
+        {r0 * :math.cos(a), r1 * :math.sin(a)}
+      end
+
+    polygon(ctx, [{r0, 0} | pts])
+  end
+
+  # dir 1 is counter-clockwise, 2 is clockwise. Same as the arc op.
+  defp arc(%{st: %{tx: tx}} = ctx, cx, cy, r, a0, a1, dir) do
+    da = arc_sweep(a1 - a0, dir)
+    n = arc_segments(abs(da), r * tx_scale(tx))
+
+    pts = for i <- 0..n, do: polar(cx, cy, r, a0 + da * i / n)
+    [{x, y} | tail] = pts
+
+    ctx =
+      case ctx do
+        %{cur: nil} -> move_to(ctx, x, y)
+        ctx -> line_to(ctx, x, y)
+      end
+
+    lines_to(ctx, tail)
+  end
+
+  defp sweep_dir(radians) when radians < 0, do: 1
+  defp sweep_dir(_), do: 2
+
+  defp arc_sweep(da, 2) when abs(da) >= @tau, do: @tau
+  defp arc_sweep(da, 2) when da < 0, do: arc_sweep(da + @tau, 2)
+  defp arc_sweep(da, 1) when abs(da) >= @tau, do: -@tau
+  defp arc_sweep(da, 1) when da > 0, do: arc_sweep(da - @tau, 1)
+  defp arc_sweep(da, _), do: da
+
+  defp arc_segments(_sweep, device_r) when device_r <= 0.5, do: @min_arc_segments
+
+  defp arc_segments(sweep, device_r) do
+    step = :math.sqrt(2 / device_r)
+    (sweep / step) |> ceil() |> max(@min_arc_segments) |> min(@max_arc_segments)
+  end
+
+  defp polar(cx, cy, r, a), do: {cx + r * :math.cos(a), cy + r * :math.sin(a)}
+
+  # tangent arc between the lines pen->p1 and p1->p2. Same math as nanovg.
+  defp arc_to(%{cur: nil} = ctx, x1, y1, _, _, _), do: move_to(ctx, x1, y1)
+
+  defp arc_to(%{pen: {x0, y0}} = ctx, x1, y1, x2, y2, r) do
+    with {d0x, d0y} <- normalize(x0 - x1, y0 - y1),
+         {d1x, d1y} <- normalize(x2 - x1, y2 - y1),
+         a when a > 0.0001 <- :math.acos(min(max(d0x * d1x + d0y * d1y, -1.0), 1.0)),
+         d when d < 10_000 <- r / :math.tan(a / 2) do
+      if d1x * d0y - d0x * d1y > 0 do
+        cx = x1 + d0x * d + d0y * r
+        cy = y1 + d0y * d - d0x * r
+        arc(ctx, cx, cy, r, :math.atan2(d0x, -d0y), :math.atan2(-d1x, d1y), 2)
+      else
+        cx = x1 + d0x * d - d0y * r
+        cy = y1 + d0y * d + d0x * r
+        arc(ctx, cx, cy, r, :math.atan2(-d0x, d0y), :math.atan2(d1x, -d1y), 1)
+      end
+    else
+      _ -> line_to(ctx, x1, y1)
+    end
+  end
+
+  defp normalize(x, y) do
+    case :math.sqrt(x * x + y * y) do
+      len when len < 1.0e-6 -> nil
+      len -> {x / len, y / len}
+    end
+  end
+
+  # cubic or quadratic bezier from the pen
+  defp curve(%{cur: nil, pen: {x, y}} = ctx, ctrl), do: ctx |> move_to(x, y) |> curve(ctrl)
+
+  defp curve(%{st: %{tx: tx}} = ctx, ctrl) do
+    len =
+      ctrl
+      |> Enum.map(&apply_tx(tx, &1))
+      |> Enum.chunk_every(2, 1, :discard)
+      |> Enum.reduce(0, fn [p0, p1], acc -> acc + dist(p0, p1) end)
+
+    n = (len / 3) |> ceil() |> max(2) |> min(@max_curve_segments)
+    lines_to(ctx, for(i <- 1..n, do: bezier(ctrl, i / n)))
+  end
+
+  defp bezier([{x0, y0}, {x1, y1}, {x2, y2}], t) do
+    u = 1 - t
+    {u * u * x0 + 2 * u * t * x1 + t * t * x2, u * u * y0 + 2 * u * t * y1 + t * t * y2}
+  end
+
+  defp bezier([{x0, y0}, {x1, y1}, {x2, y2}, {x3, y3}], t) do
+    u = 1 - t
+    {a, b, c, d} = {u * u * u, 3 * u * u * t, 3 * u * t * t, t * t * t}
+    {a * x0 + b * x1 + c * x2 + d * x3, a * y0 + b * y1 + c * y2 + d * y3}
+  end
+
+  defp dist({x0, y0}, {x1, y1}), do: :math.sqrt((x1 - x0) * (x1 - x0) + (y1 - y0) * (y1 - y0))
+
+  # ============================================================================
+  # fill and stroke
+
+  defp draw(ctx, flag), do: draw(ctx, flag, true)
+
+  defp draw(ctx, :fill_stroke, reset) do
+    ctx
+    |> draw(:fill, false)
+    |> draw(:stroke, reset)
+  end
+
+  defp draw(ctx, :fill, reset) do
+    %{path: path, st: %{fill: fill, clip: clip}} = ctx = end_contour(ctx)
+
+    contours = for {pts, _} <- path, length(pts) > 2, do: pts
+    ctx = emit(ctx, fill, clip, contours)
+    if reset, do: begin(ctx), else: ctx
+  end
+
+  defp draw(ctx, :stroke, reset) do
+    %{path: path, st: %{stroke: stroke, clip: clip} = st} = ctx = end_contour(ctx)
+
+    hw = st.stroke_width * tx_scale(st.tx) / 2
+
+    ctx =
+      case hw > 0 do
+        true -> emit(ctx, stroke, clip, Enum.flat_map(path, &stroke_contour(&1, hw, st)))
+        false -> ctx
+      end
+
+    if reset, do: begin(ctx), else: ctx
+  end
+
+  defp draw(ctx, _, _), do: ctx
+
+  # --------------------------------------------------------
+  # expand a device space contour into convex pieces
+  defp stroke_contour({pts, closed}, hw, st) do
+    pts = dedup(pts)
+
+    pts =
+      case closed and length(pts) > 2 and hd(pts) == List.last(pts) do
+        true -> Enum.drop(pts, -1)
+        false -> pts
+      end
+
+    case {pts, closed and length(pts) > 2} do
+      {[_], _} ->
+        []
+
+      {pts, true} ->
+        segs = Enum.zip(pts, tl(pts) ++ [hd(pts)])
+        pieces(segs, hw, st) ++ joins(segs ++ [hd(segs)], hw, st)
+
+      {pts, false} ->
+        segs = Enum.zip(pts, tl(pts))
+        pieces(segs, hw, st) ++ joins(segs, hw, st) ++ caps(segs, hw, st)
+    end
+    |> Enum.map(&orient/1)
+  end
+
+  defp dedup([p | pts]) do
+    Enum.reduce(pts, [p], fn
+      q, [q | _] = acc -> acc
+      q, acc -> [q | acc]
+    end)
+    |> Enum.reverse()
+  end
+
+  defp pieces(segs, hw, _st) do
+    Enum.map(segs, fn {{x0, y0}, {x1, y1}} = seg ->
+      {nx, ny} = seg_normal(seg, hw)
+      [{x0 + nx, y0 + ny}, {x1 + nx, y1 + ny}, {x1 - nx, y1 - ny}, {x0 - nx, y0 - ny}]
+    end)
+  end
+
+  defp joins(segs, hw, st) do
+    segs
+    |> Enum.chunk_every(2, 1, :discard)
+    |> Enum.flat_map(fn [s0, s1] -> join(s0, s1, hw, st) end)
+  end
+
+  defp join({{ax, ay}, {px, py}} = s0, {_, {bx, by}} = s1, hw, st) do
+    cross = (px - ax) * (by - py) - (py - ay) * (bx - px)
+    {n0x, n0y} = seg_normal(s0, 1)
+    {n1x, n1y} = seg_normal(s1, 1)
+    dot = n0x * n1x + n0y * n1y
+
+    # the join goes on the outside of the turn
+    s = if cross > 0, do: -hw, else: hw
+    o0 = {px + s * n0x, py + s * n0y}
+    o1 = {px + s * n1x, py + s * n1y}
+
+    cond do
+      abs(cross) < 1.0e-9 and dot > 0 ->
+        []
+
+      st.join == :round ->
+        [circle(px, py, hw)]
+
+      st.join == :miter and dot > -0.9999 and :math.sqrt(2 / (1 + dot)) <= st.miter_limit ->
+        k = s / (1 + dot)
+        [[{px, py}, o0, {px + k * (n0x + n1x), py + k * (n0y + n1y)}, o1]]
+
+      true ->
+        [[{px, py}, o0, o1]]
+    end
+  end
+
+  defp caps(_, _, %{cap: :butt}), do: []
+
+  defp caps(segs, hw, st) do
+    {{x0, y0}, {x1, y1}} = hd(segs)
+    {{x2, y2}, {x3, y3}} = List.last(segs)
+    [cap({x0, y0}, {x0 - x1, y0 - y1}, hw, st), cap({x3, y3}, {x3 - x2, y3 - y2}, hw, st)]
+  end
+
+  defp cap({x, y}, _, hw, %{cap: :round}), do: circle(x, y, hw)
+
+  defp cap({x, y}, {dx, dy}, hw, %{cap: :square}) do
+    {dx, dy} = normalize(dx, dy)
+    {nx, ny} = {-dy * hw, dx * hw}
+    {ex, ey} = {dx * hw, dy * hw}
+    [{x + nx, y + ny}, {x + nx + ex, y + ny + ey}, {x - nx + ex, y - ny + ey}, {x - nx, y - ny}]
+  end
+
+  defp seg_normal({{x0, y0}, {x1, y1}}, len) do
+    {dx, dy} = normalize(x1 - x0, y1 - y0)
+    {-dy * len, dx * len}
+  end
+
+  defp circle(x, y, r) do
+    n = arc_segments(@tau, r)
+    for i <- 0..(n - 1), do: polar(x, y, r, @tau * i / n)
+  end
+
+  # wind every piece the same way so overlaps merge instead of cancelling
+  defp orient(pts) do
+    area =
+      pts
+      |> Enum.zip(tl(pts) ++ [hd(pts)])
+      |> Enum.reduce(0, fn {{x0, y0}, {x1, y1}}, acc -> acc + x0 * y1 - x1 * y0 end)
+
+    if area < 0, do: Enum.reverse(pts), else: pts
+  end
+
+  # ============================================================================
+  # text. each string is one fill command
+
+  defp text(%{st: %{font: nil}} = ctx, _), do: ctx
+  defp text(%{st: %{fill: nil}} = ctx, _), do: ctx
+
+  defp text(%{st: st} = ctx, text) do
+    case Glyphs.load(st.font) do
+      {:ok, font} -> do_text(ctx, font, text)
+      _ -> ctx
+    end
+  end
+
+  defp do_text(%{st: st} = ctx, font, text) do
+    scale = st.font_size / font.upem
+
+    glyphs =
+      text
+      |> String.to_charlist()
+      |> Enum.map(&Glyphs.glyph_id(font, &1))
+
+    width = glyphs |> Enum.map(&Glyphs.advance(font, &1)) |> Enum.sum() |> Kernel.*(scale)
+
+    x =
+      case st.text_align do
+        :left -> 0
+        :center -> -width / 2
+        :right -> -width
+      end
+
+    y =
+      case st.text_base do
+        :alphabetic -> 0
+        :top -> font.ascender * scale
+        :middle -> (font.ascender + font.descender) * scale / 2
+        :bottom -> font.descender * scale
+      end
+
+    # glyph space is y up. flip it into the local space of the script
+    {contours, _} =
+      Enum.flat_map_reduce(glyphs, x, fn
+        0, pen ->
+          {[], pen + Glyphs.advance(font, 0) * scale}
+
+        g, pen ->
+          to_local = fn {gx, gy} -> {pen + gx * scale, y - gy * scale} end
+
+          contours =
+            font
+            |> Glyphs.outline(g)
+            |> Enum.map(&glyph_contour(&1, to_local, st.tx))
+
+          {contours, pen + Glyphs.advance(font, g) * scale}
+      end)
+
+    emit(ctx, st.fill, st.clip, contours)
+  end
+
+  defp glyph_contour({start, segs}, to_local, tx) do
+    dev = fn p -> apply_tx(tx, to_local.(p)) end
+    p0 = dev.(start)
+
+    {pts, _} =
+      Enum.flat_map_reduce(segs, p0, fn
+        {:line, p}, _ ->
+          p = dev.(p)
+          {[p], p}
+
+        {:quad, c, p}, prev ->
+          c = dev.(c)
+          p = dev.(p)
+          n = ((dist(prev, c) + dist(c, p)) / 3) |> ceil() |> max(2) |> min(16)
+          {for(i <- 1..n, do: bezier([prev, c, p], i / n)), p}
+      end)
+
+    [p0 | pts]
+  end
+
+  # ============================================================================
+  # display list output
+
+  defp emit(ctx, nil, _, _), do: ctx
+  defp emit(ctx, _, nil, _), do: ctx
+  defp emit(ctx, _, _, []), do: ctx
+
+  defp emit(%{out: out} = ctx, paint, {x0, y0, x1, y1}, contours) do
+    cmd = [
+      encode_paint(paint),
+      <<x0::float-32-native, y0::float-32-native, x1::float-32-native, y1::float-32-native>>,
+      <<length(contours)::32-native>>,
+      Enum.map(contours, &encode_contour/1)
+    ]
+
+    %{ctx | out: [cmd | out]}
+  end
+
+  defp encode_paint({:solid, c}) do
+    [<<@paint_solid::32-native>>, floats([@identity, {0, 0, 0, 0}, c, c, {0, 0}])]
+  end
+
+  defp encode_paint({:linear, inv, geom, c0, c1}) do
+    [<<@paint_linear::32-native>>, floats([inv, geom, c0, c1, {0, 0}])]
+  end
+
+  defp encode_paint({:radial, inv, geom, c0, c1}) do
+    [<<@paint_radial::32-native>>, floats([inv, geom, c0, c1, {0, 0}])]
+  end
+
+  defp floats(tuples) do
+    for t <- tuples, v <- Tuple.to_list(t), into: <<>>, do: <<v::float-32-native>>
+  end
+
+  defp encode_contour(pts) do
+    [
+      <<length(pts)::32-native>>,
+      for({x, y} <- pts, into: <<>>, do: <<x::float-32-native, y::float-32-native>>)
+    ]
+  end
+end
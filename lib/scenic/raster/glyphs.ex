@@ -0,0 +1,351 @@
+defmodule Scenic.Raster.Glyphs do
+  @moduledoc false
+  # Just enough of a TrueType reader to get glyph outlines and advances out of
+  # the fonts in the static asset library. Only the cmap, hmtx and glyf tables
+  # are used. No hinting, no kerning.
+  #
+  # Parsed fonts are kept in :persistent_term under their asset hash, so the
+  # table directory is only walked once per font.
+
+  alias Scenic.Assets.Static
+
+  defstruct upem: 1000,
+            ascender: 0,
+            descender: 0,
+            num_h_metrics: 0,
+            hmtx: <<>>,
+            loca: {},
+            glyf: <<>>,
+            cmap: nil
+
+  @type point :: {number, number}
+  @type segment :: {:line, point} | {:quad, point, point}
+  @type contour :: {start :: point, [segment]}
+
+  @type t :: %__MODULE__{}
+
+  # compound glyph flags
+  @arg_1_and_2_are_words 0x0001
+  @args_are_xy_values 0x0002
+  @we_have_a_scale 0x0008
+  @more_components 0x0020
+  @we_have_an_x_and_y_scale 0x0040
+  @we_have_a_two_by_two 0x0080
+
+  # simple glyph flags
+  @on_curve 0x01
+  @x_short 0x02
+  @y_short 0x04
+  @repeat 0x08
+  @x_same 0x10
+  @y_same 0x20
+
+  @max_depth 8
+
+  # --------------------------------------------------------
+  @spec load(hash :: String.t()) :: {:ok, t()} | {:error, any}
+  def load(hash) do
+    key = {__MODULE__, hash}
+
+    case :persistent_term.get(key, nil) do
+      nil ->
+        with {:ok, bin} <- Static.load(hash),
+             {:ok, font} <- parse(bin) do
+          :persistent_term.put(key, font)
+          {:ok, font}
+        end
+
+      font ->
+        {:ok, font}
+    end
+  end
+
+  # --------------------------------------------------------
+  @spec parse(bin :: binary) :: {:ok, t()} | {:error, :invalid_font}
+  def parse(<<_sfnt::32, num_tables::16, _::binary-size(6), _::binary>> = bin) do
+    tables =
+      for i <- 0..(num_tables - 1)//1, into: %{} do
+        <<tag::binary-size(4), _sum::32, offset::32, len::32>> =
+          binary_part(bin, 12 + i * 16, 16)
+
+        {tag, binary_part(bin, offset, len)}
+      end
+
+    with %{"head" => head, "hhea" => hhea, "maxp" => maxp} <- tables,
+         %{"hmtx" => hmtx, "loca" => loca, "glyf" => glyf, "cmap" => cmap} <- tables do
+      <<_::binary-size(18), upem::16, _::binary-size(30), loc_format::signed-16, _::binary>> =
+        head
+
+      <<_::binary-size(4), ascender::signed-16, descender::signed-16, _::binary-size(26),
+        num_h_metrics::16, _::binary>> = hhea
+
+      <<_::32, num_glyphs::16, _::binary>> = maxp
+
+      {:ok,
+       %__MODULE__{
+         upem: upem,
+         ascender: ascender,
+         descender: descender,
+         num_h_metrics: num_h_metrics,
+         hmtx: hmtx,
+         loca: parse_loca(loca, loc_format, num_glyphs + 1),
+         glyf: glyf,
+         cmap: parse_cmap(cmap)
+       }}
+    else
+      _ -> {:error, :invalid_font}
+    end
+  rescue
+    _ -> {:error, :invalid_font}
+  end
+
+  def parse(_), do: {:error, :invalid_font}
+
+  defp parse_loca(loca, 0, count) do
+    for(<<o::16 <- binary_part(loca, 0, count * 2)>>, do: o * 2)
+    |> List.to_tuple()
+  end
+
+  defp parse_loca(loca, _, count) do
+    for(<<o::32 <- binary_part(loca, 0, count * 4)>>, do: o)
+    |> List.to_tuple()
+  end
+
+  # prefer a full unicode (format 12) table over a bmp (format 4) one
+  defp parse_cmap(cmap) do
+    <<_version::16, count::16, records::binary-size(count * 8), _::binary>> = cmap
+
+    subtables =
+      for <<_platform::16, _encoding::16, offset::32 <- records>> do
+        <<format::16, _::binary>> = sub = binary_part(cmap, offset, byte_size(cmap) - offset)
+        {format, sub}
+      end
+
+    case List.keyfind(subtables, 12, 0) do
+      nil -> subtables |> List.keyfind(4, 0) |> cmap_4()
+      {12, sub} -> cmap_12(sub)
+    end
+  end
+
+  defp cmap_4(nil), do: {:groups, []}
+
+  defp cmap_4({4, sub}) do
+    <<4::16, len::16, _lang::16, seg_x2::16, _::binary-size(6), _::binary>> = sub
+
+    <<_::binary-size(14), ends::binary-size(seg_x2), _pad::16, starts::binary-size(seg_x2),
+      deltas::binary-size(seg_x2), ranges::binary-size(seg_x2), _::binary>> = sub
+
+    # offset of the id_range_offset array inside the subtable
+    range_base = 16 + seg_x2 * 3
+
+    segs =
+      for i <- 0..(div(seg_x2, 2) - 1)//1 do
+        <<_::binary-size(i * 2), e::16, _::binary>> = ends
+        <<_::binary-size(i * 2), s::16, _::binary>> = starts
+        <<_::binary-size(i * 2), d::signed-16, _::binary>> = deltas
+        <<_::binary-size(i * 2), r::16, _::binary>> = ranges
+        {s, e, d, r, range_base + i * 2}
+      end
+
+    {:cmap_4, segs, binary_part(sub, 0, min(len, byte_size(sub)))}
+  end
+
+  defp cmap_12(<<12::16, _::16, _len::32, _lang::32, count::32, groups::binary>>) do
+    {:groups,
+     for <<s::32, e::32, g::32 <- binary_part(groups, 0, count * 12)>> do
+       {s, e, g}
+     end}
+  end
+
+  # --------------------------------------------------------
+  @spec glyph_id(font :: t(), codepoint :: non_neg_integer) :: non_neg_integer
+  def glyph_id(%__MODULE__{cmap: {:groups, groups}}, cp) do
+    Enum.find_value(groups, 0, fn
+      {s, e, g} when cp >= s and cp <= e -> g + cp - s
+      _ -> nil
+    end)
+  end
+
+  def glyph_id(%__MODULE__{cmap: {:cmap_4, segs, sub}}, cp) do
+    Enum.find_value(segs, 0, fn
+      {s, e, d, 0, _} when cp >= s and cp <= e ->
+        rem(cp + d + 0x10000, 0x10000)
+
+      {s, e, d, r, at} when cp >= s and cp <= e ->
+        case sub do
+          <<_::binary-size(at + r + (cp - s) * 2), 0::16, _::binary>> -> 0
+          <<_::binary-size(at + r + (cp - s) * 2), g::16, _::binary>> -> rem(g + d, 0x10000)
+          _ -> 0
+        end
+
+      _ ->
+        nil
+    end)
+  end
+
+  # --------------------------------------------------------
+  @spec advance(font :: t(), glyph :: non_neg_integer) :: non_neg_integer
+  def advance(%__MODULE__{num_h_metrics: n, hmtx: hmtx}, glyph) do
+    i = min(glyph, n - 1)
+    <<_::binary-size(i * 4), adv::16, _::binary>> = hmtx
+    adv
+  end
+
+  # --------------------------------------------------------
+  # outline of a glyph in font units, y up
+  @spec outline(font :: t(), glyph :: non_neg_integer) :: [contour]
+  def outline(font, glyph), do: outline(font, glyph, 0)
+
+  defp outline(_, _, depth) when depth > @max_depth, do: []
+
+  defp outline(%__MODULE__{loca: loca, glyf: glyf} = font, glyph, depth) do
+    with true <- glyph + 1 < tuple_size(loca),
+         start <- elem(loca, glyph),
+         len when len > 0 <- elem(loca, glyph + 1) - start do
+      case binary_part(glyf, start, len) do
+        <<n::signed-16, _::binary-size(8), data::binary>> when n >= 0 -> simple(data, n)
+        <<_::signed-16, _::binary-size(8), data::binary>> -> compound(font, data, depth, [])
+      end
+    else
+      _ -> []
+    end
+  end
+
+  # --------------------------------------------------------
+  defp simple(data, n) do
+    <<ends::binary-size(n * 2), ilen::16, _::binary-size(ilen), rest::binary>> = data
+    ends = for <<e::16 <- ends>>, do: e
+    count = List.last(ends, -1) + 1
+
+    {flags, rest} = read_flags(rest, count, [])
+    {xs, rest} = read_coords(rest, flags, @x_short, @x_same, 0, [])
+    {ys, _} = read_coords(rest, flags, @y_short, @y_same, 0, [])
+
+    points =
+      Enum.zip_with([flags, xs, ys], fn [f, x, y] -> {x, y, Bitwise.band(f, @on_curve) != 0} end)
+
+    {contours, _} =
+      Enum.map_reduce(ends, {points, 0}, fn e, {pts, at} ->
+        {c, pts} = Enum.split(pts, e - at + 1)
+        {c, {pts, e + 1}}
+      end)
+
+    contours
+    |> Enum.reject(&(&1 == []))
+    |> Enum.map(&to_contour/1)
+  end
+
+  defp read_flags(rest, 0, acc), do: {Enum.reverse(acc), rest}
+
+  defp read_flags(<<f::8, rest::binary>>, n, acc) do
+    if Bitwise.band(f, @repeat) != 0 do
+      <<r::8, rest::binary>> = rest
+      r = min(r, n - 1)
+      read_flags(rest, n - 1 - r, List.duplicate(f, r + 1) ++ acc)
+    else
+      read_flags(rest, n - 1, [f | acc])
+    end
+  end
+
+  defp read_coords(rest, [], _, _, _, acc), do: {Enum.reverse(acc), rest}
+
+  defp read_coords(rest, [f | flags], short, same, v, acc) do
+    case {Bitwise.band(f, short) != 0, Bitwise.band(f, same) != 0, rest} do
+      {true, true, <<d::8, rest::binary>>} -> next_coord(rest, flags, short, same, v + d, acc)
+      {true, false, <<d::8, rest::binary>>} -> next_coord(rest, flags, short, same, v - d, acc)
+      {false, true, rest} -> next_coord(rest, flags, short, same, v, acc)
+      {false, false, <<d::signed-16, rest::binary>>} ->
+        next_coord(rest, flags, short, same, v + d, acc)
+    end
+  end
+
+  defp next_coord(rest, flags, short, same, v, acc) do
+    read_coords(rest, flags, short, same, v, [v | acc])
+  end
+
+  # turn a list of on/off curve points into a start point and segments.
+  # consecutive off curve points have an implied on curve point between them.
+  defp to_contour([first | _] = pts) do
+    last = List.last(pts)
+
+    {start, pts} =
+      case {first, last} do
+        {{x, y, true}, _} -> {{x, y}, tl(pts) ++ [first]}
+        {_, {x, y, true}} -> {{x, y}, pts}
+        _ -> {mid(last, first), pts ++ [Tuple.append(mid(last, first), true)]}
+      end
+
+    {start, segments(pts, nil, [])}
+  end
+
+  defp mid({x0, y0, _}, {x1, y1, _}), do: {(x0 + x1) / 2, (y0 + y1) / 2}
+
+  # the point list always ends on curve, so there is never a dangling control
+  defp segments([], _, acc), do: Enum.reverse(acc)
+
+  defp segments([{x, y, true} | pts], nil, acc), do: segments(pts, nil, [{:line, {x, y}} | acc])
+
+  defp segments([{x, y, true} | pts], ctrl, acc),
+    do: segments(pts, nil, [{:quad, ctrl, {x, y}} | acc])
+
+  defp segments([{x, y, false} | pts], nil, acc), do: segments(pts, {x, y}, acc)
+
+  defp segments([{x, y, false} | pts], {cx, cy}, acc) do
+    segments(pts, {x, y}, [{:quad, {cx, cy}, {(cx + x) / 2, (cy + y) / 2}} | acc])
+  end
+
+  # --------------------------------------------------------
+  defp compound(font, data, depth, acc) do
+    <<flags::16, glyph::16, rest::binary>> = data
+
+    {dx, dy, rest} =
+      case {Bitwise.band(flags, @arg_1_and_2_are_words) != 0, rest} do
+        {true, <<a::signed-16, b::signed-16, rest::binary>>} -> {a, b, rest}
+        {false, <<a::signed-8, b::signed-8, rest::binary>>} -> {a, b, rest}
+      end
+
+    # matching points aren't supported. place the component at the origin
+    {dx, dy} = if Bitwise.band(flags, @args_are_xy_values) != 0, do: {dx, dy}, else: {0, 0}
+
+    {{a, b, c, d}, rest} =
+      cond do
+        Bitwise.band(flags, @we_have_a_scale) != 0 ->
+          <<s::signed-16, rest::binary>> = rest
+          {{f2d14(s), 0, 0, f2d14(s)}, rest}
+
+        Bitwise.band(flags, @we_have_an_x_and_y_scale) != 0 ->
+          <<sx::signed-16, sy::signed-16, rest::binary>> = rest
+          {{f2d14(sx), 0, 0, f2d14(sy)}, rest}
+
+        Bitwise.band(flags, @we_have_a_two_by_two) != 0 ->
+          <<a::signed-16, b::signed-16, c::signed-16, d::signed-16, rest::binary>> = rest
+          {{f2d14(a), f2d14(b), f2d14(c), f2d14(d)}, rest}
+
+        true ->
+          {{1, 0, 0, 1}, rest}
+      end
+
+    tx = fn {x, y} -> {a * x + c * y + dx, b * x + d * y + dy} end
+
+    contours =
+      font
+      |> outline(glyph, depth + 1)
+      |> Enum.map(fn {start, segs} ->
+        {tx.(start),
+         Enum.map(segs, fn
+           {:line, p} -> {:line, tx.(p)}
+           {:quad, cp, p} -> {:quad, tx.(cp), tx.(p)}
+         end)}
+      end)
+
+    acc = acc ++ contours
+
+    if Bitwise.band(flags, @more_components) != 0 do
+      compound(font, rest, depth, acc)
+    else
+      acc
+    end
+  end
+
+  defp f2d14(v), do: v / 16384
+end
@@ -345,7 +345,9 @@ defmodule Scenic.Scene do
           child_supervisor: nil | map,
           assigns: map,
           supervisor: pid,
-          stop_pid: pid
+          stop_pid: pid,
+          animations: map,
+          animation_timer: nil | reference
         }
   defstruct viewport: nil,
             pid: nil,
@@ -357,7 +359,12 @@ defmodule Scenic.Scene do
             child_supervisor: nil,
             assigns: %{},
             supervisor: nil,
-            stop_pid: nil
+            stop_pid: nil,
+            animations: %{},
+            animation_timer: nil
+
+  # about 60 frames a second for animations
+  @frame_ms 16
 
   @type response_opts ::
           list(
@@ -838,12 +845,25 @@ defmodule Scenic.Scene do
 
   Any components that are created or removed from the scene are
   started/stopped/updated as appropriate.
+
+  The options are passed on to `Scenic.ViewPort.put_graph/4`. For example,
+  `cull: true` marks each group with its bounds so drivers can skip the
+  groups that are off screen.
+
+  If the graph has running animations (see `Scenic.Graph.animate/5`), the scene
+  keeps it and puts a new frame of it about every 16ms until they are done. Keep
+  the returned scene in your state, or the frames stop.
   """
-  @spec push_graph(scene :: Scene.t(), graph :: Graph.t(), name :: String.t() | nil) :: Scene.t()
-  def push_graph(scene, graph, id \\ nil)
+  @spec push_graph(
+          scene :: Scene.t(),
+          graph :: Graph.t(),
+          name :: String.t() | nil,
+          opts :: Keyword.t()
+        ) :: Scene.t()
+  def push_graph(scene, graph, id \\ nil, opts \\ [])
 
-  def push_graph(%Scene{id: id} = scene, %Graph{} = graph, nil) do
-    push_graph(scene, graph, id)
+  def push_graph(%Scene{id: id} = scene, %Graph{} = graph, nil, opts) do
+    push_graph(scene, graph, id, opts)
   end
 
   def push_graph(
@@ -853,7 +873,8 @@ defmodule Scenic.Scene do
           children: children
         } = scene,
         %Graph{} = graph,
-        id
+        id,
+        opts
       )
       when is_bitstring(id) do
     # if the graph does not have a theme set at the root, then
@@ -868,7 +889,7 @@ defmodule Scenic.Scene do
       end
 
     # put the graph to the ViewPort
-    ViewPort.put_graph(viewport, id, graph)
+    scene = put_frame(scene, id, graph, opts)
 
     # manage the child components
     case children do
@@ -877,6 +898,26 @@ defmodule Scenic.Scene do
     end
   end
 
+  # put the current frame of a graph. Graphs that are still animating are kept,
+  # and put again on the next frame.
+  defp put_frame(%Scene{viewport: viewport, animations: animations} = scene, id, graph, opts) do
+    {frame, running} = Graph.Animation.frame(graph)
+    ViewPort.put_graph(viewport, id, frame, opts)
+
+    case running do
+      true -> next_frame(%{scene | animations: Map.put(animations, id, {graph, opts})})
+      false -> %{scene | animations: Map.delete(animations, id)}
+    end
+  end
+
+  # one timer for all the graphs, lined up on the frame boundaries
+  defp next_frame(%Scene{pid: pid, animation_timer: nil} = scene) do
+    delay = @frame_ms - rem(Graph.Animation.now(), @frame_ms)
+    %{scene | animation_timer: Process.send_after(pid, :_animation_frame_, delay)}
+  end
+
+  defp next_frame(scene), do: scene
+
   # manage the components running on a scene
   # meant to be called internally
   @doc false
@@ -1208,7 +1249,8 @@ defmodule Scenic.Scene do
           push_script: 3,
           push_script: 4,
           push_graph: 2,
-          push_graph: 3
+          push_graph: 3,
+          push_graph: 4
         ]
 
       if Module.defines?(__MODULE__, {:filter_event, 3}) do
@@ -1478,6 +1520,15 @@ defmodule Scenic.Scene do
     end
   end
 
+  def handle_info(:_animation_frame_, %Scene{animations: animations} = scene) do
+    scene =
+      Enum.reduce(animations, %{scene | animation_timer: nil}, fn {id, {graph, opts}}, scene ->
+        put_frame(scene, id, graph, opts)
+      end)
+
+    {:noreply, scene}
+  end
+
   # --------------------------------------------------------
   # generic handle_info. give the scene a chance to handle it
   @doc false
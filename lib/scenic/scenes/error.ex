@@ -41,23 +41,19 @@ defmodule Scenic.Scenes.Error do
     # Get the viewport width
     {width, _} = scene.viewport.size
 
-    {:ok, {Static.Font, fm}} = Static.meta(@default_font)
     wrap_width = width - @margin_h * 2
 
     head_msg = module_msg <> @mod_header
 
-    err_msg =
-      (@error_header <> err_msg)
-      |> FontMetrics.wrap(wrap_width, @size, fm)
-
-    args_msg =
-      (@args_header <> args_msg)
-      |> FontMetrics.wrap(wrap_width, @size, fm)
-
-    stack_msg =
-      (@stack_header <> stack_msg)
-      |> String.replace("    ", "  ")
-      |> FontMetrics.wrap(wrap_width, @size, fm)
+    # wrap all three messages in one pass
+    [err_msg, args_msg, stack_msg] =
+      [
+        @error_header <> err_msg,
+        @args_header <> args_msg,
+        String.replace(@stack_header <> stack_msg, "    ", "  ")
+      ]
+      |> Static.Font.wraps(wrap_width, @size, @default_font)
+      |> Enum.map(&Enum.join(&1, "\n"))
 
     head_v = 80
     args_v = head_v + msg_height(head_msg, @size) + @v_spacing
@@ -158,6 +158,28 @@ defmodule Scenic.Script do
 
   Drivers, which normally do the serialization call, can intercept/override any command if they
   need something specific.
+
+  ## Packed Scripts
+
+  Scripts can also be built directly in their binary form. Call `start/1` with `:packed`
+  and every api call appends its serialized command onto the end of a single binary instead
+  of adding a tuple to a list.
+
+  ```elixir
+  my_script =
+    Script.start(:packed)
+    |> Script.fill_color(:red)
+    |> Script.draw_rectangle(100, 20, :fill)
+    |> Script.finish()
+  ```
+
+  A packed script is much smaller than the equivalent list of ops and is stored in the ViewPort's
+  script table as a single reference counted binary, so reading it out of the table with
+  `Scenic.ViewPort.get_script/2` shares it instead of copying every op onto the reader's heap.
+
+  Packed scripts are accepted everywhere list scripts are. `serialize/1` returns them as-is,
+  `media/1` scans them in place, and `reduce_packed/3` lets drivers walk the individual
+  commands without deserializing them. Use `pack/1` to convert an existing list script.
   """
 
   # mostly used by the @specs
@@ -209,6 +231,7 @@ defmodule Scenic.Script do
   @op_pop_state 0x41
   @op_pop_push_state 0x42
   @op_scissor 0x44
+  @op_cull 0x45
 
   @op_transform 0x50
   @op_scale 0x51
@@ -341,6 +364,9 @@ defmodule Scenic.Script do
           | {:join, :miter}
           | {:miter_limit, limit :: number}
           | {:scissor, {width :: number, height :: number}}
+          | {:cull,
+             {left :: number, top :: number, right :: number, bottom :: number,
+              count :: non_neg_integer}}
           | {:font, id :: Static.id()}
           | {:font_size, size :: number}
           | {:text_align, :left}
@@ -352,7 +378,8 @@ defmodule Scenic.Script do
           | {:text_base, :bottom}
 
   # @type operation :: {op :: atom, data :: any}
-  @type t :: [script_op]
+  @type packed :: binary
+  @type t :: [script_op] | packed()
 
   @doc """
   draw_flag is a helper function to choose the appropriate fill and/or stroke flag
@@ -373,6 +400,15 @@ defmodule Scenic.Script do
   @spec start() :: ops :: t()
   def start(), do: []
 
+  @doc """
+  Create a new packed Script.
+
+  The ops are serialized into a single binary as they are added. See the
+  "Packed Scripts" section above.
+  """
+  @spec start(:packed) :: ops :: packed()
+  def start(:packed), do: <<>>
+
   @doc """
   Finish a script, preparing it to be sent to the ViewPort.
 
@@ -391,6 +427,23 @@ defmodule Scenic.Script do
     |> optimize()
   end
 
+  def finish(ops) when is_binary(ops), do: optimize_packed(ops)
+
+  @doc """
+  Convert a finished list script into a packed script.
+
+  Packed scripts pass through unchanged.
+  """
+  @spec pack(script :: t()) :: packed()
+  def pack(script) when is_list(script), do: IO.iodata_to_binary(serialize(script))
+  def pack(script) when is_binary(script), do: script
+
+  @doc """
+  Returns true if the script is in the packed binary form.
+  """
+  @spec packed?(script :: t()) :: boolean
+  def packed?(script), do: is_binary(script)
+
   # control commands
   @doc """
   Saves the current style/transform state of the script as it is running.
@@ -402,7 +455,7 @@ defmodule Scenic.Script do
   `push_state/1` must be paired with an eventual `pop_state/1` or `pop_push_state/1`
   """
   @spec push_state(ops :: t()) :: ops :: t()
-  def push_state(ops), do: [:push_state | ops]
+  def push_state(ops), do: add_op(ops, :push_state)
 
   @doc """
   Reverts the style/transform state of the script to the most recently pushed state.
@@ -414,7 +467,7 @@ defmodule Scenic.Script do
   `push_state/1` must be preceded with either `push_state/1` or `pop_push_state/1`
   """
   @spec pop_state(ops :: t()) :: ops :: t()
-  def pop_state(ops), do: [:pop_state | ops]
+  def pop_state(ops), do: add_op(ops, :pop_state)
 
   @doc """
   Reverts the style/transform state of the script then immediately pushes it again.
@@ -430,7 +483,7 @@ defmodule Scenic.Script do
   `pop_state/1` or another `pop_push_state/1`
   """
   @spec pop_push_state(ops :: t()) :: ops :: t()
-  def pop_push_state(ops), do: [:pop_push_state | ops]
+  def pop_push_state(ops), do: add_op(ops, :pop_push_state)
 
   @doc """
   Erase the entire drawing field output.
@@ -441,10 +494,20 @@ defmodule Scenic.Script do
   """
   @spec clear(ops :: t(), color :: Color.t()) :: ops :: t()
   def clear(ops, color) do
-    [{:clear, Color.to_rgba(color)} | ops]
+    add_op(ops, {:clear, Color.to_rgba(color)})
   end
 
   # internal helpers
+
+  # list scripts are built in reverse and flipped by finish/1. Packed scripts are
+  # serialized straight onto the end of the binary.
+  @compile {:inline, add_op: 2}
+  defp add_op(ops, op) when is_list(ops), do: [op | ops]
+
+  defp add_op(ops, op) when is_binary(ops) do
+    <<ops::binary, IO.iodata_to_binary(serialize_op(op))::binary>>
+  end
+
   defp to_flag(:fill_stroke), do: @flag_fill_stroke
   defp to_flag(:fill), do: @flag_fill
   defp to_flag(:stroke), do: @flag_stroke
@@ -465,7 +528,7 @@ defmodule Scenic.Script do
   @spec draw_line(ops :: t(), x0 :: number, y0 :: number, x1 :: number, y1 :: number, :stroke) ::
           ops :: t()
   def draw_line(ops, x0, y0, x1, y1, :stroke) do
-    [{:draw_line, {x0, y0, x1, y1, :stroke}} | ops]
+    add_op(ops, {:draw_line, {x0, y0, x1, y1, :stroke}})
   end
 
   @doc """
@@ -484,7 +547,7 @@ defmodule Scenic.Script do
           fill_stroke_flags :: fill_stroke()
         ) :: ops :: t()
   def draw_triangle(ops, x0, y0, x1, y1, x2, y2, flag) do
-    [{:draw_triangle, {x0, y0, x1, y1, x2, y2, flag}} | ops]
+    add_op(ops, {:draw_triangle, {x0, y0, x1, y1, x2, y2, flag}})
   end
 
   @doc """
@@ -505,7 +568,7 @@ defmodule Scenic.Script do
           fill_stroke_flags :: fill_stroke()
         ) :: ops :: t()
   def draw_quad(ops, x0, y0, x1, y1, x2, y2, x3, y3, flag) do
-    [{:draw_quad, {x0, y0, x1, y1, x2, y2, x3, y3, flag}} | ops]
+    add_op(ops, {:draw_quad, {x0, y0, x1, y1, x2, y2, x3, y3, flag}})
   end
 
   @doc """
@@ -520,7 +583,7 @@ defmodule Scenic.Script do
           fill_stroke_flags :: fill_stroke()
         ) :: ops :: t()
   def draw_rectangle(ops, width, height, flag) do
-    [{:draw_rect, {width, height, flag}} | ops]
+    add_op(ops, {:draw_rect, {width, height, flag}})
   end
 
   @doc """
@@ -537,7 +600,7 @@ defmodule Scenic.Script do
         ) :: ops :: t()
   def draw_rounded_rectangle(ops, width, height, radius, flag) do
     radius = smallest([radius, width / 2, height / 2])
-    [{:draw_rrect, {width, height, radius, flag}} | ops]
+    add_op(ops, {:draw_rrect, {width, height, radius, flag}})
   end
 
   @doc """
@@ -568,12 +631,12 @@ defmodule Scenic.Script do
     lower_right_radius = smallest([r3, width / 2, height / 2])
     lower_left_radius = smallest([r4, width / 2, height / 2])
 
-    [
+    add_op(
+      ops,
       {:draw_rrectv,
        {width, height, upper_left_radius, upper_right_radius, lower_right_radius,
         lower_left_radius, flag}}
-      | ops
-    ]
+    )
   end
 
   @doc """
@@ -588,7 +651,7 @@ defmodule Scenic.Script do
           fill_stroke_flags :: fill_stroke()
         ) :: ops :: t()
   def draw_sector(ops, radius, radians, flag) do
-    [{:draw_sector, {radius, radians, flag}} | ops]
+    add_op(ops, {:draw_sector, {radius, radians, flag}})
   end
 
   @doc """
@@ -603,7 +666,7 @@ defmodule Scenic.Script do
           fill_stroke_flags :: fill_stroke()
         ) :: ops :: t()
   def draw_arc(ops, radius, radians, flag) do
-    [{:draw_arc, {radius, radians, flag}} | ops]
+    add_op(ops, {:draw_arc, {radius, radians, flag}})
   end
 
   @doc """
@@ -617,7 +680,7 @@ defmodule Scenic.Script do
           fill_stroke_flags :: fill_stroke()
         ) :: ops :: t()
   def draw_circle(ops, radius, flag) do
-    [{:draw_circle, {radius, flag}} | ops]
+    add_op(ops, {:draw_circle, {radius, flag}})
   end
 
   @doc """
@@ -632,13 +695,20 @@ defmodule Scenic.Script do
           fill_stroke_flags :: fill_stroke()
         ) :: ops :: t()
   def draw_ellipse(ops, radius0, radius1, flag) do
-    [{:draw_ellipse, {radius0, radius1, flag}} | ops]
+    add_op(ops, {:draw_ellipse, {radius0, radius1, flag}})
   end
 
   @doc """
   Draw a collection of sprites.
 
   Draws one or more subsection from a single source image.
+
+  The draw commands can be a list or a packed binary of commands. See
+  `Scenic.Primitive.Sprites` for the packed layout. Packed commands are copied
+  into the serialized script as-is.
+
+  If the image was packed into an atlas, the sprites are drawn from the atlas and
+  the source rectangles are moved to where the image is in it.
   """
   @spec draw_sprites(
           ops :: t(),
@@ -646,16 +716,32 @@ defmodule Scenic.Script do
           draw_commands :: Sprites.draw_cmds()
         ) :: ops :: t()
   def draw_sprites(ops, src_id, cmds) do
-    id =
+    {id, cmds} =
       with {:ok, hash} <- Static.to_hash(src_id),
            {:ok, {Static.Image, _}} <- Static.meta(hash) do
-        hash
+        case Static.region(hash) do
+          {:ok, {atlas, {x, y, _, _}}} -> {atlas, offset_sprites(cmds, x, y)}
+          :error -> {hash, cmds}
+        end
       else
         err ->
           raise "Invalid image -> #{inspect(src_id)}, err: #{inspect(err)}"
       end
 
-    [{:draw_sprites, {id, cmds}} | ops]
+    add_op(ops, {:draw_sprites, {id, cmds}})
+  end
+
+  defp offset_sprites(cmds, dx, dy) when is_binary(cmds) do
+    for <<sx::float-32-big, sy::float-32-big, rest::binary-size(28) <- cmds>>, into: <<>> do
+      <<sx + dx::float-32-big, sy + dy::float-32-big, rest::binary>>
+    end
+  end
+
+  defp offset_sprites(cmds, dx, dy) do
+    Enum.map(cmds, fn
+      {{sx, sy}, src_wh, dst_xy, dst_wh} -> {{sx + dx, sy + dy}, src_wh, dst_xy, dst_wh}
+      {{sx, sy}, src_wh, dst_xy, dst_wh, a} -> {{sx + dx, sy + dy}, src_wh, dst_xy, dst_wh, a}
+    end)
   end
 
   @doc """
@@ -665,7 +751,7 @@ defmodule Scenic.Script do
   """
   @spec draw_text(ops :: t(), text :: String.t()) :: ops :: t()
   def draw_text(ops, utf8_string) do
-    [{:draw_text, utf8_string} | ops]
+    add_op(ops, {:draw_text, utf8_string})
   end
 
   @doc """
@@ -704,7 +790,7 @@ defmodule Scenic.Script do
   """
   @spec render_script(ops :: t(), id :: String.t()) :: ops :: t()
   def render_script(ops, id) when is_bitstring(id) do
-    [{:script, id} | ops]
+    add_op(ops, {:script, id})
   end
 
   # path commands
@@ -712,7 +798,7 @@ defmodule Scenic.Script do
   Begin a new path.
   """
   @spec begin_path(ops :: t()) :: ops :: t()
-  def begin_path(ops), do: [:begin_path | ops]
+  def begin_path(ops), do: add_op(ops, :begin_path)
 
   @doc """
   Close the current path.
@@ -721,26 +807,26 @@ defmodule Scenic.Script do
   where the path was started.
   """
   @spec close_path(ops :: t()) :: ops :: t()
-  def close_path(ops), do: [:close_path | ops]
+  def close_path(ops), do: add_op(ops, :close_path)
 
   @doc """
   Fill the current path with the currently selected fill paint.
   """
   @spec fill_path(ops :: t()) :: ops :: t()
-  def fill_path(ops), do: [:fill_path | ops]
+  def fill_path(ops), do: add_op(ops, :fill_path)
 
   @doc """
   Stroke the current path with the currently selected stroke width/paint.
   """
   @spec stroke_path(ops :: t()) :: ops :: t()
-  def stroke_path(ops), do: [:stroke_path | ops]
+  def stroke_path(ops), do: add_op(ops, :stroke_path)
 
   @doc """
   Move the current draw position without adding a line segment.
   """
   @spec move_to(ops :: t(), x :: number, y :: number) :: ops :: t()
   def move_to(ops, x, y) do
-    [{:move_to, {x, y}} | ops]
+    add_op(ops, {:move_to, {x, y}})
   end
 
   @doc """
@@ -750,7 +836,7 @@ defmodule Scenic.Script do
   """
   @spec line_to(ops :: t(), x :: number, y :: number) :: ops :: t()
   def line_to(ops, x, y) do
-    [{:line_to, {x, y}} | ops]
+    add_op(ops, {:line_to, {x, y}})
   end
 
   @doc """
@@ -767,7 +853,7 @@ defmodule Scenic.Script do
           radius :: number
         ) :: ops :: t()
   def arc_to(ops, x1, y1, x2, y2, radius) do
-    [{:arc_to, {x1, y1, x2, y2, radius}} | ops]
+    add_op(ops, {:arc_to, {x1, y1, x2, y2, radius}})
   end
 
   @doc """
@@ -785,7 +871,7 @@ defmodule Scenic.Script do
           y :: number
         ) :: ops :: t()
   def bezier_to(ops, cp1x, cp1y, cp2x, cp2y, x, y) do
-    [{:bezier_to, {cp1x, cp1y, cp2x, cp2y, x, y}} | ops]
+    add_op(ops, {:bezier_to, {cp1x, cp1y, cp2x, cp2y, x, y}})
   end
 
   @doc """
@@ -796,7 +882,7 @@ defmodule Scenic.Script do
   @spec quadratic_to(ops :: t(), cpx :: number, cpy :: number, x :: number, y :: number) ::
           ops :: t()
   def quadratic_to(ops, cpx, cpy, x, y) do
-    [{:quadratic_to, {cpx, cpy, x, y}} | ops]
+    add_op(ops, {:quadratic_to, {cpx, cpy, x, y}})
   end
 
   @doc """
@@ -816,7 +902,7 @@ defmodule Scenic.Script do
           y3 :: number
         ) :: ops :: t()
   def quad(ops, x0, y0, x1, y1, x2, y2, x3, y3) do
-    [{:quad, {x0, y0, x1, y1, x2, y2, x3, y3}} | ops]
+    add_op(ops, {:quad, {x0, y0, x1, y1, x2, y2, x3, y3}})
   end
 
   @doc """
@@ -826,7 +912,7 @@ defmodule Scenic.Script do
   """
   @spec rectangle(ops :: t(), width :: number, height :: number) :: ops :: t()
   def rectangle(ops, width, height) do
-    [{:rect, {width, height}} | ops]
+    add_op(ops, {:rect, {width, height}})
   end
 
   @doc """
@@ -838,7 +924,7 @@ defmodule Scenic.Script do
           ops :: t()
   def rounded_rectangle(ops, width, height, radius) do
     radius = smallest([radius, width / 2, height / 2])
-    [{:rrect, {width, height, radius}} | ops]
+    add_op(ops, {:rrect, {width, height, radius}})
   end
 
   @doc """
@@ -848,7 +934,7 @@ defmodule Scenic.Script do
   """
   @spec sector(ops :: t(), radius :: number, radians :: number) :: ops :: t()
   def sector(ops, radius, radians) do
-    [{:sector, {radius, radians}} | ops]
+    add_op(ops, {:sector, {radius, radians}})
   end
 
   @doc """
@@ -858,7 +944,7 @@ defmodule Scenic.Script do
   """
   @spec circle(ops :: t(), radius :: number) :: ops :: t()
   def circle(ops, radius) do
-    [{:circle, radius} | ops]
+    add_op(ops, {:circle, radius})
   end
 
   @doc """
@@ -868,7 +954,7 @@ defmodule Scenic.Script do
   """
   @spec ellipse(ops :: t(), radius0 :: number, radius1 :: number) :: ops :: t()
   def ellipse(ops, radius0, radius1) do
-    [{:ellipse, {radius0, radius1}} | ops]
+    add_op(ops, {:ellipse, {radius0, radius1}})
   end
 
   @doc """
@@ -895,7 +981,7 @@ defmodule Scenic.Script do
           dir :: integer
         ) :: ops :: t()
   def arc(ops, cx, cy, r, a0, a1, dir) do
-    [{:arc, {cx, cy, r, a0, a1, dir}} | ops]
+    add_op(ops, {:arc, {cx, cy, r, a0, a1, dir}})
   end
 
   @doc """
@@ -913,7 +999,7 @@ defmodule Scenic.Script do
           y2 :: number
         ) :: ops :: t()
   def triangle(ops, x0, y0, x1, y1, x2, y2) do
-    [{:triangle, {x0, y0, x1, y1, x2, y2}} | ops]
+    add_op(ops, {:triangle, {x0, y0, x1, y1, x2, y2}})
   end
 
   # transform commands
@@ -922,7 +1008,7 @@ defmodule Scenic.Script do
   """
   @spec scale(ops :: t(), x :: number, y :: number) :: ops :: t()
   def scale(ops, x, y) do
-    [{:scale, {x, y}} | ops]
+    add_op(ops, {:scale, {x, y}})
   end
 
   @doc """
@@ -930,7 +1016,7 @@ defmodule Scenic.Script do
   """
   @spec rotate(ops :: t(), radians :: number) :: ops :: t()
   def rotate(ops, radians) do
-    [{:rotate, radians} | ops]
+    add_op(ops, {:rotate, radians})
   end
 
   @doc """
@@ -938,7 +1024,7 @@ defmodule Scenic.Script do
   """
   @spec translate(ops :: t(), x :: number, y :: number) :: ops :: t()
   def translate(ops, x, y) do
-    [{:translate, {x, y}} | ops]
+    add_op(ops, {:translate, {x, y}})
   end
 
   @doc """
@@ -954,7 +1040,7 @@ defmodule Scenic.Script do
           f :: number
         ) :: ops :: t()
   def transform(ops, a, b, c, d, e, f) do
-    [{:transform, {a, b, c, d, e, f}} | ops]
+    add_op(ops, {:transform, {a, b, c, d, e, f}})
   end
 
   # style commands
@@ -967,7 +1053,7 @@ defmodule Scenic.Script do
   """
   @spec fill_color(ops :: t(), color :: Color.t()) :: ops :: t()
   def fill_color(ops, color) do
-    [{:fill_color, Color.to_rgba(color)} | ops]
+    add_op(ops, {:fill_color, Color.to_rgba(color)})
   end
 
   @doc """
@@ -986,7 +1072,8 @@ defmodule Scenic.Script do
           color_end :: Color.t()
         ) :: ops :: t()
   def fill_linear(ops, start_x, start_y, end_x, end_y, color_start, color_end) do
-    [
+    add_op(
+      ops,
       {:fill_linear,
        {
          start_x,
@@ -996,8 +1083,7 @@ defmodule Scenic.Script do
          Color.to_rgba(color_start),
          Color.to_rgba(color_end)
        }}
-      | ops
-    ]
+    )
   end
 
   @doc """
@@ -1016,7 +1102,8 @@ defmodule Scenic.Script do
           color_end :: Color.t()
         ) :: ops :: t()
   def fill_radial(ops, center_x, center_y, inner_radius, outer_radius, color_start, color_end) do
-    [
+    add_op(
+      ops,
       {
         :fill_radial,
         {
@@ -1028,8 +1115,7 @@ defmodule Scenic.Script do
           Color.to_rgba(color_end)
         }
       }
-      | ops
-    ]
+    )
   end
 
   @doc """
@@ -1051,7 +1137,7 @@ defmodule Scenic.Script do
           raise "Invalid image -> #{inspect(id)}, err: #{inspect(err)}"
       end
 
-    [{:fill_image, id} | ops]
+    add_op(ops, {:fill_image, id})
   end
 
   @doc """
@@ -1063,7 +1149,7 @@ defmodule Scenic.Script do
   draw_* apis to actually draw something.
   """
   @spec fill_stream(ops :: t(), id :: Stream.id()) :: ops :: t()
-  def fill_stream(ops, id) when is_bitstring(id), do: [{:fill_stream, id} | ops]
+  def fill_stream(ops, id) when is_bitstring(id), do: add_op(ops, {:fill_stream, id})
 
   @doc """
   Set the current stroke to an single color.
@@ -1073,7 +1159,7 @@ defmodule Scenic.Script do
   """
   @spec stroke_color(ops :: t(), color :: Color.t()) :: ops :: t()
   def stroke_color(ops, color) do
-    [{:stroke_color, Color.to_rgba(color)} | ops]
+    add_op(ops, {:stroke_color, Color.to_rgba(color)})
   end
 
   @doc """
@@ -1092,7 +1178,8 @@ defmodule Scenic.Script do
           color_end :: Color.t()
         ) :: ops :: t()
   def stroke_linear(ops, start_x, start_y, end_x, end_y, color_start, color_end) do
-    [
+    add_op(
+      ops,
       {
         :stroke_linear,
         {
@@ -1104,8 +1191,7 @@ defmodule Scenic.Script do
           Color.to_rgba(color_end)
         }
       }
-      | ops
-    ]
+    )
   end
 
   @doc """
@@ -1124,7 +1210,8 @@ defmodule Scenic.Script do
           color_end :: Color.t()
         ) :: ops :: t()
   def stroke_radial(ops, center_x, center_y, inner_radius, outer_radius, color_start, color_end) do
-    [
+    add_op(
+      ops,
       {
         :stroke_radial,
         {
@@ -1136,8 +1223,7 @@ defmodule Scenic.Script do
           Color.to_rgba(color_end)
         }
       }
-      | ops
-    ]
+    )
   end
 
   @doc """
@@ -1159,7 +1245,7 @@ defmodule Scenic.Script do
           raise "Invalid image -> #{inspect(id)}, err: #{inspect(err)}"
       end
 
-    [{:stroke_image, id} | ops]
+    add_op(ops, {:stroke_image, id})
   end
 
   @doc """
@@ -1171,7 +1257,7 @@ defmodule Scenic.Script do
   draw_* apis to actually draw something.
   """
   @spec stroke_stream(ops :: t(), id :: Stream.id()) :: ops :: t()
-  def stroke_stream(ops, id) when is_bitstring(id), do: [{:stroke_stream, id} | ops]
+  def stroke_stream(ops, id) when is_bitstring(id), do: add_op(ops, {:stroke_stream, id})
 
   @doc """
   Set the current stroke width.
@@ -1180,7 +1266,7 @@ defmodule Scenic.Script do
   draw_* apis to actually draw something.
   """
   @spec stroke_width(ops :: t(), width :: number) :: ops :: t()
-  def stroke_width(ops, width), do: [{:stroke_width, width} | ops]
+  def stroke_width(ops, width), do: add_op(ops, {:stroke_width, width})
 
   @doc """
   Set the current end cap style.
@@ -1188,9 +1274,9 @@ defmodule Scenic.Script do
   Can be any one of `:butt`, `:round`, or `:square`
   """
   @spec cap(ops :: t(), type :: :butt | :round | :square) :: ops :: t()
-  def cap(ops, :butt), do: [{:cap, :butt} | ops]
-  def cap(ops, :round), do: [{:cap, :round} | ops]
-  def cap(ops, :square), do: [{:cap, :square} | ops]
+  def cap(ops, :butt), do: add_op(ops, {:cap, :butt})
+  def cap(ops, :round), do: add_op(ops, {:cap, :round})
+  def cap(ops, :square), do: add_op(ops, {:cap, :square})
 
   @doc """
   Set the current line joint style.
@@ -1198,15 +1284,15 @@ defmodule Scenic.Script do
   Can be any one of `:bevel`, `:round`, or `:miter`
   """
   @spec join(ops :: t(), type :: :bevel | :round | :miter) :: ops :: t()
-  def join(ops, :bevel), do: [{:join, :bevel} | ops]
-  def join(ops, :round), do: [{:join, :round} | ops]
-  def join(ops, :miter), do: [{:join, :miter} | ops]
+  def join(ops, :bevel), do: add_op(ops, {:join, :bevel})
+  def join(ops, :round), do: add_op(ops, {:join, :round})
+  def join(ops, :miter), do: add_op(ops, {:join, :miter})
 
   @doc """
   Set the current miter limit for joints.
   """
   @spec miter_limit(ops :: t(), limit :: number) :: ops :: t()
-  def miter_limit(ops, limit), do: [{:miter_limit, limit} | ops]
+  def miter_limit(ops, limit), do: add_op(ops, {:miter_limit, limit})
 
   @doc """
   Set the current scissor rect.
@@ -1215,7 +1301,31 @@ defmodule Scenic.Script do
   pop it afterwards.
   """
   @spec scissor(ops :: t(), width :: number, height :: number) :: ops :: t()
-  def scissor(ops, w, h), do: [{:scissor, {w, h}} | ops]
+  def scissor(ops, w, h), do: add_op(ops, {:scissor, {w, h}})
+
+  @doc """
+  Mark the bounds of the next `count` ops.
+
+  The bounds are in the current local coordinate space. If they don't
+  intersect the visible area (the scissor rect if one is set, otherwise the
+  viewport) the renderer can skip the next `count` ops entirely. Renderers that
+  don't cull can ignore this op.
+
+  The covered ops must leave the draw state as they found it. This is usually
+  done by wrapping them in a `push_state` / `pop_state` pair. The graph compiler
+  emits these when a graph is put with the `cull: true` option.
+  """
+  @spec cull(
+          ops :: t(),
+          left :: number,
+          top :: number,
+          right :: number,
+          bottom :: number,
+          count :: non_neg_integer
+        ) :: ops :: t()
+  def cull(ops, l, t, r, b, count) when is_integer(count) and count >= 0 do
+    add_op(ops, {:cull, {l, t, r, b, count}})
+  end
 
   @doc """
   Set the current font. Must be a valid reference into your static assets library.
@@ -1231,14 +1341,14 @@ defmodule Scenic.Script do
           raise "Invalid font -> #{inspect(id)}, err: #{inspect(err)}"
       end
 
-    [{:font, id} | ops]
+    add_op(ops, {:font, id})
   end
 
   @doc """
   Set the current font size.
   """
   @spec font_size(ops :: t(), size :: number) :: ops :: t()
-  def font_size(ops, px), do: [{:font_size, px} | ops]
+  def font_size(ops, px), do: add_op(ops, {:font_size, px})
 
   @doc """
   Set the current horizontal text alignment.
@@ -1246,9 +1356,9 @@ defmodule Scenic.Script do
   Can be any one of `:left`, `:right`, or `:center`
   """
   @spec text_align(ops :: t(), type :: :left | :center | :right) :: ops :: t()
-  def text_align(ops, :left), do: [{:text_align, :left} | ops]
-  def text_align(ops, :center), do: [{:text_align, :center} | ops]
-  def text_align(ops, :right), do: [{:text_align, :right} | ops]
+  def text_align(ops, :left), do: add_op(ops, {:text_align, :left})
+  def text_align(ops, :center), do: add_op(ops, {:text_align, :center})
+  def text_align(ops, :right), do: add_op(ops, {:text_align, :right})
 
   @doc """
   Set the current vertical text alignment.
@@ -1256,10 +1366,10 @@ defmodule Scenic.Script do
   Can be any one of `:top`, `:middle`, `:alphabetic`, or `:bottom`
   """
   @spec text_base(ops :: t(), type :: :top | :middle | :alphabetic | :bottom) :: ops :: t()
-  def text_base(ops, :top), do: [{:text_base, :top} | ops]
-  def text_base(ops, :middle), do: [{:text_base, :middle} | ops]
-  def text_base(ops, :alphabetic), do: [{:text_base, :alphabetic} | ops]
-  def text_base(ops, :bottom), do: [{:text_base, :bottom} | ops]
+  def text_base(ops, :top), do: add_op(ops, {:text_base, :top})
+  def text_base(ops, :middle), do: add_op(ops, {:text_base, :middle})
+  def text_base(ops, :alphabetic), do: add_op(ops, {:text_base, :alphabetic})
+  def text_base(ops, :bottom), do: add_op(ops, {:text_base, :bottom})
 
   # ============================================================================
 
@@ -1297,6 +1407,9 @@ defmodule Scenic.Script do
     Enum.map(script, &serialize_op(&1))
   end
 
+  # packed scripts are already serialized
+  def serialize(script) when is_binary(script), do: [script]
+
   @doc """
   Transform a script list into a binary IO list with a map like interceptor function.
 
@@ -1332,6 +1445,27 @@ defmodule Scenic.Script do
     end)
   end
 
+  # packed ops are decoded one at a time so they can be offered to the interceptor.
+  # Anything handed back unchanged reuses the original bytes.
+  def serialize(script, op_fn) when is_binary(script) and is_function(op_fn, 1) do
+    script
+    |> reduce_packed([], fn {_code, op_bin}, acc ->
+      {op, _} = deserialize_op(op_bin)
+
+      io =
+        case op_fn.(op) do
+          nil -> []
+          bin when is_binary(bin) -> bin
+          io_list when is_list(io_list) -> io_list
+          ^op -> op_bin
+          op -> serialize_op(op)
+        end
+
+      [io | acc]
+    end)
+    |> Enum.reverse()
+  end
+
   @doc """
   Transform a script list into a binary IO list with a map_reduce like interceptor function.
 
@@ -1367,6 +1501,51 @@ defmodule Scenic.Script do
     end)
   end
 
+  def serialize(script, acc, op_fn) when is_binary(script) and is_function(op_fn, 2) do
+    {io, acc} =
+      reduce_packed(script, {[], acc}, fn {_code, op_bin}, {io, acc} ->
+        {op, _} = deserialize_op(op_bin)
+
+        case op_fn.(op, acc) do
+          {nil, acc} -> {[[] | io], acc}
+          {bin, acc} when is_binary(bin) -> {[bin | io], acc}
+          {io_list, acc} when is_list(io_list) -> {[io_list | io], acc}
+          {^op, acc} -> {[op_bin | io], acc}
+          {op, acc} -> {[serialize_op(op) | io], acc}
+        end
+      end)
+
+    {Enum.reverse(io), acc}
+  end
+
+  @doc """
+  Reduce over the commands in a packed script without deserializing them.
+
+  The reducer is called with `{opcode, op_binary}` for each command, where `op_binary`
+  is the sub-binary holding that command's complete serialized form, including any
+  string padding. The sub-binaries reference the script itself and are not copied.
+
+  ```elixir
+  Script.reduce_packed(script, 0, fn {_opcode, op}, bytes -> bytes + byte_size(op) end)
+  ```
+  """
+  @spec reduce_packed(
+          script :: packed(),
+          acc :: any,
+          (op :: {opcode :: non_neg_integer, op_binary :: binary}, acc :: any -> any)
+        ) :: any
+  def reduce_packed(script, acc, reducer) when is_binary(script) and is_function(reducer, 2) do
+    do_reduce_packed(script, acc, reducer)
+  end
+
+  defp do_reduce_packed(<<>>, acc, _), do: acc
+
+  defp do_reduce_packed(<<code::16-big, _::binary>> = bin, acc, reducer) do
+    size = op_size(bin)
+    <<op::binary-size(size), bin::binary>> = bin
+    do_reduce_packed(bin, reducer.({code, op}, acc), reducer)
+  end
+
   @doc """
   Transform a binary or io list into a readable script list.
 
@@ -1509,38 +1688,13 @@ defmodule Scenic.Script do
   end
 
   defp serialize_op({:draw_sprites, {id, cmds}}) do
-    hash =
-      with {:ok, {Static.Image, _}} <- Static.meta(id),
-           {:ok, str_hash} <- Static.to_hash(id) do
-        # {:ok, bin_hash} <- Base.url_decode64(str_hash, padding: false) do
-        str_hash
-      else
-        err -> raise "Invalid image -> #{inspect(id)}, err: #{inspect(err)}"
-      end
+    hash = sprites_hash(id)
 
     {cmds, count} =
-      Enum.reduce(cmds, {[], 0}, fn
-        {{sx, sy}, {sw, sh}, {dx, dy}, {dw, dh}, alpha}, {cmds, count} ->
-          {
-            [
-              <<
-                sx::float-32-big,
-                sy::float-32-big,
-                sw::float-32-big,
-                sh::float-32-big,
-                dx::float-32-big,
-                dy::float-32-big,
-                dw::float-32-big,
-                dh::float-32-big,
-                alpha::float-32-big
-              >>
-              | cmds
-            ],
-            count + 1
-          }
-      end)
-
-    cmds = Enum.reverse(cmds)
+      case is_binary(cmds) do
+        true -> {cmds, div(byte_size(cmds), 36)}
+        false -> serialize_sprite_cmds(cmds)
+      end
 
     [
       <<@op_draw_sprites::16-big>>,
@@ -2100,6 +2254,22 @@ defmodule Scenic.Script do
     ]
   end
 
+  defp serialize_op({:cull, {l, t, r, b, count}}) do
+    [
+      <<
+        @op_cull::16-big,
+        0::16
+      >>,
+      <<
+        l::float-32-big,
+        t::float-32-big,
+        r::float-32-big,
+        b::float-32-big,
+        count::32-big
+      >>
+    ]
+  end
+
   defp serialize_op({:font, id}) do
     hash =
       with {:ok, {Static.Font, _}} <- Static.meta(id),
@@ -2142,6 +2312,41 @@ defmodule Scenic.Script do
   defp serialize_op({:text_base, :bottom}),
     do: <<@op_text_base::16-big, @baseline_bottom::16-big>>
 
+  defp sprites_hash(id) do
+    with {:ok, {Static.Image, _}} <- Static.meta(id),
+         {:ok, str_hash} <- Static.to_hash(id) do
+      str_hash
+    else
+      err -> raise "Invalid image -> #{inspect(id)}, err: #{inspect(err)}"
+    end
+  end
+
+  defp serialize_sprite_cmds(cmds) do
+    {cmds, count} =
+      Enum.reduce(cmds, {[], 0}, fn
+        {{sx, sy}, {sw, sh}, {dx, dy}, {dw, dh}, alpha}, {cmds, count} ->
+          {
+            [
+              <<
+                sx::float-32-big,
+                sy::float-32-big,
+                sw::float-32-big,
+                sh::float-32-big,
+                dx::float-32-big,
+                dy::float-32-big,
+                dw::float-32-big,
+                dh::float-32-big,
+                alpha::float-32-big
+              >>
+              | cmds
+            ],
+            count + 1
+          }
+      end)
+
+    {Enum.reverse(cmds), count}
+  end
+
   defp smallest([h | t]), do: do_smallest(t, h)
   defp do_smallest([], current), do: current
   defp do_smallest([h | t], current) when h < current, do: do_smallest(t, h)
@@ -2163,6 +2368,86 @@ defmodule Scenic.Script do
     ]
   end
 
+  # ============================================================================
+  # packed op sizes
+
+  # byte size of each fixed length op, including the four byte header
+  @op_sizes %{
+    @finished => 4,
+    @op_draw_line => 20,
+    @op_draw_triangle => 28,
+    @op_draw_quad => 36,
+    @op_draw_rect => 12,
+    @op_draw_rrect => 16,
+    @op_draw_arc => 12,
+    @op_draw_sector => 12,
+    @op_draw_circle => 8,
+    @op_draw_ellipse => 12,
+    @op_draw_rrectv => 28,
+    @op_begin_path => 4,
+    @op_close_path => 4,
+    @op_fill_path => 4,
+    @op_stroke_path => 4,
+    @op_move_to => 12,
+    @op_line_to => 12,
+    @op_arc_to => 24,
+    @op_bezier_to => 28,
+    @op_quadratic_to => 20,
+    @op_triangle => 28,
+    @op_quad => 36,
+    @op_rect => 12,
+    @op_rrect => 16,
+    @op_sector => 12,
+    @op_circle => 8,
+    @op_ellipse => 12,
+    @op_arc => 28,
+    @op_push_state => 4,
+    @op_pop_state => 4,
+    @op_pop_push_state => 4,
+    @op_scissor => 12,
+    @op_cull => 24,
+    @op_transform => 28,
+    @op_scale => 12,
+    @op_rotate => 8,
+    @op_translate => 12,
+    @op_fill_color => 8,
+    @op_fill_linear => 28,
+    @op_fill_radial => 28,
+    @op_stroke_width => 4,
+    @op_stroke_color => 8,
+    @op_stroke_linear => 28,
+    @op_stroke_radial => 28,
+    @op_cap => 4,
+    @op_join => 4,
+    @op_miter_limit => 4,
+    @op_font_size => 4,
+    @op_text_align => 4,
+    @op_text_base => 4
+  }
+
+  # ops that carry a padded string whose byte size is in the header parameter
+  @string_ops [
+    @op_draw_text,
+    @op_draw_script,
+    @op_fill_image,
+    @op_fill_stream,
+    @op_stroke_image,
+    @op_stroke_stream,
+    @op_font
+  ]
+
+  defp op_size(<<@op_draw_sprites::16-big, id_size::16-big, count::32-big, _::binary>>) do
+    8 + padded_size(id_size) + count * 36
+  end
+
+  defp op_size(<<code::16-big, len::16-big, _::binary>>) when code in @string_ops do
+    4 + padded_size(len)
+  end
+
+  defp op_size(<<code::16-big, _::16, _::binary>>), do: Map.fetch!(@op_sizes, code)
+
+  defp padded_size(bytes), do: div(bytes + 3, 4) * 4
+
   # ============================================================================
   # deserialization helpers
 
@@ -2808,6 +3093,19 @@ defmodule Scenic.Script do
     {{:scissor, {w, h}}, bin}
   end
 
+  defp deserialize_op(<<
+         @op_cull::16-big,
+         0::16,
+         l::float-32-big,
+         t::float-32-big,
+         r::float-32-big,
+         b::float-32-big,
+         count::32-big,
+         bin::binary
+       >>) do
+    {{:cull, {l, t, r, b, count}}, bin}
+  end
+
   defp deserialize_op(<<
          @op_font::16-big,
          id_size::16-big,
@@ -2874,10 +3172,35 @@ defmodule Scenic.Script do
     do_optimize(tail, [:pop_push_state | acc])
   end
 
+  # the packed ops of a flattened script
+  defp do_optimize(
+         [<<@op_push_state::16-big, 0::16>> | [<<@op_pop_state::16-big, 0::16>> | tail]],
+         acc
+       ) do
+    do_optimize(tail, [<<@op_pop_push_state::16-big, 0::16>> | acc])
+  end
+
   defp do_optimize([head | tail], acc) do
     do_optimize(tail, [head | acc])
   end
 
+  # same pop/push folding as above, but walking the packed ops in order
+  defp optimize_packed(bin, acc \\ [])
+  defp optimize_packed(<<>>, acc), do: acc |> Enum.reverse() |> IO.iodata_to_binary()
+
+  defp optimize_packed(
+         <<@op_pop_state::16-big, 0::16, @op_push_state::16-big, 0::16, bin::binary>>,
+         acc
+       ) do
+    optimize_packed(bin, [<<@op_pop_push_state::16-big, 0::16>> | acc])
+  end
+
+  defp optimize_packed(bin, acc) do
+    size = op_size(bin)
+    <<op::binary-size(size), bin::binary>> = bin
+    optimize_packed(bin, [op | acc])
+  end
+
   @doc """
   Extract a map of all the media (both static assets and streams) used in a script.
   """
@@ -2886,16 +3209,196 @@ defmodule Scenic.Script do
     |> Enum.into(%{})
   end
 
-  defp raw_media(script) do
+  defp raw_media(script) when is_list(script) do
     Enum.reduce(script, [], fn
-      {:font, id}, m -> Keyword.put(m, :fonts, [id | Keyword.get(m, :fonts, [])])
-      {:fill_image, id}, m -> Keyword.put(m, :images, [id | Keyword.get(m, :images, [])])
-      {:fill_stream, id}, m -> Keyword.put(m, :streams, [id | Keyword.get(m, :streams, [])])
-      {:stroke_image, id}, m -> Keyword.put(m, :images, [id | Keyword.get(m, :images, [])])
-      {:stroke_stream, id}, m -> Keyword.put(m, :streams, [id | Keyword.get(m, :streams, [])])
-      {:draw_sprites, {id, _}}, m -> Keyword.put(m, :images, [id | Keyword.get(m, :images, [])])
+      {:font, id}, m -> put_media(m, :fonts, id)
+      {:fill_image, id}, m -> put_media(m, :images, id)
+      {:fill_stream, id}, m -> put_media(m, :streams, id)
+      {:stroke_image, id}, m -> put_media(m, :images, id)
+      {:stroke_stream, id}, m -> put_media(m, :streams, id)
+      {:draw_sprites, {id, _}}, m -> put_media(m, :images, id)
+      _, media -> media
+    end)
+    |> Enum.map(fn {k, v} -> {k, Enum.uniq(v)} end)
+  end
+
+  # only the ops that reference media have their ids pulled out of the binary
+  defp raw_media(script) when is_binary(script) do
+    reduce_packed(script, [], fn
+      {@op_font, op}, m -> put_media(m, :fonts, packed_string(op))
+      {@op_fill_image, op}, m -> put_media(m, :images, packed_string(op))
+      {@op_fill_stream, op}, m -> put_media(m, :streams, packed_string(op))
+      {@op_stroke_image, op}, m -> put_media(m, :images, packed_string(op))
+      {@op_stroke_stream, op}, m -> put_media(m, :streams, packed_string(op))
+      {@op_draw_sprites, op}, m -> put_media(m, :images, packed_sprites_id(op))
       _, media -> media
     end)
     |> Enum.map(fn {k, v} -> {k, Enum.uniq(v)} end)
   end
+
+  defp put_media(media, key, id) do
+    Keyword.put(media, key, [id | Keyword.get(media, key, [])])
+  end
+
+  defp packed_string(<<_::16, len::16-big, str::binary-size(len), _::binary>>), do: str
+
+  defp packed_sprites_id(<<_::16, len::16-big, _::32, id::binary-size(len), _::binary>>),
+    do: id
+
+  # ============================================================================
+  # flattening
+
+  @doc """
+  Inline the scripts referenced by `{:script, id}` ops into a single script.
+
+  `lookup` is called with each referenced id and should return `{:ok, script}`
+  or anything else if the script doesn't exist. Each inlined script is wrapped in
+  a `push_state` / `pop_state` pair so it can't change the draw state of the
+  script that references it. References that can't be resolved, or that would
+  recurse into a script that is already being inlined, are left in place.
+
+  Returns `{flat_script, ids}` where `ids` lists every script id that was
+  referenced, resolved or not. The flat script is out of date as soon as any of
+  those scripts change.
+
+  The counts of any `:cull` ops are updated to cover the same ops after their
+  scripts are inlined.
+
+  A packed script flattens into a packed script. A list script flattens into a
+  list.
+  """
+  @spec flatten(script :: t(), lookup :: (any -> {:ok, t()} | any)) :: {t(), [any]}
+  def flatten(script, lookup) when is_list(script) and is_function(lookup, 1) do
+    {ops, ids} = flatten_list(script, lookup, [], [], [])
+    {ops |> optimize() |> resolve_culls(), Enum.uniq(ids)}
+  end
+
+  def flatten(script, lookup) when is_binary(script) and is_function(lookup, 1) do
+    {ops, ids} = flatten_packed(script, lookup, [], [], [])
+
+    {
+      ops
+      |> optimize()
+      |> resolve_culls()
+      |> Enum.map(fn
+        {:cull, _} = op -> serialize_op(op)
+        op -> op
+      end)
+      |> IO.iodata_to_binary(),
+      Enum.uniq(ids)
+    }
+  end
+
+  # ops are accumulated in reverse order. The :cull ops of each script are
+  # turned into markers first, and resolved again once everything is inlined
+  defp flatten_list(script, lookup, path, ops, ids) do
+    script
+    |> mark_culls()
+    |> Enum.reduce({ops, ids}, fn
+      {:script, id} = op, {ops, ids} ->
+        case inline_script(id, lookup, path) do
+          {:ok, sub} ->
+            sub = if is_binary(sub), do: deserialize(sub), else: sub
+            {ops, ids} = flatten_list(sub, lookup, [id | path], [:push_state | ops], ids)
+            {[:pop_state | ops], [id | ids]}
+
+          :error ->
+            {[op | ops], [id | ids]}
+        end
+
+      op, {ops, ids} ->
+        {[op | ops], ids}
+    end)
+  end
+
+  # the same, with each op as a binary
+  defp flatten_packed(script, lookup, path, ops, ids) do
+    script
+    |> packed_ops()
+    |> Enum.reduce({ops, ids}, fn
+      <<@op_draw_script::16-big, _::binary>> = op, {ops, ids} ->
+        id = packed_string(op)
+
+        case inline_script(id, lookup, path) do
+          {:ok, sub} ->
+            ops = [<<@op_push_state::16-big, 0::16>> | ops]
+            {ops, ids} = flatten_packed(pack(sub), lookup, [id | path], ops, ids)
+            {[<<@op_pop_state::16-big, 0::16>> | ops], [id | ids]}
+
+          :error ->
+            {[op | ops], [id | ids]}
+        end
+
+      op, {ops, ids} ->
+        {[op | ops], ids}
+    end)
+  end
+
+  # the ops of a packed script in order, with its :cull ops turned into markers
+  defp packed_ops(script) do
+    script
+    |> reduce_packed([], fn
+      {@op_cull, op}, ops ->
+        {cull, <<>>} = deserialize_op(op)
+        [cull | ops]
+
+      {_, op}, ops ->
+        [op | ops]
+    end)
+    |> Enum.reverse()
+    |> mark_culls()
+  end
+
+  # turn :cull ops into {:cull_begin, bounds} and :cull_end markers around the
+  # ops they cover, so the ops can change without losing track of the region.
+  # open holds the ops left in each region the op is inside of
+  defp mark_culls(ops), do: do_mark_culls(ops, [], [])
+
+  defp do_mark_culls([], open, acc), do: Enum.reverse(acc, Enum.map(open, fn _ -> :cull_end end))
+
+  defp do_mark_culls([{:cull, {l, t, r, b, count}} | ops], open, acc) do
+    open = Enum.map(open, &(&1 - 1))
+    close_culls(ops, [count | open], [{:cull_begin, {l, t, r, b}} | acc])
+  end
+
+  defp do_mark_culls([op | ops], open, acc) do
+    close_culls(ops, Enum.map(open, &(&1 - 1)), [op | acc])
+  end
+
+  defp close_culls(ops, [0 | open], acc), do: close_culls(ops, open, [:cull_end | acc])
+  defp close_culls(ops, open, acc), do: do_mark_culls(ops, open, acc)
+
+  @doc false
+  # replace the cull markers with :cull ops that know how many ops they cover.
+  # a nested region counts as its own ops plus its :cull op
+  @spec resolve_culls(ops :: list) :: list
+  def resolve_culls(ops) do
+    {ops, _, []} = do_resolve_culls(ops, [], 0)
+
+    ops
+    |> List.flatten()
+    |> Enum.reverse()
+  end
+
+  defp do_resolve_culls([], ops, count), do: {ops, count, []}
+  defp do_resolve_culls([:cull_end | tail], ops, count), do: {ops, count, tail}
+
+  defp do_resolve_culls([{:cull_begin, {l, t, r, b}} | tail], ops, count) do
+    {inner, n, tail} = do_resolve_culls(tail, [], 0)
+    ops = [inner | cull(ops, l, t, r, b, n)]
+    do_resolve_culls(tail, ops, count + n + 1)
+  end
+
+  defp do_resolve_culls([op | tail], ops, count) do
+    do_resolve_culls(tail, [op | ops], count + 1)
+  end
+
+  defp inline_script(id, lookup, path) do
+    with false <- Enum.member?(path, id),
+         {:ok, script} when is_list(script) or is_binary(script) <- lookup.(id) do
+      {:ok, script}
+    else
+      _ -> :error
+    end
+  end
 end
@@ -0,0 +1,127 @@
+defmodule Scenic.Telemetry do
+  @moduledoc """
+  `:telemetry` spans around the hot paths of the rendering pipeline.
+
+  Each span emits the usual `:start`, `:stop` and `:exception` events. The `:stop`
+  event carries the `:duration` in native time units, plus the measurements listed
+  below.
+
+  * `[:scenic, :graph, :compile]` - `Scenic.Graph.Compiler.compile/2`.
+    Measurements: `:primitives`, `:ops`.
+  * `[:scenic, :view_port, :put_script]` - `Scenic.ViewPort.put_script/4`.
+    Measurements: `:ops` for a list script, or `:bytes` for a packed one.
+    Metadata: `:name`, `:changed`.
+  * `[:scenic, :view_port, :put_graph]` - `Scenic.ViewPort.put_graph/4`, which
+    includes compiling the graph and putting its script.
+    Measurements: `:primitives`. Metadata: `:name`.
+  * `[:scenic, :view_port, :find_hit]` - hit testing a positional input against
+    the input lists. Metadata: `:input_type`, `:hit`.
+  * `[:scenic, :driver, :put_scripts]` - a driver taking in changed scripts.
+    Measurements: `:scripts`. Metadata: `:driver`.
+  * `[:scenic, :driver, :update_scene]` - a driver's `c:Scenic.Driver.update_scene/2`
+    callback. Measurements: `:scripts`. Metadata: `:driver`.
+  * `[:scenic, :assets, :stream, :put]` - `Scenic.Assets.Stream.put/2`.
+    Measurements: `:bytes`. Metadata: `:id`, `:type`.
+
+  ### Sampling
+
+  Nothing is measured unless it is sampled. By default the sample rate is `0`, so
+  a span costs at most two `:persistent_term` reads, one for its own rate and one
+  for the overall rate. Set a rate between `0` and `1` for every span, or for just
+  one of them.
+
+  ```elixir
+  # measure one in ten calls of everything
+  Scenic.Telemetry.sample(0.1)
+
+  # measure every compile
+  Scenic.Telemetry.sample([:graph, :compile], 1)
+  ```
+
+  The default rate can also be set in config.
+
+  ```elixir
+  config :scenic, :telemetry, sample_rate: 0.1
+  ```
+
+  The rates are kept in `:persistent_term`, so changing them is expensive. Set them
+  once at startup rather than toggling them while running.
+  """
+
+  @default_rate Application.compile_env(:scenic, [:telemetry, :sample_rate], 0)
+
+  @type event :: [atom]
+
+  # --------------------------------------------------------
+  @doc """
+  Set the sample rate for all the spans, or for a single one. The event is given
+  without the leading `:scenic`.
+
+  A rate of `nil` for a single span returns it to the overall rate.
+  """
+  @spec sample(rate :: number) :: :ok
+  def sample(rate) when is_number(rate) and rate >= 0 and rate <= 1 do
+    :persistent_term.put(__MODULE__, rate)
+  end
+
+  @spec sample(event :: event, rate :: number | nil) :: :ok
+  def sample(event, nil) when is_list(event) do
+    :persistent_term.erase({__MODULE__, event})
+    :ok
+  end
+
+  def sample(event, rate) when is_list(event) and is_number(rate) and rate >= 0 and rate <= 1 do
+    :persistent_term.put({__MODULE__, event}, rate)
+  end
+
+  @doc """
+  Get the sample rate of a span.
+  """
+  @spec sample_rate(event :: event) :: number
+  def sample_rate(event) do
+    case :persistent_term.get({__MODULE__, event}, nil) do
+      nil -> :persistent_term.get(__MODULE__, @default_rate)
+      rate -> rate
+    end
+  end
+
+  # --------------------------------------------------------
+  @doc false
+  # Run fun inside the span if it is sampled. measure is only called on sampled
+  # runs. It gets the result of fun and returns {measurements, metadata} for the
+  # stop event.
+  @spec span(
+          event :: event,
+          metadata :: map,
+          fun :: (-> result),
+          measure :: (result -> {map, map})
+        ) :: result
+        when result: any
+  def span(event, metadata, fun, measure) do
+    case sampled?(event) do
+      true ->
+        :telemetry.span([:scenic | event], metadata, fn ->
+          result = fun.()
+          {measurements, stop_metadata} = measure.(result)
+          {result, measurements, Map.merge(metadata, stop_metadata)}
+        end)
+
+      false ->
+        fun.()
+    end
+  end
+
+  @doc false
+  # ops in a list script, or bytes in a packed one
+  @spec script_size(script :: Scenic.Script.t()) :: map
+  def script_size(script) when is_list(script), do: %{ops: length(script)}
+  def script_size(script) when is_binary(script), do: %{bytes: byte_size(script)}
+
+  defp sampled?(event) do
+    case sample_rate(event) do
+      rate when rate <= 0 -> false
+      rate when rate >= 1 -> true
+      rate -> :rand.uniform() < rate
+    end
+  end
+end
@@ -15,6 +15,7 @@ defmodule Scenic.ViewPort do
   alias Scenic.Scene
   alias Scenic.Graph
   alias Scenic.Primitive
+  alias Scenic.Telemetry
   alias Scenic.Graph.Compiler, as: GraphCompiler
 
   # alias Scenic.Utilities
@@ -91,6 +92,17 @@ defmodule Scenic.ViewPort do
   leave the scene that thinks it has "captured" the input in an inconsistent
   state, so this is not recommended.
 
+  ## Batching Script Updates
+
+  Every time a script is put or deleted, the drivers are told which scripts
+  changed. Scenes that update often can flood the drivers with tiny messages.
+  Set the `:script_batch_ms` option to collect these notifications over a frame
+  window and send them to each driver as one message per window. Changes to the
+  root script are never delayed. They flush the pending batch immediately.
+
+  `script_stats/1` returns counters of the notifications received, how many were
+  coalesced into an already pending batch, and how many messages were sent.
+
   ## Dynamically Creating View Ports
 
   Pass in the same set of opts that you would use when starting `Scenic` in your
@@ -114,12 +126,14 @@ defmodule Scenic.ViewPort do
           pid: pid,
           # name_table: reference,
           script_table: reference,
+          flat_table: reference,
           size: {number, number}
         }
   defstruct name: nil,
             pid: nil,
             # name_table: nil,
             script_table: nil,
+            flat_table: nil,
             size: nil
 
   @viewports :scenic_viewports
@@ -137,6 +151,7 @@ defmodule Scenic.ViewPort do
     theme: [type: {:custom, Theme, :validate, []}, default: :dark],
     drivers: [type: {:custom, Driver, :validate, []}, default: []],
     input_filter: [type: {:custom, __MODULE__, :validate_input_filter, []}, default: :all],
+    script_batch_ms: [type: :non_neg_integer, default: 0],
     opts: [
       type: :keyword_list,
       keys: Scenic.Primitive.Style.opts_schema() ++ Scenic.Primitive.Transform.opts_schema()
@@ -154,6 +169,8 @@ defmodule Scenic.ViewPort do
   @gate_complete :_gate_complete_
   @clear_color :_clear_color_
 
+  @flush_scripts :_flush_scripts_
+
   @first_open_graph_id 2
 
   @input_types [
@@ -272,6 +289,42 @@ defmodule Scenic.ViewPort do
     end
   end
 
+  @doc """
+  Retrieve a script with all of its `{:script, id}` references inlined.
+
+  Drivers can use this to render a frame in one linear pass instead of looking up
+  and recursing into a separate script for every component. The flattened script
+  is built on first request and cached in the ViewPort until the script, or any
+  script it references, is put or deleted. See `Scenic.Script.flatten/2` for the
+  details of how references are inlined.
+  """
+  @spec get_flat_script(viewport :: ViewPort.t(), name :: any) ::
+          {:ok, Script.t()} | {:error, :not_found}
+  def get_flat_script(%ViewPort{pid: pid, flat_table: flat_table}, name) do
+    case :ets.lookup(flat_table, name) do
+      [{_, script, _}] -> {:ok, script}
+      [] -> GenServer.call(pid, {:flatten_script, name})
+    end
+  end
+
+  @doc """
+  Retrieve the script notification counters.
+
+  * `:received` - script put/delete notifications received by the ViewPort
+  * `:coalesced` - notifications folded into an already pending batch
+  * `:sent` - put/delete messages sent to each driver
+
+  Without the `:script_batch_ms` option, every notification is sent right away.
+  """
+  @spec script_stats(viewport :: ViewPort.t()) :: %{
+          received: non_neg_integer,
+          coalesced: non_neg_integer,
+          sent: non_neg_integer
+        }
+  def script_stats(%ViewPort{pid: pid}) do
+    GenServer.call(pid, :script_stats)
+  end
+
   @doc false
   defp put_x_opts_schema() do
     [owner: [type: :pid, default: self()]]
@@ -280,6 +333,10 @@ defmodule Scenic.ViewPort do
   @doc """
   Put a script by name.
 
+  The script can be either a list of ops or a packed binary script (see
+  `Scenic.Script.start/1`). Packed scripts are stored as a single shared binary,
+  so drivers reading them with `get_script/2` don't copy every op.
+
   returns `{:ok, id}`
   """
   @spec put_script(
@@ -295,7 +352,7 @@ defmodule Scenic.ViewPort do
         script,
         opts \\ []
       )
-      when is_list(script) do
+      when is_list(script) or is_binary(script) do
     opts =
       opts
       |> Enum.into([])
@@ -307,17 +364,24 @@ defmodule Scenic.ViewPort do
 
     owner = opts[:owner]
 
-    case :ets.lookup(script_table, name) do
-      # do nothing if the script is in the table and has not changed
-      [{_, ^script, ^owner}] ->
-        :no_change
+    Telemetry.span(
+      [:view_port, :put_script],
+      %{name: name},
+      fn ->
+        case :ets.lookup(script_table, name) do
+          # do nothing if the script is in the table and has not changed
+          [{_, ^script, ^owner}] ->
+            :no_change
 
-      # it isn't there or has changed
-      _ ->
-        true = :ets.insert(script_table, {name, script, owner})
-        GenServer.cast(pid, {:put_scripts, [name], owner})
-        {:ok, name}
-    end
+          # it isn't there or has changed
+          _ ->
+            true = :ets.insert(script_table, {name, script, owner})
+            GenServer.cast(pid, {:put_scripts, [name], owner})
+            {:ok, name}
+        end
+      end,
+      &{Telemetry.script_size(script), %{changed: &1 != :no_change}}
+    )
   end
 
   @doc """
@@ -347,10 +411,22 @@ defmodule Scenic.ViewPort do
     do_all_script_ids(table, :ets.next(table, id), [id | ids])
   end
 
+  @doc false
+  defp put_graph_opts_schema() do
+    put_x_opts_schema() ++ [cull: [type: :boolean, default: false]]
+  end
+
   @doc """
   Put a graph by name.
 
   This compiles the graph to a collection of scripts
+
+  ### Options
+  * `:owner` - The process that owns the resulting script. Defaults to `self()`.
+  * `:cull` - When true, each group that can be bounded is preceded by a `:cull`
+    op holding its bounds. Drivers can use this to skip groups that are entirely
+    off screen. Computing the bounds costs extra work at compile time, so this is
+    best used for large graphs that are mostly off screen. Defaults to `false`.
   """
   @spec put_graph(
           viewport :: ViewPort.t(),
@@ -358,17 +434,26 @@ defmodule Scenic.ViewPort do
           graph :: Graph.t(),
           opts :: Keyword.t()
         ) :: {:ok, name :: any}
-  def put_graph(%ViewPort{pid: pid} = viewport, name, %Graph{} = graph, opts \\ []) do
+  def put_graph(%ViewPort{} = viewport, name, %Graph{} = graph, opts \\ []) do
     opts =
       opts
       |> Enum.into([])
-      |> NimbleOptions.validate(put_x_opts_schema())
+      |> NimbleOptions.validate(put_graph_opts_schema())
       |> case do
         {:ok, opts} -> opts
         {:error, error} -> raise Exception.message(error)
       end
 
-    with {:ok, script} <- GraphCompiler.compile(graph),
+    Telemetry.span(
+      [:view_port, :put_graph],
+      %{name: name},
+      fn -> do_put_graph(viewport, name, graph, opts) end,
+      fn _ -> {%{primitives: map_size(graph.primitives)}, %{}} end
+    )
+  end
+
+  defp do_put_graph(%ViewPort{pid: pid} = viewport, name, graph, opts) do
+    with {:ok, script} <- GraphCompiler.compile(graph, cull: opts[:cull]),
          {:ok, input_list} <- compile_input(graph) do
       # write the script - but only if it has actually changed
       case get_script(viewport, name) do
@@ -502,6 +587,8 @@ defmodule Scenic.ViewPort do
     # script_table = :ets.new( make_ref(), [:public, {:read_concurrency, true}] )
     # name_table = :ets.new(:_vp_name_table_, [:protected])
     script_table = :ets.new(:_vp_script_table_, [:public, {:read_concurrency, true}])
+    flat_table = :ets.new(:_vp_flat_table_, [:protected, {:read_concurrency, true}])
+    flat_refs = :ets.new(:_vp_flat_refs_, [:bag, :private])
 
     state = %{
       # simple metadata about the ViewPort
@@ -540,6 +627,25 @@ defmodule Scenic.ViewPort do
       # finished scripts to the VP for writing.
       script_table: script_table,
 
+      # ets table of flattened scripts {name, flat_script, referenced_ids}. Only
+      # written by the VP, so the invalidation on put/del is ordered with the casts
+      # that notify the drivers. Empty unless a driver asks for flat scripts.
+      flat_table: flat_table,
+
+      # ets bag of {referenced_id, flat_name}, the reverse of the referenced_ids in
+      # the flat table. Lets a put or del drop just the flat scripts that depend on
+      # the changed id, without walking all of them.
+      flat_refs: flat_refs,
+
+      # batching of the put/del script notifications to the drivers. With a
+      # batch_ms of zero, the notifications are sent right away. Otherwise the
+      # pending map collects %{id => :put | :del} and is flushed by a timer, or
+      # right away if the root script changes.
+      batch_ms: opts[:script_batch_ms] || 0,
+      batch_timer: nil,
+      pending_scripts: %{},
+      script_stats: %{received: 0, coalesced: 0, sent: 0},
+
       # state related to input from drivers to scenes
       # input lists are generated when a scene pushes a graph. Primitives
       # that have input: true assigned to them end up in these lists which
@@ -656,6 +762,8 @@ defmodule Scenic.ViewPort do
           input_lists: input_lists,
           scene_transforms: scene_transforms,
           script_table: script_table,
+          flat_table: flat_table,
+          flat_refs: flat_refs,
           scenes_by_pid: scenes_by_pid,
           scenes_by_id: scenes_by_id,
           starting_scenes: starting_scenes,
@@ -664,6 +772,8 @@ defmodule Scenic.ViewPort do
       ) do
     # cleanup scripts & names tables
     :ets.match_delete(script_table, {:_, :_, pid})
+    :ets.delete_all_objects(flat_table)
+    :ets.delete_all_objects(flat_refs)
 
     # clean up any input requested by the pid
     state = input_pid_down(pid, old_state)
@@ -680,10 +790,10 @@ defmodule Scenic.ViewPort do
 
         {:ok, {id, _parent, mod}} ->
           # make sure the drivers are not gated on a scene that crashed.
-          starting_scenes =
+          {state, starting_scenes} =
             case Enum.member?(starting_scenes, id) do
               false ->
-                starting_scenes
+                {state, starting_scenes}
 
               true ->
                 Logger.error("""
@@ -695,12 +805,14 @@ defmodule Scenic.ViewPort do
                 case Enum.reject(starting_scenes, &Kernel.==(&1, id)) do
                   [] ->
                     # starting_scenes has gone to an empty list. We are done.
-                    # tell the drivers the reset is complete
+                    # make sure the drivers have the new scripts, then
+                    # tell them the reset is complete
+                    state = flush_scripts(state)
                     cast_drivers(state, @gate_complete)
-                    []
+                    {state, []}
 
                   starting_scenes ->
-                    starting_scenes
+                    {state, starting_scenes}
                 end
             end
 
@@ -734,6 +846,15 @@ defmodule Scenic.ViewPort do
     {:noreply, state}
   end
 
+  # the batch window is over. send the pending script notifications. A timer that
+  # fired after it was cancelled has its message already in the mailbox, so only
+  # the current timer is acted on.
+  def handle_info({:timeout, timer, @flush_scripts}, %{batch_timer: timer} = state) do
+    {:noreply, flush_scripts(%{state | batch_timer: nil})}
+  end
+
+  def handle_info({:timeout, _stale, @flush_scripts}, state), do: {:noreply, state}
+
   # quietly drop unhandled _input messages that make it to the ViewPort
   def handle_info({:_input, _, _, _}, state) do
     {:noreply, state}
@@ -809,8 +930,9 @@ defmodule Scenic.ViewPort do
   end
 
   def handle_cast({:put_scripts, ids, owner}, state) do
-    # tell the drivers
-    cast_drivers(state, {@put_scripts, ids})
+    # drop any flattened scripts that are now stale, then tell the drivers
+    invalidate_flat(state, ids)
+    state = notify_scripts(state, ids, :put)
     {:noreply, ensure_monitor(owner, state)}
   end
 
@@ -825,11 +947,12 @@ defmodule Scenic.ViewPort do
     state =
       case :ets.lookup(script_table, name) do
         [_] ->
-          cast_drivers(old_state, {@del_scripts, [name]})
           :ets.delete(script_table, name)
+          invalidate_flat(old_state, [name])
 
           # make sure the input list is cleaned up
           %{old_state | input_lists: Map.delete(ils, name)}
+          |> notify_scripts([name], :del)
           |> update_positional_input()
 
         _ ->
@@ -918,16 +1041,20 @@ defmodule Scenic.ViewPort do
   end
 
   def handle_cast({:scene_complete, scene_id}, %{starting_scenes: starting_scenes} = state) do
-    starting_scenes =
-      case Enum.reject(starting_scenes, &Kernel.==(&1, scene_id)) do
+    starting_scenes = Enum.reject(starting_scenes, &Kernel.==(&1, scene_id))
+
+    state =
+      case starting_scenes do
         [] ->
           # starting_scenes has gone to an empty list. We are done.
-          # tell the drivers the reset is complete
+          # make sure the drivers have the new scripts, then
+          # tell them the reset is complete
+          state = flush_scripts(state)
           cast_drivers(state, @gate_complete)
-          []
+          state
 
-        scenes_ids ->
-          scenes_ids
+        _ ->
+          state
       end
 
     {:noreply, %{state | starting_scenes: starting_scenes}}
@@ -1000,6 +1127,38 @@ defmodule Scenic.ViewPort do
   end
 
   # --------------------------------------------------------
+  def handle_call(
+        {:flatten_script, name},
+        _from,
+        %{script_table: script_table, flat_table: flat_table, flat_refs: flat_refs} = state
+      ) do
+    lookup = fn id ->
+      case :ets.lookup(script_table, id) do
+        [{_, script, _}] -> {:ok, script}
+        [] -> {:error, :not_found}
+      end
+    end
+
+    reply =
+      with [] <- :ets.lookup(flat_table, name),
+           {:ok, script} <- lookup.(name) do
+        {flat, ids} = Script.flatten(script, lookup)
+        refs = Enum.uniq([name | ids])
+        true = :ets.insert(flat_table, {name, flat, refs})
+        true = :ets.insert(flat_refs, Enum.map(refs, &{&1, name}))
+        {:ok, flat}
+      else
+        [{_, flat, _}] -> {:ok, flat}
+        err -> err
+      end
+
+    {:reply, reply, state}
+  end
+
+  def handle_call(:script_stats, _from, %{script_stats: stats} = state) do
+    {:reply, stats, state}
+  end
+
   def handle_call({:find_point, {x, y}}, _from, %{input_lists: ils} = state)
       when is_number(x) and is_number(y) do
     hit =
@@ -1171,6 +1330,7 @@ defmodule Scenic.ViewPort do
          name: name,
          # name_table: name_table,
          script_table: script_table,
+         flat_table: flat_table,
          size: size
        }) do
     %ViewPort{
@@ -1178,10 +1338,79 @@ defmodule Scenic.ViewPort do
       name: name,
       # name_table: name_table,
       script_table: script_table,
+      flat_table: flat_table,
       size: size
     }
   end
 
+  # --------------------------
+  # script notifications to the drivers
+
+  # not batching. tell the drivers right away
+  defp notify_scripts(%{batch_ms: 0, script_stats: stats} = state, ids, kind) do
+    cast_drivers(state, {script_msg(kind), ids})
+    %{state | script_stats: %{stats | received: stats.received + 1, sent: stats.sent + 1}}
+  end
+
+  # batching. the last put or del for an id wins
+  defp notify_scripts(%{pending_scripts: pending, script_stats: stats} = state, ids, kind) do
+    stats =
+      case pending == %{} do
+        true -> %{stats | received: stats.received + 1}
+        false -> %{stats | received: stats.received + 1, coalesced: stats.coalesced + 1}
+      end
+
+    pending = Enum.reduce(ids, pending, &Map.put(&2, &1, kind))
+    state = %{state | pending_scripts: pending, script_stats: stats}
+
+    case Enum.member?(ids, @root_id) do
+      true -> flush_scripts(state)
+      false -> start_batch_timer(state)
+    end
+  end
+
+  defp start_batch_timer(%{batch_timer: nil, batch_ms: batch_ms} = state) do
+    %{state | batch_timer: :erlang.start_timer(batch_ms, self(), @flush_scripts)}
+  end
+
+  defp start_batch_timer(state), do: state
+
+  defp flush_scripts(%{pending_scripts: pending} = state) when pending == %{}, do: state
+
+  defp flush_scripts(%{pending_scripts: pending, batch_timer: timer} = state) do
+    if timer, do: Process.cancel_timer(timer)
+
+    {dels, puts} =
+      Enum.reduce(pending, {[], []}, fn
+        {id, :del}, {dels, puts} -> {[id | dels], puts}
+        {id, :put}, {dels, puts} -> {dels, [id | puts]}
+      end)
+
+    msgs = Enum.reject([{@del_scripts, dels}, {@put_scripts, puts}], &match?({_, []}, &1))
+    Enum.each(msgs, &cast_drivers(state, &1))
+
+    %{state | pending_scripts: %{}, batch_timer: nil}
+    |> Map.update!(:script_stats, &%{&1 | sent: &1.sent + length(msgs)})
+  end
+
+  defp script_msg(:put), do: @put_scripts
+  defp script_msg(:del), do: @del_scripts
+
+  # drop every flattened script that references any of the given script ids,
+  # along with its entries in the reverse index
+  defp invalidate_flat(%{flat_table: flat_table, flat_refs: flat_refs}, ids) do
+    Enum.each(ids, fn id ->
+      flat_refs
+      |> :ets.lookup(id)
+      |> Enum.each(fn {_, name} ->
+        case :ets.take(flat_table, name) do
+          [{_, _, refs}] -> Enum.each(refs, &:ets.delete_object(flat_refs, {&1, name}))
+          [] -> :ok
+        end
+      end)
+    end)
+  end
+
   # --------------------------
   # start drivers cleanly
   defp do_start_driver(opts, %{driver_sup: driver_sup, theme: theme} = state) do
@@ -1238,6 +1467,7 @@ defmodule Scenic.ViewPort do
           # it isn't there or has changed
           _ ->
             true = :ets.insert(script_table, {name, script, :viewport})
+            invalidate_flat(state, [name])
             :ok
         end
 
@@ -1743,7 +1973,12 @@ defmodule Scenic.ViewPort do
   defp input_find_hit(lists, input_type, name, global_point, parent_tx \\ nil)
 
   defp input_find_hit(lists, input_type, name, global_point, nil) do
-    input_find_hit(lists, input_type, name, global_point, Math.Matrix.identity())
+    Telemetry.span(
+      [:view_port, :find_hit],
+      %{input_type: input_type},
+      fn -> input_find_hit(lists, input_type, name, global_point, Math.Matrix.identity()) end,
+      &{%{}, %{hit: &1 != :not_found}}
+    )
   end
 
   defp input_find_hit(lists, input_type, name, global_point, parent_tx) do
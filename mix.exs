@@ -50,6 +50,7 @@ defmodule Scenic.Mixfile do
       {:nimble_options, "~> 0.3.4 or ~> 0.4.0 or ~> 0.5.0 or ~> 1.1"},
       {:ex_image_info, "~> 0.2.4"},
       {:truetype_metrics, "~> 0.6"},
+      {:telemetry, "~> 1.1"},
 
       # Tools
       {:elixir_make, "~> 0.8.4", runtime: false},
@@ -17,4 +17,81 @@ defmodule Scenic.Assets.Static.FontTest do
   test "rejects invalid font data" do
     assert Font.parse_meta(<<0, 1, 2, 3, 4, 5, 6>>) == :error
   end
+
+  # --------------------------------------------------------
+  # measuring
+
+  @strings ["Hello World", "This is a test", "", "Multi\nline", "Ünïcödé"]
+
+  test "width matches FontMetrics" do
+    {:ok, {Font, fm}} = Scenic.Assets.Static.meta(:roboto)
+
+    for string <- ["Hello World", "This is a test", "", "iiiiWWWW"] do
+      assert_in_delta Font.width(string, 20, :roboto), FontMetrics.width(string, 20, fm), 0.0001
+    end
+  end
+
+  test "widths measures a batch the same as one at a time" do
+    assert Font.widths(@strings, 16, :roboto_mono) ==
+             Enum.map(@strings, &Font.width(&1, 16, :roboto_mono))
+  end
+
+  test "width scales with the font size" do
+    assert_in_delta Font.width("scale", 40, :roboto), Font.width("scale", 20, :roboto) * 2, 0.0001
+  end
+
+  test "width falls back to FontMetrics for missing characters" do
+    {:ok, {Font, fm}} = Scenic.Assets.Static.meta(:roboto)
+    string = "missing \u{10FFFD}"
+    assert Font.width(string, 20, :roboto) == FontMetrics.width(string, 20, fm)
+  end
+
+  test "width raises on a font that isn't in the library" do
+    assert_raise RuntimeError, fn -> Font.width("abc", 20, :missing) end
+    assert_raise RuntimeError, fn -> Font.width("abc", 20, :parrot) end
+  end
+
+  # --------------------------------------------------------
+  # wrapping
+
+  @text "The quick brown fox jumps over the lazy dog. Pack my box with five dozen jugs."
+
+  test "wrap keeps every line within the width" do
+    wrapped = Font.wrap(@text, 120, 20, :roboto)
+    lines = String.split(wrapped, "\n")
+    assert length(lines) > 1
+
+    for w <- Font.widths(lines, 20, :roboto) do
+      assert w <= 120
+    end
+
+    # only the spaces at the breaks are dropped
+    assert String.split(wrapped) == String.split(@text)
+  end
+
+  test "wrap breaks words that are wider than the line" do
+    [lines] = Font.wraps(["abcdefghijklmnopqrstuvwxyz"], 50, 20, :roboto_mono)
+    assert length(lines) > 1
+    assert Enum.join(lines) == "abcdefghijklmnopqrstuvwxyz"
+  end
+
+  test "wrap keeps existing line breaks" do
+    assert Font.wrap("one\ntwo", 1000, 20, :roboto) == "one\ntwo"
+    assert Font.wraps(["a b", "c"], 1000, 20, :roboto) == [["a b"], ["c"]]
+  end
+
+  # --------------------------------------------------------
+  test "results are the same with the cache running" do
+    uncached = Font.widths(@strings, 16, :roboto)
+    uncached_wrap = Font.wrap(@text, 120, 20, :roboto)
+
+    start_supervised!(Font.Cache)
+    assert Font.widths(@strings, 16, :roboto) == uncached
+    assert :ets.info(Font.Cache, :size) > 0
+
+    # the second time around comes from the cache
+    assert Font.widths(@strings, 16, :roboto) == uncached
+    assert Font.wrap(@text, 120, 20, :roboto) == uncached_wrap
+    assert Font.wrap(@text, 120, 20, :roboto) == uncached_wrap
+  end
 end
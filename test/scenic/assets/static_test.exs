@@ -8,6 +8,7 @@ defmodule Scenic.Assets.StaticTest do
   doctest Scenic.Assets.Static
 
   alias Scenic.Assets.Static
+  alias Scenic.Assets.Stream.Bitmap
 
   # we expect errors to be logged in this set of tests. This happens when we purposefully
   # attempted to load an asset that has been tampered with. So turn off the logging to
@@ -143,6 +144,55 @@ defmodule Scenic.Assets.StaticTest do
     assert Static.load(lib, {:test_assets, "images/tamper.png"}) == {:error, :hash_failed}
   end
 
+  # --------------------------------------------------------
+  # atlases
+
+  @icons ["images/icons/red.png", "images/icons/green.png", "images/icons/blue.png"]
+
+  test "atlases are added to the library as images" do
+    lib = Static.library()
+    {:ok, atlas} = Static.to_hash(lib, {:atlas, "icons"})
+    {:ok, {Static.Image, {_, _, "image/png"}}} = Static.meta(lib, atlas)
+    {:ok, _} = Static.load(lib, atlas)
+  end
+
+  test "region finds where an image was packed into the atlas" do
+    lib = Static.library()
+    {:ok, atlas} = Static.to_hash(lib, {:atlas, "icons"})
+
+    red = {:test_assets, "images/icons/red.png"}
+    green = {:test_assets, "images/icons/green.png"}
+
+    assert {:ok, {^atlas, {_, _, 8, 8}}} = Static.region(lib, red)
+    assert {:ok, {^atlas, {_, _, 16, 4}}} = Static.region(green)
+    assert Static.region(lib, :parrot) == :error
+    assert Static.region(lib, :missing) == :error
+  end
+
+  test "atlas regions don't overlap and hold the original pixels" do
+    lib = Static.library()
+    {:ok, atlas} = Static.to_hash(lib, {:atlas, "icons"})
+    {:ok, atlas_bin} = Static.load(lib, atlas)
+    {:ok, atlas_bmp} = Scenic.Assets.Stream.Image.decode(atlas_bin)
+
+    regions =
+      for id <- @icons do
+        {:ok, {^atlas, {x, y, w, h}}} = Static.region(lib, {:test_assets, id})
+        {:ok, bin} = Static.load(lib, {:test_assets, id})
+        {:ok, bmp} = Scenic.Assets.Stream.Image.decode(bin)
+
+        for {ix, iy} <- [{0, 0}, {w - 1, h - 1}, {div(w, 2), div(h, 2)}] do
+          assert Bitmap.get(atlas_bmp, x + ix, y + iy) == Bitmap.get(bmp, ix, iy)
+        end
+
+        {x, y, w, h}
+      end
+
+    for {x0, y0, w0, h0} = a <- regions, {x1, y1, w1, h1} = b <- regions, a != b do
+      assert x0 + w0 <= x1 or x1 + w1 <= x0 or y0 + h0 <= y1 or y1 + h1 <= y0
+    end
+  end
+
   test "load with lib shortcut works" do
     {:ok, bin} = Static.load(:parrot)
     assert is_binary(bin)
@@ -150,4 +200,75 @@ defmodule Scenic.Assets.StaticTest do
     {:ok, bin} = Static.load({:test_assets, "images/parrot.png"})
     assert is_binary(bin)
   end
+
+  # --------------------------------------------------------
+  # caching, mapping and streaming
+
+  test "load returns the same binary every time" do
+    lib = Static.library()
+    {:ok, bin} = Static.load(lib, :roboto)
+    assert Static.load(lib, :roboto) == {:ok, bin}
+    assert Static.load(lib, :roboto, cache: false) == {:ok, bin}
+  end
+
+  test "load can memory map the file" do
+    lib = Static.library()
+    {:ok, bin} = Static.load(lib, :parrot, cache: false)
+    assert Static.load(lib, :parrot, mmap: true, cache: false) == {:ok, bin}
+  end
+
+  test "load rejects bad options" do
+    assert_raise RuntimeError, fn -> Static.load(Static.library(), :parrot, mmap: 1) end
+  end
+
+  test "stream hands out an asset in chunks" do
+    lib = Static.library()
+    {:ok, bin} = Static.load(lib, :parrot)
+
+    {:ok, stream} = Static.stream(lib, :parrot, chunk_size: 1000)
+    chunks = Enum.to_list(stream)
+    assert length(chunks) == div(byte_size(bin) + 999, 1000)
+    assert Enum.all?(chunks, &(byte_size(&1) <= 1000))
+    assert IO.iodata_to_binary(chunks) == bin
+
+    {:ok, stream} = Static.stream(:parrot)
+    assert IO.iodata_to_binary(Enum.to_list(stream)) == bin
+
+    assert Static.stream(lib, :missing) == {:error, :not_found}
+  end
+
+  # --------------------------------------------------------
+  # build
+
+  @build_opts [
+    otp_app: :scenic,
+    sources: [{:scenic, "assets"}, {:test_assets, "test/assets"}],
+    alias: [parrot: {:test_assets, "images/parrot.png"}],
+    atlases: [icons: [{:test_assets, "images/icons/*.png"}]]
+  ]
+
+  test "build! rebuilds the same library from the manifest" do
+    dst = :code.lib_dir(:scenic) |> Path.join(Static.dst_dir())
+    assert File.exists?(Path.join(Path.dirname(dst), "assets.manifest"))
+
+    # a copy that isn't in the library is removed
+    File.write!(Path.join(dst, "stale"), "stale")
+
+    assert Static.build!(Scenic.Test.Assets, @build_opts) == Static.library()
+    refute File.exists?(Path.join(dst, "stale"))
+  end
+
+  test "build! replaces a copy that was changed in place" do
+    dst = :code.lib_dir(:scenic) |> Path.join(Static.dst_dir())
+    {:ok, str_hash} = Static.to_hash(:parrot)
+    path = Path.join(dst, str_hash)
+    bin = File.read!(path)
+
+    # same size, different contents, and a different mtime
+    File.write!(path, :binary.copy(<<0>>, byte_size(bin)))
+    File.touch!(path, System.os_time(:second) - 3600)
+
+    assert Static.build!(Scenic.Test.Assets, @build_opts) == Static.library()
+    assert File.read!(path) == bin
+  end
 end
@@ -264,4 +264,122 @@ defmodule Scenic.Assets.Stream.BitmapTest do
     assert Bitmap.get(mut, 2, 3) == color
     assert Bitmap.get(mut, 2, 4) == color
   end
+
+  # --------------------------------------------------------
+  # row stride
+
+  test "build pads the rows to the :align option" do
+    {@mutable, {11, 13, :rgb}, p} = mut = Bitmap.build(:rgb, @width, @height, align: 16)
+    assert Bitmap.stride(mut) == 48
+    assert byte_size(p) == 48 * @height
+
+    assert Bitmap.build(:rgba, 16, 2, align: 64) |> Bitmap.stride() == 64
+    assert Bitmap.build(:g, @width, @height) |> Bitmap.stride() == @width
+  end
+
+  test "put, put_offset and get address pixels in padded rows" do
+    mut =
+      Bitmap.build(:rgb, @width, @height, align: 16)
+      |> Bitmap.put(10, 3, :red)
+      |> Bitmap.put_offset(@width * 4 + 1, :green)
+
+    {@mutable, _, p} = mut
+    assert binary_part(p, 3 * 48 + 30, 3) == <<255, 0, 0>>
+    assert binary_part(p, 4 * 48 + 3, 3) == <<0, 128, 0>>
+    assert Bitmap.get(mut, 10, 3) == Color.to_rgb(:red)
+    assert Bitmap.get(mut, 1, 4) == Color.to_rgb(:green)
+  end
+
+  test "put and put_offset reject pixels in the row padding" do
+    mut = Bitmap.build(:rgb, @width, @height, align: 16)
+    assert_raise FunctionClauseError, fn -> Bitmap.put(mut, @width, 0, :red) end
+    assert_raise FunctionClauseError, fn -> Bitmap.put(mut, 0, @height, :red) end
+    assert_raise RuntimeError, fn -> Bitmap.put_offset(mut, @width * @height, :red) end
+  end
+
+  test "clear fills the pixels but not the padding" do
+    {@mutable, _, p} = Bitmap.build(:ga, 3, 2, align: 8, clear: {:color_ga, {1, 2}})
+    assert p == <<1, 2, 1, 2, 1, 2, 0, 0, 1, 2, 1, 2, 1, 2, 0, 0>>
+  end
+
+  test "valid? rejects padded rows until they are packed" do
+    padded = Bitmap.build(:rgb, @width, @height, align: 16, clear: :red, commit: true)
+    refute Bitmap.valid?(padded)
+
+    packed = Bitmap.pack(padded)
+    assert Bitmap.valid?(packed)
+    assert packed == Bitmap.build(:rgb, @width, @height, clear: :red, commit: true)
+  end
+
+  test "get rejects pixels in the row padding" do
+    bitmap = Bitmap.build(:rgb, @width, @height, align: 16)
+    assert_raise FunctionClauseError, fn -> Bitmap.get(bitmap, @width, 0) end
+    assert_raise FunctionClauseError, fn -> Bitmap.get(bitmap, 0, @height) end
+  end
+
+  # --------------------------------------------------------
+  # regions
+
+  # a 4x3 :ga bitmap whose pixels are {x + 10 * y, 200 + x}, with padded rows
+  defp ramp(opts \\ []) do
+    for x <- 0..3, y <- 0..2, reduce: Bitmap.build(:ga, 4, 3, opts) do
+      bitmap -> Bitmap.put(bitmap, x, y, {:color_ga, {x + 10 * y, 200 + x}})
+    end
+  end
+
+  test "crop copies a rect into a new packed bitmap" do
+    bitmap = ramp(align: 16)
+    {@mutable, {2, 2, :ga}, p} = Bitmap.crop(bitmap, 1, 1, 2, 2)
+    assert p == <<11, 201, 12, 202, 21, 201, 22, 202>>
+
+    {@bitmap, {4, 3, :ga}, _} = Bitmap.commit(bitmap) |> Bitmap.crop(0, 0, 4, 3)
+    {@mutable, {0, 0, :ga}, ""} = Bitmap.crop(bitmap, 4, 3, 0, 0)
+  end
+
+  test "crop shares no memory with the original" do
+    bitmap = ramp()
+    crop = Bitmap.crop(bitmap, 0, 0, 2, 2) |> Bitmap.put(0, 0, {:color_ga, {99, 99}})
+    assert Bitmap.get(bitmap, 0, 0) == {:color_ga, {0, 200}}
+    assert Bitmap.get(crop, 0, 0) == {:color_ga, {99, 99}}
+  end
+
+  test "crop rejects rects outside the bitmap" do
+    assert_raise FunctionClauseError, fn -> Bitmap.crop(ramp(), 3, 0, 2, 1) end
+    assert_raise FunctionClauseError, fn -> Bitmap.crop(ramp(), 0, -1, 1, 1) end
+  end
+
+  test "histogram counts each channel over a rect" do
+    {g, a} = ramp(align: 16) |> Bitmap.histogram({1, 1, 2, 2})
+    assert tuple_size(g) == 256
+    assert elem(g, 11) == 1 and elem(g, 22) == 1 and elem(g, 0) == 0
+    assert elem(a, 201) == 2 and elem(a, 202) == 2
+    assert g |> Tuple.to_list() |> Enum.sum() == 4
+  end
+
+  test "histogram defaults to the whole bitmap, for every depth" do
+    {g} = Bitmap.build(:g, @width, @height, clear: {:color_g, 7}) |> Bitmap.histogram()
+    assert elem(g, 7) == @width * @height
+
+    {r, _, b} = Bitmap.build(:rgb, 3, 2, clear: :red) |> Bitmap.histogram()
+    assert elem(r, 255) == 6 and elem(b, 0) == 6
+
+    {_, _, _, a} = Bitmap.build(:rgba, 3, 2, commit: true) |> Bitmap.histogram()
+    assert elem(a, 0) == 6
+  end
+
+  test "min_max_mean measures each channel over a rect" do
+    bitmap = ramp(align: 16)
+    {{0, 23, mean}, {200, 203, 201.5}} = Bitmap.min_max_mean(bitmap)
+    assert_in_delta mean, 11.5, 0.0001
+
+    {{11, 22, 16.5}, {201, 202, 201.5}} = Bitmap.min_max_mean(bitmap, {1, 1, 2, 2})
+
+    {{255, 255, 255.0}, {0, 0, +0.0}, {0, 0, +0.0}, {255, 255, 255.0}} =
+      Bitmap.build(:rgba, 3, 2, clear: :red) |> Bitmap.min_max_mean()
+  end
+
+  test "min_max_mean rejects empty rects" do
+    assert_raise ArgumentError, fn -> Bitmap.min_max_mean(ramp(), {0, 0, 0, 1}) end
+    assert_raise FunctionClauseError, fn -> Bitmap.min_max_mean(ramp(), {0, 0, 5, 1}) end
+  end
 end
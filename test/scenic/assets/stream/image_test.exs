@@ -9,6 +9,19 @@ defmodule Scenic.Assets.Stream.ImageTest do
 
   alias Scenic.Assets.Static
   alias Scenic.Assets.Stream.Image
+  alias Scenic.Assets.Stream.Bitmap
+
+  # 32x16 baseline 4:2:0 jpeg. The left half is red, the right half is blue.
+  @halves File.read!("test/assets/images/halves.jpg")
+
+  defp close?({r0, g0, b0}, {r1, g1, b1}) do
+    abs(r0 - r1) <= 4 and abs(g0 - g1) <= 4 and abs(b0 - b1) <= 4
+  end
+
+  defp rgb(bitmap, x, y) do
+    {:color_rgba, {r, g, b, _}} = Bitmap.get(bitmap, x, y) |> Scenic.Color.to_rgba()
+    {r, g, b}
+  end
 
   test "from_binary works" do
     # use the parrot from the static assets as the input...
@@ -20,4 +33,169 @@ defmodule Scenic.Assets.Stream.ImageTest do
   test "from_binary rejects non-image binary data" do
     assert Image.from_binary(<<0, 1, 2, 3, 4, 5, 6>>) == {:error, :invalid}
   end
+
+  # --------------------------------------------------------
+  # decode
+
+  test "decode turns a png into a mutable bitmap" do
+    {:ok, bin} = Static.load(:parrot)
+    {:ok, {:mutable_bitmap, {62, 114, :rgba}, pixels}} = Image.decode(bin)
+    assert byte_size(pixels) == 62 * 114 * 4
+
+    {:ok, {:mutable_bitmap, {62, 114, :rgb}, pixels}} = Image.decode(bin, format: :rgb)
+    assert byte_size(pixels) == 62 * 114 * 3
+  end
+
+  test "decode accepts a streamable image and can commit the result" do
+    {:ok, bin} = Static.load(:parrot)
+    {:ok, img} = Image.from_binary(bin)
+    {:ok, {Bitmap, {62, 114, :rgba}, _}} = Image.decode(img, commit: true)
+  end
+
+  test "decode of a png region matches the full image" do
+    {:ok, bin} = Static.load(:parrot)
+    {:ok, full} = Image.decode(bin)
+    {:ok, {:mutable_bitmap, {20, 30, :rgba}, _} = roi} = Image.decode(bin, roi: {10, 40, 20, 30})
+
+    for {x, y} <- [{0, 0}, {19, 0}, {7, 13}, {0, 29}, {19, 29}] do
+      assert Bitmap.get(roi, x, y) == Bitmap.get(full, x + 10, y + 40)
+    end
+
+    # a zero size extends the region to the edges
+    {:ok, {:mutable_bitmap, {12, 14, :rgba}, _}} = Image.decode(bin, roi: {50, 100, 0, 0})
+  end
+
+  test "decode turns a jpeg into a bitmap" do
+    {:ok, {:mutable_bitmap, {32, 16, :rgb}, _} = bitmap} = Image.decode(@halves, format: :rgb)
+    assert close?(rgb(bitmap, 4, 4), {255, 0, 0})
+    assert close?(rgb(bitmap, 28, 12), {0, 0, 255})
+
+    # jpegs are opaque
+    {:ok, bitmap} = Image.decode(@halves)
+    {:color_rgba, {_, _, _, 255}} = Bitmap.get(bitmap, 4, 4) |> Scenic.Color.to_rgba()
+  end
+
+  test "decode scales jpegs down" do
+    {:ok, {:mutable_bitmap, {16, 8, :rgba}, _} = bitmap} = Image.decode(@halves, scale: 2)
+    assert close?(rgb(bitmap, 2, 2), {255, 0, 0})
+    assert close?(rgb(bitmap, 13, 6), {0, 0, 255})
+
+    {:ok, {:mutable_bitmap, {4, 2, :rgba}, _}} = Image.decode(@halves, scale: 8)
+  end
+
+  test "decode of a jpeg region matches the full image" do
+    {:ok, bitmap} = Image.decode(@halves, roi: {16, 4, 8, 8})
+    assert close?(rgb(bitmap, 0, 0), {0, 0, 255})
+    assert close?(rgb(bitmap, 7, 7), {0, 0, 255})
+  end
+
+  test "decode returns errors" do
+    {:ok, bin} = Static.load(:parrot)
+    assert Image.decode(<<0, 1, 2, 3, 4, 5, 6>>) == {:error, :invalid}
+    assert Image.decode(binary_part(bin, 0, 100)) == {:error, :invalid}
+    assert Image.decode(bin, scale: 2) == {:error, :unsupported}
+    assert Image.decode(bin, roi: {60, 0, 10, 10}) == {:error, :roi}
+    assert Image.decode(@halves, roi: {32, 0, 0, 0}) == {:error, :roi}
+    assert Image.decode(@halves, roi: {31, 0, 0xFFFFFFFF, 1}) == {:error, :roi}
+  end
+
+  # every code of the first huffman table at 1 bit, which is more codes than fit
+  defp oversubscribed(jpeg) do
+    {at, _} = :binary.match(jpeg, <<0xFF, 0xC4>>)
+    <<head::binary-size(at + 5), counts::binary-size(16), rest::binary>> = jpeg
+    total = counts |> :binary.bin_to_list() |> Enum.sum()
+    head <> <<total, 0::size(120)>> <> rest
+  end
+
+  # a 1x1 png with the given bit depth and color type. The crcs aren't checked
+  defp png_header(depth, color) do
+    chunk = fn type, data -> <<byte_size(data)::32, type::binary, data::binary, 0::32>> end
+
+    <<137, 80, 78, 71, 13, 10, 26, 10>> <>
+      chunk.("IHDR", <<1::32, 1::32, depth, color, 0, 0, 0>>) <>
+      chunk.("IDAT", :zlib.compress(<<0, 0, 0>>)) <> chunk.("IEND", "")
+  end
+
+  test "decode rejects malformed images" do
+    assert Image.decode(oversubscribed(@halves)) == {:error, :invalid}
+
+    # a palette index is never more than 8 bits
+    assert Image.decode(png_header(16, 3)) == {:error, :invalid}
+    assert Image.decode(png_header(4, 2)) == {:error, :invalid}
+  end
+
+  test "decode rejects bad options" do
+    assert_raise RuntimeError, fn -> Image.decode(@halves, format: :g) end
+    assert_raise RuntimeError, fn -> Image.decode(@halves, scale: 3) end
+    assert_raise RuntimeError, fn -> Image.decode(@halves, roi: {0, 0, -1, 4}) end
+    assert_raise RuntimeError, fn -> Image.decode(@halves, roi: {0x100000000, 0, 2, 2}) end
+  end
+
+  # --------------------------------------------------------
+  # encode
+
+  defp test_bitmap(format) do
+    Bitmap.build(format, 20, 10, clear: :blue)
+    |> Bitmap.put(2, 3, :red)
+    |> Bitmap.put(19, 9, :yellow)
+    |> Bitmap.commit()
+  end
+
+  test "from_bitmap encodes a png that decodes back to the same pixels" do
+    {Bitmap, _, pixels} = bitmap = test_bitmap(:rgba)
+    {:ok, {Image, {20, 10, "image/png"}, png} = img} = Image.from_bitmap(bitmap)
+    assert byte_size(png) < byte_size(pixels)
+
+    # the png is valid as far as the stream is concerned
+    assert Image.from_binary(png) == {:ok, img}
+    assert Image.decode(img) == {:ok, {:mutable_bitmap, {20, 10, :rgba}, pixels}}
+  end
+
+  test "from_bitmap encodes every depth" do
+    for format <- [:g, :ga, :rgb, :rgba] do
+      {:ok, {Image, {20, 10, "image/png"}, png}} = test_bitmap(format) |> Image.from_bitmap()
+      assert {:ok, _} = Image.from_binary(png)
+    end
+
+    {Bitmap, _, pixels} = test_bitmap(:rgb)
+    {:ok, img} = test_bitmap(:rgb) |> Image.from_bitmap()
+    assert Image.decode(img, format: :rgb) == {:ok, {:mutable_bitmap, {20, 10, :rgb}, pixels}}
+  end
+
+  test "delta encodes only the changed pixels" do
+    previous = test_bitmap(:rgba)
+
+    bitmap =
+      previous
+      |> Bitmap.mutable()
+      |> Bitmap.put(4, 2, :green)
+      |> Bitmap.put(7, 5, :white)
+      |> Bitmap.commit()
+
+    {:ok, {4, 2}, {Image, {4, 4, "image/png"}, _} = img} = Image.delta(bitmap, previous)
+    {:ok, patch} = Image.decode(img)
+    assert Bitmap.get(patch, 0, 0) == Bitmap.get(bitmap, 4, 2)
+    assert Bitmap.get(patch, 3, 3) == Bitmap.get(bitmap, 7, 5)
+    assert Bitmap.get(patch, 1, 1) == Bitmap.get(bitmap, 5, 3)
+  end
+
+  test "delta returns :unchanged for identical frames" do
+    assert Image.delta(test_bitmap(:rgb), test_bitmap(:rgb)) == :unchanged
+  end
+
+  test "from_bitmap and delta skip the row padding" do
+    aligned = fn format ->
+      Bitmap.build(format, 20, 10, clear: :blue, align: 64)
+      |> Bitmap.put(2, 3, :red)
+      |> Bitmap.put(19, 9, :yellow)
+      |> Bitmap.commit()
+    end
+
+    assert Image.from_bitmap(aligned.(:rgb)) == Image.from_bitmap(test_bitmap(:rgb))
+
+    previous = aligned.(:rgba)
+    bitmap = previous |> Bitmap.mutable() |> Bitmap.put(4, 2, :green) |> Bitmap.commit()
+    {:ok, {4, 2}, {Image, {1, 1, "image/png"}, _}} = Image.delta(bitmap, previous)
+    assert Image.delta(aligned.(:g), aligned.(:g)) == :unchanged
+  end
 end
@@ -0,0 +1,118 @@
+defmodule Scenic.Graph.AnimationTest do
+  use ExUnit.Case, async: true
+  doctest Scenic.Graph.Animation
+
+  alias Scenic.Graph
+  alias Scenic.Graph.Animation
+  alias Scenic.Primitive
+
+  import Scenic.Primitives
+
+  @graph Graph.build()
+         |> rect({100, 50}, id: :rect, fill: :black, translate: {10, 20})
+         |> circle(20, id: :dot)
+         |> circle(30, id: :dot)
+
+  defp value(graph, id, fun), do: graph |> Graph.get!(id) |> fun.()
+
+  defp start(%Graph{animations: animations}), do: List.last(animations).start
+
+  # ============================================================================
+  # animate
+
+  test "animate sets the end state right away" do
+    graph = Graph.animate(@graph, :rect, :translate, {110, 70})
+    assert value(graph, :rect, &Primitive.get_transform(&1, :translate)) == {110, 70}
+    assert [%Animation{key: :translate, targets: [{_, [10, 20], {110, 70}}]}] = graph.animations
+    assert Graph.animating?(graph)
+  end
+
+  test "animate targets every primitive with the id" do
+    graph = Graph.animate(@graph, :dot, :data, 40, from: 0)
+    [%Animation{targets: targets}] = graph.animations
+    assert Enum.map(targets, &elem(&1, 1)) == [[0], [0]]
+  end
+
+  test "animate starts a transform from its identity if it isn't set" do
+    graph = Graph.animate(@graph, :rect, :rotate, 1.0)
+    assert [%Animation{targets: [{_, [0], 1.0}]}] = graph.animations
+  end
+
+  test "animate takes over the values another animation is running" do
+    graph =
+      @graph
+      |> Graph.animate(:rect, :translate, {110, 70})
+      |> Graph.animate(:rect, :fill, :red)
+      |> Graph.animate(:rect, :translate, {0, 0})
+
+    assert [%{key: :fill}, %{key: :translate, targets: [{_, [110, 70], {0, 0}}]}] =
+             graph.animations
+  end
+
+  test "animate rejects values it can't animate" do
+    assert_raise Graph.Error, fn -> Graph.animate(@graph, :rect, :scale, {2, 3}) end
+    assert_raise Graph.Error, fn -> Graph.animate(@graph, :rect, :input, []) end
+    assert_raise Graph.Error, fn -> Graph.animate(@graph, :dot, :stroke, {2, :red}) end
+    assert_raise RuntimeError, fn ->
+      Graph.animate(@graph, :rect, :translate, {1, 1}, easing: :x)
+    end
+  end
+
+  # ============================================================================
+  # frame
+
+  test "frame is the start before the animation begins and the end after it" do
+    graph = Graph.animate(@graph, :rect, :translate, {110, 70}, duration: 100, delay: 50)
+    start = start(graph)
+
+    {frame, true} = Animation.frame(graph, start - 20)
+    assert value(frame, :rect, &Primitive.get_transform(&1, :translate)) == {10.0, 20.0}
+
+    {frame, false} = Animation.frame(graph, start + 100)
+    assert value(frame, :rect, &Primitive.get_transform(&1, :translate)) == {110, 70}
+    assert frame == graph
+  end
+
+  test "frame eases the values" do
+    graph = Graph.animate(@graph, :rect, :translate, {110, 70}, duration: 100, easing: :linear)
+    {frame, true} = Animation.frame(graph, start(graph) + 50)
+    assert value(frame, :rect, &Primitive.get_transform(&1, :translate)) == {60.0, 45.0}
+
+    graph = Graph.animate(@graph, :dot, :data, 40, duration: 100, easing: :ease_in)
+    {frame, true} = Animation.frame(graph, start(graph) + 50)
+    [r0, r1] = frame |> Graph.get(:dot) |> Enum.map(& &1.data) |> Enum.sort()
+    assert_in_delta r0, 20 + 20 * 0.125, 0.01
+    assert_in_delta r1, 30 + 10 * 0.125, 0.01
+  end
+
+  test "frame keeps colors in range" do
+    graph = Graph.animate(@graph, :rect, :fill, :white, duration: 100, easing: :ease_out_back)
+
+    {frame, true} = Animation.frame(graph, start(graph) + 60)
+    {:color, {:color_rgba, {r, g, b, 255}}} = value(frame, :rect, &Primitive.get_style(&1, :fill))
+    assert r == 255 and g == 255 and b == 255
+
+    {frame, true} = Animation.frame(graph, start(graph) + 20)
+    {:color, {:color_rgba, {r, _, _, 255}}} = value(frame, :rect, &Primitive.get_style(&1, :fill))
+    assert is_integer(r) and r > 0 and r < 255
+  end
+
+  test "frame drops the cached bounds of what it changed" do
+    graph =
+      @graph
+      |> Graph.animate(:dot, :data, 100, duration: 100)
+      |> Graph.cache_bounds()
+
+    {l, _, _, _} = Graph.bounds(graph)
+    assert l == -100
+
+    {frame, true} = Animation.frame(graph, start(graph) + 50)
+    {l, _, _, _} = Graph.bounds(frame)
+    assert l > -100 and l < -30
+  end
+
+  test "frame of a graph without animations is the graph" do
+    assert Animation.frame(@graph) == {@graph, false}
+    refute Graph.animating?(@graph)
+  end
+end
@@ -207,4 +207,72 @@ defmodule Scenic.Graph.BoundsTest do
     graph = Graph.build() |> triangle({{10, 20}, {20, 60}, {40, 40}})
     assert Graph.bounds(graph) == {10.0, 20.0, 40.0, 60.0}
   end
+
+  # --------------------------------------------------------
+  # cached bounds
+
+  @cached Graph.build()
+          |> rect({100, 200}, translate: {10, 10})
+          |> group(fn g -> rect(g, {20, 20}, id: :inner) end, id: :left, translate: {0, 300})
+          |> group(fn g -> circle(g, 10, id: :dot) end, id: :right, translate: {500, 0})
+
+  test "cache_bounds computes the same bounds" do
+    graph = Graph.cache_bounds(@cached)
+    assert Graph.bounds(graph) == Graph.bounds(@cached)
+    assert Graph.bounds(graph) == {+0.0, -10.0, 510.0, 320.0}
+  end
+
+  test "cache_bounds keeps the bounds of every group" do
+    %{bounds_cache: cache} = Graph.cache_bounds(@cached)
+    [left] = @cached.ids[:left]
+    [right] = @cached.ids[:right]
+    assert Map.keys(cache) |> Enum.sort() == Enum.sort([0, left, right])
+  end
+
+  test "modifying a primitive drops only the cached groups on its path" do
+    graph = Graph.cache_bounds(@cached)
+    [left] = graph.ids[:left]
+    [right] = graph.ids[:right]
+
+    graph = Graph.modify(graph, :inner, &rect(&1, {50, 50}))
+    refute Map.has_key?(graph.bounds_cache, 0)
+    refute Map.has_key?(graph.bounds_cache, left)
+    assert Map.has_key?(graph.bounds_cache, right)
+
+    assert Graph.bounds(graph) == {+0.0, -10.0, 510.0, 350.0}
+    assert Graph.bounds(Graph.cache_bounds(graph)) == {+0.0, -10.0, 510.0, 350.0}
+  end
+
+  test "unchanged modifications keep the cache" do
+    graph = Graph.cache_bounds(@cached)
+    assert Graph.modify(graph, :inner, & &1).bounds_cache == graph.bounds_cache
+  end
+
+  test "moving a group recomputes its children" do
+    graph =
+      @cached
+      |> Graph.cache_bounds()
+      |> Graph.modify(:right, &update_opts(&1, translate: {600, 0}))
+      |> Graph.cache_bounds()
+
+    assert Graph.bounds(graph) == {+0.0, -10.0, 610.0, 320.0}
+  end
+
+  test "adding and deleting update the cached bounds" do
+    graph =
+      @cached
+      |> Graph.cache_bounds()
+      |> Graph.add_to(:left, &rect(&1, {20, 100}, id: :tall))
+
+    assert Graph.bounds(graph) == {+0.0, -10.0, 510.0, 400.0}
+
+    graph =
+      graph
+      |> Graph.cache_bounds()
+      |> Graph.delete(:left)
+
+    assert Graph.bounds(graph) == {+0.0, -10.0, 510.0, 210.0}
+    [right] = graph.ids[:right]
+    assert Map.keys(graph.bounds_cache) == [right]
+  end
 end
@@ -495,6 +495,29 @@ defmodule Scenic.Graph.CompilerTest do
            ]
   end
 
+  # ---------------------------------------------------------
+  test "rects filled with an atlased image are drawn from the atlas" do
+    red = {:test_assets, "images/icons/red.png"}
+    {:ok, {atlas, {x, y, 8, 8}}} = Scenic.Assets.Static.region(red)
+    {:ok, red_hash} = Scenic.Assets.Static.to_hash(red)
+
+    {:ok, list} =
+      Graph.build()
+      |> rect({6, 8}, fill: {:image, red})
+      |> rect({10, 8}, fill: {:image, red})
+      |> rect({8, 8}, fill: {:image, red}, stroke: {1, :white})
+      |> Compiler.compile()
+
+    assert list == [
+             {:draw_sprites, {atlas, [{{x, y}, {6.0, 8.0}, {0, 0}, {6.0, 8.0}}]}},
+             {:fill_image, red_hash},
+             {:draw_rect, {10.0, 8.0, :fill}},
+             {:stroke_width, 1},
+             {:stroke_color, {:color_rgba, {255, 255, 255, 255}}},
+             {:draw_rect, {8.0, 8.0, :fill_stroke}}
+           ]
+  end
+
   # ---------------------------------------------------------
   test "fill_streams graph works" do
     {:ok, list} =
@@ -671,4 +694,56 @@ defmodule Scenic.Graph.CompilerTest do
              {:draw_text, "World"}
            ]
   end
+
+  # ---------------------------------------------------------
+  # culling
+
+  test "cull wraps bounded groups in cull ops" do
+    {:ok, list} =
+      Graph.build()
+      |> group(&rect(&1, {10, 20}, fill: :red), translate: {100, 100})
+      |> Compiler.compile(cull: true)
+
+    assert list == [
+             {:cull, {100, 100, 110, 120, 10}},
+             :push_state,
+             :push_state,
+             {:translate, {100, 100}},
+             {:cull, {0, 0, 10, 20, 4}},
+             :push_state,
+             {:fill_color, {:color_rgba, {255, 0, 0, 255}}},
+             {:draw_rect, {10, 20, :fill}},
+             :pop_state,
+             :pop_state,
+             :pop_state
+           ]
+  end
+
+  test "cull pads the bounds by the stroke width" do
+    {:ok, [{:cull, bounds} | _]} =
+      Graph.build()
+      |> rect({10, 20}, stroke: {2, :red})
+      |> Compiler.compile(cull: true)
+
+    assert bounds == {-2, -2, 12, 22, 5}
+  end
+
+  test "cull skips groups that can't be bounded" do
+    {:ok, list} =
+      Graph.build()
+      |> rect({10, 20}, fill: :red)
+      |> script("a_script")
+      |> Compiler.compile(cull: true)
+
+    assert list == [
+             {:fill_color, {:color_rgba, {255, 0, 0, 255}}},
+             {:draw_rect, {10, 20, :fill}},
+             {:script, "a_script"}
+           ]
+  end
+
+  test "compile does not cull by default" do
+    graph = Graph.build() |> rect({10, 20}, fill: :red)
+    assert {:ok, [{:fill_color, _}, {:draw_rect, _}]} = Compiler.compile(graph)
+  end
 end
@@ -13,6 +13,7 @@ defmodule Scenic.GraphTest do
   alias Scenic.Primitive.Text
   alias Scenic.Primitive.Rectangle
   alias Scenic.Primitive.Line
+  alias Scenic.Primitive.RoundedRectangle
 
   # import IEx
 
@@ -471,6 +472,88 @@ defmodule Scenic.GraphTest do
     assert Map.get(Graph.get!(graph, {:b, :three}), :transforms) == %{}
   end
 
+  # ============================================================================
+  # modify_many(graph, actions) and put_data(graph, data)
+
+  test "modify_many modifies the primitives of every id" do
+    graph =
+      Graph.modify_many(@graph_find, %{
+        :outer_text => &Primitive.put_transforms(&1, @transform),
+        :inner_line => &Primitive.put_style(&1, :stroke, {2, :blue}),
+        :missing => &Primitive.put_transforms(&1, @transform)
+      })
+
+    assert Map.get(Graph.get!(graph, :outer_text), :transforms) == @transform
+    assert Primitive.get_style(Graph.get!(graph, :inner_line), :stroke) ==
+             {2, {:color, {:color_rgba, {0, 0, 255, 255}}}}
+
+    assert Graph.get!(graph, :inner_text) == Graph.get!(@graph_find, :inner_text)
+  end
+
+  test "modify_many applies the actions for an id in order" do
+    graph =
+      Graph.build()
+      |> Text.add_to_graph("Some text", id: :text)
+      |> Text.add_to_graph("More text", id: :text)
+      |> Graph.modify_many([
+        {:text, &Primitive.put_transform(&1, :rotate, 1.0)},
+        {:text, &Primitive.put_transform(&1, :rotate, 2.0)}
+      ])
+
+    assert Enum.map(Graph.get(graph, :text), &Primitive.get_transform(&1, :rotate)) ==
+             [2.0, 2.0]
+  end
+
+  test "modify_many drops only the cached bounds of what changed" do
+    graph =
+      Graph.build()
+      |> Group.add_to_graph(&Rectangle.add_to_graph(&1, {10, 10}, id: :left), id: :left_group)
+      |> Group.add_to_graph(&Rectangle.add_to_graph(&1, {10, 10}, id: :right), id: :right_group)
+      |> Graph.cache_bounds()
+
+    [left] = graph.ids[:left_group]
+    [right] = graph.ids[:right_group]
+
+    graph =
+      Graph.modify_many(graph, %{
+        :left => &Primitive.put_transform(&1, :translate, {100, 0}),
+        :right => & &1
+      })
+
+    refute Map.has_key?(graph.bounds_cache, @root_uid)
+    refute Map.has_key?(graph.bounds_cache, left)
+    assert Map.has_key?(graph.bounds_cache, right)
+    assert Graph.bounds(graph) == {+0.0, +0.0, 110.0, 10.0}
+  end
+
+  test "modify_many raises if an action doesn't return a primitive" do
+    assert_raise Graph.Error, fn ->
+      Graph.modify_many(@graph_find, %{outer_text: fn _ -> 1 end})
+    end
+  end
+
+  test "put_data sets and validates the data of every id" do
+    graph = Graph.put_data(@graph_find, %{outer_text: "Changed", inner_line: {{0, 0}, {1, 1}}})
+    assert Graph.get!(graph, :outer_text).data == "Changed"
+    assert Graph.get!(graph, :inner_line).data == {{0, 0}, {1, 1}}
+
+    assert_raise RuntimeError, fn -> Graph.put_data(@graph_find, %{outer_text: 123}) end
+  end
+
+  test "put_data stores the validated data, the same as add" do
+    graph = Graph.build() |> RoundedRectangle.add_to_graph({100, 20, 5}, id: :rr)
+    added = Graph.build() |> RoundedRectangle.add_to_graph({100, 20, 50}, id: :rr)
+    graph = Graph.put_data(graph, rr: {100, 20, 50})
+
+    assert Graph.get!(graph, :rr).data == {100, 20, 10.0}
+    assert Graph.get!(graph, :rr).data == Graph.get!(added, :rr).data
+  end
+
+  test "put_data leaves primitives with unchanged data alone" do
+    graph = Graph.cache_bounds(@graph_find)
+    assert Graph.put_data(graph, outer_text: "Some sample text") == graph
+  end
+
   # ============================================================================
   # reduce(graph, acc, action) - whole tree
 
@@ -1055,6 +1055,29 @@ defmodule Scenic.Math.MatrixTest do
     end
   end
 
+  # ----------------------------------------------------------------------------
+  # project lists of vectors, each by their own matrix, into bounds
+  test "project_bounds finds the bounds of all the projected vectors" do
+    regions = [
+      {Matrix.build_translation({5, 7}), [{10, 20}, {100, 200}]},
+      {Matrix.build_scale(2), [{-10, 1}]},
+      {Matrix.identity(), []}
+    ]
+
+    assert Matrix.project_bounds(regions) == {-20.0, 2.0, 105.0, 207.0}
+  end
+
+  test "project_bounds returns nil if there are no vectors" do
+    assert Matrix.project_bounds([]) == nil
+    assert Matrix.project_bounds([{Matrix.identity(), []}]) == nil
+  end
+
+  test "project_bounds checks types" do
+    assert_raise ArgumentError, fn ->
+      Matrix.project_bounds([{<<1, 2, 3>>, [{1, 2}]}])
+    end
+  end
+
   # ----------------------------------------------------------------------------
   # project packed 3d vectors with a matrix
   # test "project_vector3s works with a packed vector2 binary" do
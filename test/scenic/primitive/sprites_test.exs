@@ -46,6 +46,23 @@ defmodule Scenic.Primitive.SpritesTest do
     assert msg =~ "Invalid Sprites"
   end
 
+  test "validate accepts packed commands" do
+    packed = Sprites.pack_commands(@cmds)
+    assert byte_size(packed) == 72
+    assert Sprites.validate({:parrot, packed}) == {:ok, {:parrot, packed}}
+  end
+
+  test "validate rejects packed commands with a bad length" do
+    {:error, msg} = Sprites.validate({:parrot, Sprites.pack_commands(@cmds) <> <<0::32>>})
+    assert msg =~ "multiple of 36 bytes"
+  end
+
+  test "validate rejects packed commands with a NaN" do
+    <<head::binary-size(8), _::32, tail::binary>> = Sprites.pack_commands(@cmds)
+    {:error, msg} = Sprites.validate({:parrot, <<head::binary, 0x7FC00000::32, tail::binary>>})
+    assert msg =~ "NaN"
+  end
+
   test "validate rejects unknown image files" do
     {:error, msg} = Sprites.validate({"images/missing.jpg", @cmds})
     assert msg =~ "Invalid Sprites"
@@ -56,6 +73,29 @@ defmodule Scenic.Primitive.SpritesTest do
     assert msg =~ "is a font"
   end
 
+  # ============================================================================
+  # packed commands
+
+  test "pack_commands packs with a default alpha" do
+    assert Sprites.pack_commands(@cmds) == Sprites.pack_commands(@enhanced_cmds)
+    assert Sprites.command_count(Sprites.pack_commands(@cmds)) == 2
+    assert Sprites.pack_commands([]) == <<>>
+  end
+
+  test "put_command replaces a single command" do
+    cmd = {{7, 7}, {1, 1}, {8, 8}, {2, 2}, 0.5}
+    [first, _] = @enhanced_cmds
+
+    assert Sprites.put_command(Sprites.pack_commands(@cmds), 1, cmd) ==
+             Sprites.pack_commands([first, cmd])
+  end
+
+  test "put_command rejects an index past the end" do
+    assert_raise FunctionClauseError, fn ->
+      Sprites.put_command(Sprites.pack_commands(@cmds), 2, hd(@cmds))
+    end
+  end
+
   # ============================================================================
   # styles
 
@@ -73,4 +113,13 @@ defmodule Scenic.Primitive.SpritesTest do
              {:draw_sprites, {"VvWQFjblIwTGsvGx866t8MIG2czWyIc8by6Xc88AOns", @enhanced_cmds}}
            ]
   end
+
+  test "compile passes packed commands through" do
+    packed = Sprites.pack_commands(@cmds)
+    p = Sprites.build({:parrot, packed})
+
+    assert Sprites.compile(p, %{}) == [
+             {:draw_sprites, {"VvWQFjblIwTGsvGx866t8MIG2czWyIc8by6Xc88AOns", packed}}
+           ]
+  end
 end
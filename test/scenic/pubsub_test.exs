@@ -6,6 +6,8 @@ defmodule Scenic.PubSubTest do
   @table Scenic.PubSub
 
   @data {PubSub, :data}
+  @batch {PubSub, :batch}
+  @changed {PubSub, :changed}
   @registered {PubSub, :registered}
   @unregistered {PubSub, :unregistered}
 
@@ -111,4 +113,131 @@ defmodule Scenic.PubSubTest do
       PubSub.get!(:abc)
     end
   end
+
+  # ============================================================================
+  # high frequency sources
+
+  test "publish writes the table directly" do
+    {:ok, :abc} = PubSub.register(:abc)
+    :ok = PubSub.publish(:abc, 123)
+    assert PubSub.get(:abc) == 123
+  end
+
+  test "batched subscribers get the latest values once per tick" do
+    :ok = PubSub.subscribe(:abc, batch: true)
+    {:ok, :abc} = PubSub.register(:abc)
+    assert_receive({@registered, {:abc, _}})
+
+    :ok = PubSub.publish(:abc, 1)
+    :ok = PubSub.publish(:abc, 2)
+    :ok = PubSub.publish(:abc, 3)
+
+    # only the latest value is sent, and never as a data message
+    assert_receive({@batch, [{:abc, 3, timestamp}]}, 200)
+    assert is_integer(timestamp)
+    refute_receive({@batch, _}, 50)
+    refute_received({@data, _})
+  end
+
+  test "batched subscribers get one message for all their sources" do
+    :ok = PubSub.subscribe(:abc, batch: true)
+    :ok = PubSub.subscribe(:def, batch: true)
+    {:ok, :abc} = PubSub.register(:abc)
+    {:ok, :def} = PubSub.register(:def)
+
+    :ok = PubSub.publish(:abc, 1)
+    :ok = PubSub.publish(:def, 2)
+
+    assert_receive({@batch, batch}, 200)
+    assert Enum.sort(batch) |> Enum.map(&Tuple.delete_at(&1, 2)) == [{:abc, 1}, {:def, 2}]
+  end
+
+  test "batched subscribers get the existing value with the next batch" do
+    {:ok, :abc} = PubSub.register(:abc)
+    :ok = PubSub.publish(:abc, 123)
+
+    :ok = PubSub.subscribe(:abc, batch: true)
+    assert_receive({@batch, [{:abc, 123, _}]}, 200)
+  end
+
+  test "unsubscribing stops the batches" do
+    {:ok, :abc} = PubSub.register(:abc)
+    :ok = PubSub.subscribe(:abc, batch: true)
+    :ok = PubSub.unsubscribe(:abc)
+    # unsubscribe is a cast. make sure it has been handled
+    PubSub.stats()
+    :ok = PubSub.publish(:abc, 123)
+    refute_receive({@batch, _}, 50)
+  end
+
+  test "subscribe enforces the options schema" do
+    assert_raise PubSub.Error, fn ->
+      PubSub.subscribe(:abc, batch: :sometimes)
+    end
+  end
+
+  test "stats reports the publish counts and subscribers" do
+    {:ok, :abc} = PubSub.register(:abc)
+    :ok = PubSub.subscribe(:abc)
+    :ok = PubSub.publish(:abc, 1)
+    :ok = PubSub.publish(:abc, 2)
+
+    assert %{abc: stats} = PubSub.stats()
+    assert stats.published == 2
+    assert stats.subscribers == 1
+    assert is_number(stats.rate)
+    assert is_integer(stats.queue_depth)
+  end
+
+  test "stats only lists registered sources" do
+    :ok = PubSub.subscribe(:abc)
+    assert PubSub.stats() == %{}
+  end
+
+  # ============================================================================
+  # latest value only
+
+  test "changed subscribers are signaled once until they read the value" do
+    :ok = PubSub.subscribe(:abc, changed: true)
+    {:ok, :abc} = PubSub.register(:abc)
+
+    :ok = PubSub.publish(:abc, 1)
+    :ok = PubSub.publish(:abc, 2)
+    :ok = PubSub.publish(:abc, 3)
+
+    assert_receive({@changed, :abc})
+    refute_receive({@changed, :abc})
+    refute_received({@data, _})
+
+    # reading the value arms the next signal
+    assert PubSub.get(:abc) == 3
+    :ok = PubSub.publish(:abc, 4)
+    assert_receive({@changed, :abc})
+    assert PubSub.fetch(:abc) == {:ok, 4}
+  end
+
+  test "changed subscribers are signaled if there is already a value" do
+    {:ok, :abc} = PubSub.register(:abc)
+    :ok = PubSub.publish(:abc, 123)
+
+    :ok = PubSub.subscribe(:abc, changed: true)
+    assert_receive({@changed, :abc})
+    refute_received({@data, _})
+  end
+
+  test "subscribing again changes the mode" do
+    {:ok, :abc} = PubSub.register(:abc)
+    :ok = PubSub.subscribe(:abc, changed: true)
+    :ok = PubSub.subscribe(:abc)
+
+    :ok = PubSub.publish(:abc, 123)
+    assert_receive({@data, {:abc, 123, _}})
+    refute_received({@changed, :abc})
+  end
+
+  test "subscribe can't be both batch and changed" do
+    assert_raise PubSub.Error, fn ->
+      PubSub.subscribe(:abc, batch: true, changed: true)
+    end
+  end
 end
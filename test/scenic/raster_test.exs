@@ -0,0 +1,196 @@
+defmodule Scenic.RasterTest do
+  use ExUnit.Case, async: true
+  doctest Scenic.Raster
+
+  alias Scenic.Raster
+  alias Scenic.Script
+  alias Scenic.Assets.Stream.Bitmap
+
+  @black {0, 0, 0, 255}
+  @red {255, 0, 0, 255}
+
+  defp rgba(bitmap, x, y) do
+    {:color_rgba, rgba} = Bitmap.get(bitmap, x, y) |> Scenic.Color.to_rgba()
+    rgba
+  end
+
+  defp filled_rect(color) do
+    Script.start()
+    |> Script.translate(10, 10)
+    |> Script.fill_color(color)
+    |> Script.draw_rectangle(20, 10, :fill)
+    |> Script.finish()
+  end
+
+  # --------------------------------------------------------
+  test "render returns a committed bitmap of the requested size and format" do
+    {Bitmap, {32, 16, :rgba}, pixels} = Raster.render([], 32, 16)
+    assert byte_size(pixels) == 32 * 16 * 4
+
+    {Bitmap, {32, 16, :g}, pixels} = Raster.render([], 32, 16, format: :g)
+    assert byte_size(pixels) == 32 * 16
+  end
+
+  test "render clears to the clear color" do
+    bitmap = Raster.render([], 8, 8, clear: :red)
+    assert rgba(bitmap, 0, 0) == @red
+    assert rgba(bitmap, 7, 7) == @red
+  end
+
+  test "render rejects bad options" do
+    assert_raise RuntimeError, fn -> Raster.render([], 8, 8, format: :bgr) end
+  end
+
+  # --------------------------------------------------------
+  # shapes
+
+  test "fills a transformed rect" do
+    bitmap = Raster.render(filled_rect(:red), 40, 30)
+    assert rgba(bitmap, 15, 15) == @red
+    assert rgba(bitmap, 29, 19) == @red
+    assert rgba(bitmap, 5, 5) == @black
+    assert rgba(bitmap, 31, 15) == @black
+    assert rgba(bitmap, 15, 21) == @black
+  end
+
+  test "strokes a rect without filling it" do
+    script =
+      Script.start()
+      |> Script.translate(10, 10)
+      |> Script.stroke_color(:red)
+      |> Script.stroke_width(2)
+      |> Script.draw_rectangle(20, 20, :stroke)
+      |> Script.finish()
+
+    bitmap = Raster.render(script, 40, 40)
+    assert rgba(bitmap, 20, 10) == @red
+    assert rgba(bitmap, 10, 20) == @red
+    assert rgba(bitmap, 20, 20) == @black
+  end
+
+  test "fills circles" do
+    script =
+      Script.start()
+      |> Script.translate(20, 20)
+      |> Script.fill_color(:red)
+      |> Script.draw_circle(10, :fill)
+      |> Script.finish()
+
+    bitmap = Raster.render(script, 40, 40)
+    assert rgba(bitmap, 20, 20) == @red
+    assert rgba(bitmap, 27, 20) == @red
+    assert rgba(bitmap, 12, 12) == @black
+  end
+
+  test "fills paths" do
+    script =
+      Script.start()
+      |> Script.fill_color(:red)
+      |> Script.begin_path()
+      |> Script.move_to(0, 0)
+      |> Script.line_to(20, 0)
+      |> Script.line_to(0, 20)
+      |> Script.close_path()
+      |> Script.fill_path()
+      |> Script.finish()
+
+    bitmap = Raster.render(script, 20, 20)
+    assert rgba(bitmap, 2, 2) == @red
+    assert rgba(bitmap, 18, 18) == @black
+  end
+
+  test "honors the state stack" do
+    script =
+      Script.start()
+      |> Script.push_state()
+      |> Script.translate(100, 100)
+      |> Script.pop_state()
+      |> Script.fill_color(:red)
+      |> Script.draw_rectangle(4, 4, :fill)
+      |> Script.finish()
+
+    assert Raster.render(script, 8, 8) |> rgba(1, 1) == @red
+  end
+
+  test "clips to the scissor" do
+    script =
+      Script.start()
+      |> Script.scissor(10, 10)
+      |> Script.fill_color(:red)
+      |> Script.draw_rectangle(20, 20, :fill)
+      |> Script.finish()
+
+    bitmap = Raster.render(script, 20, 20)
+    assert rgba(bitmap, 5, 5) == @red
+    assert rgba(bitmap, 15, 15) == @black
+  end
+
+  test "fills linear gradients" do
+    script =
+      Script.start()
+      |> Script.fill_linear(0, 0, 100, 0, :black, :white)
+      |> Script.draw_rectangle(100, 10, :fill)
+      |> Script.finish()
+
+    bitmap = Raster.render(script, 100, 10)
+    {r0, _, _, _} = rgba(bitmap, 5, 5)
+    {r1, _, _, _} = rgba(bitmap, 50, 5)
+    {r2, _, _, _} = rgba(bitmap, 95, 5)
+    assert r0 < r1 and r1 < r2
+  end
+
+  test "skips culled ops that are off screen" do
+    script =
+      Script.start()
+      |> Script.cull(100, 100, 120, 120, 2)
+      |> Script.fill_color(:red)
+      |> Script.draw_rectangle(200, 200, :fill)
+      |> Script.finish()
+
+    assert Raster.render(script, 8, 8) |> rgba(1, 1) == @black
+  end
+
+  test "draws text from a static font" do
+    script =
+      Script.start()
+      |> Script.font("fonts/roboto.ttf")
+      |> Script.font_size(24)
+      |> Script.text_base(:top)
+      |> Script.fill_color(:white)
+      |> Script.draw_text("Hello")
+      |> Script.finish()
+
+    {Bitmap, _, pixels} = Raster.render(script, 80, 30, format: :g)
+    assert pixels != :binary.copy(<<0>>, 80 * 30)
+  end
+
+  # --------------------------------------------------------
+  # scripts
+
+  test "renders packed scripts the same as list scripts" do
+    script = filled_rect(:red)
+    assert Raster.render(Script.pack(script), 40, 30) == Raster.render(script, 40, 30)
+  end
+
+  test "inlines referenced scripts with a lookup" do
+    script = Script.start() |> Script.render_script("rect") |> Script.finish()
+    lookup = fn "rect" -> {:ok, filled_rect(:red)} end
+
+    assert Raster.render(script, 40, 30) |> rgba(15, 15) == @black
+    assert Raster.render(script, 40, 30, lookup: lookup) |> rgba(15, 15) == @red
+  end
+
+  test "output doesn't depend on the number of tiles" do
+    script =
+      Script.start()
+      |> Script.fill_radial(20, 20, 0, 20, :red, :blue)
+      |> Script.draw_circle(20, :fill)
+      |> Script.stroke_color(:green)
+      |> Script.stroke_width(3)
+      |> Script.draw_line(0, 0, 40, 37, :stroke)
+      |> Script.finish()
+
+    assert Raster.render(script, 40, 37, tiles: 1) == Raster.render(script, 40, 37, tiles: 4)
+    assert Raster.render(script, 40, 37, tiles: 1) == Raster.render(script, 40, 37, tiles: 37)
+  end
+end
@@ -497,4 +497,22 @@ defmodule Scenic.SceneTest do
 
     assert ViewPort.all_script_ids(vp) |> Enum.sort() == [ViewPort.main_id(), @root_id]
   end
+
+  test "push_graph keeps a graph that is animating until it is done", %{scene: scene} do
+    graph =
+      Scenic.Graph.build()
+      |> Scenic.Primitives.rect({100, 200}, fill: :red, id: :rect)
+
+    scene = Scene.push_graph(scene, graph)
+    assert scene.animations == %{}
+    assert scene.animation_timer == nil
+
+    animated = Scenic.Graph.animate(graph, :rect, :translate, {100, 0}, duration: 1000)
+    scene = Scene.push_graph(scene, animated)
+    assert Map.keys(scene.animations) == [ViewPort.main_id()]
+    assert is_reference(scene.animation_timer)
+
+    scene = Scene.push_graph(scene, graph)
+    assert scene.animations == %{}
+  end
 end
@@ -270,6 +270,37 @@ defmodule Scenic.ScriptTest do
     assert expected == Script.serialize(expected) |> Script.deserialize()
   end
 
+  test "draw_sprites serializes packed commands as-is" do
+    cmds = [{{10, 11}, {30, 40}, {2, 3}, {60, 70}, 1}]
+    packed = Scenic.Primitive.Sprites.pack_commands(cmds)
+    ops = Script.draw_sprites([], :parrot, packed)
+
+    assert IO.iodata_to_binary(Script.serialize(ops)) ==
+             IO.iodata_to_binary(Script.serialize(Script.draw_sprites([], :parrot, cmds)))
+
+    assert [{:draw_sprites, {_, deserialized}}] = Script.serialize(ops) |> Script.deserialize()
+    assert deserialized == cmds
+  end
+
+  test "draw_sprites draws atlased images from the atlas" do
+    red = {:test_assets, "images/icons/red.png"}
+    {:ok, {atlas, {x, y, 8, 8}}} = Scenic.Assets.Static.region(red)
+
+    cmds = [{{1, 2}, {4, 4}, {2, 3}, {8, 8}}, {{0, 0}, {8, 8}, {20, 30}, {8, 8}, 0.5}]
+
+    expected = [
+      {{1 + x, 2 + y}, {4, 4}, {2, 3}, {8, 8}},
+      {{x, y}, {8, 8}, {20, 30}, {8, 8}, 0.5}
+    ]
+
+    assert Script.draw_sprites([], red, cmds) == [{:draw_sprites, {atlas, expected}}]
+
+    packed = Scenic.Primitive.Sprites.pack_commands(cmds)
+    [{:draw_sprites, {^atlas, packed}}] = Script.draw_sprites([], red, packed)
+    <<sx::float-32-big, sy::float-32-big, _::binary>> = packed
+    assert {sx, sy} == {1.0 + x, 2.0 + y}
+  end
+
   # --------------------------------------------------------
   # path commands
 
@@ -560,6 +591,13 @@ defmodule Scenic.ScriptTest do
     assert expected == Script.serialize(expected) |> Script.deserialize()
   end
 
+  test "cull works" do
+    expected = [{:cull, {-1.0, 2.0, 30.0, 40.0, 3}}]
+    assert Script.cull([], -1, 2, 30, 40, 3) == expected
+    assert expected == Script.serialize(expected) |> Script.deserialize()
+    assert Script.cull(Script.start(:packed), -1, 2, 30, 40, 3) == Script.pack(expected)
+  end
+
   # --------------------------------------------------------
   # font/text styles
 
@@ -882,4 +920,208 @@ defmodule Scenic.ScriptTest do
              streams: ["test_stream"]
            }
   end
+
+  # --------------------------------------------------------
+  # packed scripts
+
+  test "start(:packed) returns an empty binary" do
+    assert Script.start(:packed) == <<>>
+  end
+
+  test "packed builders append the serialized ops" do
+    list =
+      Script.start()
+      |> Script.fill_color(:red)
+      |> Script.draw_rectangle(10, 20, :fill)
+      |> Script.draw_text("packed")
+      |> Script.finish()
+
+    packed =
+      Script.start(:packed)
+      |> Script.fill_color(:red)
+      |> Script.draw_rectangle(10, 20, :fill)
+      |> Script.draw_text("packed")
+      |> Script.finish()
+
+    assert Script.packed?(packed)
+    assert packed == Script.pack(list)
+    assert Script.serialize(packed) == [packed]
+    assert Script.deserialize(packed) == list
+  end
+
+  test "finish optimizes a packed script" do
+    packed =
+      Script.start(:packed)
+      |> Script.push_state()
+      |> Script.pop_state()
+      |> Script.push_state()
+      |> Script.pop_state()
+      |> Script.finish()
+
+    assert Script.deserialize(packed) == [:push_state, :pop_push_state, :pop_state]
+  end
+
+  test "reduce_packed walks each op without decoding it" do
+    packed =
+      Script.start(:packed)
+      |> Script.draw_text("abc")
+      |> Script.draw_sprites(:parrot, [{{0, 0}, {10, 10}, {0, 0}, {10, 10}, 1}])
+      |> Script.rotate(1.0)
+      |> Script.finish()
+
+    ops = Script.reduce_packed(packed, [], fn op, acc -> [op | acc] end) |> Enum.reverse()
+    assert Enum.count(ops) == 3
+    assert Enum.map(ops, fn {_code, op} -> byte_size(op) end) |> Enum.sum() == byte_size(packed)
+
+    [{_, text}, {_, sprites}, {_, rotate}] = ops
+    assert Script.deserialize(text) == [{:draw_text, "abc"}]
+    assert [{:draw_sprites, {_, [_]}}] = Script.deserialize(sprites)
+    assert Script.deserialize(rotate) == [{:rotate, 1.0}]
+  end
+
+  test "serialize with a map like function works on packed scripts" do
+    packed =
+      Script.start(:packed)
+      |> Script.rectangle(10, 20)
+      |> Script.fill_stream("test_stream")
+      |> Script.finish()
+
+    [rect, _] = Script.serialize(packed, & &1)
+    assert IO.iodata_to_binary([rect]) == Script.pack([{:rect, {10, 20}}])
+
+    mapped =
+      Script.serialize(packed, fn
+        {:fill_stream, _} -> "mapped"
+        other -> other
+      end)
+
+    assert [^rect, "mapped"] = mapped
+  end
+
+  test "serialize with a map_reduce like function works on packed scripts" do
+    packed =
+      Script.start(:packed)
+      |> Script.rectangle(10, 20)
+      |> Script.fill_stream("test_stream")
+      |> Script.finish()
+
+    {mapped, count} =
+      Script.serialize(packed, 0, fn
+        {:fill_stream, _}, c -> {nil, c}
+        other, c -> {other, c + 1}
+      end)
+
+    assert IO.iodata_to_binary(mapped) == Script.pack([{:rect, {10, 20}}])
+    assert count == 1
+  end
+
+  test "media extractor works on packed scripts" do
+    packed =
+      Script.start(:packed)
+      |> Script.font("fonts/roboto.ttf")
+      |> Script.fill_image(:parrot)
+      |> Script.stroke_image(:parrot)
+      |> Script.draw_sprites(:parrot, [])
+      |> Script.fill_stream("test_stream")
+      |> Script.stroke_stream("test_stream")
+      |> Script.finish()
+
+    {:ok, roboto_hash} = Scenic.Assets.Static.to_hash("fonts/roboto.ttf")
+    {:ok, parrot_hash} = Scenic.Assets.Static.to_hash(:parrot)
+
+    assert Script.media(packed) == %{
+             fonts: [roboto_hash],
+             images: [parrot_hash],
+             streams: ["test_stream"]
+           }
+  end
+
+  # --------------------------------------------------------
+  # flatten
+
+  defp flatten_lookup("a"), do: {:ok, [{:draw_circle, {10, :fill}}, {:script, "b"}]}
+  defp flatten_lookup("b"), do: {:ok, [{:draw_rect, {1, 2, :fill}}]}
+  defp flatten_lookup("loop"), do: {:ok, [{:script, "loop"}]}
+  defp flatten_lookup(_), do: {:error, :not_found}
+
+  test "flatten inlines nested scripts" do
+    {flat, ids} = Script.flatten([{:script, "a"}, {:script, "c"}], &flatten_lookup/1)
+
+    assert flat == [
+             :push_state,
+             {:draw_circle, {10, :fill}},
+             :push_state,
+             {:draw_rect, {1, 2, :fill}},
+             :pop_state,
+             :pop_state,
+             {:script, "c"}
+           ]
+
+    assert Enum.sort(ids) == ["a", "b", "c"]
+  end
+
+  test "flatten stops at recursive references" do
+    {flat, ["loop"]} = Script.flatten([{:script, "loop"}], &flatten_lookup/1)
+    assert flat == [:push_state, {:script, "loop"}, :pop_state]
+  end
+
+  test "flatten works on packed scripts" do
+    packed = Script.pack([{:script, "a"}, {:script, "c"}])
+    {flat, _} = Script.flatten(packed, &flatten_lookup/1)
+    assert is_binary(flat)
+
+    {list, _} = Script.flatten([{:script, "a"}, {:script, "c"}], &flatten_lookup/1)
+    assert Script.deserialize(flat) == Script.deserialize(Script.pack(list))
+  end
+
+  # a culled group with a component in it, then a group that isn't culled
+  @culled [
+    {:cull, {0.0, 0.0, 10.0, 10.0, 4}},
+    :push_state,
+    {:draw_circle, {5, :fill}},
+    {:script, "b"},
+    :pop_state,
+    :push_state,
+    {:draw_rect, {3, 4, :fill}},
+    :pop_state
+  ]
+
+  test "flatten updates the cull counts to cover the inlined ops" do
+    {flat, _} = Script.flatten(@culled, &flatten_lookup/1)
+
+    # the pop at the end of the culled group isn't folded into the push after it
+    assert flat == [
+             {:cull, {0.0, 0.0, 10.0, 10.0, 6}},
+             :push_state,
+             {:draw_circle, {5, :fill}},
+             :push_state,
+             {:draw_rect, {1, 2, :fill}},
+             :pop_state,
+             :pop_state,
+             :push_state,
+             {:draw_rect, {3, 4, :fill}},
+             :pop_state
+           ]
+
+    {packed, _} = Script.flatten(Script.pack(@culled), &flatten_lookup/1)
+    assert Script.deserialize(packed) == Script.deserialize(Script.pack(flat))
+  end
+
+  test "flatten keeps the cull counts of inlined scripts" do
+    lookup = fn
+      "culled" -> {:ok, [{:cull, {0.0, 0.0, 1.0, 2.0, 1}}, {:script, "b"}]}
+      id -> flatten_lookup(id)
+    end
+
+    {flat, _} = Script.flatten([{:script, "culled"}], lookup)
+
+    assert flat == [
+             :push_state,
+             {:cull, {0.0, 0.0, 1.0, 2.0, 3}},
+             :push_state,
+             {:draw_rect, {1, 2, :fill}},
+             :pop_state,
+             :pop_state
+           ]
+  end
 end
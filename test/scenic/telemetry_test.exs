@@ -0,0 +1,101 @@
+defmodule Scenic.TelemetryTest do
+  # the sample rates are global
+  use ExUnit.Case, async: false
+  doctest Scenic.Telemetry
+
+  import Scenic.Primitives
+
+  alias Scenic.Graph
+  alias Scenic.Telemetry
+  alias Scenic.ViewPort
+
+  @compile_stop [:scenic, :graph, :compile, :stop]
+  @put_script_stop [:scenic, :view_port, :put_script, :stop]
+  @put_graph_stop [:scenic, :view_port, :put_graph, :stop]
+
+  @graph Graph.build()
+         |> rect({200, 100}, fill: :red)
+         |> circle(20, fill: :green)
+
+  # --------------------------------------------------------
+  setup do
+    self = self()
+    id = make_ref()
+
+    :telemetry.attach_many(
+      id,
+      [@compile_stop, @put_script_stop, @put_graph_stop],
+      fn event, measurements, metadata, _ -> send(self, {event, measurements, metadata}) end,
+      nil
+    )
+
+    on_exit(fn ->
+      :telemetry.detach(id)
+      Telemetry.sample(0)
+      Telemetry.sample([:graph, :compile], nil)
+      Telemetry.sample([:view_port, :put_script], nil)
+    end)
+  end
+
+  # ============================================================================
+  # sampling
+
+  test "nothing is emitted by default" do
+    {:ok, _} = Graph.Compiler.compile(@graph)
+    refute_received {@compile_stop, _, _}
+  end
+
+  test "sample sets the rate of every span" do
+    Telemetry.sample(1)
+    assert Telemetry.sample_rate([:graph, :compile]) == 1
+    assert Telemetry.sample_rate([:view_port, :put_script]) == 1
+
+    {:ok, _} = Graph.Compiler.compile(@graph)
+    assert_received {@compile_stop, _, _}
+  end
+
+  test "sample sets the rate of a single span, which overrides the overall rate" do
+    Telemetry.sample([:graph, :compile], 1)
+    assert Telemetry.sample_rate([:graph, :compile]) == 1
+    assert Telemetry.sample_rate([:view_port, :put_script]) == 0
+
+    Telemetry.sample(1)
+    Telemetry.sample([:graph, :compile], 0)
+    {:ok, _} = Graph.Compiler.compile(@graph)
+    refute_received {@compile_stop, _, _}
+
+    Telemetry.sample([:graph, :compile], nil)
+    assert Telemetry.sample_rate([:graph, :compile]) == 1
+  end
+
+  test "sample rejects rates out of range" do
+    assert_raise FunctionClauseError, fn -> Telemetry.sample(2) end
+    assert_raise FunctionClauseError, fn -> Telemetry.sample([:graph, :compile], -1) end
+  end
+
+  # ============================================================================
+  # spans
+
+  test "compile reports the primitives and ops" do
+    Telemetry.sample([:graph, :compile], 1)
+    {:ok, script} = Graph.Compiler.compile(@graph)
+    assert_received {@compile_stop, measurements, %{}}
+    assert measurements.primitives == 3
+    assert measurements.ops == length(script)
+    assert is_integer(measurements.duration)
+  end
+
+  test "put_script and put_graph report the name and whether the script changed" do
+    %{vp: vp} = Scenic.Test.ViewPort.start()
+    Telemetry.sample(1)
+
+    {:ok, _} = ViewPort.put_graph(vp, "telemetry", @graph)
+    assert_received {@put_graph_stop, %{primitives: 3}, %{name: "telemetry"}}
+    assert_received {@put_script_stop, %{ops: _}, %{name: "telemetry", changed: true}}
+
+    {:ok, "script"} = ViewPort.put_script(vp, "script", [])
+    assert_received {@put_script_stop, _, %{name: "script", changed: true}}
+    :no_change = ViewPort.put_script(vp, "script", [])
+    assert_received {@put_script_stop, %{ops: 0}, %{name: "script", changed: false}}
+  end
+end
@@ -194,6 +194,17 @@ defmodule Scenic.ViewPortTest do
     assert ViewPort.get_script(vp, "test_name") == {:ok, [4, 5, 6]}
   end
 
+  test "put_script accepts packed scripts", %{vp: vp} do
+    script =
+      Scenic.Script.start(:packed)
+      |> Scenic.Script.draw_rectangle(10, 20, :fill)
+      |> Scenic.Script.finish()
+
+    {:ok, "test_name"} = ViewPort.put_script(vp, "test_name", script)
+    assert ViewPort.get_script(vp, "test_name") == {:ok, script}
+    assert ViewPort.put_script(vp, "test_name", script) == :no_change
+  end
+
   test "get_script gets by id", %{vp: vp} do
     {:ok, "test_name"} = ViewPort.put_script(vp, "test_name", [1, 2, 3])
     assert ViewPort.get_script(vp, "test_name") == {:ok, [1, 2, 3]}
@@ -215,6 +226,117 @@ defmodule Scenic.ViewPortTest do
     :ok = ViewPort.del_script(vp, "unknown_name")
   end
 
+  test "get_flat_script inlines referenced scripts", %{vp: vp} do
+    {:ok, _} = ViewPort.put_script(vp, "child", [{:draw_rect, {10, 20, :fill}}])
+    {:ok, _} = ViewPort.put_script(vp, "parent", [{:script, "child"}, {:script, "missing"}])
+
+    assert ViewPort.get_flat_script(vp, "parent") ==
+             {:ok, [:push_state, {:draw_rect, {10, 20, :fill}}, :pop_state, {:script, "missing"}]}
+  end
+
+  test "get_flat_script is invalidated when a referenced script changes", %{vp: vp} do
+    {:ok, _} = ViewPort.put_script(vp, "child", [{:draw_rect, {10, 20, :fill}}])
+    {:ok, _} = ViewPort.put_script(vp, "parent", [{:script, "child"}])
+    {:ok, [_, {:draw_rect, _}, _]} = ViewPort.get_flat_script(vp, "parent")
+
+    {:ok, _} = ViewPort.put_script(vp, "child", [{:draw_circle, {10, :fill}}])
+    Process.sleep(10)
+    assert {:ok, [_, {:draw_circle, _}, _]} = ViewPort.get_flat_script(vp, "parent")
+
+    :ok = ViewPort.del_script(vp, "child")
+    Process.sleep(10)
+    assert ViewPort.get_flat_script(vp, "parent") == {:ok, [{:script, "child"}]}
+  end
+
+  test "get_flat_script returns an error for unknown scripts", %{vp: vp} do
+    assert ViewPort.get_flat_script(vp, "unknown_name") == {:error, :not_found}
+  end
+
+  test "script_stats counts each notification as sent when not batching", %{vp: vp} do
+    %{received: received, coalesced: coalesced, sent: sent} = ViewPort.script_stats(vp)
+    {:ok, _} = ViewPort.put_script(vp, "test_name", [1, 2, 3])
+    {:ok, _} = ViewPort.put_script(vp, "test_name", [4, 5, 6])
+
+    assert ViewPort.script_stats(vp) == %{
+             received: received + 2,
+             coalesced: coalesced,
+             sent: sent + 2
+           }
+  end
+
+  test "script notifications are batched with script_batch_ms" do
+    {:ok, vp} =
+      ViewPort.start(
+        size: {700, 600},
+        default_scene: {TestSceneGreen, self()},
+        script_batch_ms: 50
+      )
+
+    assert_receive :green_up, 200
+    Process.sleep(100)
+
+    # pose as a driver and clear out the registration messages
+    GenServer.cast(vp.pid, {:register_driver, self()})
+    assert_receive {:_put_scripts_, _}, 200
+    %{sent: sent} = ViewPort.script_stats(vp)
+
+    {:ok, _} = ViewPort.put_script(vp, "a", [1])
+    {:ok, _} = ViewPort.put_script(vp, "b", [2])
+    :ok = ViewPort.del_script(vp, "a")
+
+    assert %{coalesced: 2, sent: ^sent} = ViewPort.script_stats(vp)
+    refute_received {:_put_scripts_, _}
+
+    assert_receive {:_del_scripts_, ["a"]}, 200
+    assert_receive {:_put_scripts_, ["b"]}, 200
+    assert ViewPort.script_stats(vp).sent == sent + 2
+
+    ViewPort.stop(vp)
+  end
+
+  test "root script changes flush the batch right away" do
+    {:ok, vp} =
+      ViewPort.start(
+        size: {700, 600},
+        default_scene: {TestSceneGreen, self()},
+        script_batch_ms: 10_000
+      )
+
+    assert_receive :green_up, 200
+    GenServer.cast(vp.pid, {:register_driver, self()})
+    assert_receive {:_put_scripts_, _}, 200
+
+    {:ok, _} = ViewPort.put_script(vp, "a", [1])
+    {:ok, _} = ViewPort.put_script(vp, @root_id, [2])
+    assert_receive {:_put_scripts_, ids}, 200
+    assert Enum.member?(ids, @root_id)
+    assert Enum.member?(ids, "a")
+
+    ViewPort.stop(vp)
+  end
+
+  test "a stale batch timer doesn't flush the batch early" do
+    {:ok, vp} =
+      ViewPort.start(
+        size: {700, 600},
+        default_scene: {TestSceneGreen, self()},
+        script_batch_ms: 10_000
+      )
+
+    assert_receive :green_up, 200
+    GenServer.cast(vp.pid, {:register_driver, self()})
+    assert_receive {:_put_scripts_, _}, 200
+
+    %{sent: sent} = ViewPort.script_stats(vp)
+
+    {:ok, _} = ViewPort.put_script(vp, "a", [1])
+    send(vp.pid, {:timeout, make_ref(), :_flush_scripts_})
+    assert ViewPort.script_stats(vp).sent == sent
+    refute_receive {:_put_scripts_, _}, 50
+
+    ViewPort.stop(vp)
+  end
+
   test "all_script_ids gets a list of script ids", %{vp: vp} do
     assert ViewPort.all_script_ids(vp) |> Enum.sort() == [@main_id, @root_id]
     {:ok, "test_name"} = ViewPort.put_script(vp, "test_name", [1, 2, 3])
@@ -7,5 +7,8 @@ defmodule Scenic.Test.Assets do
     ],
     alias: [
       parrot: {:test_assets, "images/parrot.png"}
+    ],
+    atlases: [
+      icons: [{:test_assets, "images/icons/*.png"}]
     ]
 end